@@ -1,6 +1,8 @@
 #include "AudioEngine.h"
 #include "Project.h"
+#include "Configuration.h"
 #include "Logger.h"
+#include "MIDIUtils.h"
 
 //==============================================================================
 // AudioEngine Implementation
@@ -8,10 +10,12 @@
 
 AudioEngine::AudioEngine()
     : deviceManager(std::make_unique<juce::AudioDeviceManager>()) {
+    diskRecorder.addChangeListener(this);
 }
 
 AudioEngine::~AudioEngine() {
     shutdown();
+    diskRecorder.removeChangeListener(this);
 }
 
 AudioEngine& AudioEngine::getInstance() {
@@ -33,7 +37,28 @@ bool AudioEngine::initialize() {
         }
         
         initializeBuffers();
+        
+        const auto& metronomeSettings = Configuration::getInstance().getMetronomeSettings();
+        metronome.setEnabled(metronomeSettings.enabled);
+        metronome.setLevel(metronomeSettings.level);
+        metronome.setAccentDownbeat(metronomeSettings.accentDownbeat);
+        metronome.setOnlyWhileRecording(metronomeSettings.onlyWhileRecording);
+        metronome.setOutputChannel(metronomeSettings.outputChannel);
+        
+        const auto& midiSettings = Configuration::getInstance().getMIDISettings();
+        syncGenerator.setClockEnabled(midiSettings.clockEnabled);
+        syncGenerator.setMTCEnabled(midiSettings.mtcEnabled);
+        syncGenerator.setMTCFormat(midiSettings.mtcFormat);
+        syncGenerator.setMMCEnabled(midiSettings.sendMMC);
+        syncReceiver.setSource(static_cast<MIDISyncReceiver::Source>(juce::jlimit(0, 2, midiSettings.syncSource)));
+        receiveMMC = midiSettings.receiveMMC;
+        
         initialized = true;
+        setSyncOutputDevice(midiSettings.syncOutputDevice);
+        
+        // Watches for the transport stopping itself after post-roll
+        lastAutoStopCount = transport.getNumAutoStops();
+        startTimer(50);
         
         LOG_INFO("Audio engine initialized successfully");
         return true;
@@ -52,7 +77,9 @@ void AudioEngine::shutdown() {
     LOG_INFO("Shutting down audio engine");
     
     stop();
+    stopTimer();
     cleanupAudioDevice();
+    syncSender.setOutput(nullptr);
     clearBuffers();
     initialized = false;
 }
@@ -70,7 +97,7 @@ bool AudioEngine::applySettings(const Settings& newSettings) {
 
     LOG_INFO("Applying new audio settings");
     
-    const bool wasPlaying = transport.isPlaying;
+    const bool wasPlaying = transport.isPlaying();
     if (wasPlaying) {
         stop();
     }
@@ -113,18 +140,34 @@ juce::String AudioEngine::getCurrentDeviceName() const {
 }
 
 void AudioEngine::setProject(Project* project) {
-    const bool wasPlaying = transport.isPlaying;
+    const bool wasPlaying = transport.isPlaying();
     if (wasPlaying) {
         stop();
     }
     
+    // Swapping projects is rare, so detach the callback rather than make
+    // the project pointer itself realtime-safe. Re-attaching calls
+    // audioDeviceAboutToStart(), which prepares the new project's mixer.
+    const bool wasAttached = initialized;
+    if (wasAttached) {
+        deviceManager->removeAudioCallback(this);
+    }
+    
     currentProject = project;
+    midiSequencer.setProject(project);
+    
+    if (wasAttached) {
+        deviceManager->addAudioCallback(this);
+    }
     
     if (currentProject != nullptr) {
-        transport.bpm = currentProject->getSettings().tempo;
+        const auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+        currentProject->getMixer().setLowLatencyMonitoring(recordingSettings.lowLatencyMonitoring,
+                                                           recordingSettings.lowLatencyThreshold);
+        
+        transport.setTempo(currentProject->getSettings().tempo);
         const auto& ts = currentProject->getSettings().timeSignature;
-        transport.timeSignature.numerator = ts.numerator;
-        transport.timeSignature.denominator = ts.denominator;
+        transport.setTimeSignature(ts.numerator, ts.denominator);
     }
     
     if (wasPlaying) {
@@ -132,27 +175,72 @@ void AudioEngine::setProject(Project* project) {
     }
 }
 
+AudioEngine::LatencyInfo AudioEngine::getRoundTripLatency() const {
+    LatencyInfo info;
+    info.inputSamples = deviceInputLatency.load();
+    info.outputSamples = deviceOutputLatency.load();
+    info.bufferSamples = settings.bufferSize;
+    if (currentProject != nullptr) {
+        info.pluginSamples = currentProject->getMixer().getMonitoringLatencySamples();
+    }
+    return info;
+}
+
+void AudioEngine::setLowLatencyMonitoring(bool enabled) {
+    auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+    recordingSettings.lowLatencyMonitoring = enabled;
+    
+    if (currentProject != nullptr) {
+        currentProject->getMixer().setLowLatencyMonitoring(enabled, recordingSettings.lowLatencyThreshold);
+    }
+    sendChangeMessage();
+}
+
+void AudioEngine::setNonRealtime(bool isNonRealtime) {
+    if (currentProject != nullptr) {
+        currentProject->getMixer().setNonRealtime(isNonRealtime);
+    }
+    LOG_INFO("Plugin quality: %s", isNonRealtime ? "offline" : "realtime");
+}
+
+AudioEngine::TransportState AudioEngine::getTransportState() const {
+    TransportState state;
+    state.isPlaying = transport.isPlaying();
+    state.isRecording = transport.isRecording();
+    state.isLooping = transport.isLooping();
+    state.bpm = transport.getBpm();
+    state.positionInSamples = transport.getPosition();
+    state.position = transport.getPositionInSeconds();
+    state.loopStart = AudioEngineUtils::samplesToTime(transport.getLoopStart(), transport.getSampleRate());
+    state.loopEnd = AudioEngineUtils::samplesToTime(transport.getLoopEnd(), transport.getSampleRate());
+    state.timeSignature.numerator = transport.getTimeSignatureNumerator();
+    state.timeSignature.denominator = transport.getTimeSignatureDenominator();
+    return state;
+}
+
 void AudioEngine::play() {
-    if (!initialized || transport.isPlaying) {
+    if (!initialized) {
         return;
     }
 
-    transport.isPlaying = true;
+    // Not gated on isPlaying(): the published state lags queued commands by
+    // up to a block, and repeating a command is harmless
+    transport.play();
     sendChangeMessage();
     
-    LOG_INFO("Transport: Play (position: %.2f s)", transport.position);
+    LOG_INFO("Transport: Play (position: %.2f s)", transport.getPositionInSeconds());
 }
 
 void AudioEngine::stop() {
-    if (!initialized || !transport.isPlaying) {
+    if (!initialized) {
         return;
     }
 
-    transport.isPlaying = false;
-    transport.isRecording = false;
+    transport.stop();
+    stopRecording();
     sendChangeMessage();
     
-    LOG_INFO("Transport: Stop (position: %.2f s)", transport.position);
+    LOG_INFO("Transport: Stop (position: %.2f s)", transport.getPositionInSeconds());
 }
 
 void AudioEngine::record() {
@@ -160,25 +248,43 @@ void AudioEngine::record() {
         return;
     }
 
-    transport.isRecording = !transport.isRecording;
-    if (transport.isRecording && !transport.isPlaying) {
-        play();
+    const bool shouldRecord = !transport.isRecording();
+    if (shouldRecord) {
+        startRecording();
+        
+        const bool fromStop = !transport.isPlaying() && !transport.isCountingIn();
+        const int64_t playStart = configurePunch(fromStop);
+        transport.setRecording(true);
+        
+        if (fromStop) {
+            const int64_t countIn = getCountInSamples(playStart);
+            transport.locate(playStart);
+            transport.playWithCountIn(countIn);
+            startMIDIRecording(playStart, countIn);
+        } else {
+            startMIDIRecording(transport.getPosition(), 0);
+        }
+    } else {
+        transport.setRecording(false);
+        transport.setAutoStop(-1);
+        stopRecording();
     }
+    
     sendChangeMessage();
     
-    LOG_INFO("Transport: Record %s", transport.isRecording ? "on" : "off");
+    LOG_INFO("Transport: Record %s", shouldRecord ? "on" : "off");
 }
 
 void AudioEngine::setPosition(double timeInSeconds) {
-    nextPosition = timeInSeconds;
+    transport.locate(AudioEngineUtils::timeToSamples(timeInSeconds, transport.getSampleRate()));
     sendChangeMessage();
     
     LOG_INFO("Transport: Set position to %.2f s", timeInSeconds);
 }
 
 void AudioEngine::setLoopPoints(double startTime, double endTime) {
-    transport.loopStart = startTime;
-    transport.loopEnd = endTime;
+    transport.setLoopRange(AudioEngineUtils::timeToSamples(startTime, transport.getSampleRate()),
+                           AudioEngineUtils::timeToSamples(endTime, transport.getSampleRate()));
     sendChangeMessage();
     
     LOG_INFO("Transport: Set loop points (%.2f s - %.2f s)",
@@ -186,22 +292,21 @@ void AudioEngine::setLoopPoints(double startTime, double endTime) {
 }
 
 void AudioEngine::setLooping(bool shouldLoop) {
-    transport.isLooping = shouldLoop;
+    transport.setLooping(shouldLoop);
     sendChangeMessage();
     
     LOG_INFO("Transport: Loop %s", shouldLoop ? "on" : "off");
 }
 
 void AudioEngine::setBpm(double newBpm) {
-    transport.bpm = newBpm;
+    transport.setTempo(newBpm);
     sendChangeMessage();
     
     LOG_INFO("Transport: Set tempo to %.1f BPM", newBpm);
 }
 
 void AudioEngine::setTimeSignature(int numerator, int denominator) {
-    transport.timeSignature.numerator = numerator;
-    transport.timeSignature.denominator = denominator;
+    transport.setTimeSignature(numerator, denominator);
     sendChangeMessage();
     
     LOG_INFO("Transport: Set time signature to %d/%d",
@@ -235,6 +340,41 @@ void AudioEngine::removeMidiInputDevice(const juce::String& deviceName) {
     }
 }
 
+void AudioEngine::setSyncOutputDevice(const juce::String& deviceName) {
+    if (getSyncOutputDevice() == deviceName) {
+        return;
+    }
+    
+    std::unique_ptr<juce::MidiOutput> newOutput;
+    if (deviceName.isNotEmpty()) {
+        newOutput = juce::MidiOutput::openDevice(deviceName);
+        if (newOutput == nullptr) {
+            LOG_WARNING("Could not open MIDI sync output: %s", deviceName.toRawUTF8());
+            return;
+        }
+    }
+    
+    // The callback feeds the sender, so swap it with the callback detached
+    const bool wasAttached = initialized;
+    if (wasAttached) {
+        deviceManager->removeAudioCallback(this);
+    }
+    
+    syncSender.setOutput(std::move(newOutput));
+    
+    if (wasAttached) {
+        deviceManager->addAudioCallback(this);
+    }
+    
+    Configuration::getInstance().getMIDISettings().syncOutputDevice = deviceName;
+    LOG_INFO("MIDI sync output: %s", deviceName.isEmpty() ? "none" : deviceName.toRawUTF8());
+}
+
+juce::String AudioEngine::getSyncOutputDevice() const {
+    auto* output = syncSender.getOutput();
+    return output != nullptr ? output->getName() : juce::String();
+}
+
 juce::StringArray AudioEngine::getMidiInputDevices() const {
     juce::StringArray devices;
     for (auto* device : midiInputs) {
@@ -245,8 +385,70 @@ juce::StringArray AudioEngine::getMidiInputDevices() const {
 
 void AudioEngine::handleIncomingMidiMessage(juce::MidiInput* source,
                                           const juce::MidiMessage& message) {
-    const juce::ScopedLock lock(midiLock);
-    incomingMidi.addEvent(message, 0);
+    // Sync and remote control never reach the tracks
+    if (syncReceiver.handleMessage(message, message.getTimeStamp())) {
+        return;
+    }
+    
+    if (message.isMidiMachineControlMessage()) {
+        if (receiveMMC) {
+            handleMachineControl(message);
+        }
+        return;
+    }
+    
+    // Thru and recording
+    midiSequencer.handleIncomingMidiMessage(message);
+}
+
+void AudioEngine::handleMachineControl(const juce::MidiMessage& message) {
+    // Transport actions touch the project and the disk recorder, so they
+    // run on the message thread
+    int hours = 0, minutes = 0, seconds = 0, frames = 0;
+    if (message.isMidiMachineControlGoto(hours, minutes, seconds, frames)) {
+        const int format = Configuration::getInstance().getMIDISettings().mtcFormat;
+        const double time = static_cast<double>(MIDIUtils::timecodeToFrames(hours, minutes, seconds, frames, format)) /
+                            MIDIUtils::getMTCFrameRate(format);
+        juce::MessageManager::callAsync([this, time] { setPosition(time); });
+        return;
+    }
+    
+    switch (message.getMidiMachineControlCommand()) {
+        case juce::MidiMessage::mmc_play:
+        case juce::MidiMessage::mmc_deferredplay:
+            juce::MessageManager::callAsync([this] { play(); });
+            break;
+            
+        case juce::MidiMessage::mmc_stop:
+        case juce::MidiMessage::mmc_pause:
+            juce::MessageManager::callAsync([this] { stop(); });
+            break;
+            
+        case juce::MidiMessage::mmc_recordStart:
+            juce::MessageManager::callAsync([this] {
+                if (!transport.isRecording()) {
+                    record();
+                }
+            });
+            break;
+            
+        case juce::MidiMessage::mmc_recordStop:
+            juce::MessageManager::callAsync([this] {
+                if (transport.isRecording()) {
+                    record();
+                }
+            });
+            break;
+            
+        default:
+            break;
+    }
+}
+
+void AudioEngine::setSyncSource(MIDISyncReceiver::Source source) {
+    syncReceiver.setSource(source);
+    Configuration::getInstance().getMIDISettings().syncSource = static_cast<int>(source);
+    sendChangeMessage();
 }
 
 void AudioEngine::audioDeviceIOCallback(const float** inputChannelData,
@@ -255,22 +457,43 @@ void AudioEngine::audioDeviceIOCallback(const float** inputChannelData,
                                       int numOutputChannels,
                                       int numSamples) {
     const juce::Time processStartTime = juce::Time::getHighResolutionTicks();
+    updateCallbackTime(numSamples);
     
-    // Process audio
-    processAudioBlock(inputChannelData, numInputChannels,
-                     outputChannelData, numOutputChannels,
-                     numSamples);
+    // Process audio, in sub-blocks if the driver delivered more than
+    // everything was prepared for
+    if (numSamples <= maxBlockSize) {
+        processAudioBlock(inputChannelData, numInputChannels,
+                         outputChannelData, numOutputChannels,
+                         numSamples, 0);
+    } else {
+        const int numInputs = juce::jmin(numInputChannels, static_cast<int>(subBlockInputs.size()));
+        const int numOutputs = juce::jmin(numOutputChannels, static_cast<int>(subBlockOutputs.size()));
+        
+        for (int channel = numOutputs; channel < numOutputChannels; ++channel) {
+            juce::FloatVectorOperations::clear(outputChannelData[channel], numSamples);
+        }
+        
+        for (int startSample = 0; startSample < numSamples; startSample += maxBlockSize) {
+            for (int channel = 0; channel < numInputs; ++channel) {
+                subBlockInputs[static_cast<size_t>(channel)] = inputChannelData[channel] + startSample;
+            }
+            for (int channel = 0; channel < numOutputs; ++channel) {
+                subBlockOutputs[static_cast<size_t>(channel)] = outputChannelData[channel] + startSample;
+            }
+            
+            processAudioBlock(subBlockInputs.data(), numInputs,
+                             subBlockOutputs.data(), numOutputs,
+                             juce::jmin(maxBlockSize, numSamples - startSample), startSample);
+        }
+    }
     
     // Process MIDI
     processMidiBlock(numSamples);
     
-    // Update transport
-    updateTransportPosition(numSamples);
-    
     // Update CPU info
     const double processTimeMs = juce::Time::highResolutionTicksToSeconds(
         juce::Time::getHighResolutionTicks() - processStartTime) * 1000.0;
-    updateCPUInfo(processTimeMs);
+    updateCPUInfo(processTimeMs, numSamples);
 }
 
 void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device) {
@@ -282,13 +505,51 @@ void AudioEngine::audioDeviceAboutToStart(juce::AudioIODevice* device) {
     
     settings.sampleRate = sampleRate;
     settings.bufferSize = bufferSize;
+    maxBlockSize = juce::jmax(1, bufferSize);
+    deviceInputLatency = device->getInputLatencyInSamples();
+    deviceOutputLatency = device->getOutputLatencyInSamples();
     
     initializeBuffers();
+    transport.prepare(sampleRate);
+    metronome.prepare(sampleRate);
+    syncGenerator.prepare(sampleRate);
+    syncBuffer.ensureSize(4096);
+    
+    // Varispeed renders up to maxVarispeed more timeline than device samples
+    maxTimelineSamples = static_cast<int>(std::ceil(bufferSize * (1.0 + maxVarispeed))) + 1;
+    const int numInputs = device->getActiveInputChannels().countNumberOfSetBits();
+    const int numOutputs = device->getActiveOutputChannels().countNumberOfSetBits();
+    varispeedInput.setSize(numInputs, maxTimelineSamples);
+    varispeedOutput.setSize(numOutputs, maxTimelineSamples);
+    subBlockInputs.assign(static_cast<size_t>(numInputs), nullptr);
+    subBlockOutputs.assign(static_cast<size_t>(numOutputs), nullptr);
+    
+    inputInterpolators.clear();
+    for (int i = 0; i < numInputs; ++i) {
+        inputInterpolators.add(new juce::LagrangeInterpolator());
+    }
+    outputInterpolators.clear();
+    for (int i = 0; i < numOutputs; ++i) {
+        outputInterpolators.add(new juce::LagrangeInterpolator());
+    }
+    chasing = false;
+    resetVarispeed();
+    
+    if (currentProject != nullptr) {
+        currentProject->getMixer().prepareToPlay(sampleRate, maxTimelineSamples);
+    }
+    
+    // Latency display
+    sendChangeMessage();
 }
 
 void AudioEngine::audioDeviceStopped() {
     LOG_INFO("Audio device stopped");
     clearBuffers();
+    
+    if (currentProject != nullptr) {
+        currentProject->getMixer().releaseResources();
+    }
 }
 
 void AudioEngine::audioDeviceError(const juce::String& errorMessage) {
@@ -300,74 +561,368 @@ void AudioEngine::processAudioBlock(const float** inputChannelData,
                                   int numInputChannels,
                                   float** outputChannelData,
                                   int numOutputChannels,
-                                  int numSamples) {
+                                  int numSamples,
+                                  int callbackOffset) {
     // Clear output
     for (int channel = 0; channel < numOutputChannels; ++channel) {
         juce::FloatVectorOperations::clear(outputChannelData[channel], numSamples);
     }
     
-    if (!transport.isPlaying || currentProject == nullptr) {
+    // Copy input
+    for (int channel = 0; channel < juce::jmin(numInputChannels, inputBuffer.getNumChannels()); ++channel) {
+        inputBuffer.copyFrom(channel, 0, inputChannelData[channel], numSamples);
+    }
+    
+    syncBuffer.clear();
+    
+    // The transport applies queued commands and splits the block at loop,
+    // punch and tempo boundaries; it runs even when stopped so commands land
+    if (currentProject == nullptr) {
+        transport.processBlock(numSamples, [this](const Transport::Segment& segment) {
+            syncGenerator.render(syncBuffer, segment, nullptr);
+        });
+        sendSyncBlock(callbackOffset, 1.0);
         return;
     }
     
-    // Copy input
-    for (int channel = 0; channel < numInputChannels; ++channel) {
-        inputBuffer.copyFrom(channel, 0, inputChannelData[channel], numSamples);
+    // One render model for the whole callback, so the mixer and the
+    // metronome agree on the tempo map
+    auto& mixer = currentProject->getMixer();
+    const RenderModelExchange::ScopedRead model(mixer.getRenderModels());
+    const TempoMap* tempoMap = model.get() != nullptr ? model->tempoMap.get() : nullptr;
+    auto* recording = model.get() != nullptr ? model->recording.get() : nullptr;
+    
+    // The mixer delays every path to match the slowest, so clicks are
+    // delayed by as much to stay in time with the tracks
+    metronome.setLatencyCompensation(model.get() != nullptr ? model->outputLatency : 0);
+    
+    // Normally the timeline is rendered straight into the device buffers.
+    // While chasing external sync it runs at a slightly different speed:
+    // input is resampled to the timeline rate and the result back again.
+    const int timelineSamples = chaseExternalSync(numSamples, tempoMap);
+    const bool varispeed = chasing;
+    const float* const* timelineInput = inputChannelData;
+    float* const* timelineOutput = outputChannelData;
+    int timelineInputs = numInputChannels;
+    int timelineOutputs = numOutputChannels;
+    
+    if (varispeed) {
+        timelineInputs = juce::jmin(numInputChannels, varispeedInput.getNumChannels());
+        timelineOutputs = juce::jmin(numOutputChannels, varispeedOutput.getNumChannels());
+        
+        for (int channel = 0; channel < timelineInputs; ++channel) {
+            inputInterpolators[channel]->process(static_cast<double>(numSamples) / timelineSamples,
+                                                 inputChannelData[channel],
+                                                 varispeedInput.getWritePointer(channel),
+                                                 timelineSamples, numSamples, 0);
+        }
+        
+        varispeedOutput.clear(0, timelineSamples);
+        timelineInput = varispeedInput.getArrayOfReadPointers();
+        timelineOutput = varispeedOutput.getArrayOfWritePointers();
     }
     
-    // Process tracks
-    if (currentProject != nullptr) {
-        // TODO: Process tracks
+    transport.processBlock(timelineSamples, [&](const Transport::Segment& segment) {
+        // Input goes to the disk FIFOs before anything else touches the block
+        if (segment.recording && recording != nullptr) {
+            recording->push(timelineInput, timelineInputs,
+                            segment.startSample, segment.numSamples, segment.position);
+        }
+        
+        // Render tracks and mixer into the output. The mixer only reads its
+        // published render model, never the live project state.
+        juce::AudioBuffer<float> output(timelineOutput, timelineOutputs,
+                                        segment.startSample, segment.numSamples);
+        mixer.processBlock(output, midiBuffer,
+                           Mixer::Input{timelineInput, timelineInputs,
+                                        segment.startSample, segment.numSamples},
+                           segment.playing);
+        
+        metronome.render(output, segment, tempoMap);
+        syncGenerator.render(syncBuffer, segment, tempoMap);
+    });
+    
+    if (varispeed) {
+        for (int channel = 0; channel < timelineOutputs; ++channel) {
+            outputInterpolators[channel]->process(static_cast<double>(timelineSamples) / numSamples,
+                                                  varispeedOutput.getReadPointer(channel),
+                                                  outputChannelData[channel],
+                                                  numSamples, timelineSamples, 0);
+        }
     }
     
-    // Copy to output
-    for (int channel = 0; channel < numOutputChannels; ++channel) {
-        juce::FloatVectorOperations::copy(outputChannelData[channel],
-                                        outputBuffer.getReadPointer(channel),
-                                        numSamples);
+    sendSyncBlock(callbackOffset, static_cast<double>(timelineSamples) / numSamples);
+}
+
+int AudioEngine::chaseExternalSync(int numSamples, const TempoMap* tempoMap) {
+    const auto source = syncReceiver.getSource();
+    if (source == MIDISyncReceiver::Source::Internal) {
+        chasing = false;
+        return numSamples;
     }
+    
+    // Where the source will be when this block is heard
+    const double sampleRate = settings.sampleRate;
+    const double heardAt = juce::Time::getMillisecondCounterHiRes() * 0.001 +
+                           deviceOutputLatency.load() / sampleRate;
+    const auto estimate = syncReceiver.getEstimate(heardAt);
+    
+    if (!estimate.running || (!chasing && !estimate.locked)) {
+        if (chasing) {
+            transport.chase(transport.getPosition(), false);
+            chasing = false;
+        }
+        return numSamples;
+    }
+    
+    // Target position, and the speed the source is running at relative to
+    // our own timeline
+    int64_t target = 0;
+    double nominalSpeed = 1.0;
+    if (source == MIDISyncReceiver::Source::Clock) {
+        if (tempoMap == nullptr) {
+            return numSamples;
+        }
+        chaseCursor.setMap(tempoMap);
+        target = chaseCursor.beatToSamples(estimate.position, sampleRate);
+        nominalSpeed = estimate.rate * 60.0 / chaseCursor.getTempoAtBeat(estimate.position);
+    } else {
+        target = AudioEngineUtils::timeToSamples(estimate.position, sampleRate);
+        nominalSpeed = estimate.rate;
+    }
+    
+    // Too far off to pull in smoothly: jump there
+    const int64_t error = target - transport.getPosition();
+    if (!chasing || !transport.isPlaying() ||
+        std::abs(static_cast<double>(error)) > sampleRate * 0.1) {
+        transport.chase(target, true);
+        chasing = true;
+        resetVarispeed();
+        return numSamples;
+    }
+    
+    // Otherwise pull the error in over about half a second, smoothing the
+    // speed so the pitch never steps
+    const double correction = static_cast<double>(error) / (sampleRate * 0.5);
+    const double speed = juce::jlimit(1.0 - maxVarispeed, 1.0 + maxVarispeed, nominalSpeed + correction);
+    varispeedRatio += (speed - varispeedRatio) * 0.1;
+    
+    const double exact = numSamples * varispeedRatio + varispeedRemainder;
+    const int timelineSamples = juce::jlimit(1, maxTimelineSamples, static_cast<int>(exact));
+    varispeedRemainder = exact - timelineSamples;
+    return timelineSamples;
 }
 
-void AudioEngine::processMidiBlock(int numSamples) {
-    if (!transport.isPlaying) {
+void AudioEngine::resetVarispeed() {
+    varispeedRatio = 1.0;
+    varispeedRemainder = 0.0;
+    for (auto* interpolator : inputInterpolators) {
+        interpolator->reset();
+    }
+    for (auto* interpolator : outputInterpolators) {
+        interpolator->reset();
+    }
+}
+
+void AudioEngine::updateCallbackTime(int numSamples) {
+    // Blocks are exactly numSamples apart, however late the callback wakes.
+    // Predict from the last block and take a small share of the error, which
+    // averages out the jitter and absorbs drift between the device and
+    // system clocks. After a dropout or restart, start again from now.
+    const double now = juce::Time::getMillisecondCounterHiRes();
+    const double blockMs = numSamples * 1000.0 / settings.sampleRate;
+    const double error = now - nextCallbackTime;
+    
+    callbackTime = std::abs(error) > juce::jmax(20.0, 2.0 * blockMs)
+        ? now
+        : nextCallbackTime + error * callbackTimeSmoothing;
+    nextCallbackTime = callbackTime + blockMs;
+}
+
+void AudioEngine::sendSyncBlock(int callbackOffset, double timelineSpeed) {
+    if (syncSender.getOutput() == nullptr || syncBuffer.isEmpty()) {
+        return;
+    }
+    
+    // The sender thread sends each message at its offset, delayed by the
+    // output latency so sync lines up with what is heard. Sub-blocks start
+    // later within the callback, in device samples. Offsets are timeline
+    // samples, which pass timelineSpeed times faster while chasing.
+    const double sampleRate = settings.sampleRate;
+    const double startTime = callbackTime +
+                             (deviceOutputLatency.load() + callbackOffset) * 1000.0 / sampleRate;
+    syncSender.push(syncBuffer, startTime, sampleRate * timelineSpeed * 0.001);
+}
+
+void AudioEngine::startRecording() {
+    if (currentProject == nullptr || diskRecorder.isRecording()) {
+        return;
+    }
+    
+    const auto directory = DiskRecorderUtils::getRecordingDirectory(currentProject->getProjectFile());
+    auto session = diskRecorder.start(currentProject->getTracks(), transport.getSampleRate(), directory);
+    
+    if (session == nullptr) {
+        LOG_WARNING("Record enabled with no armed audio tracks");
+        return;
+    }
+    
+    currentProject->getMixer().setRecordingSession(std::move(session));
+}
+
+void AudioEngine::startMIDIRecording(int64_t startSample, int64_t leadInSamples) {
+    if (currentProject == nullptr) {
         return;
     }
     
-    // Add incoming MIDI
-    {
-        const juce::ScopedLock lock(midiLock);
-        if (!incomingMidi.isEmpty()) {
-            midiBuffer.addEvents(incomingMidi, 0, numSamples, 0);
-            incomingMidi.clear();
+    // The sequencer records one track: the first armed MIDI track
+    for (auto* track : currentProject->getTracks()) {
+        if (track->getType() == Track::Type::MIDI && track->getParameters().record) {
+            midiSequencer.startRecording(track, transport, startSample, leadInSamples);
+            return;
         }
     }
+}
+
+void AudioEngine::stopRecording() {
+    // Commits the MIDI take, if any
+    midiSequencer.stopRecording();
     
-    if (currentProject != nullptr) {
-        // TODO: Process MIDI tracks
+    if (!diskRecorder.isRecording()) {
+        return;
     }
     
-    midiBuffer.clear();
+    if (currentProject != nullptr) {
+        currentProject->getMixer().setRecordingSession(nullptr);
+    }
+    diskRecorder.stop();
 }
 
-void AudioEngine::updateTransportPosition(int numSamples) {
-    if (!transport.isPlaying) {
+void AudioEngine::changeListenerCallback(juce::ChangeBroadcaster* source) {
+    if (source != &diskRecorder) {
         return;
     }
     
-    // Handle position changes
-    if (nextPosition.load() >= 0.0) {
-        transport.position = nextPosition.exchange(-1.0);
+    // Finished takes become clips on the tracks they were recorded on.
+    // Several takes in one file are loop passes: with take folders they are
+    // stacked with the last one active, otherwise only the last is kept.
+    const bool createTakeFolder = Configuration::getInstance().getRecordingSettings().createTakeFolder;
+    
+    for (const auto& take : diskRecorder.popFinishedTakes()) {
+        if (currentProject == nullptr) {
+            break;
+        }
+        
+        const bool lastTake = take.takeIndex == take.numTakes - 1;
+        if (!lastTake && !createTakeFolder) {
+            continue;
+        }
+        
+        for (auto* track : currentProject->getTracks()) {
+            if (track->getID() != take.trackID) {
+                continue;
+            }
+            
+            auto clip = std::make_unique<Clip>(Clip::Type::Audio);
+            clip->setName(take.file.getFileNameWithoutExtension());
+            clip->setAudioFile(take.file);
+            clip->setOffset(AudioEngineUtils::samplesToTime(take.fileOffset, take.sampleRate));
+            clip->setStartTime(AudioEngineUtils::samplesToTime(take.startPosition, take.sampleRate));
+            clip->setLength(AudioEngineUtils::samplesToTime(take.length, take.sampleRate));
+            
+            if (take.numTakes > 1 && createTakeFolder) {
+                clip->setName(clip->getName() + " Take " + juce::String(take.takeIndex + 1));
+                clip->setTake(take.file.getFileName(), take.takeIndex);
+                clip->setMuted(!lastTake);
+            }
+            
+            track->addClip(std::move(clip));
+            break;
+        }
+    }
+}
+
+int64_t AudioEngine::configurePunch(bool fromStop) {
+    const auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+    const double sampleRate = transport.getSampleRate();
+    const int64_t position = transport.getPosition();
+    
+    Project::TransportState projectState;
+    if (currentProject != nullptr) {
+        projectState = currentProject->getTransportState();
+    }
+    
+    const int64_t punchIn = recordingSettings.punchInEnabled
+                          ? AudioEngineUtils::timeToSamples(projectState.punchIn, sampleRate)
+                          : position;
+    const int64_t punchOut = AudioEngineUtils::timeToSamples(projectState.punchOut, sampleRate);
+    
+    // Pre-roll plays into the take; recording itself starts at the punch-in
+    // point, which the transport hits on the exact sample
+    const int64_t preroll = fromStop
+                          ? AudioEngineUtils::timeToSamples(recordingSettings.prerollTime, sampleRate)
+                          : 0;
+    transport.setPunchRange(punchIn, punchOut);
+    transport.setPunchEnabled(recordingSettings.punchInEnabled || preroll > 0,
+                              recordingSettings.punchOutEnabled);
+    
+    // Post-roll: play on past punch-out, then stop. Loop recording keeps
+    // cycling instead, adding a take per pass.
+    if (recordingSettings.punchOutEnabled && !projectState.loopEnabled) {
+        transport.setAutoStop(punchOut + AudioEngineUtils::timeToSamples(recordingSettings.postrollTime,
+                                                                         sampleRate));
+    } else {
+        transport.setAutoStop(-1);
+    }
+    
+    return preroll > 0 ? std::max<int64_t>(0, punchIn - preroll) : position;
+}
+
+void AudioEngine::timerCallback() {
+    const int autoStops = transport.getNumAutoStops();
+    if (autoStops != lastAutoStopCount) {
+        lastAutoStopCount = autoStops;
+        stopRecording();
+        sendChangeMessage();
+        
+        LOG_INFO("Transport: Stopped after post-roll");
+    }
+}
+
+int64_t AudioEngine::getCountInSamples(int64_t startPosition) const {
+    const auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+    if (!recordingSettings.countInEnabled || recordingSettings.countInBars <= 0 ||
+        currentProject == nullptr) {
+        return 0;
     }
     
-    // Update position
-    const double timeIncrement = numSamples / settings.sampleRate;
-    transport.position += timeIncrement;
+    // Whole bars of the signature in force where recording starts
+    const auto& tempoMap = currentProject->getTempoMap();
+    const double sampleRate = transport.getSampleRate();
+    const double startBeat = tempoMap.samplesToBeat(startPosition, sampleRate);
+    const auto& signature = tempoMap.getTimeSignatureAtBeat(startBeat);
+    const double barLength = signature.numerator * 4.0 / signature.denominator;
+    
+    return startPosition - tempoMap.beatToSamples(startBeat - recordingSettings.countInBars * barLength,
+                                          sampleRate);
+}
+
+void AudioEngine::processMidiBlock(int numSamples) {
+    juce::ignoreUnused(numSamples);
+    
+    // Incoming MIDI, drained even when stopped so it never piles up
+    midiSequencer.processInputBuffer(midiBuffer);
+    
+    if (!transport.isPlaying()) {
+        midiBuffer.clear();
+        return;
+    }
     
-    // Handle looping
-    if (transport.isLooping &&
-        transport.position >= transport.loopEnd) {
-        transport.position = transport.loopStart;
+    if (currentProject != nullptr) {
+        // TODO: Process MIDI tracks
     }
+    
+    midiBuffer.clear();
 }
 
 void AudioEngine::handleXRun() {
@@ -375,8 +930,14 @@ void AudioEngine::handleXRun() {
     LOG_WARNING("Audio dropout detected (total xruns: %d)", cpuInfo.xruns);
 }
 
-void AudioEngine::updateCPUInfo(double processingTimeMs) {
-    const double bufferTimeMs = (settings.bufferSize / settings.sampleRate) * 1000.0;
+void AudioEngine::updateCPUInfo(double processingTimeMs, int numSamples) {
+    // Measured against this callback's length, which may differ from the
+    // configured buffer size
+    if (numSamples <= 0) {
+        return;
+    }
+    
+    const double bufferTimeMs = (numSamples / settings.sampleRate) * 1000.0;
     const float load = static_cast<float>(processingTimeMs / bufferTimeMs);
     
     cpuInfo.currentLoad = load;
@@ -392,8 +953,10 @@ void AudioEngine::initializeBuffers() {
     const int numChannels = std::max(settings.inputChannels,
                                    settings.outputChannels);
     
-    inputBuffer.setSize(numChannels, settings.bufferSize);
-    outputBuffer.setSize(numChannels, settings.bufferSize);
+    // Sub-blocks never exceed the size the running device was prepared with
+    const int numSamples = std::max(settings.bufferSize, maxBlockSize);
+    inputBuffer.setSize(numChannels, numSamples);
+    outputBuffer.setSize(numChannels, numSamples);
     
     clearBuffers();
 }
@@ -402,7 +965,6 @@ void AudioEngine::clearBuffers() {
     inputBuffer.clear();
     outputBuffer.clear();
     midiBuffer.clear();
-    incomingMidi.clear();
 }
 
 bool AudioEngine::setupAudioDevice() {
@@ -467,12 +1029,21 @@ namespace AudioEngineUtils {
         return static_cast<int64_t>(timeInSeconds * sampleRate);
     }
 
+    // PPQ counts quarter notes, the same beats the tempo is given in
     double ppqToTime(double ppq, double bpm) {
-        return (60.0 * ppq) / (bpm * 4.0);
+        return (60.0 * ppq) / bpm;
     }
 
     double timeToPpq(double timeInSeconds, double bpm) {
-        return (timeInSeconds * bpm * 4.0) / 60.0;
+        return (timeInSeconds * bpm) / 60.0;
+    }
+
+    double ppqToTime(double ppq, const TempoMap& tempoMap) {
+        return tempoMap.beatToSeconds(ppq);
+    }
+
+    double timeToPpq(double timeInSeconds, const TempoMap& tempoMap) {
+        return tempoMap.secondsToBeat(timeInSeconds);
     }
 
     void applyGainRamp(juce::AudioBuffer<float>& buffer,
@@ -2,12 +2,22 @@
 #include <JuceHeader.h>
 #include "Track.h"
 #include "Plugin.h"
+#include "Transport.h"
+#include "TempoMap.h"
+#include "Metronome.h"
+#include "MIDISyncGenerator.h"
+#include "MIDISyncReceiver.h"
+#include "MIDISyncSender.h"
+#include "DiskRecorder.h"
+#include "MIDISequencer.h"
 
 class Project;
 
 class AudioEngine : public juce::AudioIODeviceCallback,
                    public juce::MidiInputCallback,
-                   public juce::ChangeBroadcaster {
+                   public juce::ChangeBroadcaster,
+                   private juce::ChangeListener,
+                   private juce::Timer {
 public:
     // Audio settings
     struct Settings {
@@ -20,18 +30,31 @@ public:
         bool useAsioDriver{false};
     };
 
-    // Transport state
+    // Transport state snapshot for the UI
     struct TransportState {
         bool isPlaying{false};
         bool isRecording{false};
         bool isLooping{false};
         double bpm{120.0};
         double position{0.0};
+        int64_t positionInSamples{0};
         double loopStart{0.0};
         double loopEnd{0.0};
         juce::AudioPlayHead::TimeSignature timeSignature{4, 4};
     };
 
+    // Round-trip latency heard while monitoring, in samples
+    struct LatencyInfo {
+        int inputSamples{0};
+        int outputSamples{0};
+        int bufferSamples{0};
+        int pluginSamples{0};  // Slowest monitored plugin chain
+        
+        int getTotalSamples() const {
+            return inputSamples + outputSamples + bufferSamples + pluginSamples;
+        }
+    };
+
     // CPU usage info
     struct CPUInfo {
         float averageLoad{0.0f};
@@ -59,6 +82,14 @@ public:
     juce::String getCurrentDeviceName() const;
     
     const CPUInfo& getCPUInfo() const { return cpuInfo; }
+    LatencyInfo getRoundTripLatency() const;
+    
+    // Monitored tracks skip plugins above the configured latency threshold
+    void setLowLatencyMonitoring(bool enabled);
+
+    // Offline render switches plugins to their offline quality; call
+    // before rendering starts and again when it ends
+    void setNonRealtime(bool isNonRealtime);
 
     // Project handling
     void setProject(Project* project);
@@ -74,14 +105,28 @@ public:
     void setBpm(double newBpm);
     void setTimeSignature(int numerator, int denominator);
     
-    const TransportState& getTransportState() const { return transport; }
-    double getCurrentPosition() const { return transport.position; }
+    TransportState getTransportState() const;
+    double getCurrentPosition() const { return transport.getPositionInSeconds(); }
+    Transport& getTransport() { return transport; }
+    MIDISequencer& getMIDISequencer() { return midiSequencer; }
+    Metronome& getMetronome() { return metronome; }
+    MIDISyncGenerator& getSyncGenerator() { return syncGenerator; }
+    MIDISyncReceiver& getSyncReceiver() { return syncReceiver; }
+    
+    // Follow an external MIDI clock or MTC source instead of the internal clock
+    void setSyncSource(MIDISyncReceiver::Source source);
+    bool isChasingExternalSync() const { return chasing; }
+    DiskRecorder& getDiskRecorder() { return diskRecorder; }
 
     // MIDI handling
     void addMidiInputDevice(const juce::String& deviceName);
     void removeMidiInputDevice(const juce::String& deviceName);
     juce::StringArray getMidiInputDevices() const;
     
+    // Output for generated clock, MTC and MMC; empty closes it
+    void setSyncOutputDevice(const juce::String& deviceName);
+    juce::String getSyncOutputDevice() const;
+    
     void handleIncomingMidiMessage(juce::MidiInput* source,
                                  const juce::MidiMessage& message) override;
 
@@ -101,15 +146,42 @@ private:
     std::unique_ptr<juce::AudioDeviceManager> deviceManager;
     Settings settings;
     bool initialized{false};
+    std::atomic<int> deviceInputLatency{0};
+    std::atomic<int> deviceOutputLatency{0};
     
     // Project reference
     Project* currentProject{nullptr};
     
-    // Transport state
-    TransportState transport;
-    std::atomic<double> nextPosition{0.0};
+    // Transport (commands in, published state out)
+    Transport transport;
+    Metronome metronome;
+    MIDISyncGenerator syncGenerator;
+    MIDISyncReceiver syncReceiver;
+    std::atomic<bool> receiveMMC{false};
     
-    // Processing state
+    // Chasing external sync (audio thread). The timeline is rendered at a
+    // slightly different rate and resampled to the device, so it locks to
+    // the source without audible jumps.
+    static constexpr double maxVarispeed = 0.1;  // Speed may deviate by 10%
+    std::atomic<bool> chasing{false};
+    double varispeedRatio{1.0};
+    double varispeedRemainder{0.0};
+    int maxTimelineSamples{0};
+    TempoMap::Cursor chaseCursor;
+    juce::AudioBuffer<float> varispeedInput;
+    juce::AudioBuffer<float> varispeedOutput;
+    juce::OwnedArray<juce::LagrangeInterpolator> inputInterpolators;
+    juce::OwnedArray<juce::LagrangeInterpolator> outputInterpolators;
+    DiskRecorder diskRecorder;
+    MIDISequencer midiSequencer;  // MIDI input: thru, filtering and recording
+    int lastAutoStopCount{0};
+    
+    // Processing state. Drivers may deliver any number of samples per
+    // callback; anything longer than the prepared size is rendered in
+    // sub-blocks of that size.
+    int maxBlockSize{512};
+    std::vector<const float*> subBlockInputs;
+    std::vector<float*> subBlockOutputs;
     juce::AudioBuffer<float> inputBuffer;
     juce::AudioBuffer<float> outputBuffer;
     juce::MidiBuffer midiBuffer;
@@ -120,7 +192,16 @@ private:
     
     // MIDI devices
     juce::OwnedArray<juce::MidiInput> midiInputs;
-    juce::MidiBuffer incomingMidi;
+    MIDISyncSender syncSender;
+    juce::MidiBuffer syncBuffer;  // One callback's sync, at timeline offsets
+    
+    // When the current callback's block starts, in ms on the
+    // Time::getMillisecondCounterHiRes() clock (audio thread). Follows the
+    // sample clock, so sync is not shifted by callback wake-up jitter or by
+    // how long the blocks before it took to process.
+    static constexpr double callbackTimeSmoothing = 0.05;  // Share of each error taken
+    double callbackTime{0.0};
+    double nextCallbackTime{0.0};
     juce::CriticalSection midiLock;
     
     // Internal helpers
@@ -128,12 +209,24 @@ private:
                          int numInputChannels,
                          float** outputChannelData,
                          int numOutputChannels,
-                         int numSamples);
+                         int numSamples,
+                         int callbackOffset);
                          
     void processMidiBlock(int numSamples);
-    void updateTransportPosition(int numSamples);
+    void updateCallbackTime(int numSamples);
+    void sendSyncBlock(int callbackOffset, double timelineSpeed);
+    int chaseExternalSync(int numSamples, const TempoMap* tempoMap);
+    void resetVarispeed();
+    void handleMachineControl(const juce::MidiMessage& message);
+    int64_t getCountInSamples(int64_t startPosition) const;
+    int64_t configurePunch(bool fromStop);
+    void startRecording();
+    void startMIDIRecording(int64_t startSample, int64_t leadInSamples);
+    void stopRecording();
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void timerCallback() override;
     void handleXRun();
-    void updateCPUInfo(double processingTimeMs);
+    void updateCPUInfo(double processingTimeMs, int numSamples);
     
     void initializeBuffers();
     void clearBuffers();
@@ -152,6 +245,8 @@ namespace AudioEngineUtils {
     int64_t timeToSamples(double timeInSeconds, double sampleRate);
     double ppqToTime(double ppq, double bpm);
     double timeToPpq(double timeInSeconds, double bpm);
+    double ppqToTime(double ppq, const TempoMap& tempoMap);
+    double timeToPpq(double timeInSeconds, const TempoMap& tempoMap);
     
     // Buffer utilities
     void applyGainRamp(juce::AudioBuffer<float>& buffer,
@@ -1,4 +1,5 @@
 #include "AudioUtils.h"
+#include "PartitionedConvolver.h"
 #include "Logger.h"
 
 float AudioUtils::dbToGain(float db) {
@@ -337,6 +338,130 @@ double AudioUtils::samplesToBeats(int64_t samples, double tempo,
     return secondsToBeats(samples / sampleRate, tempo);
 }
 
+int64_t AudioUtils::beatsToSamples(double beats, const TempoMap& tempoMap,
+                                  double sampleRate) {
+    return tempoMap.beatToSamples(beats, sampleRate);
+}
+
+double AudioUtils::samplesToBeats(int64_t samples, const TempoMap& tempoMap,
+                                double sampleRate) {
+    return tempoMap.samplesToBeat(samples, sampleRate);
+}
+
+void AudioUtils::convolve(const juce::AudioBuffer<float>& input,
+                          const juce::AudioBuffer<float>& impulse,
+                          juce::AudioBuffer<float>& output) {
+    const int numChannels = input.getNumChannels();
+    const int length = input.getNumSamples() + juce::jmax(0, impulse.getNumSamples() - 1);
+
+    output.setSize(numChannels, length);
+    output.clear();
+    if (numChannels == 0 || impulse.getNumChannels() == 0 || input.getNumSamples() == 0) {
+        return;
+    }
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        output.copyFrom(channel, 0, input, channel, 0, input.getNumSamples());
+    }
+
+    // Faster than real time, so the audio side simply runs the late
+    // background stages itself
+    PartitionedConvolver convolver;
+    convolver.loadImpulseResponse(impulse, numChannels);
+
+    constexpr int blockSize = 4096;
+    std::vector<float*> channels(static_cast<size_t>(numChannels));
+
+    for (int position = 0; position < length; position += blockSize) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            channels[static_cast<size_t>(channel)] = output.getWritePointer(channel, position);
+        }
+        convolver.process(channels.data(), channels.data(), numChannels, juce::jmin(blockSize, length - position));
+    }
+}
+
+AudioUtils::ConvolutionBenchmark AudioUtils::benchmarkConvolution(double sampleRate, double impulseSeconds,
+                                                                  int blockSize, int numBlocks) {
+    ConvolutionBenchmark result;
+    result.blockMs = 1000.0 * blockSize / sampleRate;
+
+    const int impulseLength = juce::jmax(1, static_cast<int>(impulseSeconds * sampleRate));
+    juce::AudioBuffer<float> impulse(2, impulseLength);
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::Random random(0x5eed);
+
+    for (int channel = 0; channel < 2; ++channel) {
+        float* data = impulse.getWritePointer(channel);
+        for (int i = 0; i < impulseLength; ++i) {
+            data[i] = (random.nextFloat() * 2.0f - 1.0f) * std::exp(-6.9f * i / impulseLength);
+        }
+    }
+
+    const auto fillNoise = [&buffer, &random] {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+            float* data = buffer.getWritePointer(channel);
+            for (int i = 0; i < buffer.getNumSamples(); ++i) {
+                data[i] = random.nextFloat() * 2.0f - 1.0f;
+            }
+        }
+    };
+
+    const auto ticksToMs = [](int64_t ticks) {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1000.0;
+    };
+
+    // Partitioned
+    {
+        PartitionedConvolver convolver;
+        convolver.loadImpulseResponse(impulse, 2);
+
+        int64_t ticks = 0;
+        for (int block = 0; block < numBlocks; ++block) {
+            fillNoise();
+            const auto start = juce::Time::getHighResolutionTicks();
+            convolver.process(buffer.getArrayOfReadPointers(), buffer.getArrayOfWritePointers(), 2, blockSize);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+
+            // Pace the blocks so the background stages get real time
+            juce::Thread::sleep(juce::roundToInt(result.blockMs));
+        }
+
+        result.partitionedMs = ticksToMs(ticks) / numBlocks;
+        result.lateBlocks = convolver.getNumLateBlocks();
+    }
+
+    // juce::dsp::Convolution, once its response has been swapped in
+    {
+        juce::dsp::Convolution convolution;
+        convolution.prepare({ sampleRate, static_cast<juce::uint32>(blockSize), 2 });
+        convolution.loadImpulseResponse(juce::AudioBuffer<float>(impulse), sampleRate,
+                                        juce::dsp::Convolution::Stereo::yes,
+                                        juce::dsp::Convolution::Trim::no,
+                                        juce::dsp::Convolution::Normalise::no);
+
+        juce::dsp::AudioBlock<float> block(buffer);
+        juce::dsp::ProcessContextReplacing<float> context(block);
+        for (int attempt = 0; attempt < 5000 && convolution.getCurrentIRSize() < impulseLength; ++attempt) {
+            convolution.process(context);
+            juce::Thread::sleep(1);
+        }
+
+        int64_t ticks = 0;
+        for (int i = 0; i < numBlocks; ++i) {
+            fillNoise();
+            const auto start = juce::Time::getHighResolutionTicks();
+            convolution.process(context);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+        }
+
+        result.juceMs = ticksToMs(ticks) / numBlocks;
+    }
+
+    LOG_INFO("Convolution benchmark (%.1f s, %d samples): partitioned %.3f ms, juce %.3f ms, budget %.3f ms, %d late",
+             impulseSeconds, blockSize, result.partitionedMs, result.juceMs, result.blockMs, result.lateBlocks);
+    return result;
+}
+
 // Private utility functions
 
 int32_t AudioUtils::float32ToInt32(float sample) {
@@ -1,5 +1,6 @@
 #pragma once
 #include <JuceHeader.h>
+#include "TempoMap.h"
 
 class AudioUtils {
 public:
@@ -105,6 +106,28 @@ public:
                                  double sampleRate);
     static double samplesToBeats(int64_t samples, double tempo,
                                double sampleRate);
+    static int64_t beatsToSamples(double beats, const TempoMap& tempoMap,
+                                 double sampleRate);
+    static double samplesToBeats(int64_t samples, const TempoMap& tempoMap,
+                               double sampleRate);
+
+    // Convolution (zero-latency partitioned). Output is resized to the
+    // input length plus the impulse length minus one.
+    static void convolve(const juce::AudioBuffer<float>& input,
+                         const juce::AudioBuffer<float>& impulse,
+                         juce::AudioBuffer<float>& output);
+
+    // Average audio-thread cost per block of PartitionedConvolver against
+    // juce::dsp::Convolution, on a stereo noise response of the given length
+    struct ConvolutionBenchmark {
+        double partitionedMs{0.0};
+        double juceMs{0.0};
+        double blockMs{0.0};   // Real-time budget per block
+        int lateBlocks{0};     // Background stages that missed their deadline
+    };
+
+    static ConvolutionBenchmark benchmarkConvolution(double sampleRate, double impulseSeconds,
+                                                     int blockSize, int numBlocks = 2000);
 
 private:
     // Utility functions for format conversion
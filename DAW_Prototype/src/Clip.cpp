@@ -57,6 +57,19 @@ void Clip::setMuted(bool shouldBeMuted) {
     }
 }
 
+void Clip::setTake(const juce::String& group, int index) {
+    if (takeGroup != group || takeIndex != index) {
+        takeGroup = group;
+        takeIndex = index;
+        sendChangeMessage();
+    }
+}
+
+void Clip::setMIDISequence(const juce::MidiMessageSequence& sequence) {
+    midiSequence = sequence;
+    sendChangeMessage();
+}
+
 void Clip::saveState(juce::ValueTree& state) const {
     state.setProperty("startTime", startTime, nullptr);
     state.setProperty("length", length, nullptr);
@@ -64,6 +77,10 @@ void Clip::saveState(juce::ValueTree& state) const {
     state.setProperty("colour", colour.toString(), nullptr);
     state.setProperty("selected", selected, nullptr);
     state.setProperty("muted", muted, nullptr);
+    if (takeGroup.isNotEmpty()) {
+        state.setProperty("takeGroup", takeGroup, nullptr);
+        state.setProperty("takeIndex", takeIndex, nullptr);
+    }
 }
 
 void Clip::loadState(const juce::ValueTree& state) {
@@ -73,6 +90,8 @@ void Clip::loadState(const juce::ValueTree& state) {
     colour = juce::Colour::fromString(state.getProperty("colour", colour.toString()));
     selected = state.getProperty("selected", selected);
     muted = state.getProperty("muted", muted);
+    takeGroup = state.getProperty("takeGroup", takeGroup);
+    takeIndex = state.getProperty("takeIndex", takeIndex);
     
     sendChangeMessage();
 }
@@ -360,7 +379,7 @@ void MIDIClip::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlo
     currentBlockSize = maximumExpectedSamplesPerBlock;
 }
 
-void MIDIClip::processBlock(juce::MidiBuffer& midiMessages, double position) {
+void MIDIClip::processBlock(juce::MidiBuffer& midiMessages, int numSamples, double position) {
     if (muted) {
         return;
     }
@@ -370,14 +389,16 @@ void MIDIClip::processBlock(juce::MidiBuffer& midiMessages, double position) {
         return;
     }
 
-    // Add MIDI messages that fall within this block
+    // Add MIDI messages that fall within this block, which may be shorter
+    // than the prepared block size
+    const double blockEnd = clipPosition + numSamples / currentSampleRate;
     for (int i = 0; i < sequence.getNumEvents(); ++i) {
         auto* event = sequence.getEventPointer(i);
         double eventTime = event->message.getTimeStamp();
         
-        if (eventTime >= clipPosition && eventTime < clipPosition + (currentBlockSize / currentSampleRate)) {
+        if (eventTime >= clipPosition && eventTime < blockEnd) {
             const int samplePosition = static_cast<int>((eventTime - clipPosition) * currentSampleRate);
-            midiMessages.addEvent(event->message, samplePosition);
+            midiMessages.addEvent(event->message, juce::jmin(samplePosition, numSamples - 1));
         }
     }
 }
@@ -26,6 +26,13 @@ public:
     double getOffset() const { return offset; }
     void setOffset(double newOffset);
     bool containsTime(double time) const;
+    void setMuted(bool shouldBeMuted);
+    bool isMuted() const { return muted; }
+
+    // Take lanes: takes of one loop recording share a group and source file
+    void setTake(const juce::String& group, int index);
+    const juce::String& getTakeGroup() const { return takeGroup; }
+    int getTakeIndex() const { return takeIndex; }
 
     // Audio specific
     void setAudioFile(const juce::File& file);
@@ -45,6 +52,7 @@ public:
     void addMIDINote(int note, int velocity, double startBeat, double lengthInBeats);
     void removeMIDINote(int note, double startBeat);
     void clearMIDINotes();
+    void setMIDISequence(const juce::MidiMessageSequence& sequence);  // Beats from the clip start, pairs matched
     const juce::MidiMessageSequence& getMIDISequence() const { return midiSequence; }
     void setMIDIChannel(int channel);
     int getMIDIChannel() const { return midiChannel; }
@@ -79,6 +87,11 @@ private:
     double startTime{0.0};
     double length{0.0};
     double offset{0.0};
+    bool muted{false};
+    
+    // Takes
+    juce::String takeGroup;
+    int takeIndex{0};
     
     // Audio properties
     juce::File audioFile;
@@ -1,5 +1,7 @@
 #include "Commands.h"
 #include "Project.h"
+#include "AudioEngine.h"
+#include "Configuration.h"
 #include "Logger.h"
 
 Commands::Commands() {
@@ -35,13 +37,11 @@ bool Commands::hasClipboard() const {
 }
 
 bool Commands::isPlaying() const {
-    // TODO: Implement playback check
-    return false;
+    return AudioEngine::getInstance().getTransport().isPlaying();
 }
 
 bool Commands::isRecording() const {
-    // TODO: Implement recording check
-    return false;
+    return AudioEngine::getInstance().getTransport().isRecording();
 }
 
 bool Commands::isLooping() const {
@@ -94,6 +94,7 @@ void Commands::getAllCommands(juce::Array<juce::CommandID>& commands) {
         ToggleLoop,
         ToggleMetronome,
         ToggleCountIn,
+        ToggleLowLatencyMonitoring,
         SetTempo,
         SetTimeSignature,
         
@@ -376,6 +377,21 @@ void Commands::addTransportCommandInfo(juce::CommandID commandID,
                 result.setActive(false);
             result.setTicked(isLooping());
             break;
+            
+        case ToggleMetronome:
+            result.setInfo("Toggle Metronome", "Toggle the metronome click", "Transport", 0);
+            result.setTicked(Configuration::getInstance().getMetronomeSettings().enabled);
+            break;
+            
+        case ToggleCountIn:
+            result.setInfo("Toggle Count-In", "Count in before recording starts", "Transport", 0);
+            result.setTicked(Configuration::getInstance().getRecordingSettings().countInEnabled);
+            break;
+            
+        case ToggleLowLatencyMonitoring:
+            result.setInfo("Low-Latency Monitoring", "Bypass high-latency plugins on monitored tracks", "Transport", 0);
+            result.setTicked(Configuration::getInstance().getRecordingSettings().lowLatencyMonitoring);
+            break;
     }
 }
 
@@ -447,7 +463,53 @@ void Commands::handleTrackCommand(juce::CommandID commandID) {
 }
 
 void Commands::handleTransportCommand(juce::CommandID commandID) {
-    // TODO: Implement transport command handling
+    auto& engine = AudioEngine::getInstance();
+    
+    switch (commandID) {
+        case Play:
+            if (isPlaying())
+                engine.stop();
+            else
+                engine.play();
+            break;
+            
+        case Stop:
+            engine.stop();
+            break;
+            
+        case Record:
+            engine.record();
+            break;
+            
+        case ToggleLoop:
+            if (project != nullptr) {
+                auto state = project->getTransportState();
+                state.loopEnabled = !state.loopEnabled;
+                project->setTransportState(state);
+                
+                engine.setLoopPoints(state.loopStart, state.loopEnd);
+                engine.setLooping(state.loopEnabled);
+            }
+            break;
+            
+        case ToggleMetronome: {
+            auto& metronomeSettings = Configuration::getInstance().getMetronomeSettings();
+            metronomeSettings.enabled = !metronomeSettings.enabled;
+            engine.getMetronome().setEnabled(metronomeSettings.enabled);
+            break;
+        }
+            
+        case ToggleCountIn: {
+            auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+            recordingSettings.countInEnabled = !recordingSettings.countInEnabled;
+            break;
+        }
+            
+        case ToggleLowLatencyMonitoring:
+            engine.setLowLatencyMonitoring(
+                !Configuration::getInstance().getRecordingSettings().lowLatencyMonitoring);
+            break;
+    }
 }
 
 void Commands::handleViewCommand(juce::CommandID commandID) {
@@ -51,6 +51,7 @@ public:
         ToggleLoop,
         ToggleMetronome,
         ToggleCountIn,
+        ToggleLowLatencyMonitoring,
         SetTempo,
         SetTimeSignature,
         
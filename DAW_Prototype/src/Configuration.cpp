@@ -47,6 +47,8 @@ void Configuration::loadFromFile() {
             midiSettings.mtcFormat = midiObj->getProperty("mtcFormat", 0);
             midiSettings.sendMMC = midiObj->getProperty("sendMMC", false);
             midiSettings.receiveMMC = midiObj->getProperty("receiveMMC", false);
+            midiSettings.syncSource = midiObj->getProperty("syncSource", 0);
+            midiSettings.syncOutputDevice = midiObj->getProperty("syncOutputDevice", "").toString();
             midiSettings.velocityScale = midiObj->getProperty("velocityScale", 1.0f);
             midiSettings.velocityOffset = midiObj->getProperty("velocityOffset", 0.0f);
             
@@ -137,6 +139,8 @@ void Configuration::loadFromFile() {
             performanceSettings.ramCacheSize = performanceObj->getProperty("ramCacheSize", 512);
             performanceSettings.processingThreads = performanceObj->getProperty("processingThreads", 0);
             performanceSettings.pluginThreadPool = performanceObj->getProperty("pluginThreadPool", 4);
+            performanceSettings.realtimeOversampling = performanceObj->getProperty("realtimeOversampling", 2);
+            performanceSettings.offlineOversampling = performanceObj->getProperty("offlineOversampling", 8);
             performanceSettings.realTimeProcessing = performanceObj->getProperty("realTimeProcessing", true);
             performanceSettings.useMMCSS = performanceObj->getProperty("useMMCSS", true);
             performanceSettings.guardAgainstDenormals = performanceObj->getProperty("guardAgainstDenormals", true);
@@ -155,6 +159,18 @@ void Configuration::loadFromFile() {
             recordingSettings.createTakeFolder = recordingObj->getProperty("createTakeFolder", true);
             recordingSettings.autoQuantize = recordingObj->getProperty("autoQuantize", false);
             recordingSettings.autoQuantizeAmount = recordingObj->getProperty("autoQuantizeAmount", 0.5f);
+            recordingSettings.lowLatencyMonitoring = recordingObj->getProperty("lowLatencyMonitoring", false);
+            recordingSettings.lowLatencyThreshold = recordingObj->getProperty("lowLatencyThreshold", 128);
+        }
+        
+        if (auto* metronomeObj = json.getProperty("metronome", nullptr).getDynamicObject()) {
+            metronomeSettings.enabled = metronomeObj->getProperty("enabled", false);
+            metronomeSettings.onlyWhileRecording = metronomeObj->getProperty("onlyWhileRecording", false);
+            metronomeSettings.level = metronomeObj->getProperty("level", 0.7f);
+            metronomeSettings.accentDownbeat = metronomeObj->getProperty("accentDownbeat", true);
+            metronomeSettings.outputChannel = metronomeObj->getProperty("outputChannel", 0);
+            metronomeSettings.clickSample = metronomeObj->getProperty("clickSample").toString();
+            metronomeSettings.accentSample = metronomeObj->getProperty("accentSample").toString();
         }
         
         if (auto* exportObj = json.getProperty("export", nullptr).getDynamicObject()) {
@@ -201,6 +217,8 @@ void Configuration::saveToFile() {
     midiObj->setProperty("mtcFormat", midiSettings.mtcFormat);
     midiObj->setProperty("sendMMC", midiSettings.sendMMC);
     midiObj->setProperty("receiveMMC", midiSettings.receiveMMC);
+    midiObj->setProperty("syncSource", midiSettings.syncSource);
+    midiObj->setProperty("syncOutputDevice", midiSettings.syncOutputDevice);
     midiObj->setProperty("velocityScale", midiSettings.velocityScale);
     midiObj->setProperty("velocityOffset", midiSettings.velocityOffset);
     midiObj->setProperty("defaultInputDevices", midiSettings.inputDevices);
@@ -276,6 +294,8 @@ void Configuration::saveToFile() {
     performanceObj->setProperty("ramCacheSize", performanceSettings.ramCacheSize);
     performanceObj->setProperty("processingThreads", performanceSettings.processingThreads);
     performanceObj->setProperty("pluginThreadPool", performanceSettings.pluginThreadPool);
+    performanceObj->setProperty("realtimeOversampling", performanceSettings.realtimeOversampling);
+    performanceObj->setProperty("offlineOversampling", performanceSettings.offlineOversampling);
     performanceObj->setProperty("realTimeProcessing", performanceSettings.realTimeProcessing);
     performanceObj->setProperty("useMMCSS", performanceSettings.useMMCSS);
     performanceObj->setProperty("guardAgainstDenormals", performanceSettings.guardAgainstDenormals);
@@ -295,8 +315,21 @@ void Configuration::saveToFile() {
     recordingObj->setProperty("createTakeFolder", recordingSettings.createTakeFolder);
     recordingObj->setProperty("autoQuantize", recordingSettings.autoQuantize);
     recordingObj->setProperty("autoQuantizeAmount", recordingSettings.autoQuantizeAmount);
+    recordingObj->setProperty("lowLatencyMonitoring", recordingSettings.lowLatencyMonitoring);
+    recordingObj->setProperty("lowLatencyThreshold", recordingSettings.lowLatencyThreshold);
     json->setProperty("recording", recordingObj);
     
+    // Metronome settings
+    auto metronomeObj = new juce::DynamicObject();
+    metronomeObj->setProperty("enabled", metronomeSettings.enabled);
+    metronomeObj->setProperty("onlyWhileRecording", metronomeSettings.onlyWhileRecording);
+    metronomeObj->setProperty("level", metronomeSettings.level);
+    metronomeObj->setProperty("accentDownbeat", metronomeSettings.accentDownbeat);
+    metronomeObj->setProperty("outputChannel", metronomeSettings.outputChannel);
+    metronomeObj->setProperty("clickSample", metronomeSettings.clickSample);
+    metronomeObj->setProperty("accentSample", metronomeSettings.accentSample);
+    json->setProperty("metronome", metronomeObj);
+    
     // Export settings
     auto exportObj = new juce::DynamicObject();
     exportObj->setProperty("defaultFormat", exportSettings.defaultFormat);
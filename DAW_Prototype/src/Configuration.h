@@ -26,6 +26,8 @@ public:
         int mtcFormat{0};
         bool sendMMC{false};
         bool receiveMMC{false};
+        int syncSource{0};  // 0 = internal, 1 = MIDI clock, 2 = MTC
+        juce::String syncOutputDevice;  // Clock, MTC and MMC go here
         float velocityScale{1.0f};
         float velocityOffset{0.0f};
     };
@@ -97,6 +99,8 @@ public:
         int ramCacheSize{512};
         int processingThreads{0};
         int pluginThreadPool{4};
+        int realtimeOversampling{2};   // Default factor for nonlinear internal plugins
+        int offlineOversampling{8};    // Used instead while rendering offline
         bool realTimeProcessing{true};
         bool useMMCSS{true};
         bool guardAgainstDenormals{true};
@@ -116,6 +120,19 @@ public:
         bool createTakeFolder{true};
         bool autoQuantize{false};
         float autoQuantizeAmount{0.5f};
+        bool lowLatencyMonitoring{false};  // Bypass high-latency plugins on monitored tracks
+        int lowLatencyThreshold{128};      // Samples
+    };
+
+    // Metronome settings
+    struct MetronomeSettings {
+        bool enabled{false};
+        bool onlyWhileRecording{false};
+        float level{0.7f};
+        bool accentDownbeat{true};
+        int outputChannel{0};  // First channel of the output pair
+        juce::String clickSample;   // Empty = built-in click
+        juce::String accentSample;
     };
 
     // Export settings
@@ -145,6 +162,7 @@ public:
     PluginSettings& getPluginSettings() { return pluginSettings; }
     PerformanceSettings& getPerformanceSettings() { return performanceSettings; }
     RecordingSettings& getRecordingSettings() { return recordingSettings; }
+    MetronomeSettings& getMetronomeSettings() { return metronomeSettings; }
     ExportSettings& getExportSettings() { return exportSettings; }
 
     const AudioSettings& getAudioSettings() const { return audioSettings; }
@@ -153,6 +171,7 @@ public:
     const PluginSettings& getPluginSettings() const { return pluginSettings; }
     const PerformanceSettings& getPerformanceSettings() const { return performanceSettings; }
     const RecordingSettings& getRecordingSettings() const { return recordingSettings; }
+    const MetronomeSettings& getMetronomeSettings() const { return metronomeSettings; }
     const ExportSettings& getExportSettings() const { return exportSettings; }
 
     // File operations
@@ -173,6 +192,7 @@ private:
     PluginSettings pluginSettings;
     PerformanceSettings performanceSettings;
     RecordingSettings recordingSettings;
+    MetronomeSettings metronomeSettings;
     ExportSettings exportSettings;
 
     void loadDefaults();
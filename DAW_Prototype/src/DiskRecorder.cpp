@@ -0,0 +1,447 @@
+#include "DiskRecorder.h"
+#include "Track.h"
+#include "Configuration.h"
+#include "Logger.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+namespace {
+    constexpr double fifoSeconds = 4.0;            // Per stream, absorbs disk stalls
+    constexpr int writeChunkSamples = 32768;       // Minimum write, keeps I/O sequential
+    constexpr size_t outputBufferBytes = 1 << 20;  // FileOutputStream buffer
+    constexpr double reserveSeconds = 60.0;        // Preallocation step
+    constexpr int writerIntervalMs = 10;
+}
+
+//==============================================================================
+// DiskRecorder::Stream Implementation
+//==============================================================================
+
+DiskRecorder::Stream::Stream(const juce::String& id, int channel, int fifoSize)
+    : trackID(id),
+      inputChannel(channel),
+      fifo(fifoSize),
+      fifoBuffer(1, fifoSize) {
+    fifoBuffer.clear();
+}
+
+void DiskRecorder::Stream::push(const float* data, int numSamples, int64_t timelinePosition) noexcept {
+    // Any jump in the timeline starts a new take in the same file
+    if (timelinePosition != nextPosition) {
+        const int take = numTakes.load(std::memory_order_relaxed);
+        if (take < maxTakes) {
+            takeMarkers[static_cast<size_t>(take)] = { samplesPushed, timelinePosition };
+            numTakes.store(take + 1, std::memory_order_release);
+        }
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    auto* dest = fifoBuffer.getWritePointer(0);
+    if (data != nullptr) {
+        juce::FloatVectorOperations::copy(dest + start1, data, size1);
+        juce::FloatVectorOperations::copy(dest + start2, data + size1, size2);
+    } else {
+        juce::FloatVectorOperations::clear(dest + start1, size1);
+        juce::FloatVectorOperations::clear(dest + start2, size2);
+    }
+
+    fifo.finishedWrite(size1 + size2);
+
+    // Dropped samples never reach the file, so the next push starts a new
+    // take rather than shifting everything after the gap
+    const int accepted = size1 + size2;
+    samplesPushed += accepted;
+    nextPosition = timelinePosition + accepted;
+
+    if (accepted < numSamples) {
+        droppedSamples.fetch_add(numSamples - accepted, std::memory_order_relaxed);
+    }
+
+    const int used = fifo.getNumReady();
+    if (used > highWater.load(std::memory_order_relaxed)) {
+        highWater.store(used, std::memory_order_relaxed);
+    }
+}
+
+int64_t DiskRecorder::Stream::getStartPosition() const {
+    return getNumTakes() > 0 ? takeMarkers[0].timelinePosition : -1;
+}
+
+float DiskRecorder::Stream::getHighWaterMark() const {
+    return static_cast<float>(highWater.load()) / static_cast<float>(fifo.getTotalSize());
+}
+
+//==============================================================================
+// DiskRecorder::Session Implementation
+//==============================================================================
+
+void DiskRecorder::Session::push(const float* const* inputChannelData, int numInputChannels,
+                                 int startSample, int numSamples, int64_t timelinePosition) noexcept {
+    if (!accepting.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    for (auto& stream : streams) {
+        const int channel = stream->getInputChannel();
+        const float* data = channel < numInputChannels && inputChannelData[channel] != nullptr
+                          ? inputChannelData[channel] + startSample
+                          : nullptr;
+        stream->push(data, numSamples, timelinePosition);
+    }
+}
+
+//==============================================================================
+// DiskRecorder Implementation
+//==============================================================================
+
+DiskRecorder::DiskRecorder()
+    : juce::Thread("Disk Recorder") {
+    startThread();
+}
+
+DiskRecorder::~DiskRecorder() {
+    stop();
+    stopThread(5000);
+
+    // The audio thread is gone by now, so flush whatever is left
+    const juce::ScopedLock sl(sessionLock);
+    for (auto& session : stoppingSessions) {
+        finishSession(*session);
+    }
+    stoppingSessions.clear();
+}
+
+std::shared_ptr<DiskRecorder::Session> DiskRecorder::start(const juce::OwnedArray<Track>& tracks,
+                                                           double sampleRate,
+                                                           const juce::File& directory) {
+    stop();
+
+    if (!directory.createDirectory()) {
+        LOG_ERROR("Cannot create recording folder %s", directory.getFullPathName().toRawUTF8());
+        return nullptr;
+    }
+
+    const auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+    const auto extension = DiskRecorderUtils::getFileExtension(recordingSettings.recordFileFormat);
+    const auto timestamp = juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S");
+    const int fifoSize = static_cast<int>(sampleRate * fifoSeconds);
+
+    auto session = std::make_shared<Session>(sampleRate);
+
+    for (auto* track : tracks) {
+        const auto& parameters = track->getParameters();
+        if (track->getType() != Track::Type::Audio || !parameters.record) {
+            continue;
+        }
+
+        auto stream = std::make_unique<Stream>(track->getID(),
+                                               juce::jmax(0, parameters.input.channel - 1),
+                                               fifoSize);
+
+        const auto name = juce::File::createLegalFileName(track->getName() + " " + timestamp);
+        stream->file = directory.getNonexistentChildFile(name, extension, false);
+        stream->writer = createWriter(stream->file, sampleRate, stream->bytesPerSample);
+
+        if (stream->writer == nullptr) {
+            LOG_ERROR("Cannot open %s for recording", stream->file.getFullPathName().toRawUTF8());
+            continue;
+        }
+
+        stream->samplesReserved = static_cast<int64_t>(sampleRate * reserveSeconds);
+        DiskRecorderUtils::preallocate(stream->file, 0,
+                                       stream->samplesReserved * stream->bytesPerSample);
+
+        session->streams.push_back(std::move(stream));
+    }
+
+    if (session->streams.empty()) {
+        return nullptr;
+    }
+
+    LOG_INFO("Recording %d input(s) to %s",
+             static_cast<int>(session->streams.size()), directory.getFullPathName().toRawUTF8());
+
+    const juce::ScopedLock sl(sessionLock);
+    activeSession = session;
+    return session;
+}
+
+void DiskRecorder::stop() {
+    const juce::ScopedLock sl(sessionLock);
+
+    if (activeSession != nullptr) {
+        activeSession->accepting = false;
+        stoppingSessions.push_back(std::move(activeSession));
+    }
+}
+
+bool DiskRecorder::isRecording() const {
+    const juce::ScopedLock sl(sessionLock);
+    return activeSession != nullptr;
+}
+
+std::vector<DiskRecorder::Take> DiskRecorder::popFinishedTakes() {
+    const juce::ScopedLock sl(takeLock);
+    std::vector<Take> takes;
+    takes.swap(finishedTakes);
+    return takes;
+}
+
+std::vector<DiskRecorder::StreamStats> DiskRecorder::getStats() const {
+    std::vector<StreamStats> stats;
+
+    const juce::ScopedLock sl(sessionLock);
+    if (activeSession != nullptr) {
+        for (const auto& stream : activeSession->streams) {
+            stats.push_back({ stream->getTrackID(),
+                              stream->getHighWaterMark(),
+                              stream->getNumDroppedSamples() });
+        }
+    }
+
+    return stats;
+}
+
+bool DiskRecorder::writeStream(Stream& stream, bool flush) {
+    const int numReady = stream.fifo.getNumReady();
+    if (numReady == 0 || (!flush && numReady < writeChunkSamples)) {
+        return false;
+    }
+
+    // Grow the reservation well ahead of the write position
+    if (stream.samplesWritten + numReady > stream.samplesReserved) {
+        const auto step = static_cast<int64_t>(stream.writer->getSampleRate() * reserveSeconds);
+        DiskRecorderUtils::preallocate(stream.file,
+                                       stream.samplesReserved * stream.bytesPerSample,
+                                       step * stream.bytesPerSample);
+        stream.samplesReserved += step;
+    }
+
+    int start1, size1, start2, size2;
+    stream.fifo.prepareToRead(numReady, start1, size1, start2, size2);
+
+    bool ok = stream.writer->writeFromAudioSampleBuffer(stream.fifoBuffer, start1, size1);
+    if (size2 > 0) {
+        ok = stream.writer->writeFromAudioSampleBuffer(stream.fifoBuffer, start2, size2) && ok;
+    }
+
+    stream.fifo.finishedRead(size1 + size2);
+    stream.samplesWritten += size1 + size2;
+
+    if (!ok) {
+        LOG_ERROR("Write failed while recording %s", stream.file.getFullPathName().toRawUTF8());
+    }
+
+    return true;
+}
+
+void DiskRecorder::finishSession(Session& session) {
+    std::vector<Take> takes;
+
+    for (auto& stream : session.streams) {
+        while (writeStream(*stream, true)) {}
+        stream->writer.reset();  // Writes the header and closes the file
+
+        LOG_INFO("Recorded %s: %lld samples, FIFO high water %.0f%%, %lld dropped",
+                 stream->file.getFileName().toRawUTF8(),
+                 static_cast<long long>(stream->samplesWritten),
+                 stream->getHighWaterMark() * 100.0f,
+                 static_cast<long long>(stream->getNumDroppedSamples()));
+
+        if (stream->samplesWritten == 0) {
+            stream->file.deleteFile();
+            continue;
+        }
+
+        const int numTakes = stream->getNumTakes();
+        for (int i = 0; i < numTakes; ++i) {
+            const auto& marker = stream->takeMarkers[static_cast<size_t>(i)];
+            const int64_t end = i + 1 < numTakes
+                              ? stream->takeMarkers[static_cast<size_t>(i + 1)].fileOffset
+                              : stream->samplesWritten;
+
+            Take take;
+            take.trackID = stream->getTrackID();
+            take.file = stream->file;
+            take.fileOffset = marker.fileOffset;
+            take.startPosition = marker.timelinePosition;
+            take.length = end - marker.fileOffset;
+            take.sampleRate = session.getSampleRate();
+            take.takeIndex = i;
+            take.numTakes = numTakes;
+
+            if (take.length > 0) {
+                takes.push_back(std::move(take));
+            }
+        }
+    }
+
+    if (!takes.empty()) {
+        {
+            const juce::ScopedLock sl(takeLock);
+            for (auto& take : takes) {
+                finishedTakes.push_back(std::move(take));
+            }
+        }
+        sendChangeMessage();
+    }
+}
+
+void DiskRecorder::run() {
+    std::vector<std::shared_ptr<Session>> sessions;
+    std::vector<std::shared_ptr<Session>> released;
+
+    while (!threadShouldExit()) {
+        {
+            const juce::ScopedLock sl(sessionLock);
+            sessions.clear();
+            if (activeSession != nullptr) {
+                sessions.push_back(activeSession);
+            }
+
+            // A stopped session nobody else references has left every
+            // published render model, so its FIFOs can be flushed
+            for (auto it = stoppingSessions.begin(); it != stoppingSessions.end();) {
+                if (it->use_count() == 1) {
+                    released.push_back(std::move(*it));
+                    it = stoppingSessions.erase(it);
+                } else {
+                    sessions.push_back(*it);
+                    ++it;
+                }
+            }
+        }
+
+        for (auto& session : released) {
+            finishSession(*session);
+        }
+        released.clear();
+
+        bool wroteAnything = false;
+        for (auto& session : sessions) {
+            for (auto& stream : session->streams) {
+                wroteAnything = writeStream(*stream, false) || wroteAnything;
+            }
+        }
+        sessions.clear();
+
+        if (!wroteAnything) {
+            wait(writerIntervalMs);
+        }
+    }
+}
+
+std::unique_ptr<juce::AudioFormatWriter> DiskRecorder::createWriter(const juce::File& file,
+                                                                    double sampleRate,
+                                                                    int& bytesPerSample) {
+    const auto& recordingSettings = Configuration::getInstance().getRecordingSettings();
+
+    std::unique_ptr<juce::AudioFormat> format;
+   #if JUCE_MAC
+    if (recordingSettings.recordFileFormat.equalsIgnoreCase("caf")) {
+        format = std::make_unique<juce::CoreAudioFormat>();
+    }
+   #endif
+    if (format == nullptr && recordingSettings.recordFileFormat.startsWithIgnoreCase("aif")) {
+        format = std::make_unique<juce::AiffAudioFormat>();
+    }
+    if (format == nullptr) {
+        format = std::make_unique<juce::WavAudioFormat>();
+    }
+
+    int bitDepth = recordingSettings.recordBitDepth;
+    if (!format->getPossibleBitDepths().contains(bitDepth)) {
+        LOG_WARNING("%s does not support %d-bit recording, using 24-bit",
+                    format->getFormatName().toRawUTF8(), bitDepth);
+        bitDepth = 24;
+    }
+    bytesPerSample = bitDepth / 8;
+
+    file.deleteFile();
+    auto output = std::make_unique<juce::FileOutputStream>(file, outputBufferBytes);
+    if (output->failedToOpen()) {
+        return nullptr;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer(
+        format->createWriterFor(output.get(), sampleRate, 1,
+                                bitDepth, {}, 0));
+    if (writer != nullptr) {
+        output.release();  // Owned by the writer now
+    }
+
+    return writer;
+}
+
+//==============================================================================
+// DiskRecorderUtils Implementation
+//==============================================================================
+
+namespace DiskRecorderUtils {
+    bool preallocate(const juce::File& file, int64_t offset, int64_t numBytes) {
+        if (numBytes <= 0) {
+            return true;
+        }
+
+       #if JUCE_LINUX
+        const int fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY);
+        if (fd < 0) {
+            return false;
+        }
+        const bool ok = ::fallocate(fd, FALLOC_FL_KEEP_SIZE,
+                                    static_cast<off_t>(offset),
+                                    static_cast<off_t>(numBytes)) == 0;
+        ::close(fd);
+        return ok;
+       #elif JUCE_MAC
+        // F_PREALLOCATE always extends from the end of the allocation
+        juce::ignoreUnused(offset);
+        const int fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY);
+        if (fd < 0) {
+            return false;
+        }
+        fstore_t store{ F_ALLOCATECONTIG, F_PEOFPOSMODE, 0, static_cast<off_t>(numBytes), 0 };
+        bool ok = ::fcntl(fd, F_PREALLOCATE, &store) != -1;
+        if (!ok) {
+            store.fst_flags = F_ALLOCATEALL;
+            ok = ::fcntl(fd, F_PREALLOCATE, &store) != -1;
+        }
+        ::close(fd);
+        return ok;
+       #else
+        juce::ignoreUnused(file, offset, numBytes);
+        return false;
+       #endif
+    }
+
+    juce::File getRecordingDirectory(const juce::File& projectFile) {
+        const auto& path = Configuration::getInstance().getRecordingSettings().recordingPath;
+        if (path.isNotEmpty() && juce::File::isAbsolutePath(path)) {
+            return juce::File(path);
+        }
+
+        if (projectFile != juce::File()) {
+            return projectFile.getParentDirectory().getChildFile("Audio");
+        }
+
+        return juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                   .getChildFile("DAW Recordings");
+    }
+
+    juce::String getFileExtension(const juce::String& format) {
+       #if JUCE_MAC
+        if (format.equalsIgnoreCase("caf")) {
+            return ".caf";
+        }
+       #endif
+        if (format.startsWithIgnoreCase("aif")) {
+            return ".aiff";
+        }
+        return ".wav";
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class Track;
+
+// Streams armed inputs to disk from the audio thread.
+//
+// Each armed track gets a Stream with its own lock-free FIFO. The audio
+// thread only copies input into the FIFOs; a single writer thread drains
+// them in large chunks into buffered, preallocated files. A Session is
+// handed to the audio thread through the RenderModel, and the writer
+// closes its files once no published model references it any more, so
+// stopping never blocks the callback or loses the final block.
+//
+// A stream writes one continuous file for the whole record pass. Every
+// discontinuity in the timeline (a loop wrap, a punch gap, a locate) starts
+// a new take, recorded as a marker into the file. Loop recording therefore
+// never opens or closes files, and choosing between takes only changes
+// clip metadata.
+class DiskRecorder : public juce::ChangeBroadcaster,
+                     private juce::Thread {
+public:
+    // One armed input recording into one file
+    class Stream {
+    public:
+        Stream(const juce::String& trackID, int inputChannel, int fifoSize);
+
+        const juce::String& getTrackID() const { return trackID; }
+        int getInputChannel() const { return inputChannel; }  // Zero-based
+
+        // Audio thread. data may be nullptr to record silence.
+        void push(const float* data, int numSamples, int64_t timelinePosition) noexcept;
+
+        // Any thread
+        int64_t getStartPosition() const;  // -1 until the first push
+        int getNumTakes() const { return numTakes.load(std::memory_order_acquire); }
+        float getHighWaterMark() const;  // Peak FIFO fill, 0..1
+        int64_t getNumDroppedSamples() const { return droppedSamples.load(); }
+
+    private:
+        friend class DiskRecorder;
+
+        // Where a take starts, in the file and on the timeline
+        struct TakeMarker {
+            int64_t fileOffset{0};
+            int64_t timelinePosition{0};
+        };
+
+        static constexpr int maxTakes = 256;  // Later passes extend the last take
+
+        juce::String trackID;
+        int inputChannel;
+
+        juce::AbstractFifo fifo;
+        juce::AudioBuffer<float> fifoBuffer;
+
+        // Written by the audio thread, published through numTakes
+        std::array<TakeMarker, maxTakes> takeMarkers;
+        std::atomic<int> numTakes{0};
+        int64_t samplesPushed{0};
+        int64_t nextPosition{-1};
+
+        std::atomic<int> highWater{0};
+        std::atomic<int64_t> droppedSamples{0};
+
+        // Writer thread
+        juce::File file;
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        int64_t samplesWritten{0};
+        int64_t samplesReserved{0};
+        int bytesPerSample{4};
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Stream)
+    };
+
+    // Every stream of one record pass
+    class Session {
+    public:
+        explicit Session(double sampleRate) : sampleRate(sampleRate) {}
+
+        // Audio thread: copies one transport segment of device input
+        void push(const float* const* inputChannelData, int numInputChannels,
+                  int startSample, int numSamples, int64_t timelinePosition) noexcept;
+
+        double getSampleRate() const { return sampleRate; }
+        const std::vector<std::unique_ptr<Stream>>& getStreams() const { return streams; }
+
+    private:
+        friend class DiskRecorder;
+
+        double sampleRate;
+        std::vector<std::unique_ptr<Stream>> streams;
+        std::atomic<bool> accepting{true};
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Session)
+    };
+
+    // One take of a finished recording, ready to become a clip. Takes of
+    // the same stream share a file.
+    struct Take {
+        juce::String trackID;
+        juce::File file;
+        int64_t fileOffset{0};
+        int64_t startPosition{0};
+        int64_t length{0};
+        double sampleRate{44100.0};
+        int takeIndex{0};
+        int numTakes{1};
+    };
+
+    // Per-stream diagnostics
+    struct StreamStats {
+        juce::String trackID;
+        float highWaterMark{0.0f};
+        int64_t droppedSamples{0};
+    };
+
+    // Constructor/Destructor
+    DiskRecorder();
+    ~DiskRecorder() override;
+
+    // Message thread. Opens one file per armed audio track and returns the
+    // session to publish to the audio thread, or nullptr if none is armed.
+    std::shared_ptr<Session> start(const juce::OwnedArray<Track>& tracks,
+                                   double sampleRate,
+                                   const juce::File& directory);
+
+    // Stops accepting input. Files are closed, and a change message sent,
+    // once the audio thread can no longer see the session.
+    void stop();
+    bool isRecording() const;
+
+    // Message thread, after a change message
+    std::vector<Take> popFinishedTakes();
+    std::vector<StreamStats> getStats() const;
+
+private:
+    mutable juce::CriticalSection sessionLock;
+    std::shared_ptr<Session> activeSession;
+    std::vector<std::shared_ptr<Session>> stoppingSessions;
+
+    juce::CriticalSection takeLock;
+    std::vector<Take> finishedTakes;
+
+    bool writeStream(Stream& stream, bool flush);
+    void finishSession(Session& session);
+    void run() override;
+
+    static std::unique_ptr<juce::AudioFormatWriter> createWriter(const juce::File& file,
+                                                                 double sampleRate,
+                                                                 int& bytesPerSample);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DiskRecorder)
+};
+
+// Disk recording utilities
+namespace DiskRecorderUtils {
+    // Reserves disk space for a file without changing its length, so a long
+    // recording is laid out contiguously. Returns false where unsupported.
+    bool preallocate(const juce::File& file, int64_t offset, int64_t numBytes);
+
+    // Recording folder from the settings, or next to the project file
+    juce::File getRecordingDirectory(const juce::File& projectFile);
+
+    juce::String getFileExtension(const juce::String& format);
+}
@@ -0,0 +1,293 @@
+#include "HostedPlugin.h"
+#include "Logger.h"
+
+//==============================================================================
+// HostedPlugin Implementation
+//==============================================================================
+
+HostedPlugin::HostedPlugin(Track& track,
+                           std::unique_ptr<juce::AudioPluginInstance> pluginInstance,
+                           Type pluginType)
+    : Plugin(track)
+    , instance(std::move(pluginInstance)) {
+    jassert(instance != nullptr);
+    format.type = pluginType;
+    updateFormat();
+}
+
+HostedPlugin::~HostedPlugin() {
+    releaseResources();
+}
+
+void HostedPlugin::saveState(juce::MemoryBlock& destData) const {
+    instance->getStateInformation(destData);
+}
+
+void HostedPlugin::loadState(const void* data, size_t sizeInBytes) {
+    instance->setStateInformation(data, static_cast<int>(sizeInBytes));
+    sendChangeMessage();
+}
+
+void HostedPlugin::savePreset(const juce::File& file) const {
+    juce::MemoryBlock data;
+    saveState(data);
+
+    if (!file.replaceWithData(data.getData(), data.getSize())) {
+        LOG_ERROR("Failed to save preset for %s: %s", getName().toRawUTF8(), file.getFullPathName().toRawUTF8());
+    }
+}
+
+void HostedPlugin::loadPreset(const juce::File& file) {
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data)) {
+        LOG_ERROR("Failed to load preset for %s: %s", getName().toRawUTF8(), file.getFullPathName().toRawUTF8());
+        return;
+    }
+
+    loadState(data.getData(), data.getSize());
+}
+
+juce::StringArray HostedPlugin::getPresetNames() const {
+    juce::StringArray names;
+    for (int i = 0; i < getNumPrograms(); ++i) {
+        names.add(getProgramName(i));
+    }
+    return names;
+}
+
+float HostedPlugin::getParameter(int index) const {
+    if (auto* parameter = format.parameters[index]) {
+        return parameter->getValue();
+    }
+    return 0.0f;
+}
+
+void HostedPlugin::setParameter(int index, float value) {
+    if (auto* parameter = format.parameters[index]) {
+        parameter->setValue(juce::jlimit(0.0f, 1.0f, value));
+    }
+}
+
+juce::String HostedPlugin::getParameterName(int index) const {
+    if (auto* parameter = format.parameters[index]) {
+        return parameter->getName(128);
+    }
+    return {};
+}
+
+juce::String HostedPlugin::getParameterText(int index) const {
+    if (auto* parameter = format.parameters[index]) {
+        return parameter->getCurrentValueAsText();
+    }
+    return {};
+}
+
+juce::NormalisableRange<float> HostedPlugin::getParameterRange(int index) const {
+    // Hosted parameters are always exposed normalised
+    juce::ignoreUnused(index);
+    return { 0.0f, 1.0f };
+}
+
+void HostedPlugin::setCurrentProgram(int index) {
+    if (juce::isPositiveAndBelow(index, getNumPrograms())) {
+        instance->setCurrentProgram(index);
+        sendChangeMessage();
+    }
+}
+
+void HostedPlugin::handleNonRealtimeChange() {
+    // Plugins pick their own offline quality, e.g. higher oversampling
+    instance->setNonRealtime(nonRealtime);
+}
+
+void HostedPlugin::setNumChannels(int newNumChannels) {
+    if (numChannels == newNumChannels) {
+        return;
+    }
+
+    numChannels = newNumChannels;
+
+    // The bus layout can only change while released
+    if (prepared) {
+        const double sampleRate = preparedSampleRate;
+        const int blockSize = maxBlockSize;
+        releaseResources();
+        prepareToPlay(sampleRate, blockSize);
+    }
+}
+
+void HostedPlugin::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) {
+    if (prepared && sampleRate == preparedSampleRate && maximumExpectedSamplesPerBlock == maxBlockSize) {
+        return;
+    }
+
+    releaseResources();
+
+    if (!configureBuses()) {
+        LOG_WARNING("Plugin %s does not support %d channels; using its default layout",
+                    getName().toRawUTF8(), numChannels);
+    }
+
+    instance->setRateAndBufferSizeDetails(sampleRate, maximumExpectedSamplesPerBlock);
+    instance->prepareToPlay(sampleRate, maximumExpectedSamplesPerBlock);
+
+    preparedSampleRate = sampleRate;
+    maxBlockSize = maximumExpectedSamplesPerBlock;
+
+    // Everything processBlock() may need, so it never allocates
+    const int pluginChannels = juce::jmax(instance->getTotalNumInputChannels(),
+                                          instance->getTotalNumOutputChannels());
+    scratchBuffer.setSize(juce::jmax(1, pluginChannels), maxBlockSize, false, false, true);
+    chunkMidi.ensureSize(midiBufferBytes);
+    outputMidi.ensureSize(midiBufferBytes);
+
+    updateFormat();
+    prepared = true;
+
+    LOG_INFO("Prepared plugin %s: %d in, %d out, %.0f Hz, %d samples, %d samples latency",
+             getName().toRawUTF8(), format.numInputChannels, format.numOutputChannels,
+             sampleRate, maxBlockSize, getLatencySamples());
+}
+
+void HostedPlugin::releaseResources() {
+    if (prepared) {
+        instance->releaseResources();
+        prepared = false;
+    }
+}
+
+void HostedPlugin::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    if (!prepared || !enabled) {
+        return;
+    }
+
+    const int numSamples = buffer.getNumSamples();
+    if (numSamples <= maxBlockSize) {
+        processChunk(buffer, 0, numSamples, midiMessages);
+        return;
+    }
+
+    // Longer than prepared for: split it, keeping each MIDI event with the
+    // chunk it falls in
+    outputMidi.clear();
+    for (int startSample = 0; startSample < numSamples; startSample += maxBlockSize) {
+        const int chunkSamples = juce::jmin(maxBlockSize, numSamples - startSample);
+
+        chunkMidi.clear();
+        chunkMidi.addEvents(midiMessages, startSample, chunkSamples, -startSample);
+        processChunk(buffer, startSample, chunkSamples, chunkMidi);
+        outputMidi.addEvents(chunkMidi, 0, chunkSamples, startSample);
+    }
+    midiMessages.swapWith(outputMidi);
+}
+
+void HostedPlugin::processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                juce::MidiBuffer& midiMessages) {
+    const int numInputs = instance->getTotalNumInputChannels();
+    const int mainInputs = instance->getMainBusNumInputChannels();
+    const int numOutputs = instance->getTotalNumOutputChannels();
+    const int pluginChannels = juce::jmax(numInputs, numOutputs);
+    const int bufferChannels = buffer.getNumChannels();
+
+    if (pluginChannels <= bufferChannels && sidechainChannels == 0) {
+        // Process in place through a view of the caller's channels
+        juce::AudioBuffer<float> view(buffer.getArrayOfWritePointers(), pluginChannels,
+                                      startSample, numSamples);
+        instance->processBlock(view, midiMessages);
+
+        // A mono plugin on a wider channel feeds all of it
+        for (int channel = numOutputs; numOutputs > 0 && channel < bufferChannels; ++channel) {
+            buffer.copyFrom(channel, startSample, buffer, numOutputs - 1, startSample, numSamples);
+        }
+        return;
+    }
+
+    // The plugin's buses are wider than the buffer, or include the
+    // sidechain: go through the scratch buffer, repeating the last input
+    // channel. Input channels follow bus order, main bus first.
+    const auto& key = getSidechainInput();
+    const int keyChannels = static_cast<int>(key.getNumChannels());
+    const bool keyed = keyChannels > 0 && key.getNumSamples() >= static_cast<size_t>(startSample + numSamples);
+
+    for (int channel = 0; channel < pluginChannels; ++channel) {
+        if (channel < mainInputs && bufferChannels > 0) {
+            scratchBuffer.copyFrom(channel, 0, buffer, juce::jmin(channel, bufferChannels - 1),
+                                   startSample, numSamples);
+        } else if (channel < numInputs && keyed) {
+            const int keyChannel = juce::jmin(channel - mainInputs, keyChannels - 1);
+            scratchBuffer.copyFrom(channel, 0, key.getChannelPointer(static_cast<size_t>(keyChannel)) + startSample,
+                                   numSamples);
+        } else {
+            scratchBuffer.clear(channel, 0, numSamples);
+        }
+    }
+
+    juce::AudioBuffer<float> view(scratchBuffer.getArrayOfWritePointers(), pluginChannels, 0, numSamples);
+    instance->processBlock(view, midiMessages);
+
+    for (int channel = 0; channel < bufferChannels && numOutputs > 0; ++channel) {
+        buffer.copyFrom(channel, startSample, scratchBuffer, juce::jmin(channel, numOutputs - 1),
+                        0, numSamples);
+    }
+}
+
+bool HostedPlugin::configureBuses() {
+    const auto channelSet = juce::AudioChannelSet::canonicalChannelSet(numChannels);
+
+    // Main buses match the mixer channel; other auxiliary buses are not routed
+    auto layout = instance->getBusesLayout();
+    for (int i = 0; i < layout.inputBuses.size(); ++i) {
+        layout.inputBuses.getReference(i) = i == 0 ? channelSet : juce::AudioChannelSet::disabled();
+    }
+    for (int i = 0; i < layout.outputBuses.size(); ++i) {
+        layout.outputBuses.getReference(i) = i == 0 ? channelSet : juce::AudioChannelSet::disabled();
+    }
+
+    // The first auxiliary input is the sidechain, in the channel's width or mono
+    if (layout.inputBuses.size() > 1) {
+        for (const auto& keySet : { channelSet, juce::AudioChannelSet::mono() }) {
+            auto keyed = layout;
+            keyed.inputBuses.getReference(1) = keySet;
+            if (instance->setBusesLayout(keyed)) {
+                return true;
+            }
+        }
+    }
+
+    if (instance->setBusesLayout(layout)) {
+        return true;
+    }
+
+    // Instruments may refuse an input bus
+    if (!layout.inputBuses.isEmpty()) {
+        layout.inputBuses.getReference(0) = juce::AudioChannelSet::disabled();
+        if (instance->setBusesLayout(layout)) {
+            return true;
+        }
+    }
+
+    // Keep the plugin's own main layout and only switch off the rest
+    layout = instance->getBusesLayout();
+    for (int i = 1; i < layout.inputBuses.size(); ++i) {
+        layout.inputBuses.getReference(i) = juce::AudioChannelSet::disabled();
+    }
+    for (int i = 1; i < layout.outputBuses.size(); ++i) {
+        layout.outputBuses.getReference(i) = juce::AudioChannelSet::disabled();
+    }
+    instance->setBusesLayout(layout);
+    return false;
+}
+
+void HostedPlugin::updateFormat() {
+    const auto description = instance->getPluginDescription();
+
+    format.name = description.name;
+    format.manufacturer = description.manufacturerName;
+    format.version = description.version;
+    format.identifier = description.fileOrIdentifier;
+    format.isInstrument = description.isInstrument;
+    format.numInputChannels = instance->getTotalNumInputChannels();
+    format.numOutputChannels = instance->getTotalNumOutputChannels();
+    format.parameters = instance->getParameters();
+    sidechainChannels = instance->getBusCount(true) > 1 ? instance->getChannelCountOfBus(true, 1) : 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <JuceHeader.h>
+#include "Plugin.h"
+
+// A third-party VST3 or Audio Unit hosted through juce::AudioPluginInstance.
+//
+// The main buses are configured to match the mixer's channel buffers. The
+// first auxiliary input, if the plugin has one, carries the sidechain; any
+// other auxiliary buses are disabled. processBlock() accepts any block size and
+// channel count: blocks longer than the prepared maximum are split, and
+// buffers narrower than the plugin's buses are routed through a scratch
+// buffer allocated in prepareToPlay(). Nothing on the audio thread allocates.
+class HostedPlugin : public Plugin {
+public:
+    // Constructor/Destructor
+    HostedPlugin(Track& track,
+                 std::unique_ptr<juce::AudioPluginInstance> pluginInstance,
+                 Type pluginType);
+    ~HostedPlugin() override;
+
+    juce::AudioPluginInstance& getInstance() const { return *instance; }
+    bool isPrepared() const { return prepared; }
+
+    // Basic properties
+    const Format& getFormat() const override { return format; }
+    juce::String getName() const override { return instance->getName(); }
+
+    // GUI
+    bool hasEditor() const override { return instance->hasEditor(); }
+    juce::AudioProcessorEditor* createEditor() override { return instance->createEditorIfNeeded(); }
+
+    // State management
+    void saveState(juce::MemoryBlock& destData) const override;
+    void loadState(const void* data, size_t sizeInBytes) override;
+
+    // Preset management
+    void savePreset(const juce::File& file) const override;
+    void loadPreset(const juce::File& file) override;
+    juce::StringArray getPresetNames() const override;
+    void setCurrentPreset(int index) override { setCurrentProgram(index); }
+    int getCurrentPreset() const override { return getCurrentProgram(); }
+
+    // Parameter management
+    int getNumParameters() const override { return format.parameters.size(); }
+    float getParameter(int index) const override;
+    void setParameter(int index, float value) override;
+    juce::String getParameterName(int index) const override;
+    juce::String getParameterText(int index) const override;
+    juce::NormalisableRange<float> getParameterRange(int index) const override;
+
+    // Processing setup. Buffers passed to processBlock() are expected to
+    // have this many channels; others work, through a copy.
+    void setNumChannels(int numChannels);
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    // The sidechain bus is fed from the mixer's view through the scratch
+    // buffer, since plugins may write into their input buses
+    bool acceptsSidechain() const override { return sidechainChannels > 0; }
+
+    // Latency handling
+    int getLatencySamples() const override { return instance->getLatencySamples(); }
+    double getTailLengthSeconds() const override { return instance->getTailLengthSeconds(); }
+
+    // Program handling
+    int getNumPrograms() const override { return instance->getNumPrograms(); }
+    int getCurrentProgram() const override { return instance->getCurrentProgram(); }
+    void setCurrentProgram(int index) override;
+    juce::String getProgramName(int index) const override { return instance->getProgramName(index); }
+
+private:
+    static constexpr int midiBufferBytes = 4096;
+
+    std::unique_ptr<juce::AudioPluginInstance> instance;
+    Format format;
+
+    int numChannels{2};
+    int sidechainChannels{0};  // Enabled channels on input bus 1
+    double preparedSampleRate{0.0};
+    int maxBlockSize{0};
+    bool prepared{false};
+
+    // Preallocated in prepareToPlay()
+    juce::AudioBuffer<float> scratchBuffer;
+    juce::MidiBuffer chunkMidi;
+    juce::MidiBuffer outputMidi;
+
+    bool configureBuses();
+    void updateFormat();
+    void handleNonRealtimeChange() override;
+    void processChunk(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                      juce::MidiBuffer& midiMessages);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostedPlugin)
+};
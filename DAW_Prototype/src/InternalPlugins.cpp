@@ -0,0 +1,799 @@
+#include "InternalPlugins.h"
+#include "Logger.h"
+
+//==============================================================================
+// InternalPlugin Implementation
+//==============================================================================
+
+InternalPlugin::InternalPlugin(Track& track, const juce::String& name)
+    : Plugin(track) {
+    format.type = Type::Internal;
+    format.name = name;
+    format.manufacturer = "DAW_Prototype";
+    format.version = "1.0";
+    format.identifier = name;
+    format.isInstrument = false;
+    format.numInputChannels = maxChannels;
+    format.numOutputChannels = maxChannels;
+}
+
+InternalPlugin::~InternalPlugin() {
+    delete pendingProcessing.exchange(nullptr);
+    delete retiredProcessing.exchange(nullptr);
+}
+
+void InternalPlugin::saveState(juce::MemoryBlock& destData) const {
+    juce::ValueTree state("InternalPlugin");
+    state.setProperty("name", format.name, nullptr);
+    for (auto* parameter : ownedParameters) {
+        state.setProperty(parameter->paramID, parameter->get(), nullptr);
+    }
+
+    if (oversamplingSupported) {
+        state.appendChild(Oversampler::toValueTree(realtimeOversampling, "RealtimeOversampling"), nullptr);
+        state.appendChild(Oversampler::toValueTree(offlineOversampling, "OfflineOversampling"), nullptr);
+    }
+
+    juce::MemoryOutputStream stream(destData, false);
+    state.writeToStream(stream);
+}
+
+void InternalPlugin::loadState(const void* data, size_t sizeInBytes) {
+    const auto state = juce::ValueTree::readFromData(data, sizeInBytes);
+    if (!state.isValid()) {
+        LOG_WARNING("Invalid state for plugin %s", format.name.toRawUTF8());
+        return;
+    }
+
+    for (int i = 0; i < ownedParameters.size(); ++i) {
+        auto* parameter = ownedParameters[i];
+        if (state.hasProperty(parameter->paramID)) {
+            parameter->setValue(parameter->convertTo0to1(static_cast<float>(state.getProperty(parameter->paramID))));
+            parameterChanged(i);
+        }
+    }
+
+    if (oversamplingSupported) {
+        setOversampling(Oversampler::fromValueTree(state.getChildWithName("RealtimeOversampling"), realtimeOversampling),
+                        Oversampler::fromValueTree(state.getChildWithName("OfflineOversampling"), offlineOversampling));
+    }
+    sendChangeMessage();
+}
+
+void InternalPlugin::savePreset(const juce::File& file) const {
+    juce::MemoryBlock data;
+    saveState(data);
+
+    if (!file.replaceWithData(data.getData(), data.getSize())) {
+        LOG_ERROR("Failed to save preset for %s: %s", format.name.toRawUTF8(), file.getFullPathName().toRawUTF8());
+    }
+}
+
+void InternalPlugin::loadPreset(const juce::File& file) {
+    juce::MemoryBlock data;
+    if (!file.loadFileAsData(data)) {
+        LOG_ERROR("Failed to load preset for %s: %s", format.name.toRawUTF8(), file.getFullPathName().toRawUTF8());
+        return;
+    }
+
+    loadState(data.getData(), data.getSize());
+}
+
+float InternalPlugin::getParameter(int index) const {
+    if (auto* parameter = ownedParameters[index]) {
+        return parameter->getValue();
+    }
+    return 0.0f;
+}
+
+void InternalPlugin::setParameter(int index, float value) {
+    if (auto* parameter = ownedParameters[index]) {
+        parameter->setValue(juce::jlimit(0.0f, 1.0f, value));
+        parameterChanged(index);
+    }
+}
+
+juce::String InternalPlugin::getParameterName(int index) const {
+    if (auto* parameter = ownedParameters[index]) {
+        return parameter->name;
+    }
+    return {};
+}
+
+juce::String InternalPlugin::getParameterText(int index) const {
+    if (auto* parameter = ownedParameters[index]) {
+        return parameter->getCurrentValueAsText() + (parameter->label.isNotEmpty() ? " " + parameter->label : "");
+    }
+    return {};
+}
+
+juce::NormalisableRange<float> InternalPlugin::getParameterRange(int index) const {
+    if (auto* parameter = ownedParameters[index]) {
+        return parameter->range;
+    }
+    return { 0.0f, 1.0f };
+}
+
+void InternalPlugin::prepareToPlay(double newSampleRate, int maximumExpectedSamplesPerBlock) {
+    sampleRate = newSampleRate;
+    maxBlockSize = maximumExpectedSamplesPerBlock;
+    prepareProcessing();
+}
+
+void InternalPlugin::releaseResources() {
+    prepared = false;
+}
+
+void InternalPlugin::setOversampling(const Oversampler::Settings& realtime, const Oversampler::Settings& offline) {
+    if (!oversamplingSupported || (realtime == realtimeOversampling && offline == offlineOversampling)) {
+        return;
+    }
+
+    realtimeOversampling = realtime;
+    offlineOversampling = offline;
+
+    if (prepared) {
+        prepareProcessing();
+    }
+    sendChangeMessage();
+}
+
+void InternalPlugin::enableOversampling() {
+    oversamplingSupported = true;
+    realtimeOversampling = Oversampler::getRealtimeDefault();
+    offlineOversampling = Oversampler::getOfflineDefault();
+}
+
+void InternalPlugin::enableSidechain() {
+    sidechainSupported = true;
+}
+
+void InternalPlugin::prepareProcessing() {
+    // Built beside the Processing that is playing, which is left alone
+    const auto settings = !oversamplingSupported ? Oversampler::Settings()
+                        : nonRealtime ? offlineOversampling
+                        : realtimeOversampling;
+
+    auto next = std::make_unique<Processing>();
+    next->maxBlockSize = maxBlockSize;
+    next->oversampler.prepare(maxChannels, maxBlockSize, settings);
+    if (sidechainSupported) {
+        next->sidechainOversampler.prepare(maxChannels, maxBlockSize, settings);
+    }
+
+    const int factor = next->oversampler.getFactor();
+    const double processingRate = sampleRate * factor;
+    next->state = prepare({ processingRate, static_cast<juce::uint32>(maxBlockSize * factor),
+                            static_cast<juce::uint32>(maxChannels) });
+    next->state->processingRate = processingRate;
+    next->state->oversamplingFactor = factor;
+
+    oversamplingFactor = factor;
+    oversamplingLatency = next->oversampler.getLatencySamples();
+
+    // Free what the audio thread has finished with, so it can take this one
+    // on its next block, then replace any that was never picked up
+    delete retiredProcessing.exchange(nullptr);
+    delete pendingProcessing.exchange(next.release());
+    prepared = true;
+}
+
+void InternalPlugin::handleNonRealtimeChange() {
+    // Offline render switches to the offline quality
+    if (prepared && oversamplingSupported && realtimeOversampling != offlineOversampling) {
+        prepareProcessing();
+    }
+}
+
+void InternalPlugin::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    juce::ignoreUnused(midiMessages);
+
+    // Take a newly prepared Processing between blocks, once the one it
+    // replaced last time has been freed
+    if (retiredProcessing.load() == nullptr) {
+        if (auto* incoming = pendingProcessing.exchange(nullptr)) {
+            retiredProcessing.store(processing.release());
+            processing.reset(incoming);
+        }
+    }
+
+    if (processing == nullptr || !prepared || !enabled) {
+        return;
+    }
+
+    auto& current = *processing;
+    const int blockSize = current.maxBlockSize;
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), maxChannels);
+    const int numSamples = buffer.getNumSamples();
+
+    // A sidechain shorter than the block cannot be lined up; ignore it
+    const auto& key = getSidechainInput();
+    const bool keyed = sidechainSupported && key.getNumChannels() > 0 &&
+                       key.getNumSamples() >= static_cast<size_t>(numSamples);
+    const size_t keyChannels = juce::jmin(key.getNumChannels(), static_cast<size_t>(maxChannels));
+
+    for (int startSample = 0; startSample < numSamples; startSample += blockSize) {
+        const int chunkSamples = juce::jmin(blockSize, numSamples - startSample);
+        juce::dsp::AudioBlock<float> block(buffer.getArrayOfWritePointers(),
+                                           static_cast<size_t>(numChannels),
+                                           static_cast<size_t>(startSample),
+                                           static_cast<size_t>(chunkSamples));
+
+        if (keyed) {
+            const auto keySlice = key.getSubsetChannelBlock(0, keyChannels)
+                                     .getSubBlock(static_cast<size_t>(startSample),
+                                                  static_cast<size_t>(chunkSamples));
+            sidechain = current.sidechainOversampler.upsample(keySlice);
+        }
+
+        auto processingBlock = current.oversampler.upsample(block);
+        process(*current.state, juce::dsp::ProcessContextReplacing<float>(processingBlock));
+        current.oversampler.downsample(block);
+    }
+
+    sidechain = {};
+}
+
+juce::AudioParameterFloat* InternalPlugin::addParameter(const juce::String& parameterID,
+                                                        const juce::String& parameterName,
+                                                        juce::NormalisableRange<float> range,
+                                                        float defaultValue) {
+    auto* parameter = ownedParameters.add(new juce::AudioParameterFloat(parameterID, parameterName,
+                                                                        range, defaultValue));
+    format.parameters.add(parameter);
+    return parameter;
+}
+
+//==============================================================================
+// GainPlugin Implementation
+//==============================================================================
+
+GainPlugin::GainPlugin(Track& track)
+    : InternalPlugin(track, "Gain") {
+    gainDb = addParameter("gain", "Gain", { -60.0f, 24.0f, 0.1f }, 0.0f);
+}
+
+std::unique_ptr<InternalPlugin::DSPState> GainPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    auto dsp = std::make_unique<DSP>();
+    dsp->gain.prepare(spec);
+    dsp->gain.setRampDurationSeconds(0.02);
+    dsp->gain.setGainDecibels(gainDb->get());
+    dsp->gain.reset();
+    return dsp;
+}
+
+void GainPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dsp = static_cast<DSP&>(state);
+
+    // Ramps when the value changes, a vector multiply otherwise
+    dsp.gain.setGainDecibels(gainDb->get());
+    dsp.gain.process(context);
+}
+
+//==============================================================================
+// DelayPlugin Implementation
+//==============================================================================
+
+DelayPlugin::DelayPlugin(Track& track)
+    : InternalPlugin(track, "Delay") {
+    for (int i = 0; i < numTaps; ++i) {
+        const juce::String number(i + 1);
+        taps[i].timeMs = addParameter("time" + number, "Tap " + number + " Time",
+                                      { 1.0f, static_cast<float>(maxDelaySeconds * 1000.0), 0.1f, 0.4f },
+                                      250.0f * (i + 1));
+        taps[i].level = addParameter("level" + number, "Tap " + number + " Level",
+                                     { 0.0f, 1.0f }, i == 0 ? 0.7f : 0.0f);
+    }
+
+    feedback = addParameter("feedback", "Feedback", { 0.0f, 0.95f }, 0.3f);
+    mix = addParameter("mix", "Mix", { 0.0f, 1.0f }, 0.3f);
+}
+
+double DelayPlugin::getTailLengthSeconds() const {
+    double longest = 0.0;
+    for (const auto& tap : taps) {
+        if (tap.level->get() > 0.0f) {
+            longest = juce::jmax(longest, tap.timeMs->get() * 0.001);
+        }
+    }
+
+    // Feedback repeats the first tap until it falls below -60 dB
+    const double fed = feedback->get();
+    if (fed > 0.0) {
+        longest += taps[0].timeMs->get() * 0.001 * std::log(0.001) / std::log(fed);
+    }
+
+    return longest;
+}
+
+std::unique_ptr<InternalPlugin::DSPState> DelayPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    auto dsp = std::make_unique<DSP>();
+    dsp->delayBufferSize = static_cast<int>(std::ceil(maxDelaySeconds * spec.sampleRate)) +
+                           static_cast<int>(spec.maximumBlockSize) + 1;
+    dsp->delayBuffer.setSize(static_cast<int>(spec.numChannels), dsp->delayBufferSize);
+    dsp->delayBuffer.clear();
+    dsp->wetBuffer.setSize(static_cast<int>(spec.numChannels), static_cast<int>(spec.maximumBlockSize));
+    dsp->feedbackBuffer.setSize(static_cast<int>(spec.numChannels), static_cast<int>(spec.maximumBlockSize));
+    return dsp;
+}
+
+void DelayPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dsp = static_cast<DSP&>(state);
+    auto& block = context.getOutputBlock();
+    const int numChannels = static_cast<int>(block.getNumChannels());
+    const int numSamples = static_cast<int>(block.getNumSamples());
+    const int bufferSize = dsp.delayBufferSize;
+
+    // Whole-sample tap times; the line always keeps a block of headroom
+    std::array<int, numTaps> delays;
+    std::array<float, numTaps> levels;
+    int shortest = bufferSize;
+    for (int i = 0; i < numTaps; ++i) {
+        delays[i] = juce::jlimit(1, bufferSize - static_cast<int>(dsp.wetBuffer.getNumSamples()) - 1,
+                                 juce::roundToInt(taps[i].timeMs->get() * 0.001 * dsp.processingRate));
+        levels[i] = taps[i].level->get();
+        shortest = juce::jmin(shortest, delays[i]);
+    }
+
+    const float fed = feedback->get();
+    const float wet = mix->get();
+
+    // A chunk never reads what it writes itself
+    for (int offset = 0; offset < numSamples;) {
+        const int chunkSamples = juce::jmin(numSamples - offset, shortest);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* io = block.getChannelPointer(static_cast<size_t>(channel)) + offset;
+            float* wetData = dsp.wetBuffer.getWritePointer(channel);
+            float* fedData = dsp.feedbackBuffer.getWritePointer(channel);
+
+            // The first tap drives the feedback path
+            dsp.read(channel, delays[0], fedData, 1.0f, chunkSamples, false);
+            juce::FloatVectorOperations::copyWithMultiply(wetData, fedData, levels[0], chunkSamples);
+
+            for (int i = 1; i < numTaps; ++i) {
+                if (levels[i] > 0.0f) {
+                    dsp.read(channel, delays[i], wetData, levels[i], chunkSamples, true);
+                }
+            }
+
+            dsp.write(channel, io, fedData, fed, chunkSamples);
+
+            juce::FloatVectorOperations::multiply(io, 1.0f - wet, chunkSamples);
+            juce::FloatVectorOperations::addWithMultiply(io, wetData, wet, chunkSamples);
+        }
+
+        dsp.writePosition = (dsp.writePosition + chunkSamples) % bufferSize;
+        offset += chunkSamples;
+    }
+}
+
+void DelayPlugin::DSP::read(int channel, int delayInSamples, float* dest, float gain,
+                            int numSamples, bool add) const {
+    const float* source = delayBuffer.getReadPointer(channel);
+    const int readPosition = (writePosition - delayInSamples + delayBufferSize) % delayBufferSize;
+    const int first = juce::jmin(numSamples, delayBufferSize - readPosition);
+
+    if (add) {
+        juce::FloatVectorOperations::addWithMultiply(dest, source + readPosition, gain, first);
+        juce::FloatVectorOperations::addWithMultiply(dest + first, source, gain, numSamples - first);
+    } else {
+        juce::FloatVectorOperations::copyWithMultiply(dest, source + readPosition, gain, first);
+        juce::FloatVectorOperations::copyWithMultiply(dest + first, source, gain, numSamples - first);
+    }
+}
+
+void DelayPlugin::DSP::write(int channel, const float* input, const float* fed, float gain, int numSamples) {
+    float* dest = delayBuffer.getWritePointer(channel);
+    const int first = juce::jmin(numSamples, delayBufferSize - writePosition);
+
+    juce::FloatVectorOperations::copy(dest + writePosition, input, first);
+    juce::FloatVectorOperations::addWithMultiply(dest + writePosition, fed, gain, first);
+    juce::FloatVectorOperations::copy(dest, input + first, numSamples - first);
+    juce::FloatVectorOperations::addWithMultiply(dest, fed + first, gain, numSamples - first);
+}
+
+//==============================================================================
+// ReverbPlugin Implementation
+//==============================================================================
+
+ReverbPlugin::ReverbPlugin(Track& track)
+    : InternalPlugin(track, "Reverb") {
+    decay = addParameter("decay", "Decay", { 0.1f, 10.0f, 0.01f, 0.5f }, 2.0f);
+    damping = addParameter("damping", "Damping", { 0.0f, 1.0f }, 0.5f);
+    predelay = addParameter("predelay", "Pre-delay", { 0.0f, 200.0f, 0.1f }, 10.0f);
+    mix = addParameter("mix", "Mix", { 0.0f, 1.0f }, 0.25f);
+}
+
+ReverbPlugin::~ReverbPlugin() {
+    builder.removeAllJobs(true, 5000);
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+}
+
+double ReverbPlugin::getTailLengthSeconds() const {
+    return predelay->get() * 0.001 + decay->get();
+}
+
+std::unique_ptr<InternalPlugin::DSPState> ReverbPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    // Build the response here so the new state's first block has it. One
+    // still being built, or waiting, was made for the old spec.
+    builder.removeAllJobs(true, 5000);
+    delete pendingEngine.exchange(nullptr);
+    delete retiredEngine.exchange(nullptr);
+
+    auto dsp = std::make_unique<DSP>();
+    dsp->engine = createEngine();
+    dsp->dryWet.prepare(spec);
+    dsp->ringBuffer.setSize(maxChannels, static_cast<int>(spec.maximumBlockSize));
+    return dsp;
+}
+
+void ReverbPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dsp = static_cast<DSP&>(state);
+    auto& engine = dsp.engine;
+    auto& ringing = dsp.ringing;
+
+    dsp.dryWet.setWetMixProportion(mix->get());
+    dsp.dryWet.pushDrySamples(context.getInputBlock());
+
+    auto& block = context.getOutputBlock();
+    const int numChannels = juce::jmin(static_cast<int>(block.getNumChannels()), maxChannels);
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    float* channels[maxChannels] = {};
+    for (int ch = 0; ch < numChannels; ++ch) {
+        channels[ch] = block.getChannelPointer(static_cast<size_t>(ch));
+    }
+
+    // Take a new response only while the current one has a slot to ring out
+    // in. The sum of the new response on the input and the old one on the
+    // silence that follows continues the old output exactly.
+    auto freeSlot = std::find_if(ringing.begin(), ringing.end(),
+                                 [](const RingingEngine& slot) { return slot.engine == nullptr; });
+    if (freeSlot != ringing.end()) {
+        if (auto* incoming = pendingEngine.exchange(nullptr)) {
+            if (engine != nullptr) {
+                freeSlot->remaining = engine->getImpulseLength();
+                freeSlot->engine = std::move(engine);
+            }
+            engine.reset(incoming);
+        }
+    }
+
+    if (engine != nullptr) {
+        engine->process(channels, channels, numChannels, numSamples);
+    } else {
+        block.clear();
+    }
+
+    for (auto& slot : ringing) {
+        if (slot.engine == nullptr) {
+            continue;
+        }
+
+        if (slot.remaining > 0) {
+            dsp.ringBuffer.clear(0, numSamples);
+            slot.engine->process(dsp.ringBuffer.getArrayOfReadPointers(), dsp.ringBuffer.getArrayOfWritePointers(),
+                                 numChannels, numSamples);
+            for (int ch = 0; ch < numChannels; ++ch) {
+                juce::FloatVectorOperations::add(channels[ch], dsp.ringBuffer.getReadPointer(ch), numSamples);
+            }
+            slot.remaining -= numSamples;
+        }
+
+        // Silent now: the builder thread frees it on its next job, or the
+        // plugin does when it goes
+        if (slot.remaining <= 0 && retiredEngine.load() == nullptr) {
+            retiredEngine.store(slot.engine.release());
+        }
+    }
+
+    dsp.dryWet.mixWetSamples(block);
+}
+
+void ReverbPlugin::parameterChanged(int index) {
+    // Only the impulse shape needs a rebuild; mix is read per block
+    if (prepared && format.parameters[index] != mix) {
+        loadImpulseResponse();
+    }
+}
+
+void ReverbPlugin::loadImpulseResponse() {
+    // Built on the builder thread. Each job frees the response the audio
+    // thread has finished with, then replaces any that was never picked up.
+    builder.removeAllJobs(false, 0);
+    builder.addJob([this] {
+        auto next = createEngine();
+        delete retiredEngine.exchange(nullptr);
+        delete pendingEngine.exchange(next.release());
+    });
+}
+
+std::unique_ptr<PartitionedConvolver> ReverbPlugin::createEngine() const {
+    const double rt60 = decay->get();
+    const int predelaySamples = juce::roundToInt(predelay->get() * 0.001 * sampleRate);
+    const int length = predelaySamples + static_cast<int>(std::ceil(rt60 * sampleRate));
+
+    juce::AudioBuffer<float> impulse(2, juce::jmax(1, length));
+    impulse.clear();
+
+    // Decorrelated noise per channel, decaying by 60 dB over rt60. Damping
+    // closes a one-pole low-pass over time, so highs die away first.
+    juce::Random random(0x5eed);
+    const double decayPerSample = std::log(0.001) / (rt60 * sampleRate);
+    const float damp = damping->get();
+
+    for (int channel = 0; channel < impulse.getNumChannels(); ++channel) {
+        float* data = impulse.getWritePointer(channel);
+        float state = 0.0f;
+
+        for (int i = predelaySamples; i < length; ++i) {
+            const double t = static_cast<double>(i - predelaySamples) / (length - predelaySamples);
+            const float cutoff = 1.0f - damp * 0.95f * static_cast<float>(t);
+            const float noise = random.nextFloat() * 2.0f - 1.0f;
+            state += cutoff * (noise - state);
+            data[i] = state * static_cast<float>(std::exp(decayPerSample * (i - predelaySamples)));
+        }
+    }
+
+    // Normalise the energy, as the response is heard at the mix level
+    float energy = 0.0f;
+    for (int channel = 0; channel < impulse.getNumChannels(); ++channel) {
+        const float rms = impulse.getRMSLevel(channel, 0, impulse.getNumSamples());
+        energy += rms * rms * static_cast<float>(impulse.getNumSamples());
+    }
+    if (energy > 0.0f) {
+        impulse.applyGain(0.125f / std::sqrt(energy / impulse.getNumChannels()));
+    }
+
+    auto convolver = std::make_unique<PartitionedConvolver>();
+    convolver->loadImpulseResponse(impulse, maxChannels);
+    return convolver;
+}
+
+//==============================================================================
+// EQPlugin Implementation
+//==============================================================================
+
+EQPlugin::EQPlugin(Track& track)
+    : InternalPlugin(track, "EQ") {
+    addBand(bands[0], BandType::LowShelf, "low", "Low", { 20.0f, 1000.0f, 1.0f, 0.3f }, 100.0f);
+    addBand(bands[1], BandType::Peak, "lowMid", "Low Mid", { 100.0f, 5000.0f, 1.0f, 0.3f }, 500.0f);
+    addBand(bands[2], BandType::Peak, "highMid", "High Mid", { 500.0f, 16000.0f, 1.0f, 0.3f }, 3000.0f);
+    addBand(bands[3], BandType::HighShelf, "high", "High", { 1000.0f, 20000.0f, 1.0f, 0.3f }, 8000.0f);
+}
+
+void EQPlugin::addBand(Band& band, BandType type, const juce::String& prefix, const juce::String& label,
+                       juce::NormalisableRange<float> frequencyRange, float defaultFrequency) {
+    band.type = type;
+    band.frequency = addParameter(prefix + "Frequency", label + " Frequency", frequencyRange, defaultFrequency);
+    band.gainDb = addParameter(prefix + "Gain", label + " Gain", { -18.0f, 18.0f, 0.1f }, 0.0f);
+    band.q = addParameter(prefix + "Q", label + " Q", { 0.1f, 10.0f, 0.01f, 0.4f }, 0.707f);
+}
+
+std::unique_ptr<InternalPlugin::DSPState> EQPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    auto dsp = std::make_unique<DSP>();
+    for (int i = 0; i < numBands; ++i) {
+        auto& filter = dsp->filters[static_cast<size_t>(i)];
+
+        // Allocates the coefficient storage that updates are written into
+        filter.filter.state = juce::dsp::IIR::Coefficients<float>::makePeakFilter(spec.sampleRate, 1000.0, 0.707, 1.0f);
+        updateCoefficients(bands[static_cast<size_t>(i)], filter, spec.sampleRate);
+        filter.filter.prepare(spec);
+        filter.filter.reset();
+    }
+    return dsp;
+}
+
+void EQPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dsp = static_cast<DSP&>(state);
+    for (int i = 0; i < numBands; ++i) {
+        auto& filter = dsp.filters[static_cast<size_t>(i)];
+        updateCoefficients(bands[static_cast<size_t>(i)], filter, dsp.processingRate);
+
+        // A flat band is an identity filter; skip it
+        if (std::abs(filter.currentGainDb) >= 0.05f) {
+            filter.filter.process(context);
+        }
+    }
+}
+
+void EQPlugin::updateCoefficients(const Band& band, BandFilter& filter, double rate) {
+    const float frequency = band.frequency->get();
+    const float gainDb = band.gainDb->get();
+    const float q = band.q->get();
+
+    if (frequency == filter.currentFrequency && gainDb == filter.currentGainDb && q == filter.currentQ) {
+        return;
+    }
+
+    filter.currentFrequency = frequency;
+    filter.currentGainDb = gainDb;
+    filter.currentQ = q;
+
+    using Coefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+    const auto gain = juce::Decibels::decibelsToGain(gainDb);
+    const float nyquistSafe = juce::jmin(frequency, static_cast<float>(rate * 0.45));
+
+    // Assigning the array reuses the existing storage
+    switch (band.type) {
+        case BandType::LowShelf:
+            *filter.filter.state = Coefficients::makeLowShelf(rate, nyquistSafe, q, gain);
+            break;
+
+        case BandType::HighShelf:
+            *filter.filter.state = Coefficients::makeHighShelf(rate, nyquistSafe, q, gain);
+            break;
+
+        case BandType::Peak:
+        default:
+            *filter.filter.state = Coefficients::makePeakFilter(rate, nyquistSafe, q, gain);
+            break;
+    }
+}
+
+//==============================================================================
+// CompressorPlugin Implementation
+//==============================================================================
+
+CompressorPlugin::CompressorPlugin(Track& track)
+    : InternalPlugin(track, "Compressor") {
+    threshold = addParameter("threshold", "Threshold", { -60.0f, 0.0f, 0.1f }, -18.0f);
+    ratio = addParameter("ratio", "Ratio", { 1.0f, 20.0f, 0.1f, 0.5f }, 4.0f);
+    attackMs = addParameter("attack", "Attack", { 0.1f, 100.0f, 0.1f, 0.4f }, 10.0f);
+    releaseMs = addParameter("release", "Release", { 5.0f, 1000.0f, 1.0f, 0.4f }, 100.0f);
+    lookaheadMs = addParameter("lookahead", "Lookahead", { 0.0f, static_cast<float>(maxLookaheadMs), 0.1f }, 5.0f);
+    makeup = addParameter("makeup", "Makeup", { 0.0f, 24.0f, 0.1f }, 0.0f);
+    enableOversampling();
+    enableSidechain();
+}
+
+int CompressorPlugin::getLatencySamples() const {
+    return InternalPlugin::getLatencySamples() + getLookaheadSamples();
+}
+
+int CompressorPlugin::getLookaheadSamples() const {
+    return juce::roundToInt(lookaheadMs->get() * 0.001 * sampleRate);
+}
+
+double CompressorPlugin::getTailLengthSeconds() const {
+    // Only what is still in the lookahead delay
+    return lookaheadMs->get() * 0.001;
+}
+
+std::unique_ptr<InternalPlugin::DSPState> CompressorPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    auto dsp = std::make_unique<DSP>();
+    dsp->lookahead.prepare(spec);
+    // Lookahead is whole host-rate samples, scaled by the oversampling factor
+    const int factor = juce::roundToInt(spec.sampleRate / sampleRate);
+    dsp->lookahead.setMaximumDelayInSamples((static_cast<int>(std::ceil(maxLookaheadMs * 0.001 * sampleRate)) + 1) * factor);
+    dsp->lookahead.reset();
+    dsp->gainBuffer.allocate(spec.maximumBlockSize, true);
+    return dsp;
+}
+
+void CompressorPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dsp = static_cast<DSP&>(state);
+    auto& block = context.getOutputBlock();
+    const size_t numChannels = block.getNumChannels();
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    const float thresholdDb = threshold->get();
+    const float slope = 1.0f - 1.0f / ratio->get();
+    const float makeupDb = makeup->get();
+    const float attack = std::exp(-1.0f / (attackMs->get() * 0.001f * static_cast<float>(dsp.processingRate)));
+    const float release = std::exp(-1.0f / (releaseMs->get() * 0.001f * static_cast<float>(dsp.processingRate)));
+
+    // Gain computer on the undelayed input, or the key input when one is
+    // connected, linked across channels
+    const bool keyed = sidechain.getNumChannels() > 0;
+    const size_t detectorChannels = keyed ? sidechain.getNumChannels() : numChannels;
+
+    for (int i = 0; i < numSamples; ++i) {
+        float peak = 0.0f;
+        for (size_t channel = 0; channel < detectorChannels; ++channel) {
+            const float sample = keyed ? sidechain.getSample(static_cast<int>(channel), i)
+                                       : block.getSample(static_cast<int>(channel), i);
+            peak = juce::jmax(peak, std::abs(sample));
+        }
+
+        const float over = juce::Decibels::gainToDecibels(peak, -120.0f) - thresholdDb;
+        const float target = over > 0.0f ? over * slope : 0.0f;
+        const float coefficient = target > dsp.envelope ? attack : release;
+        dsp.envelope = target + coefficient * (dsp.envelope - target);
+
+        dsp.gainBuffer[i] = juce::Decibels::decibelsToGain(makeupDb - dsp.envelope);
+    }
+
+    // Delay the audio so the gain reduction leads it. A whole number of
+    // host-rate samples, so the reported latency stays exact.
+    dsp.lookahead.setDelay(static_cast<float>(getLookaheadSamples() * dsp.oversamplingFactor));
+    dsp.lookahead.process(context);
+
+    for (size_t channel = 0; channel < numChannels; ++channel) {
+        juce::FloatVectorOperations::multiply(block.getChannelPointer(channel), dsp.gainBuffer.getData(), numSamples);
+    }
+}
+
+//==============================================================================
+// SaturatorPlugin Implementation
+//==============================================================================
+
+SaturatorPlugin::SaturatorPlugin(Track& track)
+    : InternalPlugin(track, "Saturator") {
+    drive = addParameter("drive", "Drive", { 0.0f, 36.0f, 0.1f }, 6.0f);
+    bias = addParameter("bias", "Bias", { -1.0f, 1.0f, 0.01f }, 0.0f);
+    output = addParameter("output", "Output", { -24.0f, 12.0f, 0.1f }, -6.0f);
+    mix = addParameter("mix", "Mix", { 0.0f, 1.0f }, 1.0f);
+    enableOversampling();
+}
+
+std::unique_ptr<InternalPlugin::DSPState> SaturatorPlugin::prepare(const juce::dsp::ProcessSpec& spec) {
+    auto dsp = std::make_unique<DSP>();
+    dsp->dryWet.prepare(spec);
+    return dsp;
+}
+
+void SaturatorPlugin::process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) {
+    auto& dryWet = static_cast<DSP&>(state).dryWet;
+    auto& block = context.getOutputBlock();
+    const int numSamples = static_cast<int>(block.getNumSamples());
+
+    const float inputGain = juce::Decibels::decibelsToGain(drive->get());
+    const float outputGain = juce::Decibels::decibelsToGain(output->get());
+    const float offset = bias->get();
+    const float restingLevel = std::tanh(offset);  // Removed so silence stays silent
+
+    dryWet.setWetMixProportion(mix->get());
+    dryWet.pushDrySamples(block);
+
+    for (size_t channel = 0; channel < block.getNumChannels(); ++channel) {
+        float* data = block.getChannelPointer(channel);
+        for (int i = 0; i < numSamples; ++i) {
+            data[i] = (std::tanh(inputGain * data[i] + offset) - restingLevel) * outputGain;
+        }
+    }
+
+    dryWet.mixWetSamples(block);
+}
+
+//==============================================================================
+// InternalPluginFactory Implementation
+//==============================================================================
+
+InternalPluginFactory::InternalPluginFactory() {
+    for (const auto& name : getPluginNames()) {
+        Plugin::Format pluginFormat;
+        pluginFormat.type = Plugin::Type::Internal;
+        pluginFormat.name = name;
+        pluginFormat.manufacturer = "DAW_Prototype";
+        pluginFormat.version = "1.0";
+        pluginFormat.identifier = name;
+        pluginFormat.isInstrument = false;
+        pluginFormat.numInputChannels = 2;
+        pluginFormat.numOutputChannels = 2;
+        formats[name] = pluginFormat;
+    }
+}
+
+juce::StringArray InternalPluginFactory::getPluginNames() const {
+    return { "Gain", "Delay", "Reverb", "EQ", "Compressor", "Saturator" };
+}
+
+std::unique_ptr<Plugin> InternalPluginFactory::createPlugin(Track& track, const juce::String& name) {
+    if (name == "Gain") return std::make_unique<GainPlugin>(track);
+    if (name == "Delay") return std::make_unique<DelayPlugin>(track);
+    if (name == "Reverb") return std::make_unique<ReverbPlugin>(track);
+    if (name == "EQ") return std::make_unique<EQPlugin>(track);
+    if (name == "Compressor") return std::make_unique<CompressorPlugin>(track);
+    if (name == "Saturator") return std::make_unique<SaturatorPlugin>(track);
+    return nullptr;
+}
+
+const Plugin::Format& InternalPluginFactory::getPluginFormat(const juce::String& name) const {
+    auto it = formats.find(name);
+    jassert(it != formats.end());
+    return it->second;
+}
@@ -0,0 +1,366 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include "Plugin.h"
+#include "Oversampler.h"
+#include "PartitionedConvolver.h"
+
+// Base for the built-in effects.
+//
+// Parameters are AudioParameterFloats owned by the plugin and exposed
+// normalised, like a hosted plugin's. Subclasses keep everything process()
+// writes to in a DSPState that prepare() allocates, and process any block up
+// to the prepared size in place; longer blocks are split here. Vector work
+// goes through FloatVectorOperations and juce::dsp, so the effects are cheap
+// enough to run on every track.
+//
+// Nonlinear effects enable oversampling: prepare() and process() then run
+// at the processing rate, with one factor while playing and another, usually
+// higher, while rendering offline. Switching builds the new oversamplers and
+// DSPState beside the ones playing; the audio thread swaps them in between
+// blocks, so the plugin never stops processing.
+class InternalPlugin : public Plugin {
+public:
+    // Constructor/Destructor
+    InternalPlugin(Track& track, const juce::String& name);
+    ~InternalPlugin() override;
+
+    // Basic properties
+    const Format& getFormat() const override { return format; }
+    juce::String getName() const override { return format.name; }
+
+    // GUI: none; parameters are edited through the Plugin interface
+    bool hasEditor() const override { return false; }
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+
+    // State management
+    void saveState(juce::MemoryBlock& destData) const override;
+    void loadState(const void* data, size_t sizeInBytes) override;
+
+    // Preset management
+    void savePreset(const juce::File& file) const override;
+    void loadPreset(const juce::File& file) override;
+    juce::StringArray getPresetNames() const override { return {}; }
+    void setCurrentPreset(int index) override { juce::ignoreUnused(index); }
+    int getCurrentPreset() const override { return 0; }
+
+    // Parameter management
+    int getNumParameters() const override { return ownedParameters.size(); }
+    float getParameter(int index) const override;
+    void setParameter(int index, float value) override;
+    juce::String getParameterName(int index) const override;
+    juce::String getParameterText(int index) const override;
+    juce::NormalisableRange<float> getParameterRange(int index) const override;
+
+    // Processing setup
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
+
+    // Sidechain, for plugins that enable it
+    bool acceptsSidechain() const override { return sidechainSupported; }
+
+    // Oversampling, for plugins that enable it. Message thread; a prepared
+    // plugin keeps processing at the old quality until the new one is in.
+    bool supportsOversampling() const { return oversamplingSupported; }
+    void setOversampling(const Oversampler::Settings& realtime, const Oversampler::Settings& offline);
+    const Oversampler::Settings& getRealtimeOversampling() const { return realtimeOversampling; }
+    const Oversampler::Settings& getOfflineOversampling() const { return offlineOversampling; }
+    int getOversamplingFactor() const { return oversamplingFactor.load(); }
+
+    // Latency handling. Subclasses with their own latency add it to this.
+    int getLatencySamples() const override { return oversamplingLatency.load(); }
+    double getTailLengthSeconds() const override { return 0.0; }
+
+    // Program handling
+    int getNumPrograms() const override { return 1; }
+    int getCurrentProgram() const override { return 0; }
+    void setCurrentProgram(int index) override { juce::ignoreUnused(index); }
+    juce::String getProgramName(int index) const override { juce::ignoreUnused(index); return "Default"; }
+
+protected:
+    static constexpr int maxChannels = 2;  // Mixer channels are stereo
+
+    juce::AudioParameterFloat* addParameter(const juce::String& parameterID,
+                                            const juce::String& parameterName,
+                                            juce::NormalisableRange<float> range,
+                                            float defaultValue);
+
+    // The filters, buffers and delay lines process() writes to. Subclasses
+    // derive their own; the audio thread owns the one playing.
+    struct DSPState {
+        virtual ~DSPState() = default;
+
+        double processingRate{44100.0};  // sampleRate times the oversampling factor
+        int oversamplingFactor{1};
+    };
+
+    // Message thread, possibly while an older state is playing, so it must
+    // leave that one alone. Returns a new state for spec, reset.
+    virtual std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) = 0;
+
+    // Audio thread, with the state prepare() returned. Blocks never exceed
+    // the prepared size.
+    virtual void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) = 0;
+
+    // Message thread, after a parameter was set from outside
+    virtual void parameterChanged(int index) { juce::ignoreUnused(index); }
+
+    // Nonlinear subclasses call this from their constructor
+    void enableOversampling();
+
+    // Subclasses with a key input call this from their constructor. During
+    // process(), sidechain then holds the matching slice of the sidechain
+    // input at the processing rate, or is empty when nothing is connected.
+    void enableSidechain();
+    juce::dsp::AudioBlock<const float> sidechain;
+
+    Format format;
+    double sampleRate{44100.0};
+    int maxBlockSize{512};
+    bool prepared{false};
+
+private:
+    juce::OwnedArray<juce::AudioParameterFloat> ownedParameters;
+
+    // Everything built for one host spec and oversampling setting. A new one
+    // is handed over like the reverb's convolvers: the audio thread takes it
+    // only once the one before was freed, and passes back the one it replaces.
+    struct Processing {
+        Oversampler oversampler;
+        Oversampler sidechainOversampler;  // Same settings, so both stay aligned
+        std::unique_ptr<DSPState> state;
+        int maxBlockSize{0};  // At the host rate
+    };
+
+    std::unique_ptr<Processing> processing;  // Audio thread's
+    std::atomic<Processing*> pendingProcessing{nullptr};
+    std::atomic<Processing*> retiredProcessing{nullptr};
+
+    Oversampler::Settings realtimeOversampling;
+    Oversampler::Settings offlineOversampling;
+    std::atomic<int> oversamplingFactor{1};   // Of the newest Processing
+    std::atomic<int> oversamplingLatency{0};
+    bool oversamplingSupported{false};
+    bool sidechainSupported{false};
+
+    void prepareProcessing();
+    void handleNonRealtimeChange() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(InternalPlugin)
+};
+
+//==============================================================================
+// Built-in effects
+//==============================================================================
+
+// Smoothed gain
+class GainPlugin : public InternalPlugin {
+public:
+    explicit GainPlugin(Track& track);
+
+private:
+    juce::AudioParameterFloat* gainDb;
+
+    struct DSP : DSPState {
+        juce::dsp::Gain<float> gain;
+    };
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+};
+
+// Four-tap delay with feedback from the first tap. Runs in vectorised
+// chunks no longer than the shortest tap, so feedback stays exact.
+class DelayPlugin : public InternalPlugin {
+public:
+    explicit DelayPlugin(Track& track);
+
+    double getTailLengthSeconds() const override;
+
+private:
+    static constexpr int numTaps = 4;
+    static constexpr double maxDelaySeconds = 2.0;
+
+    struct Tap {
+        juce::AudioParameterFloat* timeMs;
+        juce::AudioParameterFloat* level;
+    };
+
+    std::array<Tap, numTaps> taps;
+    juce::AudioParameterFloat* feedback;
+    juce::AudioParameterFloat* mix;
+
+    struct DSP : DSPState {
+        juce::AudioBuffer<float> delayBuffer;
+        juce::AudioBuffer<float> wetBuffer;
+        juce::AudioBuffer<float> feedbackBuffer;
+        int delayBufferSize{0};
+        int writePosition{0};
+
+        // Reads numSamples from delayInSamples ago into dest (adding if add)
+        void read(int channel, int delayInSamples, float* dest, float gain, int numSamples, bool add) const;
+        void write(int channel, const float* input, const float* fed, float gain, int numSamples);
+    };
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+};
+
+// Zero-latency convolution reverb with a synthetic, exponentially decaying
+// stereo impulse response. A shape change builds a new convolver off the
+// audio thread. It takes the input from then on, while the one it replaces
+// keeps running on silence until its tail has died away, so the reverb
+// already sounding is never cut.
+class ReverbPlugin : public InternalPlugin {
+public:
+    explicit ReverbPlugin(Track& track);
+    ~ReverbPlugin() override;
+
+    double getTailLengthSeconds() const override;
+
+private:
+    juce::AudioParameterFloat* decay;     // RT60 in seconds
+    juce::AudioParameterFloat* damping;
+    juce::AudioParameterFloat* predelay;  // Milliseconds
+    juce::AudioParameterFloat* mix;
+
+    // A replaced response ringing out. A new one is only taken while a slot
+    // is free; with both busy it waits for the older tail to end.
+    struct RingingEngine {
+        std::unique_ptr<PartitionedConvolver> engine;
+        int remaining{0};  // Samples until its tail is silent
+    };
+
+    static constexpr int maxRingingEngines = 2;
+
+    struct DSP : DSPState {
+        std::unique_ptr<PartitionedConvolver> engine;
+        std::array<RingingEngine, maxRingingEngines> ringing;
+        juce::dsp::DryWetMixer<float> dryWet;
+        juce::AudioBuffer<float> ringBuffer;
+    };
+
+    std::atomic<PartitionedConvolver*> pendingEngine{nullptr};
+    std::atomic<PartitionedConvolver*> retiredEngine{nullptr};
+    juce::ThreadPool builder{1};
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void parameterChanged(int index) override;
+
+    std::unique_ptr<PartitionedConvolver> createEngine() const;
+    void loadImpulseResponse();
+};
+
+// Low shelf, two peaks and a high shelf. Coefficients are recomputed in
+// place when a band changes, without allocating.
+class EQPlugin : public InternalPlugin {
+public:
+    explicit EQPlugin(Track& track);
+
+private:
+    enum class BandType { LowShelf, Peak, HighShelf };
+
+    struct Band {
+        BandType type{BandType::Peak};
+        juce::AudioParameterFloat* frequency{nullptr};
+        juce::AudioParameterFloat* gainDb{nullptr};
+        juce::AudioParameterFloat* q{nullptr};
+    };
+
+    struct BandFilter {
+        juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>,
+                                       juce::dsp::IIR::Coefficients<float>> filter;
+        float currentFrequency{-1.0f};
+        float currentGainDb{0.0f};
+        float currentQ{-1.0f};
+    };
+
+    static constexpr int numBands = 4;
+    std::array<Band, numBands> bands;
+
+    struct DSP : DSPState {
+        std::array<BandFilter, numBands> filters;
+    };
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+
+    void addBand(Band& band, BandType type, const juce::String& prefix, const juce::String& label,
+                 juce::NormalisableRange<float> frequencyRange, float defaultFrequency);
+    static void updateCoefficients(const Band& band, BandFilter& filter, double rate);
+};
+
+// Feed-forward compressor with a stereo-linked peak detector. The audio is
+// delayed by the lookahead, which is reported as latency, so gain reduction
+// is already in place when a transient arrives. Oversampled, since fast
+// gain changes modulate the signal into sidebands that would alias. A
+// connected sidechain drives the detector instead of the input.
+class CompressorPlugin : public InternalPlugin {
+public:
+    explicit CompressorPlugin(Track& track);
+
+    int getLatencySamples() const override;
+    double getTailLengthSeconds() const override;
+
+private:
+    static constexpr double maxLookaheadMs = 10.0;
+
+    juce::AudioParameterFloat* threshold;
+    juce::AudioParameterFloat* ratio;
+    juce::AudioParameterFloat* attackMs;
+    juce::AudioParameterFloat* releaseMs;
+    juce::AudioParameterFloat* lookaheadMs;
+    juce::AudioParameterFloat* makeup;
+
+    struct DSP : DSPState {
+        juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None> lookahead;
+        juce::HeapBlock<float> gainBuffer;
+        float envelope{0.0f};  // Gain reduction in dB
+    };
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+
+    int getLookaheadSamples() const;  // At the host rate
+};
+
+// Asymmetric tanh waveshaper. Oversampled, so the harmonics it adds above
+// the host Nyquist are filtered out rather than folded back.
+class SaturatorPlugin : public InternalPlugin {
+public:
+    explicit SaturatorPlugin(Track& track);
+
+private:
+    juce::AudioParameterFloat* drive;   // dB into the shaper
+    juce::AudioParameterFloat* bias;    // Asymmetry, for even harmonics
+    juce::AudioParameterFloat* output;  // dB
+    juce::AudioParameterFloat* mix;
+
+    struct DSP : DSPState {
+        juce::dsp::DryWetMixer<float> dryWet;
+    };
+
+    std::unique_ptr<DSPState> prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(DSPState& state, const juce::dsp::ProcessContextReplacing<float>& context) override;
+};
+
+//==============================================================================
+// Factory for the built-in effects, by name
+//==============================================================================
+
+class InternalPluginFactory : public PluginFactory {
+public:
+    InternalPluginFactory();
+
+    juce::StringArray getPluginNames() const override;
+    std::unique_ptr<Plugin> createPlugin(Track& track, const juce::String& name) override;
+    const Plugin::Format& getPluginFormat(const juce::String& name) const override;
+
+private:
+    std::map<juce::String, Plugin::Format> formats;
+};
@@ -0,0 +1,199 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// Interval index for time-range queries.
+//
+// Entries are kept sorted by start time with an implicit binary tree of the
+// maximum end time over each subtree, so a query for [t0, t1) visits only the
+// subtrees that can contain an overlapping interval: O(log n + k) for k hits.
+// Bulk-load with add() + build() in O(n log n), or edit in place with
+// insert()/remove()/update(). An edit only refreshes the leaves whose entries
+// moved and their ancestors, so moving an interval past a few neighbours
+// costs O(k + log n); the tree is rebuilt only when it has to grow.
+template <typename T>
+class IntervalIndex {
+public:
+    struct Entry {
+        double start;
+        double end;
+        T value;
+    };
+
+    // Bulk building
+    void clear() {
+        entries.clear();
+        maxEnd.clear();
+        leafCount = 0;
+    }
+
+    void add(double start, double end, const T& value) {
+        entries.push_back({ start, std::max(start, end), value });
+    }
+
+    void build() {
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.start < b.start; });
+        buildTree();
+    }
+
+    // Incremental edits: keep entries sorted and refresh the affected part
+    // of the tree
+    void insert(double start, double end, const T& value) {
+        const auto position = upperBound(0, size(), start);
+        entries.insert(entries.begin() + position, { start, std::max(start, end), value });
+
+        if (size() > leafCount) {
+            buildTree();
+        } else {
+            refresh(position, size());
+        }
+    }
+
+    bool remove(const T& value) {
+        const int index = find(value);
+        if (index < 0) {
+            return false;
+        }
+
+        // The vacated last leaf is cleared too
+        entries.erase(entries.begin() + index);
+        refresh(index, size() + 1);
+        return true;
+    }
+
+    bool update(const T& value, double start, double end) {
+        const int index = find(value);
+        if (index < 0) {
+            return false;
+        }
+
+        const auto first = entries.begin();
+        entries[static_cast<size_t>(index)] = { start, std::max(start, end), value };
+
+        // Rotate the entry to its new place; only the entries in between move
+        if (index + 1 < size() && entries[static_cast<size_t>(index + 1)].start <= start) {
+            const int target = upperBound(index + 1, size(), start);
+            std::rotate(first + index, first + index + 1, first + target);
+            refresh(index, target);
+        } else if (index > 0 && entries[static_cast<size_t>(index - 1)].start > start) {
+            const int target = upperBound(0, index, start);
+            std::rotate(first + target, first + index, first + index + 1);
+            refresh(target, index + 1);
+        } else {
+            refresh(index, index + 1);
+        }
+        return true;
+    }
+
+    // Queries (valid after build() or any incremental edit)
+    int size() const { return static_cast<int>(entries.size()); }
+    bool isEmpty() const { return entries.empty(); }
+    const Entry& getEntry(int index) const { return entries[static_cast<size_t>(index)]; }
+
+    // Calls callback(const Entry&) for every interval overlapping [t0, t1),
+    // in ascending start order
+    template <typename Callback>
+    void query(double t0, double t1, Callback&& callback) const {
+        if (entries.empty() || t1 <= t0) {
+            return;
+        }
+
+        // Only entries starting before t1 can overlap
+        const auto limit = static_cast<int>(std::lower_bound(entries.begin(), entries.end(), t1,
+            [](const Entry& e, double t) { return e.start < t; }) - entries.begin());
+
+        visit(1, 0, leafCount, limit, t0, callback);
+    }
+
+    std::vector<T> query(double t0, double t1) const {
+        std::vector<T> result;
+        query(t0, t1, [&result](const Entry& e) { result.push_back(e.value); });
+        return result;
+    }
+
+    // Interval containing time with the latest start, i.e. the one drawn on
+    // top. Returns false if nothing covers time.
+    bool findAt(double time, T& result) const {
+        bool found = false;
+        query(time, std::nextafter(time, std::numeric_limits<double>::infinity()),
+              [&](const Entry& e) {
+                  result = e.value;
+                  found = true;
+              });
+        return found;
+    }
+
+private:
+    std::vector<Entry> entries;
+    std::vector<double> maxEnd;
+    int leafCount{0};
+
+    void buildTree() {
+        leafCount = 1;
+        while (leafCount < static_cast<int>(entries.size())) {
+            leafCount *= 2;
+        }
+
+        maxEnd.assign(static_cast<size_t>(leafCount * 2), -std::numeric_limits<double>::infinity());
+
+        for (size_t i = 0; i < entries.size(); ++i) {
+            maxEnd[static_cast<size_t>(leafCount) + i] = entries[i].end;
+        }
+
+        for (int node = leafCount - 1; node > 0; --node) {
+            maxEnd[static_cast<size_t>(node)] = std::max(maxEnd[static_cast<size_t>(node * 2)],
+                                                         maxEnd[static_cast<size_t>(node * 2 + 1)]);
+        }
+    }
+
+    // Rewrites leaves [first, last) from entries and recomputes their
+    // ancestors, one level at a time
+    void refresh(int first, int last) {
+        if (first >= last) {
+            return;
+        }
+
+        for (int i = first; i < last; ++i) {
+            maxEnd[static_cast<size_t>(leafCount + i)] = i < size() ? entries[static_cast<size_t>(i)].end
+                                                                    : -std::numeric_limits<double>::infinity();
+        }
+
+        for (int lo = (leafCount + first) / 2, hi = (leafCount + last - 1) / 2; lo > 0; lo /= 2, hi /= 2) {
+            for (int node = lo; node <= hi; ++node) {
+                maxEnd[static_cast<size_t>(node)] = std::max(maxEnd[static_cast<size_t>(node * 2)],
+                                                             maxEnd[static_cast<size_t>(node * 2 + 1)]);
+            }
+        }
+    }
+
+    int find(const T& value) const {
+        const auto it = std::find_if(entries.begin(), entries.end(),
+                                     [&value](const Entry& e) { return e.value == value; });
+        return it != entries.end() ? static_cast<int>(it - entries.begin()) : -1;
+    }
+
+    // First index in [first, last) whose entry starts after start
+    int upperBound(int first, int last, double start) const {
+        return static_cast<int>(std::upper_bound(entries.begin() + first, entries.begin() + last, start,
+            [](double t, const Entry& e) { return t < e.start; }) - entries.begin());
+    }
+
+    template <typename Callback>
+    void visit(int node, int lo, int hi, int limit, double t0, Callback& callback) const {
+        if (lo >= limit || maxEnd[static_cast<size_t>(node)] <= t0) {
+            return;
+        }
+
+        if (hi - lo == 1) {
+            callback(entries[static_cast<size_t>(lo)]);
+            return;
+        }
+
+        const int mid = (lo + hi) / 2;
+        visit(node * 2, lo, mid, limit, t0, callback);
+        visit(node * 2 + 1, mid, hi, limit, t0, callback);
+    }
+};
@@ -0,0 +1,524 @@
+#include "LoudnessMeter.h"
+#include "Logger.h"
+
+namespace {
+    // ITU-R BS.1770-4 Annex 2 interpolation filter, one row per phase
+    constexpr float truePeakCoefficients[4][12] = {
+        {  0.0017089843750f,  0.0109863281250f, -0.0196533203125f,  0.0332031250000f,
+          -0.0594482421875f,  0.1373291015625f,  0.9721679687500f, -0.1022949218750f,
+           0.0476074218750f, -0.0266113281250f,  0.0148925781250f, -0.0083007812500f },
+        { -0.0291748046875f,  0.0292968750000f, -0.0517578125000f,  0.0891113281250f,
+          -0.1665039062500f,  0.4650878906250f,  0.7797851562500f, -0.2003173828125f,
+           0.1015625000000f, -0.0582275390625f,  0.0330810546875f, -0.0189208984375f },
+        { -0.0189208984375f,  0.0330810546875f, -0.0582275390625f,  0.1015625000000f,
+          -0.2003173828125f,  0.7797851562500f,  0.4650878906250f, -0.1665039062500f,
+           0.0891113281250f, -0.0517578125000f,  0.0292968750000f, -0.0291748046875f },
+        { -0.0083007812500f,  0.0148925781250f, -0.0266113281250f,  0.0476074218750f,
+          -0.1022949218750f,  0.9721679687500f,  0.1373291015625f, -0.0594482421875f,
+           0.0332031250000f, -0.0196533203125f,  0.0109863281250f,  0.0017089843750f }
+    };
+}
+
+//==============================================================================
+// LoudnessMeter Implementation
+//==============================================================================
+
+LoudnessMeter::LoudnessMeter() {
+    prepare(sampleRate, 2);
+}
+
+LoudnessMeter::~LoudnessMeter() {
+}
+
+void LoudnessMeter::prepare(double newSampleRate, int numChannels) {
+    sampleRate = newSampleRate;
+    subBlockLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+
+    channels.resize(static_cast<size_t>(juce::jmax(1, numChannels)));
+    for (size_t i = 0; i < channels.size(); ++i) {
+        // BS.1770 channel weights for the 5.1 layout (L R C LFE Ls Rs)
+        if (channels.size() >= 6 && i == 3) {
+            channels[i].weight = 0.0;
+        } else if (channels.size() >= 6 && i >= 4) {
+            channels[i].weight = 1.41;
+        } else {
+            channels[i].weight = 1.0;
+        }
+    }
+
+    scratch.resize(static_cast<size_t>(subBlockLength));
+
+    designFilters();
+    reset();
+}
+
+void LoudnessMeter::reset() {
+    for (auto& channel : channels) {
+        channel.shelf.reset();
+        channel.highPass.reset();
+        channel.truePeak.reset();
+    }
+
+    subBlockPosition = 0;
+    subBlockEnergy = 0.0;
+    subBlocks.fill(0.0);
+    subBlockIndex = 0;
+    numSubBlocks = 0;
+    histogram.fill(0);
+
+    truePeak = 0.0f;
+    maxMomentary = -std::numeric_limits<double>::infinity();
+    maxShortTerm = -std::numeric_limits<double>::infinity();
+    samplesProcessed = 0;
+}
+
+void LoudnessMeter::process(const float* const* channelData, int numChannels, int numSamples) {
+    const int channelsToProcess = juce::jmin(numChannels, static_cast<int>(channels.size()));
+    int position = 0;
+
+    while (position < numSamples) {
+        const int chunk = juce::jmin(numSamples - position,
+                                     subBlockLength - subBlockPosition);
+
+        for (int ch = 0; ch < channelsToProcess; ++ch) {
+            auto& state = channels[static_cast<size_t>(ch)];
+            const float* input = channelData[ch] + position;
+
+            truePeak = std::max(truePeak, state.truePeak.process(input, chunk));
+
+            if (state.weight == 0.0) {
+                continue;
+            }
+
+            // K-weighting: high shelf followed by the RLB high-pass. The
+            // recursion is inherently serial, so both stages run in one pass
+            // with their state held in locals.
+            auto& s = state.shelf;
+            auto& h = state.highPass;
+            double sx1 = s.x1, sx2 = s.x2, sy1 = s.y1, sy2 = s.y2;
+            double hx1 = h.x1, hx2 = h.x2, hy1 = h.y1, hy2 = h.y2;
+            float* out = scratch.data();
+
+            for (int i = 0; i < chunk; ++i) {
+                const double x = input[i];
+                const double y = s.b0 * x + s.b1 * sx1 + s.b2 * sx2 - s.a1 * sy1 - s.a2 * sy2;
+                sx2 = sx1; sx1 = x; sy2 = sy1; sy1 = y;
+
+                const double z = h.b0 * y + h.b1 * hx1 + h.b2 * hx2 - h.a1 * hy1 - h.a2 * hy2;
+                hx2 = hx1; hx1 = y; hy2 = hy1; hy1 = z;
+
+                out[i] = static_cast<float>(z);
+            }
+
+            s.x1 = sx1; s.x2 = sx2; s.y1 = sy1; s.y2 = sy2;
+            h.x1 = hx1; h.x2 = hx2; h.y1 = hy1; h.y2 = hy2;
+
+            // Mean square of the filtered block (vectorised)
+            juce::FloatVectorOperations::multiply(out, out, chunk);
+
+            double energy = 0.0;
+            for (int i = 0; i < chunk; ++i) {
+                energy += out[i];
+            }
+
+            subBlockEnergy += state.weight * energy;
+        }
+
+        position += chunk;
+        subBlockPosition += chunk;
+        samplesProcessed += chunk;
+
+        if (subBlockPosition >= subBlockLength) {
+            finishSubBlock();
+        }
+    }
+}
+
+void LoudnessMeter::process(const juce::AudioBuffer<float>& buffer) {
+    process(buffer.getArrayOfReadPointers(), buffer.getNumChannels(), buffer.getNumSamples());
+}
+
+double LoudnessMeter::getMomentaryLoudness() const {
+    return energyToLoudness(getMeanEnergy(subBlocksPerMomentary));
+}
+
+double LoudnessMeter::getShortTermLoudness() const {
+    return energyToLoudness(getMeanEnergy(subBlocksPerShortTerm));
+}
+
+double LoudnessMeter::getIntegratedLoudness() const {
+    // Absolute gate has already been applied when filling the histogram
+    double sum = 0.0;
+    uint64_t count = 0;
+
+    for (int bin = 0; bin < histogramSize; ++bin) {
+        if (histogram[static_cast<size_t>(bin)] > 0) {
+            sum += histogram[static_cast<size_t>(bin)] * histogramBinEnergy(bin);
+            count += histogram[static_cast<size_t>(bin)];
+        }
+    }
+
+    if (count == 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // Relative gate
+    const double gate = energyToLoudness(sum / static_cast<double>(count)) + relativeGate;
+    const int firstBin = juce::jlimit(0, histogramSize - 1,
+        static_cast<int>(std::ceil((gate - histogramMin) / histogramStep - 0.5)));
+
+    sum = 0.0;
+    count = 0;
+
+    for (int bin = firstBin; bin < histogramSize; ++bin) {
+        sum += histogram[static_cast<size_t>(bin)] * histogramBinEnergy(bin);
+        count += histogram[static_cast<size_t>(bin)];
+    }
+
+    return count > 0 ? energyToLoudness(sum / static_cast<double>(count))
+                     : -std::numeric_limits<double>::infinity();
+}
+
+LoudnessMeter::Report LoudnessMeter::createReport() const {
+    Report report;
+    report.integratedLoudness = getIntegratedLoudness();
+    report.maxMomentaryLoudness = maxMomentary;
+    report.maxShortTermLoudness = maxShortTerm;
+    report.truePeak = truePeak;
+    report.durationSeconds = samplesProcessed / sampleRate;
+    return report;
+}
+
+void LoudnessMeter::designFilters() {
+    // Coefficients re-derived for the current sample rate so that the
+    // response matches the 48 kHz reference filters of BS.1770
+    const double pi = juce::MathConstants<double>::pi;
+
+    // Stage 1: high shelf
+    {
+        const double f0 = 1681.974450955533;
+        const double gainDb = 3.999843853973347;
+        const double q = 0.7071752369554196;
+
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double vh = std::pow(10.0, gainDb / 20.0);
+        const double vb = std::pow(vh, 0.4996667741545416);
+        const double a0 = 1.0 + k / q + k * k;
+
+        for (auto& channel : channels) {
+            auto& f = channel.shelf;
+            f.b0 = (vh + vb * k / q + k * k) / a0;
+            f.b1 = 2.0 * (k * k - vh) / a0;
+            f.b2 = (vh - vb * k / q + k * k) / a0;
+            f.a1 = 2.0 * (k * k - 1.0) / a0;
+            f.a2 = (1.0 - k / q + k * k) / a0;
+        }
+    }
+
+    // Stage 2: RLB high-pass
+    {
+        const double f0 = 38.13547087602444;
+        const double q = 0.5003270373238773;
+
+        const double k = std::tan(pi * f0 / sampleRate);
+        const double a0 = 1.0 + k / q + k * k;
+
+        for (auto& channel : channels) {
+            auto& f = channel.highPass;
+            f.b0 = 1.0;
+            f.b1 = -2.0;
+            f.b2 = 1.0;
+            f.a1 = 2.0 * (k * k - 1.0) / a0;
+            f.a2 = (1.0 - k / q + k * k) / a0;
+        }
+    }
+}
+
+void LoudnessMeter::finishSubBlock() {
+    subBlocks[static_cast<size_t>(subBlockIndex)] = subBlockEnergy / subBlockLength;
+    subBlockIndex = (subBlockIndex + 1) % subBlocksPerShortTerm;
+    numSubBlocks = std::min(numSubBlocks + 1, subBlocksPerShortTerm);
+
+    subBlockEnergy = 0.0;
+    subBlockPosition = 0;
+
+    // A new 400 ms gating block completes every 100 ms (75% overlap)
+    if (numSubBlocks >= subBlocksPerMomentary) {
+        const double momentary = getMomentaryLoudness();
+        maxMomentary = std::max(maxMomentary, momentary);
+
+        if (momentary > absoluteGate) {
+            const int bin = juce::jlimit(0, histogramSize - 1,
+                static_cast<int>((momentary - histogramMin) / histogramStep));
+            ++histogram[static_cast<size_t>(bin)];
+        }
+    }
+
+    if (numSubBlocks >= subBlocksPerShortTerm) {
+        maxShortTerm = std::max(maxShortTerm, getShortTermLoudness());
+    }
+}
+
+double LoudnessMeter::getMeanEnergy(int numBlocks) const {
+    if (numSubBlocks < numBlocks) {
+        return 0.0;
+    }
+
+    double sum = 0.0;
+    for (int i = 1; i <= numBlocks; ++i) {
+        const int index = (subBlockIndex - i + subBlocksPerShortTerm) % subBlocksPerShortTerm;
+        sum += subBlocks[static_cast<size_t>(index)];
+    }
+
+    return sum / numBlocks;
+}
+
+double LoudnessMeter::energyToLoudness(double energy) {
+    return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy)
+                        : -std::numeric_limits<double>::infinity();
+}
+
+double LoudnessMeter::loudnessToEnergy(double loudness) {
+    return std::pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+double LoudnessMeter::histogramBinEnergy(int bin) {
+    return loudnessToEnergy(histogramMin + (bin + 0.5) * histogramStep);
+}
+
+//==============================================================================
+// TruePeakDetector Implementation
+//==============================================================================
+
+void LoudnessMeter::TruePeakDetector::reset() {
+    history.fill(0.0f);
+    writeIndex = 0;
+}
+
+float LoudnessMeter::TruePeakDetector::process(const float* data, int numSamples) {
+    float peak = 0.0f;
+
+    for (int n = 0; n < numSamples; ++n) {
+        history[static_cast<size_t>(writeIndex)] = data[n];
+        history[static_cast<size_t>(writeIndex + tapsPerPhase)] = data[n];
+        writeIndex = (writeIndex + 1) % tapsPerPhase;
+
+        // Oldest sample first, newest at the end of the window
+        const float* window = history.data() + writeIndex;
+
+        for (const auto& phase : truePeakCoefficients) {
+            float sum = 0.0f;
+            for (int k = 0; k < tapsPerPhase; ++k) {
+                sum += phase[k] * window[tapsPerPhase - 1 - k];
+            }
+            peak = std::max(peak, std::abs(sum));
+        }
+    }
+
+    return peak;
+}
+
+//==============================================================================
+// LoudnessMeter::Report Implementation
+//==============================================================================
+
+juce::String LoudnessMeter::Report::toString() const {
+    juce::String text;
+    text << "Integrated loudness: " << LoudnessMeterUtils::formatLoudness(integratedLoudness) << "\n";
+    text << "Max momentary:       " << LoudnessMeterUtils::formatLoudness(maxMomentaryLoudness) << "\n";
+    text << "Max short-term:      " << LoudnessMeterUtils::formatLoudness(maxShortTermLoudness) << "\n";
+    text << "True peak:           "
+         << (truePeak > 0.0f ? juce::String(juce::Decibels::gainToDecibels(truePeak), 1) + " dBTP"
+                             : juce::String("-inf dBTP")) << "\n";
+    text << "Duration:            " << juce::String(durationSeconds, 2) << " s\n";
+    return text;
+}
+
+//==============================================================================
+// LoudnessAnalyser::Source Implementation
+//==============================================================================
+
+LoudnessAnalyser::Source::Source(double sampleRate, int numChannels, int maxBlockSize)
+    : fifo(juce::jmax(maxBlockSize, 1) * 16),
+      fifoBuffer(numChannels, juce::jmax(maxBlockSize, 1) * 16),
+      readBuffer(numChannels, juce::jmax(maxBlockSize, 1) * 4) {
+    meter.prepare(sampleRate, numChannels);
+}
+
+void LoudnessAnalyser::Source::push(const juce::AudioBuffer<float>& buffer, int numSamples) noexcept {
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    // Never write a partial block; a gap is better than a discontinuity
+    if (size1 + size2 < numSamples) {
+        droppedBlocks.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), fifoBuffer.getNumChannels());
+    for (int ch = 0; ch < numChannels; ++ch) {
+        if (size1 > 0) {
+            fifoBuffer.copyFrom(ch, start1, buffer, ch, 0, size1);
+        }
+        if (size2 > 0) {
+            fifoBuffer.copyFrom(ch, start2, buffer, ch, size1, size2);
+        }
+    }
+
+    fifo.finishedWrite(size1 + size2);
+}
+
+LoudnessAnalyser::Values LoudnessAnalyser::Source::getValues() const {
+    Values values;
+    values.momentary = momentary.load();
+    values.shortTerm = shortTerm.load();
+    values.integrated = integrated.load();
+    values.truePeak = truePeak.load();
+    return values;
+}
+
+bool LoudnessAnalyser::Source::drain() {
+    if (resetRequested.exchange(false)) {
+        meter.reset();
+    }
+
+    bool didWork = false;
+
+    while (fifo.getNumReady() > 0) {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(juce::jmin(fifo.getNumReady(), readBuffer.getNumSamples()),
+                           start1, size1, start2, size2);
+
+        for (int ch = 0; ch < readBuffer.getNumChannels(); ++ch) {
+            if (size1 > 0) {
+                readBuffer.copyFrom(ch, 0, fifoBuffer, ch, start1, size1);
+            }
+            if (size2 > 0) {
+                readBuffer.copyFrom(ch, size1, fifoBuffer, ch, start2, size2);
+            }
+        }
+
+        fifo.finishedRead(size1 + size2);
+
+        meter.process(readBuffer.getArrayOfReadPointers(), readBuffer.getNumChannels(), size1 + size2);
+        didWork = true;
+    }
+
+    if (didWork) {
+        const auto toDisplay = [](double lufs) {
+            return static_cast<float>(std::isfinite(lufs) ? juce::jmax(lufs, -100.0) : -100.0);
+        };
+
+        momentary = toDisplay(meter.getMomentaryLoudness());
+        shortTerm = toDisplay(meter.getShortTermLoudness());
+        integrated = toDisplay(meter.getIntegratedLoudness());
+        truePeak = meter.getTruePeak();
+
+        if (auto* slot = meterSlot.load()) {
+            slot->publish(0.0f, 0.0f, meter.getTruePeak(), 0);
+        }
+    }
+
+    return didWork;
+}
+
+//==============================================================================
+// LoudnessAnalyser Implementation
+//==============================================================================
+
+LoudnessAnalyser::LoudnessAnalyser()
+    : juce::Thread("Loudness Analyser") {
+    startThread();
+}
+
+LoudnessAnalyser::~LoudnessAnalyser() {
+    stopThread(2000);
+}
+
+std::shared_ptr<LoudnessAnalyser::Source> LoudnessAnalyser::createSource(double sampleRate,
+                                                                          int numChannels,
+                                                                          int maxBlockSize) {
+    auto source = std::make_shared<Source>(sampleRate, numChannels, maxBlockSize);
+
+    const juce::ScopedLock sl(sourceLock);
+    sources.push_back(source);
+    return source;
+}
+
+void LoudnessAnalyser::removeSource(const std::shared_ptr<Source>& source) {
+    const juce::ScopedLock sl(sourceLock);
+    sources.erase(std::remove(sources.begin(), sources.end(), source), sources.end());
+}
+
+void LoudnessAnalyser::run() {
+    while (!threadShouldExit()) {
+        {
+            const juce::ScopedLock sl(sourceLock);
+            for (auto& source : sources) {
+                source->drain();
+            }
+        }
+
+        wait(10);
+    }
+}
+
+//==============================================================================
+// LoudnessMeterUtils Implementation
+//==============================================================================
+
+namespace LoudnessMeterUtils {
+    LoudnessMeter::Report analyseFile(const juce::File& file) {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+        if (reader == nullptr) {
+            LOG_ERROR("Cannot analyse loudness of %s", file.getFullPathName().toRawUTF8());
+            return {};
+        }
+
+        const int numChannels = static_cast<int>(reader->numChannels);
+        const int blockSize = 65536;
+
+        LoudnessMeter meter;
+        meter.prepare(reader->sampleRate, numChannels);
+
+        juce::AudioBuffer<float> buffer(numChannels, blockSize);
+
+        for (juce::int64 position = 0; position < reader->lengthInSamples; position += blockSize) {
+            const int numSamples = static_cast<int>(
+                juce::jmin(static_cast<juce::int64>(blockSize), reader->lengthInSamples - position));
+
+            reader->read(&buffer, 0, numSamples, position, true, true);
+            meter.process(buffer.getArrayOfReadPointers(), numChannels, numSamples);
+        }
+
+        return meter.createReport();
+    }
+
+    LoudnessMeter::Report analyseBuffer(const juce::AudioBuffer<float>& buffer,
+                                       double sampleRate) {
+        LoudnessMeter meter;
+        meter.prepare(sampleRate, buffer.getNumChannels());
+        meter.process(buffer);
+        return meter.createReport();
+    }
+
+    bool writeReport(const LoudnessMeter::Report& report, const juce::File& file) {
+        if (!file.replaceWithText(report.toString())) {
+            LOG_ERROR("Failed to write loudness report: %s", file.getFullPathName().toRawUTF8());
+            return false;
+        }
+
+        return true;
+    }
+
+    juce::String formatLoudness(double lufs) {
+        if (!std::isfinite(lufs) || lufs <= -100.0) {
+            return "-inf LUFS";
+        }
+
+        return juce::String(lufs, 1) + " LUFS";
+    }
+}
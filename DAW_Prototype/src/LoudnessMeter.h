@@ -0,0 +1,190 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <vector>
+#include "MeterBus.h"
+
+// EBU R128 / ITU-R BS.1770-4 loudness meter.
+//
+// Pure DSP object with no thread affinity: the realtime path drives it from
+// LoudnessAnalyser's worker thread, offline export drives it directly.
+class LoudnessMeter {
+public:
+    // Summary produced at the end of an analysis pass
+    struct Report {
+        double integratedLoudness{-std::numeric_limits<double>::infinity()};
+        double maxMomentaryLoudness{-std::numeric_limits<double>::infinity()};
+        double maxShortTermLoudness{-std::numeric_limits<double>::infinity()};
+        float truePeak{0.0f};
+        double durationSeconds{0.0};
+
+        juce::String toString() const;
+    };
+
+    // Constructor/Destructor
+    LoudnessMeter();
+    ~LoudnessMeter();
+
+    // Setup
+    void prepare(double sampleRate, int numChannels);
+    void reset();
+
+    // Processing
+    void process(const float* const* channelData, int numChannels, int numSamples);
+    void process(const juce::AudioBuffer<float>& buffer);
+
+    // Results in LUFS (-inf when nothing has been measured)
+    double getMomentaryLoudness() const;
+    double getShortTermLoudness() const;
+    double getIntegratedLoudness() const;
+    float getTruePeak() const { return truePeak; }
+    Report createReport() const;
+
+private:
+    // Direct form I biquad
+    struct Biquad {
+        double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+        double x1{0.0}, x2{0.0}, y1{0.0}, y2{0.0};
+
+        void reset() { x1 = x2 = y1 = y2 = 0.0; }
+    };
+
+    // 4x oversampling true-peak detector (BS.1770-4 Annex 2)
+    class TruePeakDetector {
+    public:
+        void reset();
+        float process(const float* data, int numSamples);
+
+    private:
+        static constexpr int tapsPerPhase = 12;
+        // History is kept twice so every dot product reads a contiguous window
+        std::array<float, tapsPerPhase * 2> history{};
+        int writeIndex{0};
+    };
+
+    struct ChannelState {
+        Biquad shelf;
+        Biquad highPass;
+        TruePeakDetector truePeak;
+        double weight{1.0};
+    };
+
+    static constexpr int subBlocksPerMomentary = 4;    // 400 ms
+    static constexpr int subBlocksPerShortTerm = 30;   // 3 s
+    static constexpr double absoluteGate = -70.0;
+    static constexpr double relativeGate = -10.0;
+    static constexpr double histogramMin = -70.0;
+    static constexpr double histogramStep = 0.1;
+    static constexpr int histogramSize = 750;          // -70 .. +5 LUFS
+
+    double sampleRate{48000.0};
+    std::vector<ChannelState> channels;
+    std::vector<float> scratch;
+
+    // 100 ms sub-block accumulation
+    int subBlockLength{4800};
+    int subBlockPosition{0};
+    double subBlockEnergy{0.0};
+    std::array<double, subBlocksPerShortTerm> subBlocks{};
+    int subBlockIndex{0};
+    int numSubBlocks{0};
+
+    // Gating block histogram for the integrated measurement
+    std::array<uint32_t, histogramSize> histogram{};
+
+    float truePeak{0.0f};
+    double maxMomentary{-std::numeric_limits<double>::infinity()};
+    double maxShortTerm{-std::numeric_limits<double>::infinity()};
+    int64_t samplesProcessed{0};
+
+    void designFilters();
+    void finishSubBlock();
+    double getMeanEnergy(int numBlocks) const;
+
+    static double energyToLoudness(double energy);
+    static double loudnessToEnergy(double loudness);
+    static double histogramBinEnergy(int bin);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessMeter)
+};
+
+// Background loudness analysis fed from the audio thread.
+//
+// Each Source owns a lock-free FIFO. The audio thread pushes blocks into it
+// and a single worker thread drains every source through its LoudnessMeter,
+// publishing the results into atomics the UI can read at any time.
+class LoudnessAnalyser : private juce::Thread {
+public:
+    // Latest published values
+    struct Values {
+        float momentary{-100.0f};
+        float shortTerm{-100.0f};
+        float integrated{-100.0f};
+        float truePeak{0.0f};
+    };
+
+    class Source {
+    public:
+        Source(double sampleRate, int numChannels, int maxBlockSize);
+
+        // Audio thread. Drops the block (and counts it) if the FIFO is full.
+        void push(const juce::AudioBuffer<float>& buffer, int numSamples) noexcept;
+
+        // Any thread
+        Values getValues() const;
+        int getNumDroppedBlocks() const { return droppedBlocks.load(); }
+        void requestReset() { resetRequested = true; }
+
+        // Optional meter slot that receives the oversampled true peak
+        void setMeterSlot(MeterBus::Slot* slot) { meterSlot.store(slot); }
+
+    private:
+        friend class LoudnessAnalyser;
+
+        juce::AbstractFifo fifo;
+        juce::AudioBuffer<float> fifoBuffer;
+        juce::AudioBuffer<float> readBuffer;
+        LoudnessMeter meter;
+
+        std::atomic<float> momentary{-100.0f};
+        std::atomic<float> shortTerm{-100.0f};
+        std::atomic<float> integrated{-100.0f};
+        std::atomic<float> truePeak{0.0f};
+        std::atomic<int> droppedBlocks{0};
+        std::atomic<bool> resetRequested{false};
+        std::atomic<MeterBus::Slot*> meterSlot{nullptr};
+
+        bool drain();
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Source)
+    };
+
+    // Constructor/Destructor
+    LoudnessAnalyser();
+    ~LoudnessAnalyser() override;
+
+    // Source management (message thread)
+    std::shared_ptr<Source> createSource(double sampleRate, int numChannels, int maxBlockSize);
+    void removeSource(const std::shared_ptr<Source>& source);
+
+private:
+    juce::CriticalSection sourceLock;
+    std::vector<std::shared_ptr<Source>> sources;
+
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LoudnessAnalyser)
+};
+
+// Loudness utilities
+namespace LoudnessMeterUtils {
+    // Offline analysis for export and loudness reports
+    LoudnessMeter::Report analyseFile(const juce::File& file);
+    LoudnessMeter::Report analyseBuffer(const juce::AudioBuffer<float>& buffer,
+                                       double sampleRate);
+    bool writeReport(const LoudnessMeter::Report& report, const juce::File& file);
+
+    // Display helpers
+    juce::String formatLoudness(double lufs);
+}
@@ -1,7 +1,11 @@
 #include "MIDISequencer.h"
+#include "AudioEngine.h"
+#include "Configuration.h"
 #include "Project.h"
 #include "Track.h"
 #include "Logger.h"
+#include "MIDIUtils.h"
+#include <array>
 
 //==============================================================================
 // MIDISequencer Implementation
@@ -11,6 +15,8 @@ MIDISequencer::MIDISequencer() {
     // Initialize default settings
     recordSettings.activeChannels.setRange(0, 16, true);  // All channels active
     recordSettings.activeNotes.setRange(0, 128, true);    // All notes active
+    
+    recordedEvents.reserve(recordBufferSize);
 }
 
 MIDISequencer::~MIDISequencer() {
@@ -162,16 +168,28 @@ void MIDISequencer::setSendSysEx(bool shouldSend) {
     }
 }
 
-void MIDISequencer::startRecording(Track* track) {
+void MIDISequencer::startRecording(Track* track, const Transport& transport,
+                                   int64_t startSample, int64_t leadInSamples) {
     if (track == nullptr || track->getType() != Track::Type::MIDI) {
         return;
     }
 
     stopRecording();  // Stop any existing recording
     
+    // Incoming events are stamped with the MIDI input clock; remember when
+    // the timeline passes the start, and the loop it will wrap in. Events
+    // played before then land on the start.
+    const double sampleRate = transport.getSampleRate();
+    
+    const juce::ScopedLock lock(midiLock);
     recordingTrack = track;
-    recordingStartTime = currentProject != nullptr ? currentProject->getTransportPosition() : 0.0;
-    recordingSequence.clear();
+    recordingStartTime = AudioEngineUtils::samplesToTime(startSample, sampleRate);
+    recordingStartClock = juce::Time::getMillisecondCounterHiRes() * 0.001 +
+                          AudioEngineUtils::samplesToTime(leadInSamples, sampleRate);
+    recordingLooped = transport.isLooping();
+    loopStartTime = AudioEngineUtils::samplesToTime(transport.getLoopStart(), sampleRate);
+    loopEndTime = AudioEngineUtils::samplesToTime(transport.getLoopEnd(), sampleRate);
+    recordedEvents.clear();
     recording = true;
     
     LOG_INFO("Started MIDI recording on track: %s", track->getName());
@@ -182,6 +200,14 @@ void MIDISequencer::stopRecording() {
         return;
     }
 
+    // After this no more events are appended, so the buffer can be read
+    // without holding up MIDI input
+    {
+        const juce::ScopedLock lock(midiLock);
+        recording = false;
+        recordingEndTime = clockToTimeline(juce::Time::getMillisecondCounterHiRes() * 0.001);
+    }
+    
     finalizeRecording();
     clearRecordingState();
     
@@ -202,8 +228,9 @@ void MIDISequencer::handleIncomingMidiMessage(const juce::MidiMessage& message)
     
     // Handle recording
     if (recording && recordingTrack != nullptr) {
-        const double messageTime = message.getTimeStamp() - recordingStartTime;
-        processRecordedMessage(message, messageTime);
+        const double clock = message.getTimeStamp() > 0.0 ?
+            message.getTimeStamp() : juce::Time::getMillisecondCounterHiRes() * 0.001;
+        processRecordedMessage(message, clockToTimeline(clock));
     }
 }
 
@@ -221,16 +248,6 @@ void MIDISequencer::processOutputBuffer(juce::MidiBuffer& buffer, double positio
         return;
     }
 
-    // Send MIDI clock
-    if (playbackSettings.sendClock) {
-        sendMidiClock(position);
-    }
-    
-    // Send MTC
-    if (playbackSettings.sendMTC) {
-        sendMidiTimeCode(position);
-    }
-    
     // Process track MIDI
     // TODO: Process MIDI from tracks
     
@@ -238,35 +255,6 @@ void MIDISequencer::processOutputBuffer(juce::MidiBuffer& buffer, double positio
     outputBuffer.clear();
 }
 
-void MIDISequencer::sendMidiClock(double position) {
-    const double clockInterval = 60.0 / (currentProject->getSettings().tempo * 24.0);
-    
-    while (lastClockTime <= position) {
-        outputBuffer.addEvent(juce::MidiMessage::midiClock(),
-                            static_cast<int>((lastClockTime - position) * 44100.0));
-        lastClockTime += clockInterval;
-    }
-}
-
-void MIDISequencer::sendMidiTimeCode(double position) {
-    const int frameRate = getMTCFrameRate(playbackSettings.mtcFormat);
-    const double frameTime = 1.0 / frameRate;
-    
-    while (lastMTCTime <= position) {
-        const int totalFrames = static_cast<int>(lastMTCTime * frameRate);
-        if (totalFrames != mtcFrameCount) {
-            mtcFrameCount = totalFrames;
-            
-            // Send MTC quarter-frame messages
-            const juce::String mtcString = getMTCString(lastMTCTime,
-                                                      playbackSettings.mtcFormat);
-            // TODO: Generate and send MTC messages
-        }
-        
-        lastMTCTime += frameTime;
-    }
-}
-
 void MIDISequencer::sendMidiMachineControl(int command) {
     if (!playbackSettings.sendMMC) {
         return;
@@ -307,6 +295,7 @@ void MIDISequencer::quantizeEvents(juce::MidiMessageSequence& sequence,
         }
     }
     
+    sequence.sort();
     sequence.updateMatchedPairs();
 }
 
@@ -423,40 +412,248 @@ void MIDISequencer::processRecordedMessage(const juce::MidiMessage& message,
     
     // Apply velocity processing
     if (message.isNoteOn()) {
-        recordedMessage.setVelocity(processVelocity(message.getVelocity()));
+        recordedMessage.setVelocity(processVelocity(message.getVelocity()) / 127.0f);
     }
     
-    // Apply quantization
-    const double messageTime = recordSettings.quantizeInput ?
-        quantizeTime(time) : time;
-    recordedMessage.setTimeStamp(messageTime);
-    
-    recordingSequence.addEvent(recordedMessage);
-    recordingSequence.updateMatchedPairs();
+    // Amortised O(1); quantisation and pair matching wait for the commit
+    recordedEvents.push_back({recordedMessage, time});
 }
 
 void MIDISequencer::finalizeRecording() {
-    if (recordingTrack == nullptr || recordingSequence.getNumEvents() == 0) {
+    if (recordingTrack == nullptr || currentProject == nullptr || recordedEvents.empty()) {
         return;
     }
-
-    // Apply auto-quantize if enabled
-    if (recordSettings.autoQuantize) {
-        quantizeEvents(recordingSequence, recordSettings.quantizeGrid);
+    
+    auto takes = buildTakes();
+    
+    // Overdubbing a loop layers every pass into one take; replacing keeps
+    // only the last pass, since each pass replaces the one before
+    if (takes.size() > 1 && recordSettings.overdubMode) {
+        for (size_t i = 1; i < takes.size(); ++i) {
+            takes.front().sequence.addSequence(takes[i].sequence, 0.0);
+            takes.front().startTime = juce::jmin(takes.front().startTime, takes[i].startTime);
+            takes.front().endTime = juce::jmax(takes.front().endTime, takes[i].endTime);
+        }
+        takes.resize(1);
+    } else if (takes.size() > 1 &&
+               (recordSettings.replaceMode ||
+                !Configuration::getInstance().getRecordingSettings().createTakeFolder)) {
+        takes.erase(takes.begin(), takes.end() - 1);
     }
     
-    // TODO: Add recorded sequence to track
+    const juce::String takeGroup = juce::Uuid().toString();
+    const int numTakes = static_cast<int>(takes.size());
+    
+    for (int i = 0; i < numTakes; ++i) {
+        auto& take = takes[static_cast<size_t>(i)];
+        if (take.sequence.getNumEvents() == 0) {
+            continue;
+        }
+        
+        // Note pairs are matched once per take, after all events are in
+        if (recordSettings.quantizeInput || recordSettings.autoQuantize) {
+            quantizeEvents(take.sequence, recordSettings.quantizeGrid);
+        } else {
+            take.sequence.updateMatchedPairs();
+        }
+        
+        commitTake(*recordingTrack, take, takeGroup, i, numTakes);
+    }
+    
+    LOG_INFO("Committed %d MIDI events to track %s",
+             static_cast<int>(recordedEvents.size()), recordingTrack->getName().toRawUTF8());
 }
 
 void MIDISequencer::clearRecordingState() {
     recording = false;
     recordingTrack = nullptr;
-    recordingSequence.clear();
+    recordedEvents.clear();  // Keeps the reserved capacity for the next take
     recordingStartTime = 0.0;
+    recordingEndTime = 0.0;
+}
+
+double MIDISequencer::clockToTimeline(double clockSeconds) const {
+    return recordingStartTime + juce::jmax(0.0, clockSeconds - recordingStartClock);
+}
+
+int MIDISequencer::getLoopPass(double time, double& position) const {
+    const double loopLength = loopEndTime - loopStartTime;
+    if (!recordingLooped || loopLength <= 0.0 ||
+        recordingStartTime >= loopEndTime || time < loopEndTime) {
+        position = time;
+        return 0;
+    }
+    
+    // The transport jumps back to the loop start every time it reaches the end
+    const double sinceFirstWrap = time - loopEndTime;
+    const auto wraps = static_cast<int>(sinceFirstWrap / loopLength);
+    position = loopStartTime + (sinceFirstWrap - wraps * loopLength);
+    return wraps + 1;
 }
 
-double MIDISequencer::quantizeTime(double time) const {
-    return std::round(time / recordSettings.quantizeGrid) * recordSettings.quantizeGrid;
+std::vector<MIDISequencer::RecordedTake> MIDISequencer::buildTakes() const {
+    const auto& tempoMap = currentProject->getTempoMap();
+    
+    double endPosition = 0.0;
+    const int lastPass = getLoopPass(recordingEndTime, endPosition);
+    
+    std::vector<RecordedTake> takes(static_cast<size_t>(lastPass + 1));
+    for (int pass = 0; pass <= lastPass; ++pass) {
+        auto& take = takes[static_cast<size_t>(pass)];
+        take.startTime = pass == 0 ? recordingStartTime : loopStartTime;
+        take.endTime = pass == lastPass ? endPosition : loopEndTime;
+        take.endTime = juce::jmax(take.startTime, take.endTime);
+    }
+    
+    // Notes still held when a pass ends are cut there, and note-offs that
+    // arrive in a later pass are dropped, so every take is self-contained
+    std::array<std::array<juce::uint8, 128>, 16> held{};
+    int currentPass = 0;
+    
+    auto closeHeldNotes = [&](RecordedTake& take) {
+        const double endBeat = tempoMap.secondsToBeat(take.endTime);
+        for (int channel = 0; channel < 16; ++channel) {
+            for (int note = 0; note < 128; ++note) {
+                for (; held[channel][note] > 0; --held[channel][note]) {
+                    take.sequence.addEvent(juce::MidiMessage::noteOff(channel + 1, note), endBeat);
+                }
+            }
+        }
+    };
+    
+    for (const auto& event : recordedEvents) {
+        double position = 0.0;
+        const int pass = juce::jmin(lastPass, getLoopPass(event.time, position));
+        for (; currentPass < pass; ++currentPass) {
+            closeHeldNotes(takes[static_cast<size_t>(currentPass)]);
+        }
+        
+        const auto& message = event.message;
+        if (message.isNoteOnOrOff()) {
+            auto& count = held[message.getChannel() - 1][message.getNoteNumber()];
+            if (message.isNoteOn()) {
+                ++count;
+            } else if (count > 0) {
+                --count;
+            } else {
+                continue;
+            }
+        }
+        
+        // Events of one pass arrive in order, so this appends in O(1)
+        juce::MidiMessage stamped(message);
+        stamped.setTimeStamp(tempoMap.secondsToBeat(position));
+        takes[static_cast<size_t>(pass)].sequence.addEvent(stamped);
+    }
+    
+    for (; currentPass <= lastPass; ++currentPass) {
+        closeHeldNotes(takes[static_cast<size_t>(currentPass)]);
+    }
+    
+    return takes;
+}
+
+void MIDISequencer::commitTake(Track& track, const RecordedTake& take,
+                               const juce::String& takeGroup, int takeIndex, int numTakes) {
+    const auto& tempoMap = currentProject->getTempoMap();
+    
+    if (recordSettings.overdubMode) {
+        // Merge into the MIDI clip the recording started in, if any
+        auto* clip = track.getClipAt(take.startTime);
+        if (clip != nullptr && clip->getType() == Clip::Type::MIDI) {
+            juce::MidiMessageSequence merged(clip->getMIDISequence());
+            merged.addSequence(take.sequence, -tempoMap.secondsToBeat(clip->getStartTime()));
+            merged.updateMatchedPairs();
+            
+            const double length = juce::jmax(clip->getLength(), take.endTime - clip->getStartTime());
+            replaceClipSequence(track, *clip, merged, length);
+            return;
+        }
+    } else if (recordSettings.replaceMode) {
+        eraseRange(track, take.startTime, take.endTime);
+    }
+    
+    juce::MidiMessageSequence sequence(take.sequence);
+    sequence.addTimeToMessages(-tempoMap.secondsToBeat(take.startTime));
+    sequence.updateMatchedPairs();
+    
+    auto clip = std::make_unique<Clip>(Clip::Type::MIDI);
+    clip->setName(track.getName());
+    clip->setStartTime(take.startTime);
+    clip->setLength(take.endTime - take.startTime);
+    clip->setMIDISequence(sequence);
+    
+    if (numTakes > 1) {
+        clip->setName(clip->getName() + " Take " + juce::String(takeIndex + 1));
+        clip->setTake(takeGroup, takeIndex);
+        clip->setMuted(takeIndex != numTakes - 1);
+    }
+    
+    track.addClip(std::move(clip));
+}
+
+void MIDISequencer::eraseRange(Track& track, double startTime, double endTime) {
+    const auto& tempoMap = currentProject->getTempoMap();
+    
+    for (auto* clip : track.getClipsInRange(startTime, endTime)) {
+        if (clip->getType() != Clip::Type::MIDI) {
+            continue;
+        }
+        
+        const double clipStart = clip->getStartTime();
+        const double clipEnd = clipStart + clip->getLength();
+        if (clipStart >= startTime && clipEnd <= endTime) {
+            track.removeClip(clip);
+            continue;
+        }
+        
+        // Keep what lies outside the range; notes sounding into it are cut
+        // at its start
+        const double clipStartBeat = tempoMap.secondsToBeat(clipStart);
+        const double fromBeat = tempoMap.secondsToBeat(startTime) - clipStartBeat;
+        const double toBeat = tempoMap.secondsToBeat(endTime) - clipStartBeat;
+        const auto& sequence = clip->getMIDISequence();
+        
+        juce::MidiMessageSequence kept;
+        for (int i = 0; i < sequence.getNumEvents(); ++i) {
+            const auto* event = sequence.getEventPointer(i);
+            const auto& message = event->message;
+            const double beat = message.getTimeStamp();
+            const bool outside = beat < fromBeat || beat >= toBeat;
+            
+            if (message.isNoteOff()) {
+                continue;  // Re-added with its note-on
+            }
+            
+            if (!outside) {
+                continue;
+            }
+            
+            kept.addEvent(message);
+            if (message.isNoteOn() && event->noteOffObject != nullptr) {
+                const double offBeat = event->noteOffObject->message.getTimeStamp();
+                kept.addEvent(event->noteOffObject->message,
+                              beat < fromBeat && offBeat > fromBeat ? fromBeat - offBeat : 0.0);
+            }
+        }
+        
+        kept.updateMatchedPairs();
+        replaceClipSequence(track, *clip, kept, clip->getLength());
+    }
+}
+
+void MIDISequencer::replaceClipSequence(Track& track, Clip& clip,
+                                        const juce::MidiMessageSequence& sequence,
+                                        double length) {
+    // Replaced rather than edited in place, so the track's clip index
+    // picks up the new length
+    auto replacement = std::make_unique<Clip>(Clip::Type::MIDI);
+    replacement->restoreState(clip.getState());
+    replacement->setMIDISequence(sequence);
+    replacement->setLength(length);
+    
+    track.removeClip(&clip);
+    track.addClip(std::move(replacement));
 }
 
 int MIDISequencer::processVelocity(int velocity) const {
@@ -465,10 +662,10 @@ int MIDISequencer::processVelocity(int velocity) const {
             return velocity;
             
         case 1:  // Fixed
-            return static_cast<int>(recordSettings.velocityValue);
+            return juce::jlimit(1, 127, static_cast<int>(recordSettings.velocityValue));
             
         case 2:  // Scaled
-            return static_cast<int>(velocity * recordSettings.velocityScale);
+            return juce::jlimit(1, 127, static_cast<int>(velocity * recordSettings.velocityScale));
             
         default:
             return velocity;
@@ -494,29 +691,6 @@ bool MIDISequencer::shouldProcessMessage(const juce::MidiMessage& message) const
     return true;
 }
 
-juce::String MIDISequencer::getMTCString(double time, int format) {
-    const int frameRate = getMTCFrameRate(format);
-    const int totalFrames = static_cast<int>(time * frameRate);
-    
-    const int hours = totalFrames / (frameRate * 3600);
-    const int minutes = (totalFrames % (frameRate * 3600)) / (frameRate * 60);
-    const int seconds = (totalFrames % (frameRate * 60)) / frameRate;
-    const int frames = totalFrames % frameRate;
-    
-    return juce::String::formatted("%02d:%02d:%02d:%02d",
-                                 hours, minutes, seconds, frames);
-}
-
-int MIDISequencer::getMTCFrameRate(int format) {
-    switch (format) {
-        case 0: return 24;  // 24 fps
-        case 1: return 25;  // 25 fps
-        case 2: return 30;  // 30 fps drop
-        case 3: return 30;  // 30 fps
-        default: return 25;
-    }
-}
-
 //==============================================================================
 // MIDISequencerUtils Implementation
 //==============================================================================
@@ -586,6 +760,53 @@ namespace MIDISequencerUtils {
         return static_cast<int>((time * bpm * ppq) / 60.0);
     }
 
+    double ticksToTime(int ticks, int ppq, const TempoMap& tempoMap) {
+        return tempoMap.beatToSeconds(static_cast<double>(ticks) / ppq);
+    }
+
+    int timeToTicks(double time, int ppq, const TempoMap& tempoMap) {
+        return static_cast<int>(tempoMap.secondsToBeat(time) * ppq);
+    }
+
+    void renderSequenceBlock(const juce::MidiMessageSequence& sequence,
+                           double clipStartBeat,
+                           TempoMap::Cursor& tempoCursor,
+                           int64_t blockStartSample,
+                           int numSamples,
+                           double sampleRate,
+                           juce::MidiBuffer& midiMessages) {
+        const int64_t blockEndSample = blockStartSample + numSamples;
+        const double startBeat = tempoCursor.samplesToBeat(blockStartSample, sampleRate) - clipStartBeat;
+        const double endBeat = tempoCursor.samplesToBeat(blockEndSample, sampleRate) - clipStartBeat;
+        
+        // Events are sorted, so binary search to the first one in the block
+        const int numEvents = sequence.getNumEvents();
+        int first = 0;
+        int count = numEvents;
+        while (count > 0) {
+            const int step = count / 2;
+            if (sequence.getEventPointer(first + step)->message.getTimeStamp() < startBeat) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        
+        for (int i = first; i < numEvents; ++i) {
+            const auto& message = sequence.getEventPointer(i)->message;
+            const double beat = message.getTimeStamp();
+            if (beat >= endBeat) {
+                break;
+            }
+            
+            const int64_t eventSample = tempoCursor.beatToSamples(clipStartBeat + beat, sampleRate);
+            const int offset = static_cast<int>(juce::jlimit<int64_t>(0, numSamples - 1,
+                                                                      eventSample - blockStartSample));
+            midiMessages.addEvent(message, offset);
+        }
+    }
+
     void filterChannelMessages(juce::MidiMessageSequence& sequence,
                              int channel) {
         for (int i = sequence.getNumEvents() - 1; i >= 0; --i) {
@@ -636,13 +857,19 @@ namespace MIDISequencerUtils {
     void generateMidiTimeCode(juce::MidiMessageSequence& sequence,
                            double duration,
                            int format) {
-        const int frameRate = format == 1 ? 25 : 30;
-        const double frameTime = 1.0 / frameRate;
-        double time = 0.0;
+        const double quarterFrameTime = 1.0 / (MIDIUtils::getMTCFrameRate(format) * 4.0);
         
-        while (time < duration) {
-            // TODO: Generate MTC quarter-frame messages
-            time += frameTime;
+        for (int64_t index = 0;; ++index) {
+            const double time = static_cast<double>(index) * quarterFrameTime;
+            if (time >= duration) {
+                break;
+            }
+            
+            // Each group of 8 pieces carries the frame its first piece is on
+            const auto piece = static_cast<int>(index & 7);
+            int hours = 0, minutes = 0, seconds = 0, frames = 0;
+            MIDIUtils::framesToTimecode((index - piece) / 4, format, hours, minutes, seconds, frames);
+            sequence.addEvent(MIDIUtils::createQuarterFrame(piece, hours, minutes, seconds, frames, format), time);
         }
     }
 }
\ No newline at end of file
@@ -1,8 +1,12 @@
 #pragma once
 #include <JuceHeader.h>
+#include <vector>
+#include "TempoMap.h"
 
+class Clip;
 class Track;
 class Project;
+class Transport;
 
 class MIDISequencer : public juce::ChangeBroadcaster {
 public:
@@ -70,8 +74,14 @@ public:
     void setSendControlChanges(bool shouldSend);
     void setSendSysEx(bool shouldSend);
 
-    // Recording control
-    void startRecording(Track* track);
+    // Recording control. Takes are committed to the track as MIDI clips when
+    // recording stops: replace mode clears what was under the recording,
+    // overdub mode merges into the clip already there (and layers loop
+    // passes), otherwise each loop pass becomes a take of its own. The
+    // transport reaches startSample leadInSamples from now (e.g. after a
+    // count-in).
+    void startRecording(Track* track, const Transport& transport,
+                        int64_t startSample, int64_t leadInSamples = 0);
     void stopRecording();
     bool isRecording() const { return recording; }
     Track* getRecordingTrack() const { return recordingTrack; }
@@ -80,10 +90,9 @@ public:
     void handleIncomingMidiMessage(const juce::MidiMessage& message);
     void processInputBuffer(juce::MidiBuffer& buffer);
 
-    // MIDI output handling
+    // MIDI output handling. Clock and MTC are generated sample-accurately by
+    // MIDISyncGenerator on the audio thread.
     void processOutputBuffer(juce::MidiBuffer& buffer, double position);
-    void sendMidiClock(double position);
-    void sendMidiTimeCode(double position);
     void sendMidiMachineControl(int command);
 
     // Event processing
@@ -106,33 +115,54 @@ private:
     RecordingSettings recordSettings;
     PlaybackSettings playbackSettings;
     
-    // Recording state
+    // One incoming event, stamped in unwrapped timeline seconds
+    struct RecordedEvent {
+        juce::MidiMessage message;
+        double time{0.0};
+    };
+    
+    // One loop pass of a recording, beat-stamped on the timeline
+    struct RecordedTake {
+        juce::MidiMessageSequence sequence;
+        double startTime{0.0};
+        double endTime{0.0};
+    };
+    
+    static constexpr size_t recordBufferSize = 16384;  // Events reserved up front
+    
+    // Recording state. Events are only appended while recording; sorting
+    // into takes and matching note pairs happens once, when it stops.
     bool recording{false};
     Track* recordingTrack{nullptr};
-    juce::MidiMessageSequence recordingSequence;
-    double recordingStartTime{0.0};
+    std::vector<RecordedEvent> recordedEvents;
+    double recordingStartTime{0.0};   // Timeline seconds
+    double recordingStartClock{0.0};  // MIDI input clock seconds at the same moment
+    double recordingEndTime{0.0};
+    bool recordingLooped{false};
+    double loopStartTime{0.0};
+    double loopEndTime{0.0};
     
     // MIDI processing
     juce::MidiBuffer inputBuffer;
     juce::MidiBuffer outputBuffer;
     juce::CriticalSection midiLock;
     
-    // MIDI timing
-    double lastClockTime{0.0};
-    double lastMTCTime{0.0};
-    int mtcFrameCount{0};
-    
     // Internal helpers
     void processRecordedMessage(const juce::MidiMessage& message, double time);
     void finalizeRecording();
     void clearRecordingState();
     
-    double quantizeTime(double time) const;
+    double clockToTimeline(double clockSeconds) const;
+    int getLoopPass(double time, double& position) const;
+    std::vector<RecordedTake> buildTakes() const;
+    void commitTake(Track& track, const RecordedTake& take, const juce::String& takeGroup,
+                    int takeIndex, int numTakes);
+    void eraseRange(Track& track, double startTime, double endTime);
+    void replaceClipSequence(Track& track, Clip& clip,
+                             const juce::MidiMessageSequence& sequence, double length);
+    
     int processVelocity(int velocity) const;
     bool shouldProcessMessage(const juce::MidiMessage& message) const;
-    
-    static juce::String getMTCString(double time, int format);
-    static int getMTCFrameRate(int format);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDISequencer)
 };
@@ -154,6 +184,19 @@ namespace MIDISequencerUtils {
     // Time conversion
     double ticksToTime(int ticks, int ppq, double bpm);
     int timeToTicks(double time, int ppq, double bpm);
+    double ticksToTime(int ticks, int ppq, const TempoMap& tempoMap);
+    int timeToTicks(double time, int ppq, const TempoMap& tempoMap);
+    
+    // Adds the events of a beat-stamped sequence (clip starting at
+    // clipStartBeat) that fall inside the block to midiMessages, at their
+    // sample offsets according to the tempo map
+    void renderSequenceBlock(const juce::MidiMessageSequence& sequence,
+                           double clipStartBeat,
+                           TempoMap::Cursor& tempoCursor,
+                           int64_t blockStartSample,
+                           int numSamples,
+                           double sampleRate,
+                           juce::MidiBuffer& midiMessages);
     
     // Event filtering
     void filterChannelMessages(juce::MidiMessageSequence& sequence, int channel);
@@ -168,5 +211,5 @@ namespace MIDISequencerUtils {
                          double bpm);
     void generateMidiTimeCode(juce::MidiMessageSequence& sequence,
                            double duration,
-                           int format);
+                           int format);  // Quarter-frames, see MIDIUtils
 }
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "MIDISyncGenerator.h"
+#include "MIDIUtils.h"
+
+//==============================================================================
+// MIDISyncGenerator Implementation
+//==============================================================================
+
+void MIDISyncGenerator::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+
+    cursor.setMap(nullptr);
+    wasPlaying = false;
+    wasRecording = false;
+    expectedPosition = 0;
+}
+
+void MIDISyncGenerator::render(juce::MidiBuffer& output,
+                               const Transport::Segment& segment,
+                               const TempoMap* tempoMap) {
+    // Slaves start with the transport, not with the count-in
+    if (segment.countingIn) {
+        return;
+    }
+
+    cursor.setMap(tempoMap);
+
+    const bool jumped = segment.position != expectedPosition;
+    if (segment.playing != wasPlaying || segment.recording != wasRecording || jumped) {
+        renderTransportChange(output, segment, tempoMap, jumped);
+    }
+
+    if (segment.playing) {
+        if (clockEnabled.load(std::memory_order_relaxed) && tempoMap != nullptr) {
+            renderClock(output, segment);
+        }
+
+        if (mtcEnabled.load(std::memory_order_relaxed)) {
+            renderTimecode(output, segment, mtcFormat.load(std::memory_order_relaxed));
+        }
+    }
+
+    wasPlaying = segment.playing;
+    wasRecording = segment.recording;
+    expectedPosition = segment.position + (segment.playing ? segment.numSamples : 0);
+}
+
+void MIDISyncGenerator::renderTransportChange(juce::MidiBuffer& output,
+                                              const Transport::Segment& segment,
+                                              const TempoMap* tempoMap,
+                                              bool jumped) {
+    const int offset = segment.startSample;
+    const bool started = segment.playing && !wasPlaying;
+    const bool stopped = !segment.playing && wasPlaying;
+    const bool sendClock = clockEnabled.load(std::memory_order_relaxed);
+    const bool sendMMC = mmcEnabled.load(std::memory_order_relaxed);
+    const int format = mtcFormat.load(std::memory_order_relaxed);
+
+    int hours = 0, minutes = 0, seconds = 0, frames = 0;
+    MIDIUtils::framesToTimecode(getFrameAt(segment.position, format), format,
+                                hours, minutes, seconds, frames);
+
+    // Stop first, so a jump while playing restarts slaves from the new position
+    if (stopped || (segment.playing && jumped && !started)) {
+        if (sendClock) {
+            output.addEvent(juce::MidiMessage::midiStop(), offset);
+        }
+        if (sendMMC && stopped) {
+            output.addEvent(juce::MidiMessage::midiMachineControlCommand(
+                juce::MidiMessage::mmc_stop), offset);
+        }
+    }
+
+    if (started || jumped) {
+        if (sendClock && tempoMap != nullptr) {
+            // Song position counts sixteenth notes
+            const double beat = cursor.samplesToBeat(segment.position, sampleRate);
+            const int sixteenths = juce::jlimit(0, 0x3FFF, static_cast<int>(std::floor(beat * 4.0 + 1.0e-9)));
+            output.addEvent(juce::MidiMessage::songPositionPointer(sixteenths), offset);
+        }
+
+        if (mtcEnabled.load(std::memory_order_relaxed)) {
+            output.addEvent(juce::MidiMessage::fullFrame(
+                hours, minutes, seconds, frames,
+                static_cast<juce::MidiMessage::SmpteTimecodeType>(format)), offset);
+        }
+
+        if (sendMMC) {
+            output.addEvent(juce::MidiMessage::midiMachineControlGoto(
+                hours, minutes, seconds, frames), offset);
+        }
+    }
+
+    if (segment.playing && (started || jumped)) {
+        if (sendClock) {
+            output.addEvent(segment.position == 0 && started ? juce::MidiMessage::midiStart()
+                                                             : juce::MidiMessage::midiContinue(),
+                            offset);
+        }
+        if (sendMMC && started) {
+            output.addEvent(juce::MidiMessage::midiMachineControlCommand(
+                juce::MidiMessage::mmc_play), offset);
+        }
+    }
+
+    if (sendMMC && segment.recording != wasRecording) {
+        output.addEvent(juce::MidiMessage::midiMachineControlCommand(
+            segment.recording ? juce::MidiMessage::mmc_recordStart
+                              : juce::MidiMessage::mmc_recordStop), offset);
+    }
+}
+
+void MIDISyncGenerator::renderClock(juce::MidiBuffer& output, const Transport::Segment& segment) {
+    const int64_t start = segment.position;
+    const int64_t end = start + segment.numSamples;
+
+    // A tick belongs to the segment its rounded sample falls in. Start one
+    // sample early so a tick rounding onto the first sample is not lost.
+    auto tick = static_cast<int64_t>(std::floor(cursor.samplesToBeat(start - 1, sampleRate) * clocksPerBeat));
+
+    for (int i = 0; i < maxMessagesPerSegment; ++i, ++tick) {
+        const int64_t tickPosition = cursor.beatToSamples(static_cast<double>(tick) / clocksPerBeat, sampleRate);
+        if (tickPosition >= end) {
+            break;
+        }
+
+        if (tickPosition >= start) {
+            output.addEvent(juce::MidiMessage::midiClock(),
+                            segment.startSample + static_cast<int>(tickPosition - start));
+        }
+    }
+}
+
+void MIDISyncGenerator::renderTimecode(juce::MidiBuffer& output,
+                                       const Transport::Segment& segment,
+                                       int format) {
+    const int64_t start = segment.position;
+    const int64_t end = start + segment.numSamples;
+
+    // Quarter-frames run at four per frame from timeline zero; the 8 pieces
+    // of a group carry the frame their first piece was sent on
+    const double quarterFramesPerSample = MIDIUtils::getMTCFrameRate(format) * 4.0 / sampleRate;
+    auto quarterFrameAt = [&](int64_t index) {
+        return static_cast<int64_t>(std::llround(static_cast<double>(index) / quarterFramesPerSample));
+    };
+
+    auto index = static_cast<int64_t>(std::ceil(static_cast<double>(juce::jmax<int64_t>(0, start)) * quarterFramesPerSample));
+    while (index > 0 && quarterFrameAt(index - 1) >= start) {
+        --index;
+    }
+
+    for (int i = 0; i < maxMessagesPerSegment; ++i, ++index) {
+        const int64_t position = quarterFrameAt(index);
+        if (position >= end) {
+            break;
+        }
+
+        if (position < start) {
+            continue;
+        }
+
+        const auto piece = static_cast<int>(index & 7);
+        int hours = 0, minutes = 0, seconds = 0, frames = 0;
+        MIDIUtils::framesToTimecode((index - piece) / 4, format, hours, minutes, seconds, frames);
+
+        output.addEvent(MIDIUtils::createQuarterFrame(piece, hours, minutes, seconds, frames, format),
+                        segment.startSample + static_cast<int>(position - start));
+    }
+}
+
+int64_t MIDISyncGenerator::getFrameAt(int64_t position, int format) const {
+    const double seconds = static_cast<double>(juce::jmax<int64_t>(0, position)) / sampleRate;
+    return static_cast<int64_t>(seconds * MIDIUtils::getMTCFrameRate(format) + 1.0e-9);
+}
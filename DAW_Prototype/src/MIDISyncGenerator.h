@@ -0,0 +1,66 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include "Transport.h"
+#include "TempoMap.h"
+
+// Generates MIDI clock, MTC and MMC from the transport on the audio thread.
+//
+// Like the metronome, it renders one transport segment at a time, so every
+// message lands on its exact sample within the device block at any buffer
+// size and across loop wraps. Clock ticks follow the tempo map (24 per
+// quarter note); MTC quarter-frames follow the timeline in seconds, in any
+// of the four MTC rates. Transport changes (start, stop, locate, loop wrap,
+// record) are sent as Start/Stop/Continue with a song position, an MTC full
+// frame and MMC commands.
+class MIDISyncGenerator {
+public:
+    // Constructor/Destructor
+    MIDISyncGenerator() = default;
+    ~MIDISyncGenerator() = default;
+
+    // Call while the audio callback is stopped
+    void prepare(double sampleRate);
+
+    // Settings (any thread)
+    void setClockEnabled(bool shouldSend) { clockEnabled = shouldSend; }
+    bool isClockEnabled() const { return clockEnabled; }
+    void setMTCEnabled(bool shouldSend) { mtcEnabled = shouldSend; }
+    bool isMTCEnabled() const { return mtcEnabled; }
+    void setMTCFormat(int format) { mtcFormat = juce::jlimit(0, 3, format); }
+    int getMTCFormat() const { return mtcFormat; }
+    void setMMCEnabled(bool shouldSend) { mmcEnabled = shouldSend; }
+    bool isMMCEnabled() const { return mmcEnabled; }
+
+    // Audio thread: adds the sync messages for one transport segment to
+    // output, at offsets into the device block
+    void render(juce::MidiBuffer& output,
+                const Transport::Segment& segment,
+                const TempoMap* tempoMap);
+
+private:
+    static constexpr int clocksPerBeat = 24;
+    static constexpr int maxMessagesPerSegment = 1024;
+
+    double sampleRate{44100.0};
+
+    std::atomic<bool> clockEnabled{false};
+    std::atomic<bool> mtcEnabled{false};
+    std::atomic<int> mtcFormat{0};
+    std::atomic<bool> mmcEnabled{false};
+
+    // Audio thread state
+    TempoMap::Cursor cursor;
+    bool wasPlaying{false};
+    bool wasRecording{false};
+    int64_t expectedPosition{0};  // Where the next segment starts if nothing jumps
+
+    void renderTransportChange(juce::MidiBuffer& output, const Transport::Segment& segment,
+                               const TempoMap* tempoMap, bool jumped);
+    void renderClock(juce::MidiBuffer& output, const Transport::Segment& segment);
+    void renderTimecode(juce::MidiBuffer& output, const Transport::Segment& segment, int format);
+
+    int64_t getFrameAt(int64_t position, int format) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDISyncGenerator)
+};
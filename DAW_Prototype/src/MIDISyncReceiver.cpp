@@ -0,0 +1,267 @@
+#include "MIDISyncReceiver.h"
+#include "MIDIUtils.h"
+
+namespace {
+    constexpr double defaultClockPeriod = 60.0 / (120.0 * 24.0);
+}
+
+//==============================================================================
+// MIDISyncReceiver Implementation
+//==============================================================================
+
+void MIDISyncReceiver::setSource(Source newSource) {
+    source = newSource;
+}
+
+bool MIDISyncReceiver::handleMessage(const juce::MidiMessage& message, double time) {
+    const auto currentSource = getSource();
+    if (currentSource != activeSource) {
+        reset(currentSource);
+    }
+
+    switch (currentSource) {
+        case Source::Clock:
+            return handleClock(message, time);
+
+        case Source::MTC:
+            return handleTimecode(message, time);
+
+        default:
+            return false;
+    }
+}
+
+MIDISyncReceiver::Estimate MIDISyncReceiver::getEstimate(double time) const {
+    Source snapshotSource;
+    bool snapshotRunning, snapshotLocked;
+    double tickTime, position, period, units;
+
+    // Retry if the MIDI thread published while we were reading
+    for (;;) {
+        const uint32_t before = sequence.load(std::memory_order_acquire);
+        snapshotSource = publishedSource.load(std::memory_order_relaxed);
+        snapshotRunning = publishedRunning.load(std::memory_order_relaxed);
+        snapshotLocked = publishedLocked.load(std::memory_order_relaxed);
+        tickTime = publishedTime.load(std::memory_order_relaxed);
+        position = publishedPosition.load(std::memory_order_relaxed);
+        period = publishedPeriod.load(std::memory_order_relaxed);
+        units = publishedUnitsPerTick.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if ((before & 1) == 0 && sequence.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    Estimate estimate;
+    if (snapshotSource != getSource() || period <= 0.0) {
+        return estimate;
+    }
+
+    estimate.position = position;
+
+    // A source that has gone quiet has stopped, whatever it last said
+    const double elapsed = time - tickTime;
+    if (!snapshotRunning || elapsed > timeoutTicks * period) {
+        return estimate;
+    }
+
+    estimate.running = true;
+    estimate.locked = snapshotLocked;
+    estimate.rate = units / period;
+    estimate.position = position + juce::jmax(0.0, elapsed) * estimate.rate;
+    return estimate;
+}
+
+bool MIDISyncReceiver::handleClock(const juce::MidiMessage& message, double time) {
+    if (message.isMidiClock()) {
+        if (running) {
+            tick(time);
+        }
+        return true;
+    }
+
+    if (message.isMidiStart()) {
+        locate(0.0);
+        running = true;
+        loop.reset(loop.period);
+        publish();
+        return true;
+    }
+
+    if (message.isMidiContinue()) {
+        running = true;
+        loop.reset(loop.period);
+        publish();
+        return true;
+    }
+
+    if (message.isMidiStop()) {
+        running = false;
+        publish();
+        return true;
+    }
+
+    if (message.isSongPositionPointer()) {
+        // Counted in sixteenth notes
+        locate(message.getSongPositionPointerMidiBeat() / 4.0);
+        publish();
+        return true;
+    }
+
+    return false;
+}
+
+bool MIDISyncReceiver::handleTimecode(const juce::MidiMessage& message, double time) {
+    if (message.isQuarterFrame()) {
+        const int piece = message.getQuarterFrameSequenceNumber();
+        mtcPieces[piece] = message.getQuarterFrameValue();
+
+        // Pieces must arrive in order; anything else (a jump, reverse play)
+        // starts the assembly again
+        if (lastPiece >= 0 && piece == (lastPiece + 1) % 8) {
+            ++consecutivePieces;
+            if (running) {
+                tick(time);
+            }
+        } else {
+            consecutivePieces = piece == 0 ? 1 : 0;
+            if (running) {
+                running = false;
+                publish();
+            }
+        }
+        lastPiece = piece;
+
+        // A complete group carries the frame its first piece was sent on;
+        // this piece is the eighth quarter-frame from there
+        if (piece == 7 && consecutivePieces >= 8) {
+            const int format = (mtcPieces[7] >> 1) & 0x03;
+            const int frames = mtcPieces[0] | ((mtcPieces[1] & 0x01) << 4);
+            const int seconds = mtcPieces[2] | ((mtcPieces[3] & 0x03) << 4);
+            const int minutes = mtcPieces[4] | ((mtcPieces[5] & 0x03) << 4);
+            const int hours = mtcPieces[6] | ((mtcPieces[7] & 0x01) << 4);
+
+            const double quarterFramesPerSecond = MIDIUtils::getMTCFrameRate(format) * 4.0;
+            const auto quarterFrame = MIDIUtils::timecodeToFrames(hours, minutes, seconds, frames, format) * 4 + 7;
+            const double position = static_cast<double>(quarterFrame) / quarterFramesPerSecond;
+
+            unitsPerTick = 1.0 / quarterFramesPerSecond;
+
+            if (!running || std::abs(position - tickPosition) > unitsPerTick * 0.5) {
+                running = true;
+                tickPosition = position;
+                loop.reset(unitsPerTick);
+                loop.update(time, bandwidth.load(std::memory_order_relaxed));
+                publish();
+            }
+        }
+        return true;
+    }
+
+    if (MIDIUtils::isMTCFullFrameMessage(message)) {
+        int hours = 0, minutes = 0, seconds = 0, frames = 0, format = 0;
+        MIDIUtils::parseMTCFullFrame(message, hours, minutes, seconds, frames, format);
+
+        // Full frames are sent while stopped or shuttling
+        running = false;
+        lastPiece = -1;
+        consecutivePieces = 0;
+        tickPosition = static_cast<double>(MIDIUtils::timecodeToFrames(hours, minutes, seconds, frames, format)) /
+                       MIDIUtils::getMTCFrameRate(format);
+        publish();
+        return true;
+    }
+
+    return false;
+}
+
+void MIDISyncReceiver::reset(Source newSource) {
+    activeSource = newSource;
+    running = false;
+    tickPosition = 0.0;
+    unitsPerTick = newSource == Source::Clock ? 1.0 / clocksPerBeat : 0.0;  // MTC: set by the first group
+    lastPiece = -1;
+    consecutivePieces = 0;
+    loop = Loop();
+    publish();
+}
+
+void MIDISyncReceiver::locate(double position) {
+    // The next tick lands on the new position
+    tickPosition = position - unitsPerTick;
+}
+
+void MIDISyncReceiver::tick(double time) {
+    // After a gap the old phase is meaningless; keep only the rate
+    if (loop.started && time - loop.nextTime > timeoutTicks * loop.period) {
+        loop.reset(loop.period);
+    }
+
+    tickPosition += unitsPerTick;
+    loop.update(time, bandwidth.load(std::memory_order_relaxed));
+    publish();
+}
+
+void MIDISyncReceiver::publish() {
+    const uint32_t current = sequence.load(std::memory_order_relaxed);
+    sequence.store(current + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    publishedSource.store(activeSource, std::memory_order_relaxed);
+    publishedRunning.store(running && loop.started, std::memory_order_relaxed);
+    publishedLocked.store(loop.ticks >= ticksToLock, std::memory_order_relaxed);
+    publishedTime.store(loop.filteredTime, std::memory_order_relaxed);
+    publishedPosition.store(tickPosition, std::memory_order_relaxed);
+    publishedPeriod.store(loop.period, std::memory_order_relaxed);
+    publishedUnitsPerTick.store(unitsPerTick, std::memory_order_relaxed);
+
+    sequence.store(current + 2, std::memory_order_release);
+}
+
+//==============================================================================
+// Delay-locked loop
+//==============================================================================
+
+void MIDISyncReceiver::Loop::reset(double newNominalPeriod) {
+    started = false;
+    nominalPeriod = newNominalPeriod;
+    ticks = 0;
+}
+
+void MIDISyncReceiver::Loop::update(double time, double bandwidthHz) {
+    if (!started) {
+        started = true;
+        period = nominalPeriod > 0.0 ? nominalPeriod : defaultClockPeriod;
+        startTime = time;
+        filteredTime = time;
+        nextTime = time + period;
+        ticks = 1;
+        return;
+    }
+
+    // A clock's tempo is unknown until it has ticked. Start the loop from
+    // the average of the first intervals instead of slewing from a guess,
+    // which would still be off when the lock is reported.
+    if (nominalPeriod <= 0.0 && ticks < seedTicks) {
+        if (time > startTime) {
+            period = (time - startTime) / ticks;
+        }
+        filteredTime = time;
+        nextTime = time + period;
+        ++ticks;
+        return;
+    }
+
+    // Second-order loop, critically damped: the phase error corrects the
+    // predicted tick time, its integral the period
+    const double omega = juce::MathConstants<double>::twoPi * bandwidthHz * period;
+    const double b = juce::MathConstants<double>::sqrt2 * omega;
+    const double c = omega * omega;
+
+    const double error = time - nextTime;
+    filteredTime = nextTime;
+    nextTime += b * error + period;
+    period += c * error;
+    ++ticks;
+}
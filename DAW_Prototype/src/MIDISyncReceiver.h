@@ -0,0 +1,102 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+
+// Follows an external MIDI clock or MTC source.
+//
+// Incoming clock ticks or MTC quarter-frames are fed, with their arrival
+// timestamps, through a second-order delay-locked loop. The loop filters
+// out MIDI jitter and tracks the source's rate, so the position the source
+// is at can be estimated smoothly at any moment, not just when a message
+// arrives. The MIDI input thread updates the loop; the audio thread reads
+// a consistent snapshot of it through a sequence lock and never waits.
+class MIDISyncReceiver {
+public:
+    enum class Source {
+        Internal,
+        Clock,  // 24 PPQN clock with Start/Stop/Continue and song position
+        MTC     // Quarter-frames, with full frames for locating
+    };
+
+    // Where the source is at a given moment
+    struct Estimate {
+        bool running{false};
+        bool locked{false};   // The loop has settled
+        double position{0.0}; // Beats for clock, seconds for MTC
+        double rate{0.0};     // Position units per second
+    };
+
+    // Constructor/Destructor
+    MIDISyncReceiver() = default;
+    ~MIDISyncReceiver() = default;
+
+    // Settings (any thread)
+    void setSource(Source newSource);
+    Source getSource() const { return source.load(std::memory_order_relaxed); }
+
+    // Loop bandwidth in Hz. Lower rejects more jitter but follows tempo
+    // changes more slowly.
+    void setBandwidth(double hz) { bandwidth = juce::jlimit(0.05, 10.0, hz); }
+
+    // MIDI input thread. time is the arrival time in seconds on the
+    // Time::getMillisecondCounterHiRes() clock, as MidiInput stamps it.
+    // Returns true if the message was consumed as sync.
+    bool handleMessage(const juce::MidiMessage& message, double time);
+
+    // Any thread. Time on the same clock as handleMessage().
+    Estimate getEstimate(double time) const;
+
+private:
+    static constexpr int clocksPerBeat = 24;
+    static constexpr int seedTicks = 7;         // Ticks measured before the loop runs, at an unknown rate
+    static constexpr int ticksToLock = 24;      // Settling time before reporting a lock
+    static constexpr double timeoutTicks = 8.0; // Missing ticks before the source counts as stopped
+
+    std::atomic<Source> source{Source::Internal};
+    std::atomic<double> bandwidth{1.0};
+
+    // Delay-locked loop state (MIDI input thread)
+    struct Loop {
+        bool started{false};
+        double filteredTime{0.0};  // Filtered time of the last tick
+        double nextTime{0.0};      // Predicted time of the next tick
+        double period{0.0};        // Filtered tick period in seconds
+        double nominalPeriod{0.0}; // 0 while the rate is unknown
+        double startTime{0.0};     // Arrival of the first tick
+        int ticks{0};
+
+        void reset(double newNominalPeriod);
+        void update(double time, double bandwidthHz);
+    };
+
+    Loop loop;
+    bool running{false};
+    double tickPosition{0.0};  // Position units of the last tick
+    double unitsPerTick{1.0 / clocksPerBeat};
+
+    Source activeSource{Source::Internal};
+
+    // MTC assembly
+    int mtcPieces[8]{};
+    int lastPiece{-1};
+    int consecutivePieces{0};
+
+    // Published snapshot, guarded by a sequence counter
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<Source> publishedSource{Source::Internal};
+    std::atomic<bool> publishedRunning{false};
+    std::atomic<bool> publishedLocked{false};
+    std::atomic<double> publishedTime{0.0};
+    std::atomic<double> publishedPosition{0.0};
+    std::atomic<double> publishedPeriod{0.0};
+    std::atomic<double> publishedUnitsPerTick{0.0};
+
+    bool handleClock(const juce::MidiMessage& message, double time);
+    bool handleTimecode(const juce::MidiMessage& message, double time);
+    void reset(Source newSource);
+    void locate(double position);
+    void tick(double time);
+    void publish();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDISyncReceiver)
+};
@@ -0,0 +1,68 @@
+#include "MIDISyncSender.h"
+#include <cstring>
+
+//==============================================================================
+// MIDISyncSender Implementation
+//==============================================================================
+
+// Constructor/Destructor
+MIDISyncSender::MIDISyncSender()
+    : juce::Thread("MIDI Sync Sender") {
+}
+
+MIDISyncSender::~MIDISyncSender() {
+    stopThread(2000);
+}
+
+void MIDISyncSender::setOutput(std::unique_ptr<juce::MidiOutput> newOutput) {
+    stopThread(2000);
+    output = std::move(newOutput);
+    fifo.reset();
+
+    if (output != nullptr) {
+        startThread(9);
+    }
+}
+
+void MIDISyncSender::push(const juce::MidiBuffer& block, double startTime, double samplesPerMs) noexcept {
+    for (const auto metadata : block) {
+        if (metadata.numBytes > maxMessageSize) {
+            continue;
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(1, start1, size1, start2, size2);
+        if (size1 == 0) {
+            return;
+        }
+
+        auto& message = messages[static_cast<size_t>(start1)];
+        std::memcpy(message.data, metadata.data, static_cast<size_t>(metadata.numBytes));
+        message.size = metadata.numBytes;
+        message.time = startTime + metadata.samplePosition / samplesPerMs;
+        fifo.finishedWrite(1);
+    }
+}
+
+void MIDISyncSender::run() {
+    while (!threadShouldExit()) {
+        if (fifo.getNumReady() == 0) {
+            wait(1);
+            continue;
+        }
+
+        // Messages arrive in time order, so only the oldest can be due
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(1, start1, size1, start2, size2);
+        const auto& message = messages[static_cast<size_t>(start1)];
+
+        const double remaining = message.time - juce::Time::getMillisecondCounterHiRes();
+        if (remaining > 0.5) {
+            wait(juce::jmax(1, static_cast<int>(remaining)));
+            continue;
+        }
+
+        output->sendMessageNow(juce::MidiMessage(message.data, message.size));
+        fifo.finishedRead(1);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <memory>
+
+// Sends the sync messages rendered on the audio thread to a MIDI output.
+//
+// MidiOutput::sendBlockOfMessages() allocates and locks, so the audio
+// thread only copies each message and the time it is due into a
+// preallocated FIFO. A sender thread sleeps until each message is due and
+// sends it. Messages that do not fit, in size or in the FIFO, are dropped.
+class MIDISyncSender : private juce::Thread {
+public:
+    // Constructor/Destructor
+    MIDISyncSender();
+    ~MIDISyncSender() override;
+
+    // Call while the audio callback is detached. nullptr stops sending.
+    void setOutput(std::unique_ptr<juce::MidiOutput> newOutput);
+    juce::MidiOutput* getOutput() const { return output.get(); }
+
+    // Audio thread. Queues every message of block. The first sample is due
+    // at startTime (ms, on the Time::getMillisecondCounterHiRes() clock),
+    // and offsets advance by samplesPerMs per millisecond.
+    void push(const juce::MidiBuffer& block, double startTime, double samplesPerMs) noexcept;
+
+private:
+    static constexpr int queueSize = 1024;
+    static constexpr int maxMessageSize = 16;  // Fits MTC full frames and MMC locates
+
+    struct Message {
+        juce::uint8 data[maxMessageSize];
+        int size{0};
+        double time{0.0};
+    };
+
+    std::unique_ptr<juce::MidiOutput> output;
+    juce::AbstractFifo fifo{queueSize};
+    std::array<Message, queueSize> messages;
+
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MIDISyncSender)
+};
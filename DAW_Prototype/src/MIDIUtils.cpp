@@ -350,9 +350,9 @@ bool MIDIUtils::isMidiContinueMessage(const juce::MidiMessage& message) {
 juce::MidiMessage MIDIUtils::createFullFrameMessage(int hours, int minutes,
                                                    int seconds, int frames,
                                                    int frameRate) {
-    uint8_t data[10] = { MIDI_MTC_FULL_FRAME, 0x7F, 0x01, 0x01,
-                         static_cast<uint8_t>(frameRate),
-                         static_cast<uint8_t>(hours),
+    // Universal real-time SysEx; the rate lives in bits 5-6 of the hours
+    uint8_t data[10] = { MIDI_MTC_FULL_FRAME, 0x7F, 0x7F, 0x01, 0x01,
+                         static_cast<uint8_t>(((frameRate & 0x03) << 5) | (hours & 0x1F)),
                          static_cast<uint8_t>(minutes),
                          static_cast<uint8_t>(seconds),
                          static_cast<uint8_t>(frames),
@@ -366,8 +366,8 @@ void MIDIUtils::parseMTCFullFrame(const juce::MidiMessage& message,
                                  int& frameRate) {
     if (isMTCFullFrameMessage(message)) {
         const uint8_t* data = message.getRawData();
-        frameRate = data[4];
-        hours = data[5];
+        frameRate = (data[5] >> 5) & 0x03;
+        hours = data[5] & 0x1F;
         minutes = data[6];
         seconds = data[7];
         frames = data[8];
@@ -380,5 +380,77 @@ bool MIDIUtils::isMTCMessage(const juce::MidiMessage& message) {
 }
 
 bool MIDIUtils::isMTCFullFrameMessage(const juce::MidiMessage& message) {
-    return message.getRawData()[0] == MIDI_MTC_FULL_FRAME;
-}
\ No newline at end of file
+    const uint8_t* data = message.getRawData();
+    return message.getRawDataSize() == 10 && data[0] == MIDI_MTC_FULL_FRAME &&
+           data[1] == 0x7F && data[3] == 0x01 && data[4] == 0x01;
+}
+
+double MIDIUtils::getMTCFrameRate(int format) {
+    switch (format) {
+        case 0: return 24.0;
+        case 1: return 25.0;
+        case 2: return 30000.0 / 1001.0;
+        default: return 30.0;
+    }
+}
+
+int MIDIUtils::getMTCNominalFrameRate(int format) {
+    switch (format) {
+        case 0: return 24;
+        case 1: return 25;
+        default: return 30;
+    }
+}
+
+void MIDIUtils::framesToTimecode(int64_t frameCount, int format,
+                                int& hours, int& minutes,
+                                int& seconds, int& frames) {
+    frameCount = std::max<int64_t>(0, frameCount);
+    
+    // Drop-frame skips frame numbers 0 and 1 at the start of every minute
+    // except each tenth, so the numbering keeps up with 29.97 fps
+    if (format == 2) {
+        constexpr int64_t framesPerTenMinutes = 17982;
+        constexpr int64_t framesPerMinute = 1798;
+        
+        const int64_t tens = frameCount / framesPerTenMinutes;
+        const int64_t remainder = frameCount % framesPerTenMinutes;
+        const int64_t dropped = remainder < 2 ? 0 : 2 * ((remainder - 2) / framesPerMinute);
+        frameCount += 18 * tens + dropped;
+    }
+    
+    const int64_t rate = getMTCNominalFrameRate(format);
+    frames = static_cast<int>(frameCount % rate);
+    seconds = static_cast<int>((frameCount / rate) % 60);
+    minutes = static_cast<int>((frameCount / (rate * 60)) % 60);
+    hours = static_cast<int>((frameCount / (rate * 3600)) % 24);
+}
+
+int64_t MIDIUtils::timecodeToFrames(int hours, int minutes,
+                                    int seconds, int frames, int format) {
+    const int64_t rate = getMTCNominalFrameRate(format);
+    int64_t frameCount = ((hours * 3600LL) + minutes * 60LL + seconds) * rate + frames;
+    
+    if (format == 2) {
+        const int64_t totalMinutes = hours * 60LL + minutes;
+        frameCount -= 2 * (totalMinutes - totalMinutes / 10);
+    }
+    
+    return frameCount;
+}
+
+juce::MidiMessage MIDIUtils::createQuarterFrame(int piece, int hours, int minutes,
+                                               int seconds, int frames, int format) {
+    int value = 0;
+    switch (piece & 7) {
+        case 0: value = frames & 0x0F; break;
+        case 1: value = (frames >> 4) & 0x01; break;
+        case 2: value = seconds & 0x0F; break;
+        case 3: value = (seconds >> 4) & 0x03; break;
+        case 4: value = minutes & 0x0F; break;
+        case 5: value = (minutes >> 4) & 0x03; break;
+        case 6: value = hours & 0x0F; break;
+        case 7: value = ((hours >> 4) & 0x01) | ((format & 0x03) << 1); break;
+    }
+    return juce::MidiMessage::quarterFrame(piece & 7, value);
+}
@@ -108,6 +108,20 @@ public:
                                 int& frameRate);
     static bool isMTCMessage(const juce::MidiMessage& message);
     static bool isMTCFullFrameMessage(const juce::MidiMessage& message);
+    
+    // MTC frame counting. Formats follow juce::MidiMessage::SmpteTimecodeType:
+    // 0 = 24, 1 = 25, 2 = 29.97 drop-frame, 3 = 30 fps.
+    static double getMTCFrameRate(int format);         // Real frames per second
+    static int getMTCNominalFrameRate(int format);     // Frames per timecode second
+    static void framesToTimecode(int64_t frameCount, int format,
+                               int& hours, int& minutes,
+                               int& seconds, int& frames);
+    static int64_t timecodeToFrames(int hours, int minutes,
+                                  int seconds, int frames, int format);
+    
+    // Quarter-frame piece 0-7 of the given timecode
+    static juce::MidiMessage createQuarterFrame(int piece, int hours, int minutes,
+                                              int seconds, int frames, int format);
 
 private:
     // Constants
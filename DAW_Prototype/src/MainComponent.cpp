@@ -1,4 +1,5 @@
 #include "MainComponent.h"
+#include "AudioEngine.h"
 #include "Logger.h"
 #include "CustomLookAndFeel.h"
 
@@ -25,7 +26,8 @@ void MainComponent::TransportComponent::resized() {
     grid.templateColumns = {
         Track(Fr(1)), Track(Fr(1)), Track(Fr(1)), Track(Fr(1)),  // Buttons
         Track(Fr(2)),                                            // Time display
-        Track(Fr(1)), Track(Fr(2))                              // Tempo controls
+        Track(Fr(1)), Track(Fr(2)),                             // Tempo controls
+        Track(Fr(2))                                             // Latency display
     };
     
     grid.templateRows = { Track(Fr(1)) };
@@ -38,6 +40,7 @@ void MainComponent::TransportComponent::resized() {
     items.add(timeDisplay);
     items.add(tempoDisplay);
     items.add(tempoSlider);
+    items.add(latencyDisplay);
     
     grid.items = items;
     grid.performLayout(getLocalBounds());
@@ -45,6 +48,16 @@ void MainComponent::TransportComponent::resized() {
 
 void MainComponent::TransportComponent::updateFromTransport() {
     // TODO: Update transport controls from engine state
+    
+    // Round-trip latency a performer hears while monitoring
+    const auto& engine = AudioEngine::getInstance();
+    const auto latency = engine.getRoundTripLatency();
+    const double sampleRate = engine.getSettings().sampleRate;
+    const double milliseconds = sampleRate > 0.0 ? latency.getTotalSamples() * 1000.0 / sampleRate : 0.0;
+    
+    latencyDisplay.setText(juce::String(milliseconds, 1) + " ms (" +
+                           juce::String(latency.getTotalSamples()) + " smp)",
+                           juce::dontSendNotification);
 }
 
 void MainComponent::TransportComponent::setupControls() {
@@ -85,6 +98,11 @@ void MainComponent::TransportComponent::setupControls() {
     tempoSlider.setRange(20.0, 300.0, 0.1);
     tempoSlider.setValue(120.0);
     tempoSlider.onValueChange = [this] { handleTempoChange(); };
+    
+    // Latency display
+    addAndMakeVisible(latencyDisplay);
+    latencyDisplay.setJustificationType(juce::Justification::centred);
+    latencyDisplay.setTooltip("Round-trip monitoring latency");
 }
 
 void MainComponent::TransportComponent::handlePlayClick() {
@@ -224,9 +242,13 @@ MainComponent::MainComponent() {
     
     setupLayout();
     createNewProject();
+    
+    AudioEngine::getInstance().addChangeListener(this);
 }
 
 MainComponent::~MainComponent() {
+    AudioEngine::getInstance().removeChangeListener(this);
+    
     if (currentProject != nullptr) {
         currentProject->removeChangeListener(this);
     }
@@ -243,6 +265,8 @@ void MainComponent::resized() {
 void MainComponent::changeListenerCallback(juce::ChangeBroadcaster* source) {
     if (source == currentProject.get()) {
         updateViews();
+    } else if (source == &AudioEngine::getInstance()) {
+        transport->updateFromTransport();
     }
 }
 
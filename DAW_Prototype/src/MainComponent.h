@@ -26,6 +26,7 @@ public:
         juce::Label timeDisplay;
         juce::Label tempoDisplay;
         juce::Slider tempoSlider;
+        juce::Label latencyDisplay;
         
         void setupControls();
         void handlePlayClick();
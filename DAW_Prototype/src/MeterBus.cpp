@@ -0,0 +1,129 @@
+#include "MeterBus.h"
+
+//==============================================================================
+// MeterBus::Slot Implementation
+//==============================================================================
+
+void MeterBus::Slot::publish(float newPeak, float newRms, float newTruePeak, int clips) noexcept {
+    storeMax(peak, newPeak);
+    storeMax(rms, newRms);
+    storeMax(truePeak, newTruePeak);
+
+    if (clips > 0) {
+        clipCount.fetch_add(clips, std::memory_order_relaxed);
+    }
+}
+
+MeterBus::Reading MeterBus::Slot::consume() noexcept {
+    Reading reading;
+    reading.peak = peak.exchange(0.0f, std::memory_order_acq_rel);
+    reading.rms = rms.exchange(0.0f, std::memory_order_acq_rel);
+    reading.truePeak = truePeak.exchange(0.0f, std::memory_order_acq_rel);
+    reading.clipCount = clipCount.exchange(0, std::memory_order_acq_rel);
+    return reading;
+}
+
+MeterBus::Reading MeterBus::Slot::peek() const noexcept {
+    Reading reading;
+    reading.peak = peak.load(std::memory_order_acquire);
+    reading.rms = rms.load(std::memory_order_acquire);
+    reading.truePeak = truePeak.load(std::memory_order_acquire);
+    reading.clipCount = clipCount.load(std::memory_order_acquire);
+    return reading;
+}
+
+void MeterBus::Slot::reset() noexcept {
+    consume();
+}
+
+void MeterBus::Slot::storeMax(std::atomic<float>& target, float value) noexcept {
+    float current = target.load(std::memory_order_relaxed);
+
+    while (value > current &&
+           !target.compare_exchange_weak(current, value,
+                                         std::memory_order_release,
+                                         std::memory_order_relaxed)) {
+        // current has been reloaded by compare_exchange_weak
+    }
+}
+
+//==============================================================================
+// MeterBallistics Implementation
+//==============================================================================
+
+void MeterBallistics::update(const MeterBus::Reading& reading,
+                             double nowMs,
+                             int peakHoldTimeMs,
+                             int rmsWindowMs,
+                             float fallbackDbPerUpdate) {
+    // Peak falls back at a fixed rate unless a louder reading arrives
+    peak = std::max(reading.peak, peak * juce::Decibels::decibelsToGain(-fallbackDbPerUpdate));
+
+    // Held marker shows the highest of sample and true peak
+    const float newPeak = std::max(reading.peak, reading.truePeak);
+    if (newPeak >= heldPeak || nowMs - heldPeakTimeMs > peakHoldTimeMs) {
+        heldPeak = newPeak;
+        heldPeakTimeMs = nowMs;
+    }
+
+    // RMS over the configured window
+    rmsHistory[static_cast<size_t>(rmsWriteIndex)] = { nowMs, reading.rms * reading.rms };
+    rmsWriteIndex = (rmsWriteIndex + 1) % static_cast<int>(rmsHistory.size());
+
+    double sum = 0.0;
+    int count = 0;
+
+    for (const auto& sample : rmsHistory) {
+        if (sample.timeMs > 0.0 && nowMs - sample.timeMs <= rmsWindowMs) {
+            sum += sample.meanSquare;
+            ++count;
+        }
+    }
+
+    rms = count > 0 ? static_cast<float>(std::sqrt(sum / count)) : reading.rms;
+}
+
+void MeterBallistics::reset() {
+    peak = 0.0f;
+    heldPeak = 0.0f;
+    heldPeakTimeMs = 0.0;
+    rms = 0.0f;
+    rmsHistory.fill({});
+    rmsWriteIndex = 0;
+}
+
+//==============================================================================
+// MeterBusUtils Implementation
+//==============================================================================
+
+namespace MeterBusUtils {
+    void measureAndPublish(const juce::AudioBuffer<float>& buffer,
+                          int numSamples,
+                          MeterBus::Slot& slot) {
+        float peak = 0.0f;
+        float rms = 0.0f;
+        int clips = 0;
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+            const float* data = buffer.getReadPointer(channel);
+
+            peak = std::max(peak, buffer.getMagnitude(channel, 0, numSamples));
+            rms = std::max(rms, buffer.getRMSLevel(channel, 0, numSamples));
+            clips += countClippedSamples(data, numSamples);
+        }
+
+        // Sample peak stands in for true peak until an oversampled
+        // detector is attached to the channel
+        slot.publish(peak, rms, peak, clips);
+    }
+
+    int countClippedSamples(const float* data, int numSamples) {
+        int clips = 0;
+
+        for (int i = 0; i < numSamples; ++i) {
+            clips += std::abs(data[i]) >= 1.0f ? 1 : 0;
+        }
+
+        return clips;
+    }
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// Lock-free meter transport from the audio thread to the UI.
+//
+// The audio thread publishes per-block levels into a Slot; the UI consumes
+// the maximum seen since its previous read. Neither side ever blocks, so the
+// meters stay correct at any UI refresh rate.
+class MeterBus {
+public:
+    // Levels accumulated since the last read
+    struct Reading {
+        float peak{0.0f};
+        float rms{0.0f};
+        float truePeak{0.0f};
+        int clipCount{0};
+    };
+
+    // Meter slot. Any number of threads may publish: levels merge by atomic
+    // maximum and clip counts add up. consume() drains the slot, so with
+    // several consumers each only sees what arrived since anyone's last
+    // read. Fields are atomic one by one, so a reading may take a block's
+    // peak on one read and its RMS on the next.
+    class Slot {
+    public:
+        Slot() = default;
+
+        // Audio thread
+        void publish(float peak, float rms, float truePeak, int clips) noexcept;
+
+        // UI thread
+        Reading consume() noexcept;
+        Reading peek() const noexcept;
+        void reset() noexcept;
+
+    private:
+        std::atomic<float> peak{0.0f};
+        std::atomic<float> rms{0.0f};
+        std::atomic<float> truePeak{0.0f};
+        std::atomic<int> clipCount{0};
+
+        static void storeMax(std::atomic<float>& target, float value) noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(Slot)
+    };
+
+    // Constructor/Destructor
+    MeterBus() = default;
+    ~MeterBus() = default;
+
+    // Consumer registration. Metering is skipped entirely on the audio
+    // thread while nobody is listening.
+    void addConsumer() noexcept { consumers.fetch_add(1, std::memory_order_relaxed); }
+    void removeConsumer() noexcept { consumers.fetch_sub(1, std::memory_order_relaxed); }
+    bool isActive() const noexcept { return consumers.load(std::memory_order_relaxed) > 0; }
+
+private:
+    std::atomic<int> consumers{0};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MeterBus)
+};
+
+// UI-side meter ballistics.
+//
+// Turns raw readings into what a meter should display: peak with a
+// configurable fall-back, a held peak marker and RMS averaged over a window.
+class MeterBallistics {
+public:
+    void update(const MeterBus::Reading& reading,
+                double nowMs,
+                int peakHoldTimeMs,
+                int rmsWindowMs,
+                float fallbackDbPerUpdate);
+    void reset();
+
+    float getPeak() const { return peak; }
+    float getHeldPeak() const { return heldPeak; }
+    float getRMS() const { return rms; }
+
+private:
+    struct RMSSample {
+        double timeMs{0.0};
+        float meanSquare{0.0f};
+    };
+
+    float peak{0.0f};
+    float heldPeak{0.0f};
+    double heldPeakTimeMs{0.0};
+    float rms{0.0f};
+
+    std::array<RMSSample, 64> rmsHistory{};
+    int rmsWriteIndex{0};
+};
+
+// Meter utilities
+namespace MeterBusUtils {
+    // Measures a block and publishes it into the slot
+    void measureAndPublish(const juce::AudioBuffer<float>& buffer,
+                          int numSamples,
+                          MeterBus::Slot& slot);
+
+    // Number of samples at or above full scale
+    int countClippedSamples(const float* data, int numSamples);
+}
@@ -0,0 +1,165 @@
+#include "Metronome.h"
+#include "Configuration.h"
+#include "Logger.h"
+
+namespace {
+    constexpr float clickFrequency = 1000.0f;
+    constexpr float accentFrequency = 1500.0f;
+    constexpr double clickLengthSeconds = 0.03;
+    constexpr int maxClicksPerSegment = 64;
+}
+
+//==============================================================================
+// Metronome Implementation
+//==============================================================================
+
+void Metronome::prepare(double newSampleRate) {
+    sampleRate = newSampleRate;
+
+    const auto& metronomeSettings = Configuration::getInstance().getMetronomeSettings();
+    loadSample(metronomeSettings.clickSample, sampleRate, clickFrequency, clickSample);
+    loadSample(metronomeSettings.accentSample, sampleRate, accentFrequency, accentSample);
+
+    voice = nullptr;
+    voicePosition = 0;
+    cursor.setMap(nullptr);
+}
+
+void Metronome::render(juce::AudioBuffer<float>& output,
+                       const Transport::Segment& segment,
+                       const TempoMap* tempoMap) {
+    const int numSamples = segment.numSamples;
+    int rendered = 0;
+
+    if (tempoMap != nullptr && isActive(segment)) {
+        cursor.setMap(tempoMap);
+
+        // Clicks for timeline sample t are heard at t + latency
+        const int64_t start = segment.position - latencyCompensation.load(std::memory_order_relaxed);
+        const int64_t end = start + numSamples;
+
+        // Search from one sample early so a beat that rounds onto the
+        // first sample of this segment is not lost between segments
+        double beat = cursor.samplesToBeat(start - 1, sampleRate);
+
+        for (int i = 0; i < maxClicksPerSegment; ++i) {
+            const auto& signature = tempoMap->getTimeSignatureAtBeat(beat);
+            const double beatLength = 4.0 / signature.denominator;
+            const double index = std::ceil((beat - signature.beat) / beatLength - 1.0e-9);
+            const double clickBeat = signature.beat + index * beatLength;
+            const int64_t clickPosition = cursor.beatToSamples(clickBeat, sampleRate);
+
+            if (clickPosition >= end) {
+                break;
+            }
+
+            if (clickPosition >= start) {
+                const int offset = static_cast<int>(clickPosition - start);
+                renderVoice(output, rendered, offset - rendered);
+                rendered = offset;
+
+                const auto beatInBar = static_cast<int64_t>(index) % signature.numerator;
+                trigger(beatInBar == 0);
+            }
+
+            beat = clickBeat + beatLength * 0.5;
+        }
+    }
+
+    // Let the last click ring out, even after the metronome stops
+    renderVoice(output, rendered, numSamples - rendered);
+}
+
+bool Metronome::isActive(const Transport::Segment& segment) const {
+    if (segment.countingIn) {
+        return true;
+    }
+
+    if (!enabled.load(std::memory_order_relaxed) || !segment.playing) {
+        return false;
+    }
+
+    return !onlyWhileRecording.load(std::memory_order_relaxed) || segment.recording;
+}
+
+void Metronome::trigger(bool downbeat) {
+    const bool accent = downbeat && accentDownbeat.load(std::memory_order_relaxed);
+    voice = accent ? &accentSample : &clickSample;
+    voicePosition = 0;
+}
+
+void Metronome::renderVoice(juce::AudioBuffer<float>& output, int startSample, int numSamples) {
+    if (voice == nullptr || numSamples <= 0) {
+        return;
+    }
+
+    const int count = std::min(numSamples, voice->getNumSamples() - voicePosition);
+    if (count <= 0) {
+        voice = nullptr;
+        return;
+    }
+
+    const int numChannels = output.getNumChannels();
+    int firstChannel = outputChannel.load(std::memory_order_relaxed);
+    if (firstChannel >= numChannels) {
+        firstChannel = 0;
+    }
+
+    const float gain = level.load(std::memory_order_relaxed);
+    for (int channel = firstChannel; channel < std::min(firstChannel + 2, numChannels); ++channel) {
+        output.addFrom(channel, startSample, *voice, 0, voicePosition, count, gain);
+    }
+
+    voicePosition += count;
+    if (voicePosition >= voice->getNumSamples()) {
+        voice = nullptr;
+    }
+}
+
+void Metronome::loadSample(const juce::String& path, double sampleRate,
+                           float fallbackFrequency, juce::AudioBuffer<float>& buffer) {
+    if (path.isNotEmpty()) {
+        juce::AudioFormatManager formatManager;
+        formatManager.registerBasicFormats();
+
+        std::unique_ptr<juce::AudioFormatReader> reader(
+            formatManager.createReaderFor(juce::File(path)));
+
+        if (reader != nullptr && reader->lengthInSamples > 0) {
+            // Mono is enough for a click; keep samples short
+            const int sourceLength = static_cast<int>(std::min<juce::int64>(
+                reader->lengthInSamples, static_cast<juce::int64>(reader->sampleRate * 2.0)));
+
+            juce::AudioBuffer<float> source(1, sourceLength);
+            reader->read(&source, 0, sourceLength, 0, true, false);
+
+            const double ratio = reader->sampleRate / sampleRate;
+            const int length = static_cast<int>(sourceLength / ratio);
+            buffer.setSize(1, length);
+
+            juce::LagrangeInterpolator interpolator;
+            interpolator.process(ratio, source.getReadPointer(0), buffer.getWritePointer(0), length);
+            return;
+        }
+
+        LOG_WARNING("Could not load metronome sample %s, using built-in click", path.toRawUTF8());
+    }
+
+    synthesiseClick(fallbackFrequency, sampleRate, buffer);
+}
+
+void Metronome::synthesiseClick(float frequency, double sampleRate,
+                                juce::AudioBuffer<float>& buffer) {
+    const int length = static_cast<int>(clickLengthSeconds * sampleRate);
+    buffer.setSize(1, length);
+
+    auto* data = buffer.getWritePointer(0);
+    const double phaseIncrement = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    const double decay = std::exp(-6.0 / length);  // About -52 dB at the end
+
+    double envelope = 1.0;
+    for (int i = 0; i < length; ++i) {
+        data[i] = static_cast<float>(std::sin(phaseIncrement * i) * envelope);
+        envelope *= decay;
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include "Transport.h"
+#include "TempoMap.h"
+
+// Built-in metronome voice rendered on the audio thread.
+//
+// Clicks are placed on beats of the tempo map (the time signature's beat
+// unit), so they follow ramps and signature changes. Each transport segment
+// is rendered separately, which keeps clicks on the exact sample at any
+// buffer size and across loop wraps. Click samples are loaded or
+// synthesised in prepare(); render() never allocates.
+class Metronome {
+public:
+    // Constructor/Destructor
+    Metronome() = default;
+    ~Metronome() = default;
+
+    // Call while the audio callback is stopped. Loads the click samples named
+    // in the configuration, or synthesises them if none are set.
+    void prepare(double sampleRate);
+
+    // Settings (any thread)
+    void setEnabled(bool shouldBeEnabled) { enabled = shouldBeEnabled; }
+    bool isEnabled() const { return enabled; }
+    void setLevel(float newLevel) { level = juce::jlimit(0.0f, 1.0f, newLevel); }
+    float getLevel() const { return level; }
+    void setAccentDownbeat(bool shouldAccent) { accentDownbeat = shouldAccent; }
+    void setOnlyWhileRecording(bool onlyRecording) { onlyWhileRecording = onlyRecording; }
+    void setOutputChannel(int firstChannel) { outputChannel = juce::jmax(0, firstChannel); }
+
+    // Delay the rest of the output path adds, so clicks line up with what
+    // is heard rather than with the timeline
+    void setLatencyCompensation(int samples) { latencyCompensation = juce::jmax(0, samples); }
+
+    // Audio thread: mixes clicks for one transport segment into output,
+    // which covers exactly that segment
+    void render(juce::AudioBuffer<float>& output,
+                const Transport::Segment& segment,
+                const TempoMap* tempoMap);
+
+private:
+    juce::AudioBuffer<float> clickSample;
+    juce::AudioBuffer<float> accentSample;
+    double sampleRate{44100.0};
+
+    std::atomic<bool> enabled{false};
+    std::atomic<float> level{0.7f};
+    std::atomic<bool> accentDownbeat{true};
+    std::atomic<bool> onlyWhileRecording{false};
+    std::atomic<int> outputChannel{0};
+    std::atomic<int> latencyCompensation{0};
+
+    // Audio thread state
+    TempoMap::Cursor cursor;
+    const juce::AudioBuffer<float>* voice{nullptr};
+    int voicePosition{0};
+
+    bool isActive(const Transport::Segment& segment) const;
+    void trigger(bool downbeat);
+    void renderVoice(juce::AudioBuffer<float>& output, int startSample, int numSamples);
+
+    static void loadSample(const juce::String& path, double sampleRate,
+                           float fallbackFrequency, juce::AudioBuffer<float>& buffer);
+    static void synthesiseClick(float frequency, double sampleRate,
+                                juce::AudioBuffer<float>& buffer);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Metronome)
+};
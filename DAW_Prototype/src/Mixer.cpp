@@ -3,6 +3,8 @@
 #include "Track.h"
 #include "Plugin.h"
 #include "Logger.h"
+#include <limits>
+#include <set>
 
 //==============================================================================
 // Mixer Implementation
@@ -28,14 +30,104 @@ void Mixer::setProject(Project* project) {
         // Initialize channels for all tracks
         const int numTracks = currentProject->getTracks().size();
         channels.resize(numTracks);
-        channelSoloBuffer.resize(numTracks);
+        updateSoloStates();
         updateProcessingBuffers();
     } else {
+        std::vector<std::unique_ptr<Plugin>> removedPlugins;
+        
+        for (auto& channel : channels) {
+            for (auto& plugin : channel.plugins) {
+                removedPlugins.push_back(std::move(plugin));
+            }
+        }
+        for (auto& bus : buses) {
+            loudnessAnalyser.removeSource(bus.channel.loudness);
+            for (auto& plugin : bus.channel.plugins) {
+                removedPlugins.push_back(std::move(plugin));
+            }
+        }
+        
         channels.clear();
-        channelSoloBuffer.clear();
         buses.clear();
+        sidechains.clear();
+        pendingSidechains.clear();
+        soloActive = false;
+        recordingSession.reset();
+        updateProcessingBuffers();
+        retirePlugins(removedPlugins);
+    }
+    
+    sendChangeMessage();
+}
+
+void Mixer::addChannel() {
+    channels.emplace_back();
+    updateSoloStates();
+    updateProcessingBuffers();
+    sendChangeMessage();
+}
+
+void Mixer::removeChannel(int index) {
+    if (index < 0 || index >= channels.size()) {
+        return;
+    }
+    
+    auto plugins = std::move(channels[index].plugins);
+    channels.erase(channels.begin() + index);
+    
+    // Bus sources and sidechains refer to channels by index
+    for (auto& bus : buses) {
+        auto& sources = bus.sources;
+        sources.erase(std::remove(sources.begin(), sources.end(), index), sources.end());
+        for (auto& source : sources) {
+            if (source > index) {
+                --source;
+            }
+        }
+    }
+    remapSidechains(Node::Type::Channel, [index](int channel) {
+        return channel == index ? -1 : channel > index ? channel - 1 : channel;
+    });
+    
+    updateSoloStates();
+    updateProcessingBuffers();
+    retirePlugins(plugins);
+    sendChangeMessage();
+}
+
+void Mixer::moveChannel(int fromIndex, int toIndex) {
+    const int numChannels = static_cast<int>(channels.size());
+    if (fromIndex < 0 || fromIndex >= numChannels ||
+        toIndex < 0 || toIndex >= numChannels || fromIndex == toIndex) {
+        return;
+    }
+    
+    auto channel = std::move(channels[fromIndex]);
+    channels.erase(channels.begin() + fromIndex);
+    channels.insert(channels.begin() + toIndex, std::move(channel));
+    
+    // Follow the moved channel in bus sources
+    auto remap = [fromIndex, toIndex](int index) {
+        if (index == fromIndex) {
+            return toIndex;
+        }
+        if (fromIndex < toIndex && index > fromIndex && index <= toIndex) {
+            return index - 1;
+        }
+        if (toIndex < fromIndex && index >= toIndex && index < fromIndex) {
+            return index + 1;
+        }
+        return index;
+    };
+    
+    for (auto& bus : buses) {
+        for (auto& source : bus.sources) {
+            source = remap(source);
+        }
     }
+    remapSidechains(Node::Type::Channel, remap);
     
+    publishRenderModel();
     sendChangeMessage();
 }
 
@@ -52,6 +144,7 @@ const Mixer::Channel& Mixer::getChannel(int index) const {
 void Mixer::setChannelVolume(int index, float volume) {
     if (index >= 0 && index < channels.size()) {
         channels[index].volume = juce::jlimit(0.0f, 2.0f, volume);
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -59,6 +152,7 @@ void Mixer::setChannelVolume(int index, float volume) {
 void Mixer::setChannelPan(int index, float pan) {
     if (index >= 0 && index < channels.size()) {
         channels[index].pan = juce::jlimit(-1.0f, 1.0f, pan);
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -66,6 +160,7 @@ void Mixer::setChannelPan(int index, float pan) {
 void Mixer::setChannelMute(int index, bool mute) {
     if (index >= 0 && index < channels.size()) {
         channels[index].mute = mute;
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -74,6 +169,7 @@ void Mixer::setChannelSolo(int index, bool solo) {
     if (index >= 0 && index < channels.size()) {
         channels[index].solo = solo;
         updateSoloStates();
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -81,54 +177,167 @@ void Mixer::setChannelSolo(int index, bool solo) {
 void Mixer::setChannelBypass(int index, bool bypass) {
     if (index >= 0 && index < channels.size()) {
         channels[index].bypass = bypass;
+        publishRenderModel();
         sendChangeMessage();
     }
 }
 
+void Mixer::setMasterVolume(float volume) {
+    masterChannel.volume = juce::jlimit(0.0f, 2.0f, volume);
+    publishRenderModel();
+    sendChangeMessage();
+}
+
+void Mixer::setMasterPan(float pan) {
+    masterChannel.pan = juce::jlimit(-1.0f, 1.0f, pan);
+    publishRenderModel();
+    sendChangeMessage();
+}
+
+void Mixer::setMasterMute(bool mute) {
+    masterChannel.mute = mute;
+    publishRenderModel();
+    sendChangeMessage();
+}
+
 float Mixer::getChannelPeakLevel(int index) const {
     if (index >= 0 && index < channels.size()) {
-        return channels[index].peakLevel;
+        return channels[index].meter->peek().peak;
     }
     return 0.0f;
 }
 
 float Mixer::getChannelRMSLevel(int index) const {
     if (index >= 0 && index < channels.size()) {
-        return channels[index].rmsLevel;
+        return channels[index].meter->peek().rms;
     }
     return 0.0f;
 }
 
-void Mixer::addSend(int channelIndex, int busIndex, float level) {
-    if (channelIndex >= 0 && channelIndex < channels.size() &&
-        busIndex >= 0 && busIndex < buses.size()) {
-        channels[channelIndex].sends.push_back({busIndex, level});
-        sendChangeMessage();
+MeterBus::Reading Mixer::readChannelMeter(int index) {
+    if (index >= 0 && index < channels.size()) {
+        return channels[index].meter->consume();
+    }
+    return {};
+}
+
+MeterBus::Reading Mixer::readBusMeter(int index) {
+    if (index >= 0 && index < buses.size()) {
+        return buses[index].channel.meter->consume();
+    }
+    return {};
+}
+
+MeterBus::Reading Mixer::readMasterMeter() {
+    return masterChannel.meter->consume();
+}
+
+LoudnessAnalyser::Values Mixer::getBusLoudness(int index) const {
+    if (index >= 0 && index < buses.size() && buses[index].channel.loudness != nullptr) {
+        return buses[index].channel.loudness->getValues();
+    }
+    return {};
+}
+
+LoudnessAnalyser::Values Mixer::getMasterLoudness() const {
+    if (masterChannel.loudness != nullptr) {
+        return masterChannel.loudness->getValues();
+    }
+    return {};
+}
+
+void Mixer::resetLoudness() {
+    for (auto& bus : buses) {
+        if (bus.channel.loudness != nullptr) {
+            bus.channel.loudness->requestReset();
+        }
+    }
+    
+    if (masterChannel.loudness != nullptr) {
+        masterChannel.loudness->requestReset();
+    }
+}
+
+bool Mixer::addSend(int channelIndex, int busIndex, float level, SendTap tap) {
+    if (channelIndex < 0 || channelIndex >= channels.size() ||
+        busIndex < 0 || busIndex >= buses.size()) {
+        return false;
+    }
+    
+    auto* send = findSend(channelIndex, busIndex);
+    if (send == nullptr) {
+        auto& channel = channels[channelIndex];
+        if (channel.numSends >= maxSends) {
+            LOG_WARNING("Channel %d already has %d sends", channelIndex + 1, maxSends);
+            return false;
+        }
+        
+        // New sends fade in from silence
+        send = &channel.sends[static_cast<size_t>(channel.numSends++)];
+        *send = Send();
+        send->bus = busIndex;
+        send->ramp = std::make_shared<RenderModel::GainRamp>();
     }
+    
+    send->level = juce::jlimit(0.0f, 1.0f, level);
+    send->tap = tap;
+    publishRenderModel();
+    sendChangeMessage();
+    return true;
 }
 
 void Mixer::removeSend(int channelIndex, int busIndex) {
-    if (channelIndex >= 0 && channelIndex < channels.size()) {
-        auto& sends = channels[channelIndex].sends;
-        sends.erase(std::remove_if(sends.begin(), sends.end(),
-                                 [busIndex](const auto& send) {
-                                     return send.first == busIndex;
-                                 }),
-                   sends.end());
-        sendChangeMessage();
+    auto* send = findSend(channelIndex, busIndex);
+    if (send == nullptr) {
+        return;
     }
+    
+    // Keep the array packed, in insertion order
+    auto& channel = channels[channelIndex];
+    auto* end = channel.sends.data() + channel.numSends;
+    std::move(send + 1, end, send);
+    channel.sends[static_cast<size_t>(--channel.numSends)] = Send();
+    
+    publishRenderModel();
+    sendChangeMessage();
 }
 
 void Mixer::setSendLevel(int channelIndex, int busIndex, float level) {
-    if (channelIndex >= 0 && channelIndex < channels.size()) {
-        for (auto& send : channels[channelIndex].sends) {
-            if (send.first == busIndex) {
-                send.second = juce::jlimit(0.0f, 1.0f, level);
-                sendChangeMessage();
-                break;
-            }
+    if (auto* send = findSend(channelIndex, busIndex)) {
+        send->level = juce::jlimit(0.0f, 1.0f, level);
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setSendTap(int channelIndex, int busIndex, SendTap tap) {
+    if (auto* send = findSend(channelIndex, busIndex)) {
+        send->tap = tap;
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setSendMute(int channelIndex, int busIndex, bool mute) {
+    if (auto* send = findSend(channelIndex, busIndex)) {
+        send->mute = mute;
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+Mixer::Send* Mixer::findSend(int channelIndex, int busIndex) {
+    if (channelIndex < 0 || channelIndex >= channels.size()) {
+        return nullptr;
+    }
+    
+    auto& channel = channels[channelIndex];
+    for (int i = 0; i < channel.numSends; ++i) {
+        if (channel.sends[static_cast<size_t>(i)].bus == busIndex) {
+            return &channel.sends[static_cast<size_t>(i)];
         }
     }
+    return nullptr;
 }
 
 int Mixer::addBus(BusType type, const juce::String& name) {
@@ -146,14 +355,44 @@ int Mixer::addBus(BusType type, const juce::String& name) {
 
 void Mixer::removeBus(int index) {
     if (index >= 0 && index < buses.size()) {
-        // Remove sends to this bus
+        // Remove sends to this bus and follow the buses after it
         for (auto& channel : channels) {
-            removeSend(static_cast<int>(&channel - &channels[0]), index);
+            auto* begin = channel.sends.data();
+            auto* end = std::remove_if(begin, begin + channel.numSends,
+                                       [index](const Send& send) {
+                                           return send.bus == index;
+                                       });
+            for (auto* send = end; send != begin + channel.numSends; ++send) {
+                *send = Send();
+            }
+            channel.numSends = static_cast<int>(end - begin);
+            
+            for (auto* send = begin; send != end; ++send) {
+                if (send->bus > index) {
+                    --send->bus;
+                }
+            }
         }
         
-        // Remove bus
+        for (auto& bus : buses) {
+            if (bus.outputBus == index) {
+                bus.outputBus = -1;
+            } else if (bus.outputBus > index) {
+                --bus.outputBus;
+            }
+        }
+        
+        remapSidechains(Node::Type::Bus, [index](int bus) {
+            return bus == index ? -1 : bus > index ? bus - 1 : bus;
+        });
+        
+        // Remove bus; the published model keeps its plugins alive until
+        // the audio thread has moved on
+        auto plugins = std::move(buses[index].channel.plugins);
+        loudnessAnalyser.removeSource(buses[index].channel.loudness);
         buses.erase(buses.begin() + index);
         updateProcessingBuffers();
+        retirePlugins(plugins);
         sendChangeMessage();
     }
 }
@@ -175,16 +414,71 @@ void Mixer::setBusName(int index, const juce::String& name) {
     }
 }
 
-void Mixer::setBusOutput(int index, int outputBus) {
+void Mixer::setBusVolume(int index, float volume) {
+    if (index >= 0 && index < buses.size()) {
+        buses[index].channel.volume = juce::jlimit(0.0f, 2.0f, volume);
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setBusPan(int index, float pan) {
+    if (index >= 0 && index < buses.size()) {
+        buses[index].channel.pan = juce::jlimit(-1.0f, 1.0f, pan);
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setBusMute(int index, bool mute) {
+    if (index >= 0 && index < buses.size()) {
+        buses[index].channel.mute = mute;
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setBusSolo(int index, bool solo) {
+    if (index >= 0 && index < buses.size()) {
+        buses[index].channel.solo = solo;
+        updateSoloStates();
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+void Mixer::setBusSoloSafe(int index, bool soloSafe) {
     if (index >= 0 && index < buses.size()) {
-        buses[index].outputBus = outputBus;
+        buses[index].soloSafe = soloSafe;
+        publishRenderModel();
         sendChangeMessage();
     }
 }
 
+bool Mixer::setBusOutput(int index, int outputBus) {
+    if (index < 0 || index >= buses.size()) {
+        return false;
+    }
+    
+    const int previousOutput = buses[index].outputBus;
+    buses[index].outputBus = outputBus;
+    
+    std::vector<int> order;
+    if (!sortRoutingGraph(buildRoutingGraph(), order)) {
+        buses[index].outputBus = previousOutput;
+        LOG_WARNING("Routing bus %s to bus %d would create a feedback loop", buses[index].name.toRawUTF8(), outputBus);
+        return false;
+    }
+    
+    publishRenderModel();
+    sendChangeMessage();
+    return true;
+}
+
 void Mixer::addBusSource(int busIndex, int sourceIndex) {
     if (busIndex >= 0 && busIndex < buses.size()) {
         buses[busIndex].sources.push_back(sourceIndex);
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -194,6 +488,7 @@ void Mixer::removeBusSource(int busIndex, int sourceIndex) {
         auto& sources = buses[busIndex].sources;
         sources.erase(std::remove(sources.begin(), sources.end(), sourceIndex),
                      sources.end());
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -222,7 +517,12 @@ int Mixer::getBusOutput(int index) const {
 
 void Mixer::addPlugin(int channelIndex, std::unique_ptr<Plugin> plugin) {
     if (channelIndex >= 0 && channelIndex < channels.size() && plugin != nullptr) {
+        plugin->setNonRealtime(nonRealtime);
+        if (processingPrepared) {
+            plugin->prepareToPlay(currentSampleRate, currentBlockSize);
+        }
         channels[channelIndex].plugins.push_back(std::move(plugin));
+        publishRenderModel();
         sendChangeMessage();
     }
 }
@@ -231,7 +531,11 @@ void Mixer::removePlugin(int channelIndex, int pluginIndex) {
     if (channelIndex >= 0 && channelIndex < channels.size()) {
         auto& plugins = channels[channelIndex].plugins;
         if (pluginIndex >= 0 && pluginIndex < plugins.size()) {
+            std::vector<std::unique_ptr<Plugin>> removed;
+            removed.push_back(std::move(plugins[pluginIndex]));
             plugins.erase(plugins.begin() + pluginIndex);
+            publishRenderModel();
+            retirePlugins(removed);
             sendChangeMessage();
         }
     }
@@ -245,6 +549,7 @@ void Mixer::movePlugin(int channelIndex, int fromIndex, int toIndex) {
             auto plugin = std::move(plugins[fromIndex]);
             plugins.erase(plugins.begin() + fromIndex);
             plugins.insert(plugins.begin() + toIndex, std::move(plugin));
+            publishRenderModel();
             sendChangeMessage();
         }
     }
@@ -267,13 +572,66 @@ int Mixer::getNumPlugins(int channelIndex) const {
     return 0;
 }
 
+bool Mixer::addSidechain(const Node& source, Plugin* plugin) {
+    if (plugin == nullptr || !plugin->acceptsSidechain() || getNodeIndex(source) < 0 ||
+        findPlugin(plugin).position < 0) {
+        return false;
+    }
+    
+    // Keying a node from itself or from anything it feeds closes a loop
+    auto previous = sidechains;
+    sidechains.erase(std::remove_if(sidechains.begin(), sidechains.end(),
+                                    [plugin](const Sidechain& sidechain) {
+                                        return sidechain.plugin == plugin;
+                                    }),
+                     sidechains.end());
+    sidechains.push_back({source, plugin});
+    
+    std::vector<int> order;
+    if (!sortRoutingGraph(buildRoutingGraph(), order)) {
+        sidechains = std::move(previous);
+        LOG_WARNING("Sidechain into %s would create a feedback loop", plugin->getName().toRawUTF8());
+        return false;
+    }
+    
+    publishRenderModel();
+    sendChangeMessage();
+    return true;
+}
+
+void Mixer::removeSidechain(Plugin* plugin) {
+    const auto size = sidechains.size();
+    sidechains.erase(std::remove_if(sidechains.begin(), sidechains.end(),
+                                    [plugin](const Sidechain& sidechain) {
+                                        return sidechain.plugin == plugin;
+                                    }),
+                     sidechains.end());
+    
+    if (sidechains.size() != size) {
+        publishRenderModel();
+        sendChangeMessage();
+    }
+}
+
+int Mixer::getOutputLatencySamples() const {
+    const auto* latest = renderModels.getLatest();
+    return latest != nullptr ? latest->outputLatency : 0;
+}
+
 void Mixer::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) {
     currentSampleRate = sampleRate;
     currentBlockSize = maximumExpectedSamplesPerBlock;
     
     updateProcessingBuffers();
+    updateLoudnessSources(true);
+    
+    // Prepare track and mixer plugins at the session's rate and block size
+    if (currentProject != nullptr) {
+        for (auto* track : currentProject->getTracks()) {
+            track->prepareToPlay(sampleRate, maximumExpectedSamplesPerBlock);
+        }
+    }
     
-    // Prepare plugins
     for (auto& channel : channels) {
         for (auto& plugin : channel.plugins) {
             plugin->prepareToPlay(sampleRate, maximumExpectedSamplesPerBlock);
@@ -286,30 +644,60 @@ void Mixer::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock)
         }
     }
     
+    publishRenderModel();
     processingPrepared = true;
 }
 
 void Mixer::processBlock(juce::AudioBuffer<float>& buffer,
                         juce::MidiBuffer& midiMessages) {
-    if (!processingPrepared || currentProject == nullptr) {
+    processBlock(buffer, midiMessages, Input(), true);
+}
+
+void Mixer::processBlock(juce::AudioBuffer<float>& buffer,
+                        juce::MidiBuffer& midiMessages,
+                        const Input& input,
+                        bool playing) {
+    // Everything below reads only from this snapshot
+    const RenderModelExchange::ScopedRead model(renderModels);
+    
+    if (!processingPrepared || model.get() == nullptr || model->buffers == nullptr) {
+        buffer.clear();
         return;
     }
 
-    // Clear all buffers
-    clearAllBuffers();
+    // Every node renders exactly the samples heard, so tracks, plugins,
+    // sidechains and delay lines all advance by the same amount. Blocks
+    // longer than prepared for are cut short.
+    const int numSamples = juce::jmin(buffer.getNumSamples(), model->buffers->blockSize);
+    model->buffers->setNumSamples(numSamples);
     
-    // Process channels
-    processChannels(buffer, midiMessages);
+    // Clear all buffers
+    clearAllBuffers(*model->buffers);
+    sleepingNodes = 0;
     
-    // Process buses
-    processBuses();
+    // Channels and buses, every source before what it feeds
+    for (const auto& node : model->order) {
+        if (node.type == Node::Type::Channel) {
+            processChannel(*model, node.index, midiMessages, input, playing, numSamples);
+        } else {
+            processBus(*model, node.index, numSamples);
+        }
+    }
     
     // Process master
-    processMaster(buffer);
+    processMaster(*model, buffer, numSamples);
+    
+    numSleepingNodes.store(sleepingNodes, std::memory_order_relaxed);
 }
 
 void Mixer::releaseResources() {
     // Release plugins
+    if (currentProject != nullptr) {
+        for (auto* track : currentProject->getTracks()) {
+            track->releaseResources();
+        }
+    }
+    
     for (auto& channel : channels) {
         for (auto& plugin : channel.plugins) {
             plugin->releaseResources();
@@ -325,6 +713,37 @@ void Mixer::releaseResources() {
     processingPrepared = false;
 }
 
+void Mixer::setNonRealtime(bool isNonRealtime) {
+    if (nonRealtime == isNonRealtime) {
+        return;
+    }
+    nonRealtime = isNonRealtime;
+
+    if (currentProject != nullptr) {
+        for (auto* track : currentProject->getTracks()) {
+            for (auto* plugin : track->getPlugins()) {
+                plugin->setNonRealtime(nonRealtime);
+            }
+        }
+    }
+
+    for (auto& channel : channels) {
+        for (auto& plugin : channel.plugins) {
+            plugin->setNonRealtime(nonRealtime);
+        }
+    }
+
+    for (auto& bus : buses) {
+        for (auto& plugin : bus.channel.plugins) {
+            plugin->setNonRealtime(nonRealtime);
+        }
+    }
+
+    // Latencies may have changed with the quality
+    publishRenderModel();
+    sendChangeMessage();
+}
+
 void Mixer::saveState(juce::ValueTree& state) const {
     // Save channels
     auto channelsNode = state.getOrCreateChildWithName("channels", nullptr);
@@ -340,10 +759,13 @@ void Mixer::saveState(juce::ValueTree& state) const {
         
         // Save sends
         auto sendsNode = channelNode.getOrCreateChildWithName("sends", nullptr);
-        for (const auto& send : channel.sends) {
+        for (int i = 0; i < channel.numSends; ++i) {
+            const auto& send = channel.sends[static_cast<size_t>(i)];
             auto sendNode = sendsNode.createChild("send");
-            sendNode.setProperty("bus", send.first, nullptr);
-            sendNode.setProperty("level", send.second, nullptr);
+            sendNode.setProperty("bus", send.bus, nullptr);
+            sendNode.setProperty("level", send.level, nullptr);
+            sendNode.setProperty("tap", MixerUtils::tapToString(send.tap), nullptr);
+            sendNode.setProperty("mute", send.mute, nullptr);
         }
     }
     
@@ -356,6 +778,7 @@ void Mixer::saveState(juce::ValueTree& state) const {
         busNode.setProperty("type", static_cast<int>(bus.type), nullptr);
         busNode.setProperty("name", bus.name, nullptr);
         busNode.setProperty("output", bus.outputBus, nullptr);
+        busNode.setProperty("soloSafe", bus.soloSafe, nullptr);
         
         // Save sources
         auto sourcesNode = busNode.getOrCreateChildWithName("sources", nullptr);
@@ -369,6 +792,7 @@ void Mixer::saveState(juce::ValueTree& state) const {
         channelNode.setProperty("volume", bus.channel.volume, nullptr);
         channelNode.setProperty("pan", bus.channel.pan, nullptr);
         channelNode.setProperty("mute", bus.channel.mute, nullptr);
+        channelNode.setProperty("solo", bus.channel.solo, nullptr);
         channelNode.setProperty("bypass", bus.channel.bypass, nullptr);
     }
     
@@ -378,11 +802,45 @@ void Mixer::saveState(juce::ValueTree& state) const {
     masterNode.setProperty("pan", masterChannel.pan, nullptr);
     masterNode.setProperty("mute", masterChannel.mute, nullptr);
     masterNode.setProperty("bypass", masterChannel.bypass, nullptr);
+    
+    // Save sidechains by chain position; plugins have no stable identity
+    auto sidechainsNode = state.getOrCreateChildWithName("sidechains", nullptr);
+    sidechainsNode.removeAllChildren(nullptr);
+    
+    auto saveSidechain = [&sidechainsNode](const SidechainState& sidechain) {
+        auto sidechainNode = sidechainsNode.createChild("sidechain");
+        sidechainNode.setProperty("sourceType", MixerUtils::nodeTypeToString(sidechain.source.type), nullptr);
+        sidechainNode.setProperty("source", sidechain.source.index, nullptr);
+        sidechainNode.setProperty("targetType", MixerUtils::nodeTypeToString(sidechain.target.type), nullptr);
+        sidechainNode.setProperty("target", sidechain.target.index, nullptr);
+        sidechainNode.setProperty("chain", sidechain.onTrack ? "track" : "mixer", nullptr);
+        sidechainNode.setProperty("position", sidechain.position, nullptr);
+    };
+    
+    for (const auto& sidechain : sidechains) {
+        auto location = findPlugin(sidechain.plugin);
+        if (location.position >= 0) {
+            location.source = sidechain.source;
+            saveSidechain(location);
+        }
+    }
+    
+    // Still waiting for their plugins to load
+    for (const auto& sidechain : pendingSidechains) {
+        saveSidechain(sidechain);
+    }
 }
 
 void Mixer::loadState(const juce::ValueTree& state) {
     // Load channels
+    std::vector<std::unique_ptr<Plugin>> removedPlugins;
+    
     if (auto channelsNode = state.getChildWithName("channels")) {
+        for (auto& channel : channels) {
+            for (auto& plugin : channel.plugins) {
+                removedPlugins.push_back(std::move(plugin));
+            }
+        }
         channels.clear();
         
         for (auto channelNode : channelsNode) {
@@ -393,12 +851,22 @@ void Mixer::loadState(const juce::ValueTree& state) {
             channel.solo = channelNode.getProperty("solo", false);
             channel.bypass = channelNode.getProperty("bypass", false);
             
-            // Load sends
+            // Load sends. Older projects only have bus and level, and
+            // tapped after the pan.
             if (auto sendsNode = channelNode.getChildWithName("sends")) {
                 for (auto sendNode : sendsNode) {
-                    int bus = sendNode.getProperty("bus");
-                    float level = sendNode.getProperty("level");
-                    channel.sends.push_back({bus, level});
+                    if (channel.numSends >= maxSends) {
+                        LOG_WARNING("Ignoring sends beyond the first %d on a channel", maxSends);
+                        break;
+                    }
+                    
+                    auto& send = channel.sends[static_cast<size_t>(channel.numSends++)];
+                    send.bus = sendNode.getProperty("bus");
+                    send.level = sendNode.getProperty("level");
+                    send.tap = MixerUtils::stringToTap(sendNode.getProperty("tap", "postPan"));
+                    send.mute = sendNode.getProperty("mute", false);
+                    send.ramp = std::make_shared<RenderModel::GainRamp>();
+                    send.ramp->gain = send.mute ? 0.0f : send.level;
                 }
             }
             
@@ -408,6 +876,12 @@ void Mixer::loadState(const juce::ValueTree& state) {
     
     // Load buses
     if (auto busesNode = state.getChildWithName("buses")) {
+        for (auto& bus : buses) {
+            loudnessAnalyser.removeSource(bus.channel.loudness);
+            for (auto& plugin : bus.channel.plugins) {
+                removedPlugins.push_back(std::move(plugin));
+            }
+        }
         buses.clear();
         
         for (auto busNode : busesNode) {
@@ -415,6 +889,7 @@ void Mixer::loadState(const juce::ValueTree& state) {
             bus.type = static_cast<BusType>(static_cast<int>(busNode.getProperty("type")));
             bus.name = busNode.getProperty("name");
             bus.outputBus = busNode.getProperty("output");
+            bus.soloSafe = busNode.getProperty("soloSafe", false);
             
             // Load sources
             if (auto sourcesNode = busNode.getChildWithName("sources")) {
@@ -428,6 +903,7 @@ void Mixer::loadState(const juce::ValueTree& state) {
                 bus.channel.volume = channelNode.getProperty("volume", 1.0f);
                 bus.channel.pan = channelNode.getProperty("pan", 0.0f);
                 bus.channel.mute = channelNode.getProperty("mute", false);
+                bus.channel.solo = channelNode.getProperty("solo", false);
                 bus.channel.bypass = channelNode.getProperty("bypass", false);
             }
             
@@ -443,159 +919,1099 @@ void Mixer::loadState(const juce::ValueTree& state) {
         masterChannel.bypass = masterNode.getProperty("bypass", false);
     }
     
-    updateProcessingBuffers();
+    // Load sidechains; each connects once its plugin exists
+    sidechains.clear();
+    pendingSidechains.clear();
+    
+    if (auto sidechainsNode = state.getChildWithName("sidechains")) {
+        for (auto sidechainNode : sidechainsNode) {
+            SidechainState sidechain;
+            sidechain.source = { MixerUtils::stringToNodeType(sidechainNode.getProperty("sourceType")),
+                                 sidechainNode.getProperty("source") };
+            sidechain.target = { MixerUtils::stringToNodeType(sidechainNode.getProperty("targetType")),
+                                 sidechainNode.getProperty("target") };
+            sidechain.onTrack = sidechainNode.getProperty("chain").toString() == "track";
+            sidechain.position = sidechainNode.getProperty("position", 0);
+            pendingSidechains.push_back(sidechain);
+        }
+    }
+    
     updateSoloStates();
+    updateProcessingBuffers();
+    retirePlugins(removedPlugins);
     sendChangeMessage();
 }
 
-void Mixer::updateProcessingBuffers() {
-    // Channel buffers
-    channelBuffers.resize(channels.size());
-    for (auto& buffer : channelBuffers) {
-        buffer.setSize(2, currentBlockSize);
-    }
-    
-    // Bus buffers
-    busBuffers.resize(buses.size());
-    for (auto& buffer : busBuffers) {
-        buffer.setSize(2, currentBlockSize);
-    }
-    
-    // Master buffer
-    masterBuffer.setSize(2, currentBlockSize);
+void Mixer::retireTrack(std::unique_ptr<Track> track) {
+    renderModels.retire(std::move(track));
 }
 
-void Mixer::clearAllBuffers() {
-    for (auto& buffer : channelBuffers) {
-        buffer.clear();
-    }
-    
-    for (auto& buffer : busBuffers) {
-        buffer.clear();
+void Mixer::retireTrackPlugins(std::vector<std::unique_ptr<Plugin>> plugins) {
+    // The track's chain no longer holds them, so their sidechains resolve
+    // to pending
+    publishRenderModel();
+    retirePlugins(plugins);
+}
+
+void Mixer::setLowLatencyMonitoring(bool enabled, int thresholdSamples) {
+    const int limit = enabled ? juce::jmax(0, thresholdSamples) : -1;
+    if (monitoringLatencyLimit != limit) {
+        monitoringLatencyLimit = limit;
+        publishRenderModel();
+        sendChangeMessage();
     }
-    
-    masterBuffer.clear();
 }
 
-void Mixer::processChannels(juce::AudioBuffer<float>& buffer,
-                          juce::MidiBuffer& midiMessages) {
+int Mixer::getMonitoringLatencySamples() const {
+    if (currentProject == nullptr) {
+        return 0;
+    }
+    
     const auto& tracks = currentProject->getTracks();
+    int latency = 0;
     
-    for (size_t i = 0; i < channels.size(); ++i) {
-        if (!isChannelActive(static_cast<int>(i))) {
+    for (int i = 0; i < tracks.size(); ++i) {
+        const auto* track = tracks[i];
+        if (track->getType() != Track::Type::Audio || !track->getParameters().monitoring) {
             continue;
         }
         
-        auto& channelBuffer = channelBuffers[i];
-        auto& channel = channels[i];
-        
-        // Get audio from track
-        if (i < tracks.size()) {
-            tracks[i]->processBlock(channelBuffer, midiMessages);
-        }
-        
-        // Process plugins
-        if (!channel.bypass) {
-            for (auto& plugin : channel.plugins) {
-                if (!plugin->isBypassed()) {
-                    plugin->processBlock(channelBuffer, midiMessages);
+        int chain = track->getPluginLatencySamples(monitoringLatencyLimit);
+        if (i < static_cast<int>(channels.size()) && !channels[static_cast<size_t>(i)].bypass) {
+            for (const auto& plugin : channels[static_cast<size_t>(i)].plugins) {
+                const int pluginLatency = plugin->getLatencySamples();
+                if (!plugin->isBypassed() &&
+                    (monitoringLatencyLimit < 0 || pluginLatency <= monitoringLatencyLimit)) {
+                    chain += pluginLatency;
                 }
             }
         }
         
-        // Apply channel settings
-        applyChannelSettings(channelBuffer, channel);
-        
-        // Update meters
-        updatePeakAndRMSLevels(channelBuffer, channel.peakLevel, channel.rmsLevel);
-        
-        // Process sends
-        processSends(channelBuffer, channel);
-        
-        // Mix to master
-        MixerUtils::mixBuffers(channelBuffer, masterBuffer);
+        latency = juce::jmax(latency, chain);
     }
+    
+    return latency;
 }
 
-void Mixer::processBuses() {
-    for (size_t i = 0; i < buses.size(); ++i) {
-        auto& bus = buses[i];
-        auto& busBuffer = busBuffers[i];
-        
-        // Mix sources
-        for (int source : bus.sources) {
-            if (source >= 0 && source < channelBuffers.size()) {
-                MixerUtils::mixBuffers(channelBuffers[source], busBuffer);
+void Mixer::setRecordingSession(std::shared_ptr<DiskRecorder::Session> session) {
+    recordingSession = std::move(session);
+    publishRenderModel();
+}
+
+void Mixer::publishRenderModel() {
+    updateSidechains();
+    
+    auto model = std::make_unique<RenderModel>();
+    
+    if (currentProject != nullptr) {
+        for (auto* track : currentProject->getTracks()) {
+            model->tracks.push_back(track);
+        }
+        model->tempoMap = currentProject->getTempoMapSnapshot();
+    }
+    model->recording = recordingSession;
+    model->monitoringLatencyLimit = monitoringLatencyLimit;
+    
+    // Channels; mute and solo are resolved with the routing
+    model->channels.reserve(channels.size());
+    for (size_t i = 0; i < channels.size(); ++i) {
+        const Track* track = i < model->tracks.size() ? model->tracks[i] : nullptr;
+        model->channels.push_back(makeChannelSnapshot(channels[i], track));
+    }
+    
+    // Audio tracks monitoring their input
+    for (size_t i = 0; i < model->tracks.size() && i < model->channels.size(); ++i) {
+        const auto* track = model->tracks[i];
+        if (track->getType() == Track::Type::Audio && track->getParameters().monitoring) {
+            model->channels[i].monitorInput = juce::jmax(0, track->getParameters().input.channel - 1);
+        }
+    }
+    
+    // Buses
+    model->buses.reserve(buses.size());
+    for (const auto& bus : buses) {
+        RenderModel::Bus snapshot;
+        snapshot.channel = makeChannelSnapshot(bus.channel);
+        model->buses.push_back(std::move(snapshot));
+    }
+    
+    model->master = makeChannelSnapshot(masterChannel);
+    
+    // Edges, render order and delay compensation
+    int numDelayLines = 0;
+    int maxDelay = 0;
+    buildRoutingPlan(*model, numDelayLines, maxDelay);
+    
+    // Reuse the scratch buffers unless the topology or block size changed
+    const int numChannels = static_cast<int>(channels.size());
+    const int numBuses = static_cast<int>(buses.size());
+    const auto* latest = renderModels.getLatest();
+    
+    if (latest != nullptr && latest->buffers != nullptr &&
+        latest->buffers->matches(numChannels, numBuses, currentBlockSize, numDelayLines, maxDelay)) {
+        model->buffers = latest->buffers;
+    } else {
+        auto buffers = std::make_shared<RenderModel::Buffers>();
+        buffers->channelBuffers.resize(channels.size());
+        for (auto& buffer : buffers->channelBuffers) {
+            buffer.setSize(2, currentBlockSize);
+        }
+        
+        buffers->busBuffers.resize(buses.size());
+        for (auto& buffer : buffers->busBuffers) {
+            buffer.setSize(2, currentBlockSize);
+        }
+        
+        buffers->masterBuffer.setSize(2, currentBlockSize);
+        buffers->blockSize = currentBlockSize;
+        
+        // Rounded up, so small latency changes keep the same buffers
+        buffers->delayCapacity = juce::nextPowerOfTwo(maxDelay + currentBlockSize);
+        buffers->delayLines.resize(static_cast<size_t>(numDelayLines));
+        for (auto& delayLine : buffers->delayLines) {
+            delayLine.prepare(2, buffers->delayCapacity, currentBlockSize);
+        }
+        
+        buffers->silentSamples.assign(channels.size() + buses.size() + 1, 0);
+        
+        model->buffers = std::move(buffers);
+    }
+    
+    renderModels.publish(std::move(model));
+}
+
+RenderModel::Channel Mixer::makeChannelSnapshot(const Channel& channel, const Track* track) const {
+    RenderModel::Channel snapshot;
+    snapshot.volume = channel.volume;
+    snapshot.pan = channel.pan;
+    snapshot.mute = channel.mute;
+    snapshot.bypass = channel.bypass;
+    snapshot.meter = channel.meter;
+    snapshot.loudness = channel.loudness;
+    
+    snapshot.plugins.reserve(channel.plugins.size());
+    for (const auto& plugin : channel.plugins) {
+        snapshot.plugins.push_back(plugin.get());
+    }
+    
+    // How long the track and strip chains may still sound after their
+    // input stops. Bypassed plugins count too, as bypass can change without
+    // a new model.
+    double tailSeconds = 0.0;
+    int latency = 0;
+    auto addTail = [&tailSeconds, &latency](const Plugin& plugin) {
+        tailSeconds += plugin.getTailLengthSeconds();
+        latency += plugin.getLatencySamples();
+    };
+    
+    if (track != nullptr) {
+        for (const auto* plugin : track->getPlugins()) {
+            addTail(*plugin);
+        }
+    }
+    for (const auto* plugin : snapshot.plugins) {
+        addTail(*plugin);
+    }
+    
+    const double tail = std::ceil(tailSeconds * currentSampleRate) + latency;
+    snapshot.tailSamples = tail < std::numeric_limits<int>::max() / 4 ? static_cast<int>(tail) : -1;
+    
+    return snapshot;
+}
+
+void Mixer::buildRoutingPlan(RenderModel& model, int& numDelayLines, int& maxDelay) {
+    const int numChannels = static_cast<int>(model.channels.size());
+    const int numBuses = static_cast<int>(model.buses.size());
+    const int masterNode = numChannels + numBuses;
+    
+    auto getSnapshot = [&model](const Node& node) -> RenderModel::Channel& {
+        switch (node.type) {
+            case Node::Type::Channel: return model.channels[static_cast<size_t>(node.index)];
+            case Node::Type::Bus: return model.buses[static_cast<size_t>(node.index)].channel;
+            case Node::Type::Master: break;
+        }
+        return model.master;
+    };
+    
+    auto getGraphIndex = [this, masterNode](const Node& node) {
+        return node.type == Node::Type::Master ? masterNode : getNodeIndex(node);
+    };
+    
+    // Latency of the first count plugins of a chain, as processBlock() runs it
+    auto getChainLatency = [](const auto& plugins, int count, int limit) {
+        int latency = 0;
+        int position = 0;
+        for (const Plugin* plugin : plugins) {
+            if (position++ >= count) {
+                break;
+            }
+            const int pluginLatency = plugin->getLatencySamples();
+            if (!plugin->isBypassed() && (limit < 0 || pluginLatency <= limit)) {
+                latency += pluginLatency;
             }
         }
+        return latency;
+    };
+    
+    // Latency from a node's input to a plugin in its track or strip chain
+    auto getLatencyBefore = [&](const Node& node, bool onTrack, int position) {
+        const auto& snapshot = getSnapshot(node);
+        const int limit = snapshot.monitorInput >= 0 ? model.monitoringLatencyLimit : -1;
+        int latency = 0;
         
-        // Process plugins
-        if (!bus.channel.bypass) {
-            for (auto& plugin : bus.channel.plugins) {
-                if (!plugin->isBypassed()) {
-                    plugin->processBlock(busBuffer, juce::MidiBuffer());
+        if (node.type == Node::Type::Channel && node.index < static_cast<int>(model.tracks.size())) {
+            const auto& trackPlugins = model.tracks[static_cast<size_t>(node.index)]->getPlugins();
+            latency += getChainLatency(trackPlugins, onTrack ? position : trackPlugins.size(), limit);
+            if (onTrack) {
+                return latency;
+            }
+        }
+        
+        if (!snapshot.bypass) {
+            latency += getChainLatency(snapshot.plugins, position, limit);
+        }
+        return latency;
+    };
+    
+    constexpr int wholeChain = std::numeric_limits<int>::max();
+    
+    // Edges into buses and the master. Channels always reach the master
+    // directly, as well as any bus they are a source of or send to. An edge
+    // that already existed keeps its ramp; a new one fades in from silence.
+    std::set<const RenderModel::GainRamp*> usedRamps;
+    auto addOutput = [&usedRamps](RenderModel::Channel& snapshot, Channel& source, int bus) {
+        auto& ramp = source.directRamps[bus];
+        if (ramp == nullptr) {
+            ramp = std::make_shared<RenderModel::GainRamp>();
+        }
+        usedRamps.insert(ramp.get());
+        
+        RenderModel::Output output;
+        output.bus = bus;
+        output.ramp = ramp;
+        snapshot.outputs.push_back(std::move(output));
+    };
+    
+    for (int b = 0; b < numBuses; ++b) {
+        for (int source : buses[static_cast<size_t>(b)].sources) {
+            if (source >= 0 && source < numChannels) {
+                addOutput(model.channels[static_cast<size_t>(source)], channels[static_cast<size_t>(source)], b);
+            }
+        }
+        
+        const int output = buses[static_cast<size_t>(b)].outputBus;
+        addOutput(model.buses[static_cast<size_t>(b)].channel, buses[static_cast<size_t>(b)].channel,
+                  output >= 0 && output < numBuses ? output : -1);
+    }
+    
+    for (int c = 0; c < numChannels; ++c) {
+        auto& snapshot = model.channels[static_cast<size_t>(c)];
+        auto& channel = channels[static_cast<size_t>(c)];
+        
+        for (int i = 0; i < channel.numSends; ++i) {
+            const auto& send = channel.sends[static_cast<size_t>(i)];
+            if (send.bus >= 0 && send.bus < numBuses) {
+                RenderModel::Output output;
+                output.bus = send.bus;
+                output.tap = send.tap;
+                output.gain = send.mute ? 0.0f : send.level;
+                output.ramp = send.ramp;
+                snapshot.outputs.push_back(std::move(output));
+            }
+        }
+        addOutput(snapshot, channel, -1);
+    }
+    
+    // A removed edge forgets its ramp, so it fades in again if restored
+    auto pruneRamps = [&usedRamps](Channel& channel) {
+        for (auto it = channel.directRamps.begin(); it != channel.directRamps.end();) {
+            if (usedRamps.count(it->second.get()) > 0) {
+                ++it;
+            } else {
+                it = channel.directRamps.erase(it);
+            }
+        }
+    };
+    for (auto& channel : channels) {
+        pruneRamps(channel);
+    }
+    for (auto& bus : buses) {
+        pruneRamps(bus.channel);
+    }
+    
+    // Group every node's edges by tap, so processing walks each group
+    // without testing them
+    auto groupByTap = [](RenderModel::Channel& snapshot) {
+        std::stable_sort(snapshot.outputs.begin(), snapshot.outputs.end(),
+                         [](const RenderModel::Output& a, const RenderModel::Output& b) {
+                             return a.tap < b.tap;
+                         });
+        
+        snapshot.tapOffsets.fill(0);
+        for (const auto& output : snapshot.outputs) {
+            ++snapshot.tapOffsets[static_cast<size_t>(output.tap) + 1];
+        }
+        for (size_t t = 1; t < snapshot.tapOffsets.size(); ++t) {
+            snapshot.tapOffsets[t] += snapshot.tapOffsets[t - 1];
+        }
+    };
+    
+    for (auto& snapshot : model.channels) {
+        groupByTap(snapshot);
+    }
+    for (auto& bus : model.buses) {
+        groupByTap(bus.channel);
+    }
+    
+    // Render order
+    std::vector<int> order;
+    if (!sortRoutingGraph(buildRoutingGraph(), order)) {
+        LOG_WARNING("Mixer routing contains a feedback loop; part of it renders a block late");
+    }
+    
+    // Latency at every node's output. A summing node waits for its slowest
+    // input, so arrival is the maximum over its edges.
+    std::vector<int> arrival(static_cast<size_t>(masterNode + 1), 0);
+    std::vector<int> latency(static_cast<size_t>(masterNode), 0);
+    
+    auto getDestination = [numChannels, masterNode](const RenderModel::Output& output) {
+        return output.bus >= 0 ? numChannels + output.bus : masterNode;
+    };
+    
+    for (int n : order) {
+        const auto node = getNode(n);
+        auto& snapshot = getSnapshot(node);
+        latency[static_cast<size_t>(n)] = arrival[static_cast<size_t>(n)] + getLatencyBefore(node, false, wholeChain);
+        snapshot.latency = latency[static_cast<size_t>(n)];
+        
+        for (const auto& output : snapshot.outputs) {
+            auto& destination = arrival[static_cast<size_t>(getDestination(output))];
+            destination = juce::jmax(destination, snapshot.latency);
+        }
+    }
+    
+    const Node master{ Node::Type::Master, 0 };
+    model.master.latency = arrival[static_cast<size_t>(masterNode)] + getLatencyBefore(master, false, wholeChain);
+    model.outputLatency = model.master.latency;
+    
+    // Delay every edge up to its destination's arrival
+    numDelayLines = 0;
+    maxDelay = 0;
+    
+    for (int n = 0; n < masterNode; ++n) {
+        for (auto& output : getSnapshot(getNode(n)).outputs) {
+            output.delay = juce::jmax(0, arrival[static_cast<size_t>(getDestination(output))] - latency[static_cast<size_t>(n)]);
+            if (output.delay > 0) {
+                output.delayLine = numDelayLines++;
+                maxDelay = juce::jmax(maxDelay, output.delay);
+            }
+        }
+    }
+    
+    // Sidechains line up with the audio reaching their plugin. A source
+    // slower than that path stays late: compensating it would mean delaying
+    // the target, and with it everything downstream.
+    for (const auto& sidechain : sidechains) {
+        const auto location = findPlugin(sidechain.plugin);
+        const int source = getNodeIndex(sidechain.source);
+        if (location.position < 0 || source < 0) {
+            continue;
+        }
+        
+        const int atPlugin = arrival[static_cast<size_t>(getGraphIndex(location.target))] +
+                             getLatencyBefore(location.target, location.onTrack, location.position);
+        
+        RenderModel::Sidechain edge;
+        edge.source = sidechain.source;
+        edge.plugin = sidechain.plugin;
+        edge.delay = juce::jmax(0, atPlugin - latency[static_cast<size_t>(source)]);
+        if (edge.delay > 0) {
+            edge.delayLine = numDelayLines++;
+            maxDelay = juce::jmax(maxDelay, edge.delay);
+        }
+        getSnapshot(location.target).sidechains.push_back(edge);
+    }
+    
+    // Solo in place, on the full graph and after delay compensation, so
+    // soloing never shifts anything in time. Downstream of a solo or of a
+    // solo-safe bus, every edge carries on towards the master. Upstream of
+    // a solo, edges only count towards the solo or into solo-safe buses.
+    std::vector<char> soloed(static_cast<size_t>(masterNode), 0);
+    std::vector<char> soloPath(static_cast<size_t>(masterNode), 0);
+    std::vector<char> safePath(static_cast<size_t>(masterNode), 0);
+    std::vector<char> upstream(static_cast<size_t>(masterNode), 0);
+    
+    for (int n = 0; n < masterNode; ++n) {
+        const auto node = getNode(n);
+        const auto index = static_cast<size_t>(node.index);
+        soloed[static_cast<size_t>(n)] = node.type == Node::Type::Channel ? channels[index].solo : buses[index].channel.solo;
+        soloPath[static_cast<size_t>(n)] = soloed[static_cast<size_t>(n)];
+        safePath[static_cast<size_t>(n)] = node.type == Node::Type::Bus && buses[index].soloSafe;
+    }
+    
+    for (int n : order) {
+        for (const auto& output : getSnapshot(getNode(n)).outputs) {
+            const int d = getDestination(output);
+            if (d < masterNode) {
+                soloPath[static_cast<size_t>(d)] |= soloPath[static_cast<size_t>(n)];
+                safePath[static_cast<size_t>(d)] |= safePath[static_cast<size_t>(n)];
+            }
+        }
+    }
+    
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        for (const auto& output : getSnapshot(getNode(*it)).outputs) {
+            const int d = getDestination(output);
+            if (d < masterNode && (soloed[static_cast<size_t>(d)] || upstream[static_cast<size_t>(d)])) {
+                upstream[static_cast<size_t>(*it)] = 1;
+            }
+        }
+    }
+    
+    auto isLive = [&](int n, int d) {
+        const auto source = static_cast<size_t>(n);
+        if (!soloActive || soloPath[source] || safePath[source]) {
+            return true;
+        }
+        return upstream[source] && d < masterNode &&
+               (soloed[static_cast<size_t>(d)] || upstream[static_cast<size_t>(d)] || safePath[static_cast<size_t>(d)]);
+    };
+    
+    // Skip whatever cannot be heard. A node is fed if it has a track, a
+    // plugin that may still ring, or a live input; it contributes if it is
+    // fed and reaches the master or keys a plugin on a node that does.
+    std::vector<char> fed(static_cast<size_t>(masterNode), 0);
+    std::vector<char> keys(static_cast<size_t>(masterNode), 0);
+    std::vector<char> contributes(static_cast<size_t>(masterNode + 1), 0);
+    contributes[static_cast<size_t>(masterNode)] = 1;
+    
+    for (int n : order) {
+        const auto node = getNode(n);
+        const auto& snapshot = getSnapshot(node);
+        auto& isFed = fed[static_cast<size_t>(n)];
+        isFed |= node.type == Node::Type::Channel || (!snapshot.bypass && !snapshot.plugins.empty());
+        if (snapshot.mute || !isFed) {
+            continue;
+        }
+        
+        for (const auto& output : snapshot.outputs) {
+            const int d = getDestination(output);
+            if (d < masterNode && isLive(n, d)) {
+                fed[static_cast<size_t>(d)] = 1;
+            }
+        }
+    }
+    
+    auto markKeys = [&](const RenderModel::Channel& snapshot) {
+        for (const auto& sidechain : snapshot.sidechains) {
+            keys[static_cast<size_t>(getNodeIndex(sidechain.source))] = 1;
+        }
+    };
+    markKeys(model.master);
+    
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        const int n = *it;
+        auto& snapshot = getSnapshot(getNode(n));
+        if (snapshot.mute || !fed[static_cast<size_t>(n)]) {
+            continue;
+        }
+        
+        bool reachesMaster = false;
+        for (const auto& output : snapshot.outputs) {
+            const int d = getDestination(output);
+            reachesMaster |= isLive(n, d) && contributes[static_cast<size_t>(d)];
+        }
+        
+        if (reachesMaster || keys[static_cast<size_t>(n)]) {
+            contributes[static_cast<size_t>(n)] = 1;
+            markKeys(snapshot);
+        }
+    }
+    
+    // Keep only contributing nodes and the edges between them. A key-only
+    // node renders for its sidechains but outputs nothing.
+    for (int n = 0; n < masterNode; ++n) {
+        auto& snapshot = getSnapshot(getNode(n));
+        snapshot.active = contributes[static_cast<size_t>(n)] != 0;
+        
+        auto& outputs = snapshot.outputs;
+        outputs.erase(std::remove_if(outputs.begin(), outputs.end(),
+                                     [&](const RenderModel::Output& output) {
+                                         const int d = getDestination(output);
+                                         return !snapshot.active || !isLive(n, d) ||
+                                                !contributes[static_cast<size_t>(d)];
+                                     }),
+                      outputs.end());
+        groupByTap(snapshot);
+    }
+    
+    model.order.reserve(order.size());
+    for (int n : order) {
+        if (contributes[static_cast<size_t>(n)]) {
+            model.order.push_back(getNode(n));
+        }
+    }
+}
+
+int Mixer::getNodeIndex(const Node& node) const {
+    const int numChannels = static_cast<int>(channels.size());
+    switch (node.type) {
+        case Node::Type::Channel:
+            return node.index >= 0 && node.index < numChannels ? node.index : -1;
+        case Node::Type::Bus:
+            return node.index >= 0 && node.index < static_cast<int>(buses.size()) ? numChannels + node.index : -1;
+        case Node::Type::Master:
+            break;
+    }
+    return -1;
+}
+
+Mixer::Node Mixer::getNode(int nodeIndex) const {
+    const int numChannels = static_cast<int>(channels.size());
+    return nodeIndex < numChannels ? Node{ Node::Type::Channel, nodeIndex }
+                                   : Node{ Node::Type::Bus, nodeIndex - numChannels };
+}
+
+std::vector<std::vector<int>> Mixer::buildRoutingGraph() const {
+    const int numChannels = static_cast<int>(channels.size());
+    const int numBuses = static_cast<int>(buses.size());
+    std::vector<std::vector<int>> graph(static_cast<size_t>(numChannels + numBuses));
+    
+    for (int b = 0; b < numBuses; ++b) {
+        const auto& bus = buses[static_cast<size_t>(b)];
+        for (int source : bus.sources) {
+            if (source >= 0 && source < numChannels) {
+                graph[static_cast<size_t>(source)].push_back(numChannels + b);
+            }
+        }
+        if (bus.outputBus >= 0 && bus.outputBus < numBuses) {
+            graph[static_cast<size_t>(numChannels + b)].push_back(numChannels + bus.outputBus);
+        }
+    }
+    
+    for (int c = 0; c < numChannels; ++c) {
+        const auto& channel = channels[static_cast<size_t>(c)];
+        for (int i = 0; i < channel.numSends; ++i) {
+            const int bus = channel.sends[static_cast<size_t>(i)].bus;
+            if (bus >= 0 && bus < numBuses) {
+                graph[static_cast<size_t>(c)].push_back(numChannels + bus);
+            }
+        }
+    }
+    
+    // The master renders last anyway, so only sidechains into channels and
+    // buses constrain the order
+    for (const auto& sidechain : sidechains) {
+        const int source = getNodeIndex(sidechain.source);
+        const int target = getNodeIndex(findPlugin(sidechain.plugin).target);
+        if (source >= 0 && target >= 0) {
+            graph[static_cast<size_t>(source)].push_back(target);
+        }
+    }
+    
+    return graph;
+}
+
+bool Mixer::sortRoutingGraph(const std::vector<std::vector<int>>& graph, std::vector<int>& order) {
+    // Kahn's algorithm, taking ready nodes in index order
+    const size_t numNodes = graph.size();
+    std::vector<int> inputs(numNodes, 0);
+    for (const auto& edges : graph) {
+        for (int destination : edges) {
+            ++inputs[static_cast<size_t>(destination)];
+        }
+    }
+    
+    order.clear();
+    order.reserve(numNodes);
+    for (size_t n = 0; n < numNodes; ++n) {
+        if (inputs[n] == 0) {
+            order.push_back(static_cast<int>(n));
+        }
+    }
+    
+    for (size_t i = 0; i < order.size(); ++i) {
+        for (int destination : graph[static_cast<size_t>(order[i])]) {
+            if (--inputs[static_cast<size_t>(destination)] == 0) {
+                order.push_back(destination);
+            }
+        }
+    }
+    
+    if (order.size() == numNodes) {
+        return true;
+    }
+    
+    // A loop: whatever is left renders in index order
+    for (size_t n = 0; n < numNodes; ++n) {
+        if (inputs[n] > 0) {
+            order.push_back(static_cast<int>(n));
+        }
+    }
+    return false;
+}
+
+Mixer::SidechainState Mixer::findPlugin(const Plugin* plugin) const {
+    auto findIn = [plugin](const std::vector<std::unique_ptr<Plugin>>& plugins) {
+        for (size_t i = 0; i < plugins.size(); ++i) {
+            if (plugins[i].get() == plugin) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    };
+    
+    SidechainState location;
+    location.position = -1;
+    if (plugin == nullptr) {
+        return location;
+    }
+    
+    for (int i = 0; i < static_cast<int>(channels.size()); ++i) {
+        location.target = { Node::Type::Channel, i };
+        
+        if (currentProject != nullptr && i < currentProject->getTracks().size()) {
+            location.onTrack = true;
+            location.position = currentProject->getTracks()[i]->getPlugins().indexOf(plugin);
+            if (location.position >= 0) {
+                return location;
+            }
+        }
+        
+        location.onTrack = false;
+        location.position = findIn(channels[static_cast<size_t>(i)].plugins);
+        if (location.position >= 0) {
+            return location;
+        }
+    }
+    
+    for (int i = 0; i < static_cast<int>(buses.size()); ++i) {
+        location.target = { Node::Type::Bus, i };
+        location.position = findIn(buses[static_cast<size_t>(i)].channel.plugins);
+        if (location.position >= 0) {
+            return location;
+        }
+    }
+    
+    location.target = { Node::Type::Master, 0 };
+    location.position = findIn(masterChannel.plugins);
+    return location;
+}
+
+Plugin* Mixer::resolvePlugin(const SidechainState& state) const {
+    const std::vector<std::unique_ptr<Plugin>>* plugins = nullptr;
+    
+    switch (state.target.type) {
+        case Node::Type::Channel:
+            if (state.target.index < 0 || state.target.index >= static_cast<int>(channels.size())) {
+                return nullptr;
+            }
+            if (state.onTrack) {
+                if (currentProject == nullptr || state.target.index >= currentProject->getTracks().size()) {
+                    return nullptr;
                 }
+                return currentProject->getTracks()[state.target.index]->getPlugin(state.position);
+            }
+            plugins = &channels[static_cast<size_t>(state.target.index)].plugins;
+            break;
+        case Node::Type::Bus:
+            if (state.target.index < 0 || state.target.index >= static_cast<int>(buses.size())) {
+                return nullptr;
             }
+            plugins = &buses[static_cast<size_t>(state.target.index)].channel.plugins;
+            break;
+        case Node::Type::Master:
+            plugins = &masterChannel.plugins;
+            break;
+    }
+    
+    if (!juce::isPositiveAndBelow(state.position, static_cast<int>(plugins->size()))) {
+        return nullptr;
+    }
+    return (*plugins)[static_cast<size_t>(state.position)].get();
+}
+
+void Mixer::updateSidechains() {
+    // Drop edges whose plugin has gone, e.g. removed from its track
+    sidechains.erase(std::remove_if(sidechains.begin(), sidechains.end(),
+                                    [this](const Sidechain& sidechain) {
+                                        return getNodeIndex(sidechain.source) < 0 ||
+                                               findPlugin(sidechain.plugin).position < 0;
+                                    }),
+                     sidechains.end());
+    
+    // Connect loaded edges once their plugins exist; track chains load
+    // asynchronously
+    for (auto it = pendingSidechains.begin(); it != pendingSidechains.end();) {
+        auto* plugin = resolvePlugin(*it);
+        if (plugin == nullptr || !plugin->acceptsSidechain() || getNodeIndex(it->source) < 0) {
+            ++it;
+            continue;
         }
         
-        // Apply channel settings
-        applyChannelSettings(busBuffer, bus.channel);
+        sidechains.erase(std::remove_if(sidechains.begin(), sidechains.end(),
+                                        [plugin](const Sidechain& sidechain) {
+                                            return sidechain.plugin == plugin;
+                                        }),
+                         sidechains.end());
+        sidechains.push_back({it->source, plugin});
+        it = pendingSidechains.erase(it);
+    }
+}
+
+void Mixer::remapSidechains(Node::Type type, const std::function<int(int)>& remap) {
+    // remap returns -1 for a node that no longer exists
+    auto update = [type, &remap](Node& node) {
+        if (node.type == type) {
+            node.index = remap(node.index);
+        }
+        return node.index >= 0;
+    };
+    
+    for (auto it = sidechains.begin(); it != sidechains.end();) {
+        it = update(it->source) ? it + 1 : sidechains.erase(it);
+    }
+    
+    for (auto it = pendingSidechains.begin(); it != pendingSidechains.end();) {
+        const bool valid = update(it->source) && update(it->target);
+        it = valid ? it + 1 : pendingSidechains.erase(it);
+    }
+}
+
+void Mixer::retirePlugins(std::vector<std::unique_ptr<Plugin>>& plugins) {
+    // Only call once a model without these plugins has been published
+    for (auto& plugin : plugins) {
+        renderModels.retire(std::move(plugin));
+    }
+    plugins.clear();
+}
+
+void Mixer::updateProcessingBuffers() {
+    updateLoudnessSources(false);
+    publishRenderModel();
+}
+
+void Mixer::clearAllBuffers(RenderModel::Buffers& buffers) {
+    for (auto& buffer : buffers.channelBuffers) {
+        buffer.clear();
+    }
+    
+    for (auto& buffer : buffers.busBuffers) {
+        buffer.clear();
+    }
+    
+    buffers.masterBuffer.clear();
+}
+
+juce::AudioBuffer<float>& Mixer::getNodeBuffer(RenderModel::Buffers& buffers, const Node& node) {
+    switch (node.type) {
+        case Node::Type::Channel: return buffers.channelBuffers[static_cast<size_t>(node.index)];
+        case Node::Type::Bus: return buffers.busBuffers[static_cast<size_t>(node.index)];
+        case Node::Type::Master: break;
+    }
+    return buffers.masterBuffer;
+}
+
+void Mixer::processChannel(const RenderModel& model,
+                         int index,
+                         juce::MidiBuffer& midiMessages,
+                         const Input& input,
+                         bool playing,
+                         int numSamples) {
+    auto& buffers = *model.buffers;
+    const auto& channel = model.channels[static_cast<size_t>(index)];
+    auto& channelBuffer = buffers.channelBuffers[static_cast<size_t>(index)];
+    
+    const bool monitoring = channel.monitorInput >= 0 && channel.monitorInput < input.numChannels &&
+                            input.channels[channel.monitorInput] != nullptr;
+    
+    // Sidechain delays run even when the channel is skipped, so they never
+    // replay stale audio
+    const bool keysSilent = connectSidechains(channel, buffers, numSamples);
+    
+    if (!channel.active || (!playing && !monitoring)) {
+        disconnectSidechains(channel);
+        skipOutputs(channelBuffer, channel, buffers, numSamples);
+        return;
+    }
+    
+    // Live input goes through the same chain as the track, in this callback
+    if (monitoring) {
+        const float* source = input.channels[channel.monitorInput] + input.startSample;
+        const int inputSamples = juce::jmin(channelBuffer.getNumSamples(), input.numSamples);
+        for (int ch = 0; ch < channelBuffer.getNumChannels(); ++ch) {
+            channelBuffer.addFrom(ch, 0, source, inputSamples);
+        }
+    }
+    
+    const int latencyLimit = monitoring ? model.monitoringLatencyLimit : -1;
+    
+    // MIDI may start a note, so only audio-silent input without events lets
+    // the track and strip chains sleep; the snapshot's tail covers both
+    const bool inputSilent = MixerUtils::clearIfSilent(channelBuffer, numSamples) && keysSilent &&
+                             midiMessages.isEmpty();
+    const bool asleep = updateSleepState(buffers, static_cast<size_t>(index), channel, inputSilent, numSamples);
+    
+    if (!asleep) {
+        // Get audio from track
+        if (index < static_cast<int>(model.tracks.size())) {
+            model.tracks[static_cast<size_t>(index)]->processBlock(channelBuffer, midiMessages, latencyLimit);
+        }
         
-        // Route to output
-        if (bus.outputBus >= 0 && bus.outputBus < busBuffers.size()) {
-            MixerUtils::mixBuffers(busBuffer, busBuffers[bus.outputBus]);
-        } else {
-            MixerUtils::mixBuffers(busBuffer, masterBuffer);
+        // Process plugins
+        if (!channel.bypass) {
+            for (auto* plugin : channel.plugins) {
+                if (!plugin->isBypassed() &&
+                    (latencyLimit < 0 || plugin->getLatencySamples() <= latencyLimit)) {
+                    plugin->processBlock(channelBuffer, midiMessages);
+                }
+            }
         }
+        MixerUtils::clearIfSilent(channelBuffer, numSamples);
     }
+    disconnectSidechains(channel);
+    
+    // Sends tap the strip before and after each stage; direct out and bus
+    // sources leave after the pan
+    processOutputs(channelBuffer, channel, buffers, RenderModel::Tap::PreFader, numSamples);
+    applyVolume(channelBuffer, channel);
+    processOutputs(channelBuffer, channel, buffers, RenderModel::Tap::PostFader, numSamples);
+    applyPan(channelBuffer, channel);
+    
+    // Update meters
+    updatePeakAndRMSLevels(channelBuffer, channel);
+    
+    processOutputs(channelBuffer, channel, buffers, RenderModel::Tap::PostPan, numSamples);
 }
 
-void Mixer::processMaster(juce::AudioBuffer<float>& buffer) {
+void Mixer::processBus(const RenderModel& model, int index, int numSamples) {
+    auto& buffers = *model.buffers;
+    const auto& bus = model.buses[static_cast<size_t>(index)];
+    auto& busBuffer = buffers.busBuffers[static_cast<size_t>(index)];
+    
+    // Every input has already been pushed here; silent ones were skipped,
+    // so the buffer is still flagged cleared if they all were
+    const bool keysSilent = connectSidechains(bus.channel, buffers, numSamples);
+    const bool asleep = updateSleepState(buffers, model.channels.size() + static_cast<size_t>(index), bus.channel,
+                                         busBuffer.hasBeenCleared() && keysSilent, numSamples);
+    
+    // Process plugins
+    if (!bus.channel.bypass && !asleep) {
+        for (auto* plugin : bus.channel.plugins) {
+            if (!plugin->isBypassed()) {
+                emptyMidi.clear();
+                plugin->processBlock(busBuffer, emptyMidi);
+            }
+        }
+        MixerUtils::clearIfSilent(busBuffer, numSamples);
+    }
+    disconnectSidechains(bus.channel);
+    
+    // Apply channel settings
+    applyChannelSettings(busBuffer, bus.channel);
+    
+    // Update meters
+    updatePeakAndRMSLevels(busBuffer, bus.channel);
+    pushLoudness(busBuffer, bus.channel);
+    
+    // Route to output
+    processOutputs(busBuffer, bus.channel, buffers, RenderModel::Tap::PostPan, numSamples);
+}
+
+void Mixer::processMaster(const RenderModel& model, juce::AudioBuffer<float>& buffer, int numSamples) {
+    const auto& master = model.master;
+    auto& masterBuffer = model.buffers->masterBuffer;
+    
     // Process master plugins
-    if (!masterChannel.bypass) {
-        for (auto& plugin : masterChannel.plugins) {
+    const bool keysSilent = connectSidechains(master, *model.buffers, numSamples);
+    const bool asleep = updateSleepState(*model.buffers, model.buffers->silentSamples.size() - 1, master,
+                                         masterBuffer.hasBeenCleared() && keysSilent, numSamples);
+    if (!master.bypass && !asleep) {
+        for (auto* plugin : master.plugins) {
             if (!plugin->isBypassed()) {
-                plugin->processBlock(masterBuffer, juce::MidiBuffer());
+                emptyMidi.clear();
+                plugin->processBlock(masterBuffer, emptyMidi);
             }
         }
+        MixerUtils::clearIfSilent(masterBuffer, numSamples);
     }
+    disconnectSidechains(master);
     
     // Apply master settings
-    applyChannelSettings(masterBuffer, masterChannel);
+    applyChannelSettings(masterBuffer, master);
     
     // Update meters
-    updatePeakAndRMSLevels(masterBuffer, masterChannel.peakLevel, masterChannel.rmsLevel);
+    updatePeakAndRMSLevels(masterBuffer, master);
+    pushLoudness(masterBuffer, master);
+    
+    // Copy to output (makeCopyOf would reallocate the device buffer)
+    const int numChannels = std::min(buffer.getNumChannels(), masterBuffer.getNumChannels());
+    
+    buffer.clear();
+    for (int channel = 0; channel < numChannels; ++channel) {
+        buffer.copyFrom(channel, 0, masterBuffer, channel, 0, numSamples);
+    }
+}
+
+bool Mixer::updateSleepState(RenderModel::Buffers& buffers,
+                             size_t node,
+                             const RenderModel::Channel& channel,
+                             bool inputSilent,
+                             int numSamples) {
+    // Asleep once the last input has had the chain's latency and tail to
+    // come out, so this block's output is silent too
+    auto& silentSamples = buffers.silentSamples[node];
+    silentSamples = inputSilent ? juce::jmin(silentSamples + numSamples, std::numeric_limits<int>::max() / 2) : 0;
     
-    // Copy to output
-    buffer.makeCopyOf(masterBuffer);
+    const bool asleep = channel.tailSamples >= 0 && silentSamples >= channel.tailSamples + numSamples;
+    if (asleep) {
+        ++sleepingNodes;
+    }
+    return asleep;
+}
+
+bool Mixer::connectSidechains(const RenderModel::Channel& channel,
+                            RenderModel::Buffers& buffers,
+                            int numSamples) {
+    // Sources have rendered already. Undelayed, the plugin reads the source
+    // buffer itself; otherwise the delay line's output. Returns whether
+    // every key is silent.
+    bool silent = true;
+    for (const auto& sidechain : channel.sidechains) {
+        const juce::AudioBuffer<float>* source = &getNodeBuffer(buffers, sidechain.source);
+        
+        if (sidechain.delayLine >= 0) {
+            auto& delayLine = buffers.delayLines[static_cast<size_t>(sidechain.delayLine)];
+            delayLine.process(*source, numSamples, sidechain.delay);
+            source = &delayLine.output;
+        }
+        
+        sidechain.plugin->setSidechainInput(
+            juce::dsp::AudioBlock<const float>(source->getArrayOfReadPointers(),
+                                               static_cast<size_t>(source->getNumChannels()),
+                                               static_cast<size_t>(source->getNumSamples())));
+        silent = silent && source->hasBeenCleared();
+    }
+    return silent;
+}
+
+void Mixer::disconnectSidechains(const RenderModel::Channel& channel) {
+    for (const auto& sidechain : channel.sidechains) {
+        sidechain.plugin->clearSidechainInput();
+    }
+}
+
+void Mixer::processOutputs(const juce::AudioBuffer<float>& source,
+                         const RenderModel::Channel& channel,
+                         RenderModel::Buffers& buffers,
+                         RenderModel::Tap tap,
+                         int numSamples) {
+    const auto t = static_cast<size_t>(tap);
+    
+    for (int i = channel.tapOffsets[t]; i < channel.tapOffsets[t + 1]; ++i) {
+        const auto& output = channel.outputs[static_cast<size_t>(i)];
+        auto& destination = output.bus >= 0 ? buffers.busBuffers[static_cast<size_t>(output.bus)]
+                                            : buffers.masterBuffer;
+        const auto* signal = &source;
+        
+        if (output.delayLine >= 0) {
+            auto& delayLine = buffers.delayLines[static_cast<size_t>(output.delayLine)];
+            delayLine.process(source, numSamples, output.delay);
+            signal = &delayLine.output;
+        }
+        
+        MixerUtils::mixBuffersWithRamp(*signal, destination, numSamples, output.ramp->gain, output.gain);
+        output.ramp->gain = output.gain;
+    }
+}
+
+void Mixer::skipOutputs(const juce::AudioBuffer<float>& silence,
+                      const RenderModel::Channel& channel,
+                      RenderModel::Buffers& buffers,
+                      int numSamples) {
+    // Nothing to add, but delay lines still drain what they hold. Once an
+    // edge has nothing left to send its ramp drops to silence, so the node
+    // fades back in through mixBuffersWithRamp when it resumes.
+    for (const auto& output : channel.outputs) {
+        if (output.delayLine >= 0) {
+            auto& destination = output.bus >= 0 ? buffers.busBuffers[static_cast<size_t>(output.bus)]
+                                                : buffers.masterBuffer;
+            auto& delayLine = buffers.delayLines[static_cast<size_t>(output.delayLine)];
+            delayLine.process(silence, numSamples, output.delay);
+            
+            if (!delayLine.output.hasBeenCleared()) {
+                MixerUtils::mixBuffersWithRamp(delayLine.output, destination, numSamples,
+                                               output.ramp->gain, output.gain);
+                output.ramp->gain = output.gain;
+                continue;
+            }
+        }
+        output.ramp->gain = 0.0f;
+    }
 }
 
 void Mixer::updatePeakAndRMSLevels(const juce::AudioBuffer<float>& buffer,
-                                  float& peak, float& rms) {
-    peak = 0.0f;
-    rms = 0.0f;
+                                  const RenderModel::Channel& channel) {
+    // Nobody is watching, or silence: the slot already reads zero once
+    // consumed, so skip the measurement entirely
+    if (!meterBus.isActive() || buffer.hasBeenCleared()) {
+        return;
+    }
     
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
-        peak = std::max(peak, buffer.getMagnitude(channel, 0, buffer.getNumSamples()));
-        rms = std::max(rms, MixerUtils::calculateRMSLevel(buffer.getReadPointer(channel),
-                                                        buffer.getNumSamples()));
+    MeterBusUtils::measureAndPublish(buffer, buffer.getNumSamples(), *channel.meter);
+}
+
+void Mixer::updateLoudnessSources(bool recreate) {
+    auto updateSource = [this, recreate](Channel& channel) {
+        if (recreate && channel.loudness != nullptr) {
+            loudnessAnalyser.removeSource(channel.loudness);
+            channel.loudness.reset();
+        }
+        
+        if (channel.loudness == nullptr) {
+            channel.loudness = loudnessAnalyser.createSource(currentSampleRate, 2, currentBlockSize);
+            channel.loudness->setMeterSlot(channel.meter.get());
+        }
+    };
+    
+    for (auto& bus : buses) {
+        updateSource(bus.channel);
+    }
+    
+    updateSource(masterChannel);
+}
+
+void Mixer::pushLoudness(const juce::AudioBuffer<float>& buffer,
+                        const RenderModel::Channel& channel) {
+    // Loudness runs regardless of meter consumers so the integrated
+    // measurement covers the whole programme
+    if (channel.loudness != nullptr) {
+        channel.loudness->push(buffer, buffer.getNumSamples());
     }
 }
 
 void Mixer::applyChannelSettings(juce::AudioBuffer<float>& buffer,
-                               const Channel& channel) {
-    if (channel.mute || !buffer.hasBeenCleared()) {
+                               const RenderModel::Channel& channel) {
+    applyVolume(buffer, channel);
+    applyPan(buffer, channel);
+}
+
+void Mixer::applyVolume(juce::AudioBuffer<float>& buffer,
+                      const RenderModel::Channel& channel) {
+    if (channel.mute) {
         buffer.clear();
         return;
     }
     
-    // Apply volume
-    if (channel.volume != 1.0f) {
+    // A silent buffer has nothing to scale
+    if (!buffer.hasBeenCleared() && channel.volume != 1.0f) {
         buffer.applyGain(channel.volume);
     }
-    
-    // Apply pan
-    if (channel.pan != 0.0f && buffer.getNumChannels() == 2) {
+}
+
+void Mixer::applyPan(juce::AudioBuffer<float>& buffer,
+                   const RenderModel::Channel& channel) {
+    if (channel.pan != 0.0f && buffer.getNumChannels() == 2 && !buffer.hasBeenCleared()) {
         const float leftGain = calculatePanGain(channel.pan, true);
         const float rightGain = calculatePanGain(channel.pan, false);
         
@@ -604,35 +2020,18 @@ void Mixer::applyChannelSettings(juce::AudioBuffer<float>& buffer,
     }
 }
 
-void Mixer::processSends(const juce::AudioBuffer<float>& source,
-                        const Channel& channel) {
-    for (const auto& send : channel.sends) {
-        if (send.first >= 0 && send.first < busBuffers.size()) {
-            MixerUtils::mixBuffers(source, busBuffers[send.first], send.second);
-        }
-    }
-}
-
 void Mixer::updateSoloStates() {
-    soloActive = false;
-    
-    // Check if any channel is soloed
-    for (const auto& channel : channels) {
-        if (channel.solo) {
-            soloActive = true;
-            break;
-        }
-    }
-    
-    // Update solo buffer
-    for (size_t i = 0; i < channels.size(); ++i) {
-        channelSoloBuffer[i] = !soloActive || channels[i].solo;
-    }
+    // Check if any channel or bus is soloed; the render model resolves the rest
+    soloActive = std::any_of(channels.begin(), channels.end(),
+                             [](const Channel& channel) { return channel.solo; }) ||
+                 std::any_of(buses.begin(), buses.end(),
+                             [](const Bus& bus) { return bus.channel.solo; });
 }
 
 bool Mixer::isChannelActive(int index) const {
-    if (index >= 0 && index < channels.size()) {
-        return !channels[index].mute && channelSoloBuffer[index];
+    const auto* latest = renderModels.getLatest();
+    if (latest != nullptr && index >= 0 && index < static_cast<int>(latest->channels.size())) {
+        return latest->channels[static_cast<size_t>(index)].active;
     }
     return false;
 }
@@ -697,6 +2096,22 @@ namespace MixerUtils {
         return peak;
     }
 
+    bool clearIfSilent(juce::AudioBuffer<float>& buffer, int numSamples) {
+        if (buffer.hasBeenCleared()) {
+            return true;
+        }
+        
+        numSamples = std::min(numSamples, buffer.getNumSamples());
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel) {
+            if (buffer.getMagnitude(channel, 0, numSamples) > silenceThreshold) {
+                return false;
+            }
+        }
+        
+        buffer.clear();
+        return true;
+    }
+    
     void applyGainRamp(juce::AudioBuffer<float>& buffer,
                       int startSample,
                       int numSamples,
@@ -730,6 +2145,27 @@ namespace MixerUtils {
         }
     }
 
+    void mixBuffersWithRamp(const juce::AudioBuffer<float>& source,
+                           juce::AudioBuffer<float>& destination,
+                           int numSamples,
+                           float startGain,
+                           float endGain) {
+        const int numChannels = std::min(source.getNumChannels(),
+                                       destination.getNumChannels());
+        numSamples = std::min({ numSamples, source.getNumSamples(), destination.getNumSamples() });
+        
+        // Silence adds nothing, and leaves the destination flagged cleared
+        if (source.hasBeenCleared()) {
+            return;
+        }
+        
+        // A constant gain falls back to a plain add, which skips zero gain
+        for (int channel = 0; channel < numChannels; ++channel) {
+            destination.addFromWithRamp(channel, 0, source.getReadPointer(channel),
+                                        numSamples, startGain, endGain);
+        }
+    }
+
     void copyWithGain(const juce::AudioBuffer<float>& source,
                      juce::AudioBuffer<float>& destination,
                      float gain) {
@@ -748,4 +2184,34 @@ namespace MixerUtils {
             destination.applyGain(gain);
         }
     }
-}
\ No newline at end of file
+
+    juce::String nodeTypeToString(RenderModel::Node::Type type) {
+        switch (type) {
+            case RenderModel::Node::Type::Channel: return "channel";
+            case RenderModel::Node::Type::Bus: return "bus";
+            case RenderModel::Node::Type::Master: return "master";
+        }
+        return "master";
+    }
+
+    RenderModel::Node::Type stringToNodeType(const juce::String& str) {
+        if (str == "channel") return RenderModel::Node::Type::Channel;
+        if (str == "bus") return RenderModel::Node::Type::Bus;
+        return RenderModel::Node::Type::Master;
+    }
+
+    juce::String tapToString(RenderModel::Tap tap) {
+        switch (tap) {
+            case RenderModel::Tap::PreFader: return "preFader";
+            case RenderModel::Tap::PostFader: return "postFader";
+            case RenderModel::Tap::PostPan: return "postPan";
+        }
+        return "postFader";
+    }
+
+    RenderModel::Tap stringToTap(const juce::String& str) {
+        if (str == "preFader") return RenderModel::Tap::PreFader;
+        if (str == "postPan") return RenderModel::Tap::PostPan;
+        return RenderModel::Tap::PostFader;
+    }
+}
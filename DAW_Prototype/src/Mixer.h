@@ -1,14 +1,45 @@
 #pragma once
 #include <JuceHeader.h>
+#include <array>
+#include <map>
 #include <vector>
 #include <memory>
+#include <functional>
+#include "MeterBus.h"
+#include "LoudnessMeter.h"
+#include "RenderModel.h"
 
 class Track;
 class Project;
 class Plugin;
 
+// Channel strips, buses and master section.
+//
+// All state is owned and edited on the message thread. Every edit publishes
+// a new immutable RenderModel, which is all the audio thread ever reads, so
+// adding or removing buses and plugins during playback cannot race with
+// processBlock(). Anything a published model points at (plugins, tracks) is
+// handed to the RenderModelExchange instead of being deleted directly.
+//
+// Channels, buses and sidechains form a routing graph. The model renders it
+// in dependency order and delays every edge so all inputs of a bus, the
+// master or a sidechained plugin line up despite plugin latency.
 class Mixer : public juce::ChangeBroadcaster {
 public:
+    // Send tap points
+    using SendTap = RenderModel::Tap;
+
+    // Send to a bus. Level changes and mutes ramp over one block.
+    struct Send {
+        int bus{-1};
+        float level{1.0f};
+        SendTap tap{SendTap::PostFader};
+        bool mute{false};
+        std::shared_ptr<RenderModel::GainRamp> ramp;
+    };
+
+    static constexpr int maxSends = 8;
+
     // Mixer channel strip
     struct Channel {
         float volume{1.0f};
@@ -16,10 +47,23 @@ public:
         bool mute{false};
         bool solo{false};
         bool bypass{false};
-        float peakLevel{0.0f};
-        float rmsLevel{0.0f};
-        std::vector<std::pair<int, float>> sends;  // bus index, level
+        std::shared_ptr<MeterBus::Slot> meter{std::make_shared<MeterBus::Slot>()};
+        std::shared_ptr<LoudnessAnalyser::Source> loudness;  // Buses and master only
+        std::array<Send, maxSends> sends;  // The first numSends are in use
+        int numSends{0};
         std::vector<std::unique_ptr<Plugin>> plugins;
+        
+        // Ramps of the direct outputs by destination bus, -1 for the master.
+        // Kept across models like a send's, so only a new edge ramps in.
+        std::map<int, std::shared_ptr<RenderModel::GainRamp>> directRamps;
+    };
+
+    // Device input for the block being rendered, for input monitoring
+    struct Input {
+        const float* const* channels{nullptr};
+        int numChannels{0};
+        int startSample{0};
+        int numSamples{0};
     };
 
     // Bus types
@@ -36,6 +80,17 @@ public:
         Channel channel;
         std::vector<int> sources;  // Track/bus indices
         int outputBus{-1};  // -1 = master
+        bool soloSafe{false};  // Keeps playing while something else is soloed
+    };
+
+    // Routing graph node: a channel strip, a bus or the master
+    using Node = RenderModel::Node;
+
+    // A node's output feeding a plugin's sidechain input. The plugin may be
+    // on a track or on any mixer strip.
+    struct Sidechain {
+        Node source;
+        Plugin* plugin{nullptr};
     };
 
     // Constructor/Destructor
@@ -46,7 +101,12 @@ public:
     void setProject(Project* project);
     Project* getProject() const { return currentProject; }
 
-    // Channel management
+    // Channel management (one channel per project track)
+    void addChannel();
+    void removeChannel(int index);
+    void moveChannel(int fromIndex, int toIndex);
+    int getNumChannels() const { return static_cast<int>(channels.size()); }
+    
     Channel& getChannel(int index);
     const Channel& getChannel(int index) const;
     Channel& getMasterChannel() { return masterChannel; }
@@ -58,12 +118,36 @@ public:
     void setChannelSolo(int index, bool solo);
     void setChannelBypass(int index, bool bypass);
     
+    // Solo in place. A soloed channel or bus keeps everything feeding it
+    // and everything it feeds playing, sends included; solo-safe buses are
+    // never silenced by a solo. Resolved when the render model is built.
+    bool isChannelActive(int index) const;
+    
+    void setMasterVolume(float volume);
+    void setMasterPan(float pan);
+    void setMasterMute(bool mute);
+    
     float getChannelPeakLevel(int index) const;
     float getChannelRMSLevel(int index) const;
     
-    void addSend(int channelIndex, int busIndex, float level);
+    // Metering (UI thread). Readings return the maximum since the last read.
+    MeterBus& getMeterBus() { return meterBus; }
+    MeterBus::Reading readChannelMeter(int index);
+    MeterBus::Reading readBusMeter(int index);
+    MeterBus::Reading readMasterMeter();
+    
+    // Loudness (any thread)
+    LoudnessAnalyser::Values getBusLoudness(int index) const;
+    LoudnessAnalyser::Values getMasterLoudness() const;
+    void resetLoudness();
+    
+    // Sends, one per bus and at most maxSends per channel. addSend()
+    // updates an existing send to the same bus.
+    bool addSend(int channelIndex, int busIndex, float level, SendTap tap = SendTap::PostFader);
     void removeSend(int channelIndex, int busIndex);
     void setSendLevel(int channelIndex, int busIndex, float level);
+    void setSendTap(int channelIndex, int busIndex, SendTap tap);
+    void setSendMute(int channelIndex, int busIndex, bool mute);
 
     // Bus management
     int addBus(BusType type, const juce::String& name);
@@ -73,7 +157,12 @@ public:
     int getNumBuses() const { return static_cast<int>(buses.size()); }
     
     void setBusName(int index, const juce::String& name);
-    void setBusOutput(int index, int outputBus);
+    void setBusVolume(int index, float volume);
+    void setBusPan(int index, float pan);
+    void setBusMute(int index, bool mute);
+    void setBusSolo(int index, bool solo);
+    void setBusSoloSafe(int index, bool soloSafe);
+    bool setBusOutput(int index, int outputBus);  // False if it would close a loop
     void addBusSource(int busIndex, int sourceIndex);
     void removeBusSource(int busIndex, int sourceIndex);
     
@@ -88,9 +177,58 @@ public:
     Plugin* getPlugin(int channelIndex, int pluginIndex);
     int getNumPlugins(int channelIndex) const;
 
-    // Processing
+    // Sidechain routing. The source renders first and is delayed to line up
+    // with the audio reaching the plugin. Fails if the plugin has no
+    // sidechain input or the edge would close a loop. One per plugin.
+    bool addSidechain(const Node& source, Plugin* plugin);
+    void removeSidechain(Plugin* plugin);
+    const std::vector<Sidechain>& getSidechains() const { return sidechains; }
+
+    // Delay compensation. Every path to the master is delayed to match the
+    // slowest, so the output lags the timeline by this many samples.
+    int getOutputLatencySamples() const;
+
+    // Silence detection. A node whose input has been silent for longer than
+    // its plugins' latency and tail sleeps: its chain, metering and summing
+    // are skipped until signal returns. Counted over the last block.
+    int getNumSleepingNodes() const { return numSleepingNodes.load(std::memory_order_relaxed); }
+
+    // Defers deletion of a track removed from the project until the audio
+    // thread can no longer be rendering it
+    void retireTrack(std::unique_ptr<Track> track);
+    
+    // Same for plugins removed from a track's chain. Publishes a render
+    // model first, so no sidechain edge still points at them.
+    void retireTrackPlugins(std::vector<std::unique_ptr<Plugin>> plugins);
+    
+    // Hands the armed inputs of a record pass to the audio thread; nullptr
+    // stops feeding them
+    void setRecordingSession(std::shared_ptr<DiskRecorder::Session> session);
+    
+    // Re-publishes the render model after a change the mixer cannot see,
+    // e.g. tracks being replaced wholesale by the project
+    void publishRenderModel();
+    
+    // Lets other audio-thread consumers share the snapshot processBlock() renders
+    RenderModelExchange& getRenderModels() { return renderModels; }
+    
+    // Input monitoring. In low-latency mode, monitored channels skip plugins
+    // reporting more than thresholdSamples of latency.
+    void setLowLatencyMonitoring(bool enabled, int thresholdSamples);
+    bool isLowLatencyMonitoring() const { return monitoringLatencyLimit >= 0; }
+    int getMonitoringLatencySamples() const;  // Slowest monitored plugin chain
+
+    // Offline render: every plugin switches to its offline quality, e.g.
+    // higher oversampling. Call with processing stopped.
+    void setNonRealtime(bool isNonRealtime);
+    bool isNonRealtime() const { return nonRealtime; }
+    
+    // Processing (audio thread). Tracks only render while playing; channels
+    // monitoring their input render either way.
     void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock);
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages,
+                      const Input& input, bool playing);
     void releaseResources();
 
     // State management
@@ -106,37 +244,113 @@ private:
     std::vector<Bus> buses;
     Channel masterChannel;
     
-    // Processing buffers
-    std::vector<juce::AudioBuffer<float>> channelBuffers;
-    std::vector<juce::AudioBuffer<float>> busBuffers;
-    juce::AudioBuffer<float> masterBuffer;
-    
     // Processing state
     double currentSampleRate{44100.0};
     int currentBlockSize{512};
-    bool processingPrepared{false};
+    std::atomic<bool> processingPrepared{false};
+    
+    // Metering
+    MeterBus meterBus;
+    LoudnessAnalyser loudnessAnalyser;
     
     // Solo state
     bool soloActive{false};
-    std::vector<bool> channelSoloBuffer;
+
+    // Sidechains by node and chain position, for saving and for edges
+    // loaded before their plugins exist
+    struct SidechainState {
+        Node source;
+        Node target;
+        bool onTrack{false};  // In the track's chain rather than the strip's
+        int position{0};
+    };
+
+    std::vector<Sidechain> sidechains;
+    std::vector<SidechainState> pendingSidechains;
+    
+    // Disk recording, referenced by published models while active
+    std::shared_ptr<DiskRecorder::Session> recordingSession;
+    
+    // Low-latency monitoring threshold in samples, -1 = off
+    int monitoringLatencyLimit{-1};
+
+    // Rendering offline
+    bool nonRealtime{false};
+    
+    // Audio thread view. Declared last so retired models and plugins are
+    // reclaimed before the rest of the mixer is torn down.
+    RenderModelExchange renderModels;
+    
+    // Scratch MIDI for bus and master plugins (audio thread)
+    juce::MidiBuffer emptyMidi;
+    
+    // Sleeping nodes, counted by the audio thread during a block
+    int sleepingNodes{0};
+    std::atomic<int> numSleepingNodes{0};
+    
+    // Model building (message thread)
+    // track is the one feeding the strip, whose chain runs first
+    RenderModel::Channel makeChannelSnapshot(const Channel& channel, const Track* track = nullptr) const;
+    void retirePlugins(std::vector<std::unique_ptr<Plugin>>& plugins);
+    void buildRoutingPlan(RenderModel& model, int& numDelayLines, int& maxDelay);
+    
+    // Routing graph: channels first, then buses; the master is implicit
+    int getNodeIndex(const Node& node) const;
+    Node getNode(int nodeIndex) const;
+    std::vector<std::vector<int>> buildRoutingGraph() const;
+    static bool sortRoutingGraph(const std::vector<std::vector<int>>& graph, std::vector<int>& order);
+    
+    // Sidechain bookkeeping
+    SidechainState findPlugin(const Plugin* plugin) const;  // position -1 if not found
+    Plugin* resolvePlugin(const SidechainState& state) const;
+    void updateSidechains();
+    void remapSidechains(Node::Type type, const std::function<int(int)>& remap);
     
     // Internal helpers
+    Send* findSend(int channelIndex, int busIndex);
     void updateProcessingBuffers();
-    void clearAllBuffers();
-    void processChannels(juce::AudioBuffer<float>& buffer,
-                        juce::MidiBuffer& midiMessages);
-    void processBuses();
-    void processMaster(juce::AudioBuffer<float>& buffer);
+    static void clearAllBuffers(RenderModel::Buffers& buffers);
+    static juce::AudioBuffer<float>& getNodeBuffer(RenderModel::Buffers& buffers, const Node& node);
+    void processChannel(const RenderModel& model,
+                       int index,
+                       juce::MidiBuffer& midiMessages,
+                       const Input& input,
+                       bool playing,
+                       int numSamples);
+    void processBus(const RenderModel& model, int index, int numSamples);
+    void processMaster(const RenderModel& model, juce::AudioBuffer<float>& buffer, int numSamples);
+    bool updateSleepState(RenderModel::Buffers& buffers,
+                          size_t node,
+                          const RenderModel::Channel& channel,
+                          bool inputSilent,
+                          int numSamples);
+    static bool connectSidechains(const RenderModel::Channel& channel,
+                                  RenderModel::Buffers& buffers,
+                                  int numSamples);
+    static void disconnectSidechains(const RenderModel::Channel& channel);
+    static void processOutputs(const juce::AudioBuffer<float>& source,
+                               const RenderModel::Channel& channel,
+                               RenderModel::Buffers& buffers,
+                               RenderModel::Tap tap,
+                               int numSamples);
+    static void skipOutputs(const juce::AudioBuffer<float>& silence,
+                            const RenderModel::Channel& channel,
+                            RenderModel::Buffers& buffers,
+                            int numSamples);
     
     void updatePeakAndRMSLevels(const juce::AudioBuffer<float>& buffer,
-                               float& peak, float& rms);
+                               const RenderModel::Channel& channel);
+    void updateLoudnessSources(bool recreate);
+    static void pushLoudness(const juce::AudioBuffer<float>& buffer,
+                            const RenderModel::Channel& channel);
     void applyChannelSettings(juce::AudioBuffer<float>& buffer,
-                            const Channel& channel);
-    void processSends(const juce::AudioBuffer<float>& source,
-                     const Channel& channel);
+                            const RenderModel::Channel& channel);
+    void applyVolume(juce::AudioBuffer<float>& buffer,
+                     const RenderModel::Channel& channel);
+    void applyPan(juce::AudioBuffer<float>& buffer,
+                  const RenderModel::Channel& channel);
     
     void updateSoloStates();
-    bool isChannelActive(int index) const;
     
     static float calculatePanGain(float pan, bool leftChannel);
 
@@ -158,7 +372,13 @@ namespace MixerUtils {
     float calculateRMSLevel(const float* data, int numSamples);
     float calculatePeakLevel(const float* data, int numSamples);
     
-    // Buffer operations
+    // Below -120 dBFS a buffer counts as silent
+    constexpr float silenceThreshold{1.0e-6f};
+    
+    // Buffer operations. Silent buffers are flagged cleared, and mixing
+    // skips them.
+    bool clearIfSilent(juce::AudioBuffer<float>& buffer, int numSamples);
+    
     void applyGainRamp(juce::AudioBuffer<float>& buffer,
                       int startSample,
                       int numSamples,
@@ -168,8 +388,20 @@ namespace MixerUtils {
     void mixBuffers(const juce::AudioBuffer<float>& source,
                    juce::AudioBuffer<float>& destination,
                    float gain = 1.0f);
+    
+    void mixBuffersWithRamp(const juce::AudioBuffer<float>& source,
+                           juce::AudioBuffer<float>& destination,
+                           int numSamples,
+                           float startGain,
+                           float endGain);
                    
     void copyWithGain(const juce::AudioBuffer<float>& source,
                      juce::AudioBuffer<float>& destination,
                      float gain);
+    
+    // Routing graph conversion
+    juce::String nodeTypeToString(RenderModel::Node::Type type);
+    RenderModel::Node::Type stringToNodeType(const juce::String& str);
+    juce::String tapToString(RenderModel::Tap tap);
+    RenderModel::Tap stringToTap(const juce::String& str);
 }
\ No newline at end of file
@@ -4,6 +4,52 @@
 #include "Plugin.h"
 #include "Logger.h"
 #include "CustomLookAndFeel.h"
+#include "Configuration.h"
+
+//==============================================================================
+// MeterBar Implementation
+//==============================================================================
+
+void MixerComponent::MeterBar::update(const MeterBus::Reading& reading) {
+    const auto& settings = Configuration::getInstance().getUISettings().meters;
+    
+    ballistics.update(reading, juce::Time::getMillisecondCounterHiRes(),
+                      settings.peakHoldTime, settings.rmsWindowSize, settings.meterFallback);
+    clipped = clipped || (settings.showClipIndicators && reading.clipCount > 0);
+    repaint();
+}
+
+void MixerComponent::MeterBar::paint(juce::Graphics& g) {
+    auto& lf = dynamic_cast<CustomLookAndFeel&>(getLookAndFeel());
+    const auto bounds = getLocalBounds().toFloat();
+    
+    // Draw background
+    g.setColour(lf.getMeterBackground());
+    g.fillRect(bounds);
+    
+    // Draw RMS level
+    const float rmsHeight = bounds.getHeight() * juce::jmin(ballistics.getRMS(), 1.0f);
+    g.setColour(lf.getMeterRMSColour());
+    g.fillRect(bounds.withHeight(rmsHeight).withY(bounds.getBottom() - rmsHeight));
+    
+    // Draw peak level
+    const float peakHeight = bounds.getHeight() * juce::jmin(ballistics.getPeak(), 1.0f);
+    g.setColour(lf.getMeterPeakColour());
+    g.fillRect(bounds.withHeight(2.0f).withY(bounds.getBottom() - peakHeight));
+    
+    // Draw peak hold marker
+    if (Configuration::getInstance().getUISettings().meters.showPeakMarkers) {
+        const float holdHeight = bounds.getHeight() * juce::jmin(ballistics.getHeldPeak(), 1.0f);
+        g.setColour(lf.getMeterPeakColour().brighter());
+        g.fillRect(bounds.withHeight(1.0f).withY(bounds.getBottom() - holdHeight));
+    }
+    
+    // Draw clip indicator
+    if (clipped) {
+        g.setColour(juce::Colours::red);
+        g.fillRect(bounds.withHeight(4.0f));
+    }
+}
 
 //==============================================================================
 // ChannelStrip Implementation
@@ -104,10 +150,8 @@ void MixerComponent::ChannelStrip::updateFromTrack() {
     }
 }
 
-void MixerComponent::ChannelStrip::updateMeters(float peak, float rms) {
-    meter.peak = peak;
-    meter.rms = rms;
-    meter.repaint();
+void MixerComponent::ChannelStrip::updateMeters(const MeterBus::Reading& reading) {
+    meter.update(reading);
 }
 
 void MixerComponent::ChannelStrip::setupControls() {
@@ -199,25 +243,6 @@ void MixerComponent::ChannelStrip::handleEditClick() {
     // TODO: Show channel edit dialog
 }
 
-void MixerComponent::ChannelStrip::MeterBar::paint(juce::Graphics& g) {
-    auto& lf = dynamic_cast<CustomLookAndFeel&>(getLookAndFeel());
-    const auto bounds = getLocalBounds().toFloat();
-    
-    // Draw background
-    g.setColour(lf.getMeterBackground());
-    g.fillRect(bounds);
-    
-    // Draw RMS level
-    const float rmsHeight = bounds.getHeight() * rms;
-    g.setColour(lf.getMeterRMSColour());
-    g.fillRect(bounds.withHeight(rmsHeight).withY(bounds.getBottom() - rmsHeight));
-    
-    // Draw peak level
-    const float peakHeight = bounds.getHeight() * peak;
-    g.setColour(lf.getMeterPeakColour());
-    g.fillRect(bounds.withHeight(2.0f).withY(bounds.getBottom() - peakHeight));
-}
-
 //==============================================================================
 // BusStrip Implementation
 //==============================================================================
@@ -306,10 +331,8 @@ void MixerComponent::BusStrip::updateFromBus() {
     }
 }
 
-void MixerComponent::BusStrip::updateMeters(float peak, float rms) {
-    meter.peak = peak;
-    meter.rms = rms;
-    meter.repaint();
+void MixerComponent::BusStrip::updateMeters(const MeterBus::Reading& reading) {
+    meter.update(reading);
 }
 
 void MixerComponent::BusStrip::setupControls() {
@@ -367,22 +390,19 @@ void MixerComponent::BusStrip::setupControls() {
 
 void MixerComponent::BusStrip::handleFaderChange() {
     if (auto* mixer = owner.getMixer()) {
-        auto& bus = mixer->getBus(busIndex);
-        bus.channel.volume = static_cast<float>(fader.getValue());
+        mixer->setBusVolume(busIndex, static_cast<float>(fader.getValue()));
     }
 }
 
 void MixerComponent::BusStrip::handlePanChange() {
     if (auto* mixer = owner.getMixer()) {
-        auto& bus = mixer->getBus(busIndex);
-        bus.channel.pan = static_cast<float>(pan.getValue());
+        mixer->setBusPan(busIndex, static_cast<float>(pan.getValue()));
     }
 }
 
 void MixerComponent::BusStrip::handleMuteClick() {
     if (auto* mixer = owner.getMixer()) {
-        auto& bus = mixer->getBus(busIndex);
-        bus.channel.mute = muteButton.getToggleState();
+        mixer->setBusMute(busIndex, muteButton.getToggleState());
     }
 }
 
@@ -397,25 +417,6 @@ void MixerComponent::BusStrip::handleOutputChange() {
     }
 }
 
-void MixerComponent::BusStrip::MeterBar::paint(juce::Graphics& g) {
-    auto& lf = dynamic_cast<CustomLookAndFeel&>(getLookAndFeel());
-    const auto bounds = getLocalBounds().toFloat();
-    
-    // Draw background
-    g.setColour(lf.getMeterBackground());
-    g.fillRect(bounds);
-    
-    // Draw RMS level
-    const float rmsHeight = bounds.getHeight() * rms;
-    g.setColour(lf.getMeterRMSColour());
-    g.fillRect(bounds.withHeight(rmsHeight).withY(bounds.getBottom() - rmsHeight));
-    
-    // Draw peak level
-    const float peakHeight = bounds.getHeight() * peak;
-    g.setColour(lf.getMeterPeakColour());
-    g.fillRect(bounds.withHeight(2.0f).withY(bounds.getBottom() - peakHeight));
-}
-
 //==============================================================================
 // MasterStrip Implementation
 //==============================================================================
@@ -453,6 +454,7 @@ void MixerComponent::MasterStrip::resized() {
     grid.templateRows = {
         Track(Fr(1)),    // Name
         Track(Fr(8)),    // Meter
+        Track(Fr(1)),    // Loudness
         Track(Fr(1)),    // Pan
         Track(Fr(1)),    // Buttons
         Track(Fr(12))    // Fader
@@ -463,6 +465,7 @@ void MixerComponent::MasterStrip::resized() {
     juce::Array<juce::GridItem> items;
     items.add(juce::GridItem(nameLabel));
     items.add(juce::GridItem(meter));
+    items.add(juce::GridItem(loudnessLabel));
     items.add(juce::GridItem(pan));
     
     // Buttons panel
@@ -499,10 +502,15 @@ void MixerComponent::MasterStrip::updateFromMaster() {
     }
 }
 
-void MixerComponent::MasterStrip::updateMeters(float peak, float rms) {
-    meter.peak = peak;
-    meter.rms = rms;
-    meter.repaint();
+void MixerComponent::MasterStrip::updateMeters(const MeterBus::Reading& reading) {
+    meter.update(reading);
+    
+    if (auto* mixer = owner.getMixer()) {
+        const auto loudness = mixer->getMasterLoudness();
+        loudnessLabel.setText("M " + LoudnessMeterUtils::formatLoudness(loudness.momentary) +
+                              "\nI " + LoudnessMeterUtils::formatLoudness(loudness.integrated),
+                              juce::dontSendNotification);
+    }
 }
 
 void MixerComponent::MasterStrip::setupControls() {
@@ -541,6 +549,12 @@ void MixerComponent::MasterStrip::setupControls() {
     // Meter
     addAndMakeVisible(meter);
     
+    // Loudness readout (click to reset the integrated measurement)
+    addAndMakeVisible(loudnessLabel);
+    loudnessLabel.setJustificationType(juce::Justification::centred);
+    loudnessLabel.setFont(juce::Font(10.0f));
+    loudnessLabel.addMouseListener(this, false);
+    
     if (auto* mixer = owner.getMixer()) {
         mixer->addChangeListener(this);
     }
@@ -548,22 +562,19 @@ void MixerComponent::MasterStrip::setupControls() {
 
 void MixerComponent::MasterStrip::handleFaderChange() {
     if (auto* mixer = owner.getMixer()) {
-        auto& master = mixer->getMasterChannel();
-        master.volume = static_cast<float>(fader.getValue());
+        mixer->setMasterVolume(static_cast<float>(fader.getValue()));
     }
 }
 
 void MixerComponent::MasterStrip::handlePanChange() {
     if (auto* mixer = owner.getMixer()) {
-        auto& master = mixer->getMasterChannel();
-        master.pan = static_cast<float>(pan.getValue());
+        mixer->setMasterPan(static_cast<float>(pan.getValue()));
     }
 }
 
 void MixerComponent::MasterStrip::handleMuteClick() {
     if (auto* mixer = owner.getMixer()) {
-        auto& master = mixer->getMasterChannel();
-        master.mute = muteButton.getToggleState();
+        mixer->setMasterMute(muteButton.getToggleState());
     }
 }
 
@@ -571,23 +582,16 @@ void MixerComponent::MasterStrip::handleEditClick() {
     // TODO: Show master edit dialog
 }
 
-void MixerComponent::MasterStrip::MeterBar::paint(juce::Graphics& g) {
-    auto& lf = dynamic_cast<CustomLookAndFeel&>(getLookAndFeel());
-    const auto bounds = getLocalBounds().toFloat();
-    
-    // Draw background
-    g.setColour(lf.getMeterBackground());
-    g.fillRect(bounds);
-    
-    // Draw RMS level
-    const float rmsHeight = bounds.getHeight() * rms;
-    g.setColour(lf.getMeterRMSColour());
-    g.fillRect(bounds.withHeight(rmsHeight).withY(bounds.getBottom() - rmsHeight));
-    
-    // Draw peak level
-    const float peakHeight = bounds.getHeight() * peak;
-    g.setColour(lf.getMeterPeakColour());
-    g.fillRect(bounds.withHeight(2.0f).withY(bounds.getBottom() - peakHeight));
+void MixerComponent::MasterStrip::mouseDown(const juce::MouseEvent& e) {
+    if (e.eventComponent == &loudnessLabel) {
+        handleLoudnessClick();
+    }
+}
+
+void MixerComponent::MasterStrip::handleLoudnessClick() {
+    if (auto* mixer = owner.getMixer()) {
+        mixer->resetLoudness();
+    }
 }
 
 //==============================================================================
@@ -596,10 +600,16 @@ void MixerComponent::MasterStrip::MeterBar::paint(juce::Graphics& g) {
 
 MixerComponent::MixerComponent() {
     setupLayout();
-    startTimerHz(30);  // Update meters at 30Hz
 }
 
 MixerComponent::~MixerComponent() {
+    stopTimer();
+    
+    if (meteredMixer != nullptr) {
+        meteredMixer->getMeterBus().removeConsumer();
+        meteredMixer = nullptr;
+    }
+    
     if (auto* mixer = getMixer()) {
         mixer->removeChangeListener(this);
     }
@@ -643,6 +653,10 @@ void MixerComponent::resized() {
     }
 }
 
+void MixerComponent::visibilityChanged() {
+    updateMeterSubscription();
+}
+
 void MixerComponent::changeListenerCallback(juce::ChangeBroadcaster* source) {
     if (source == getMixer()) {
         updateChannelStrips();
@@ -666,6 +680,7 @@ void MixerComponent::setProject(Project* project) {
         newMixer->addChangeListener(this);
     }
     
+    updateMeterSubscription();
     updateChannelStrips();
     updateBusStrips();
     updateMasterStrip();
@@ -739,29 +754,46 @@ void MixerComponent::updateMeters() {
     if (auto* mixer = getMixer()) {
         // Update channel meters
         for (int i = 0; i < channelStrips.size(); ++i) {
-            channelStrips[i]->updateMeters(
-                mixer->getChannelPeakLevel(i),
-                mixer->getChannelRMSLevel(i));
+            channelStrips[i]->updateMeters(mixer->readChannelMeter(i));
         }
         
         // Update bus meters
         for (int i = 0; i < busStrips.size(); ++i) {
-            const auto& bus = mixer->getBus(i);
-            busStrips[i]->updateMeters(
-                bus.channel.peakLevel,
-                bus.channel.rmsLevel);
+            busStrips[i]->updateMeters(mixer->readBusMeter(i));
         }
         
         // Update master meters
         if (masterStrip != nullptr) {
-            const auto& master = mixer->getMasterChannel();
-            masterStrip->updateMeters(
-                master.peakLevel,
-                master.rmsLevel);
+            masterStrip->updateMeters(mixer->readMasterMeter());
         }
     }
 }
 
+void MixerComponent::timerCallback() {
+    updateMeters();
+}
+
+void MixerComponent::updateMeterSubscription() {
+    // Only consume meter data while the mixer is actually on screen
+    auto* wanted = isShowing() ? getMixer() : nullptr;
+    
+    if (wanted == meteredMixer) {
+        return;
+    }
+    
+    if (meteredMixer != nullptr) {
+        meteredMixer->getMeterBus().removeConsumer();
+        stopTimer();
+    }
+    
+    meteredMixer = wanted;
+    
+    if (meteredMixer != nullptr) {
+        meteredMixer->getMeterBus().addConsumer();
+        startTimerHz(30);  // Update meters at 30Hz
+    }
+}
+
 void MixerComponent::setupLayout() {
     // Add bus button
     addAndMakeVisible(addBusButton);
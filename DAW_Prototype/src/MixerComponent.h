@@ -6,8 +6,21 @@ class Project;
 class Track;
 
 class MixerComponent : public juce::Component,
-                      public juce::ChangeListener {
+                      public juce::ChangeListener,
+                      private juce::Timer {
 public:
+    // Level meter used by every strip type; a click clears the clip light
+    class MeterBar : public juce::Component {
+    public:
+        void paint(juce::Graphics& g) override;
+        void mouseDown(const juce::MouseEvent&) override { clipped = false; repaint(); }
+        void update(const MeterBus::Reading& reading);
+        
+    private:
+        MeterBallistics ballistics;
+        bool clipped{false};
+    };
+
     // Channel strip component
     class ChannelStrip : public juce::Component,
                         public juce::ChangeListener {
@@ -20,7 +33,7 @@ public:
         void changeListenerCallback(juce::ChangeBroadcaster* source) override;
         
         void updateFromTrack();
-        void updateMeters(float peak, float rms);
+        void updateMeters(const MeterBus::Reading& reading);
         
     private:
         MixerComponent& owner;
@@ -34,10 +47,7 @@ public:
         juce::TextButton recordButton;
         juce::TextButton editButton;
         
-        struct MeterBar : public juce::Component {
-            void paint(juce::Graphics& g) override;
-            float peak{0.0f}, rms{0.0f};
-        } meter;
+        MeterBar meter;
         
         juce::OwnedArray<juce::Component> plugins;
         juce::OwnedArray<juce::Component> sends;
@@ -65,7 +75,7 @@ public:
         void changeListenerCallback(juce::ChangeBroadcaster* source) override;
         
         void updateFromBus();
-        void updateMeters(float peak, float rms);
+        void updateMeters(const MeterBus::Reading& reading);
         
     private:
         MixerComponent& owner;
@@ -78,10 +88,7 @@ public:
         juce::TextButton editButton;
         juce::ComboBox outputSelector;
         
-        struct MeterBar : public juce::Component {
-            void paint(juce::Graphics& g) override;
-            float peak{0.0f}, rms{0.0f};
-        } meter;
+        MeterBar meter;
         
         juce::OwnedArray<juce::Component> plugins;
         
@@ -106,8 +113,10 @@ public:
         void resized() override;
         void changeListenerCallback(juce::ChangeBroadcaster* source) override;
         
+        void mouseDown(const juce::MouseEvent& e) override;
+        
         void updateFromMaster();
-        void updateMeters(float peak, float rms);
+        void updateMeters(const MeterBus::Reading& reading);
         
     private:
         MixerComponent& owner;
@@ -117,11 +126,9 @@ public:
         juce::Slider pan;
         juce::TextButton muteButton;
         juce::TextButton editButton;
+        juce::Label loudnessLabel;
         
-        struct MeterBar : public juce::Component {
-            void paint(juce::Graphics& g) override;
-            float peak{0.0f}, rms{0.0f};
-        } meter;
+        MeterBar meter;
         
         juce::OwnedArray<juce::Component> plugins;
         
@@ -130,6 +137,7 @@ public:
         void handlePanChange();
         void handleMuteClick();
         void handleEditClick();
+        void handleLoudnessClick();
         
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MasterStrip)
     };
@@ -141,6 +149,7 @@ public:
     // Component interface
     void paint(juce::Graphics& g) override;
     void resized() override;
+    void visibilityChanged() override;
     
     // ChangeListener interface
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
@@ -171,6 +180,21 @@ private:
     juce::TextButton addBusButton;
     juce::ComboBox busTypeSelector;
     
+    // Meter subscription
+    Mixer* meteredMixer{nullptr};
+    
+    // visibilityChanged() only hears about this component; hiding a parent
+    // window or tab must drop the subscription too
+    struct ShowingWatcher : public juce::ComponentMovementWatcher {
+        explicit ShowingWatcher(MixerComponent& o) : juce::ComponentMovementWatcher(&o), owner(o) {}
+        void componentMovedOrResized(bool, bool) override {}
+        void componentPeerChanged() override { owner.updateMeterSubscription(); }
+        void componentVisibilityChanged() override { owner.updateMeterSubscription(); }
+        MixerComponent& owner;
+    } showingWatcher{*this};
+    
+    void timerCallback() override;
+    void updateMeterSubscription();
     void setupLayout();
     void handleAddBusClick();
     void handleBusTypeChange();
@@ -0,0 +1,99 @@
+#include "Oversampler.h"
+#include "Configuration.h"
+
+//==============================================================================
+// Oversampler Implementation
+//==============================================================================
+
+Oversampler::Settings Oversampler::getRealtimeDefault() {
+    Settings defaults;
+    defaults.factor = validateFactor(Configuration::getInstance().getPerformanceSettings().realtimeOversampling);
+    defaults.filter = Filter::IIR;
+    defaults.steep = false;
+    return defaults;
+}
+
+Oversampler::Settings Oversampler::getOfflineDefault() {
+    Settings defaults;
+    defaults.factor = validateFactor(Configuration::getInstance().getPerformanceSettings().offlineOversampling);
+    defaults.filter = Filter::FIR;
+    defaults.steep = true;
+    return defaults;
+}
+
+void Oversampler::prepare(int numChannels, int maximumBlockSize, const Settings& newSettings) {
+    settings = newSettings;
+    settings.factor = validateFactor(settings.factor);
+    factor = settings.factor;
+    oversampling.reset();
+    latencySamples = 0;
+
+    if (factor == 1) {
+        return;
+    }
+
+    const auto type = settings.filter == Filter::FIR
+        ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+        : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+    // One half-band stage per doubling
+    oversampling = std::make_unique<juce::dsp::Oversampling<float>>(
+        static_cast<size_t>(juce::jmax(1, numChannels)),
+        static_cast<size_t>(juce::roundToInt(std::log2(factor))),
+        type, settings.steep, true);
+    oversampling->initProcessing(static_cast<size_t>(juce::jmax(1, maximumBlockSize)));
+
+    latencySamples = static_cast<int>(std::ceil(oversampling->getLatencyInSamples()));
+}
+
+void Oversampler::reset() {
+    if (oversampling != nullptr) {
+        oversampling->reset();
+    }
+}
+
+juce::dsp::AudioBlock<float> Oversampler::upsample(const juce::dsp::AudioBlock<float>& block) noexcept {
+    if (oversampling == nullptr) {
+        return block;
+    }
+    return oversampling->processSamplesUp(juce::dsp::AudioBlock<const float>(block));
+}
+
+juce::dsp::AudioBlock<const float> Oversampler::upsample(const juce::dsp::AudioBlock<const float>& block) noexcept {
+    if (oversampling == nullptr) {
+        return block;
+    }
+    return oversampling->processSamplesUp(block);
+}
+
+void Oversampler::downsample(juce::dsp::AudioBlock<float>& block) noexcept {
+    if (oversampling != nullptr) {
+        oversampling->processSamplesDown(block);
+    }
+}
+
+juce::ValueTree Oversampler::toValueTree(const Settings& settings, const juce::Identifier& type) {
+    juce::ValueTree state(type);
+    state.setProperty("factor", settings.factor, nullptr);
+    state.setProperty("filter", settings.filter == Filter::FIR ? "FIR" : "IIR", nullptr);
+    state.setProperty("steep", settings.steep, nullptr);
+    return state;
+}
+
+Oversampler::Settings Oversampler::fromValueTree(const juce::ValueTree& state, const Settings& fallback) {
+    if (!state.isValid()) {
+        return fallback;
+    }
+
+    Settings settings;
+    settings.factor = validateFactor(state.getProperty("factor", fallback.factor));
+    const juce::String filter = state.getProperty("filter", fallback.filter == Filter::FIR ? "FIR" : "IIR");
+    settings.filter = filter == "FIR" ? Filter::FIR : Filter::IIR;
+    settings.steep = state.getProperty("steep", fallback.steep);
+    return settings;
+}
+
+int Oversampler::validateFactor(int factor) {
+    // Powers of two from 1 to 16
+    return juce::jlimit(1, 16, juce::nextPowerOfTwo(juce::jmax(1, factor)));
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <memory>
+
+// Runs nonlinear processing at a multiple of the host rate, so harmonics
+// above the host Nyquist are filtered out instead of folding back.
+//
+// A cascade of polyphase half-band stages (juce::dsp::Oversampling) from 2x
+// to 16x. IIR stages are cheap and add little latency but bend the phase;
+// FIR stages are linear-phase and cost more. Latency is rounded up to whole
+// host-rate samples, so it can be reported and compensated exactly.
+class Oversampler {
+public:
+    enum class Filter {
+        IIR,
+        FIR
+    };
+
+    struct Settings {
+        int factor{1};                // 1 = off, otherwise 2, 4, 8 or 16
+        Filter filter{Filter::IIR};
+        bool steep{false};            // Narrower transition band, more taps
+
+        bool operator==(const Settings& other) const {
+            return factor == other.factor && filter == other.filter && steep == other.steep;
+        }
+        bool operator!=(const Settings& other) const { return !(*this == other); }
+    };
+
+    // Defaults for new plugins, from the performance settings: a cheap IIR
+    // cascade while playing, steep FIR stages for offline render
+    static Settings getRealtimeDefault();
+    static Settings getOfflineDefault();
+
+    // Constructor/Destructor
+    Oversampler() = default;
+    ~Oversampler() = default;
+
+    // Allocates. maximumBlockSize is at the host rate.
+    void prepare(int numChannels, int maximumBlockSize, const Settings& settings);
+    void reset();
+
+    const Settings& getSettings() const { return settings; }
+    int getFactor() const { return factor; }
+    int getLatencySamples() const { return latencySamples; }  // Host-rate samples
+
+    // Audio thread. upsample() returns the oversampled block, or the block
+    // itself when off; process that in place, then downsample() writes the
+    // result back into block.
+    juce::dsp::AudioBlock<float> upsample(const juce::dsp::AudioBlock<float>& block) noexcept;
+    void downsample(juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // Upsampling only, for side inputs such as a sidechain: the result is
+    // read but never downsampled
+    juce::dsp::AudioBlock<const float> upsample(const juce::dsp::AudioBlock<const float>& block) noexcept;
+
+    // State
+    static juce::ValueTree toValueTree(const Settings& settings, const juce::Identifier& type);
+    static Settings fromValueTree(const juce::ValueTree& state, const Settings& fallback);
+
+private:
+    Settings settings;
+    std::unique_ptr<juce::dsp::Oversampling<float>> oversampling;
+    int factor{1};
+    int latencySamples{0};
+
+    static int validateFactor(int factor);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Oversampler)
+};
@@ -0,0 +1,409 @@
+#include "PartitionedConvolver.h"
+#include <algorithm>
+#include <cstring>
+
+//==============================================================================
+// PartitionedConvolver::Workers Implementation
+//==============================================================================
+
+// Background stages of every live convolver, run by a few shared threads.
+// Created with the first convolver that needs it and stopped with the last.
+class PartitionedConvolver::Workers {
+public:
+    static std::shared_ptr<Workers> acquire() {
+        static juce::CriticalSection instanceLock;
+        static std::weak_ptr<Workers> instance;
+
+        const juce::ScopedLock sl(instanceLock);
+        auto shared = instance.lock();
+        if (shared == nullptr) {
+            shared = std::make_shared<Workers>();
+            instance = shared;
+        }
+        return shared;
+    }
+
+    Workers() {
+        const int numThreads = juce::jlimit(1, 4, juce::SystemStats::getNumCpus() / 2);
+        for (int i = 0; i < numThreads; ++i) {
+            threads.add(new Worker(*this))->startThread(8);
+        }
+    }
+
+    ~Workers() {
+        for (auto* thread : threads) {
+            thread->signalThreadShouldExit();
+        }
+        for (auto* thread : threads) {
+            wakeEvent.signal();
+            thread->stopThread(2000);
+        }
+    }
+
+    void add(PartitionedConvolver& convolver) {
+        const juce::ScopedWriteLock sl(convolverLock);
+        convolvers.push_back(&convolver);
+    }
+
+    // Returns once no worker is running a job of the convolver
+    void remove(PartitionedConvolver& convolver) {
+        const juce::ScopedWriteLock sl(convolverLock);
+        convolvers.erase(std::remove(convolvers.begin(), convolvers.end(), &convolver), convolvers.end());
+    }
+
+    // Audio thread
+    void wake() noexcept { wakeEvent.signal(); }
+
+private:
+    class Worker : public juce::Thread {
+    public:
+        explicit Worker(Workers& owner) : juce::Thread("Convolution"), owner(owner) {}
+
+        void run() override {
+            while (!threadShouldExit()) {
+                if (!owner.runNextJob()) {
+                    owner.wakeEvent.wait(50);
+                }
+            }
+        }
+
+    private:
+        Workers& owner;
+    };
+
+    juce::ReadWriteLock convolverLock;
+    std::vector<PartitionedConvolver*> convolvers;
+    juce::WaitableEvent wakeEvent;
+    juce::OwnedArray<Worker> threads;
+
+    bool runNextJob() {
+        const juce::ScopedReadLock sl(convolverLock);
+
+        // Smaller stages have the nearest deadlines, so every convolver's
+        // second stage goes before any third one, and so on. Stage 0 runs on
+        // the audio thread.
+        bool pending = true;
+        for (size_t level = 1; pending; ++level) {
+            pending = false;
+            for (auto* convolver : convolvers) {
+                if (level < convolver->stages.size()) {
+                    pending = true;
+                    if (convolver->runNextJob(*convolver->stages[level])) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+};
+
+//==============================================================================
+// PartitionedConvolver Implementation
+//==============================================================================
+
+// Constructor/Destructor
+PartitionedConvolver::PartitionedConvolver() {
+}
+
+PartitionedConvolver::~PartitionedConvolver() {
+    releaseWorkers();
+}
+
+void PartitionedConvolver::releaseWorkers() {
+    if (workers != nullptr) {
+        workers->remove(*this);
+        workers.reset();
+    }
+}
+
+void PartitionedConvolver::loadImpulseResponse(const juce::AudioBuffer<float>& impulse,
+                                               int numChannelsToUse,
+                                               int headSizeToUse,
+                                               int maxPartitionSize) {
+    releaseWorkers();
+    stages.clear();
+
+    numChannels = juce::jmax(1, numChannelsToUse);
+    headSize = juce::nextPowerOfTwo(juce::jmax(16, headSizeToUse));
+    maxPartitionSize = juce::jmax(headSize, juce::nextPowerOfTwo(maxPartitionSize));
+    impulseLength = impulse.getNumSamples();
+
+    const auto impulseChannel = [&impulse](int channel) {
+        return impulse.getReadPointer(juce::jmin(channel, impulse.getNumChannels() - 1));
+    };
+
+    // Head: the first headSize taps, stored for direct convolution
+    headTaps.assign(static_cast<size_t>(numChannels), {});
+    headHistory.assign(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(2 * headSize - 1), 0.0f));
+    for (int ch = 0; ch < numChannels && impulse.getNumChannels() > 0; ++ch) {
+        const int numTaps = juce::jmin(headSize, impulseLength);
+        headTaps[static_cast<size_t>(ch)].assign(impulseChannel(ch), impulseChannel(ch) + numTaps);
+    }
+
+    // Stages: block size grows by four until the cap, and each stage covers
+    // the response up to twice the next stage's block size, where that
+    // stage can start without latency
+    int offset = headSize;
+    int blockSize = headSize;
+
+    while (offset < impulseLength && impulse.getNumChannels() > 0) {
+        const int nextBlockSize = juce::jmin(blockSize * 4, maxPartitionSize);
+        const int end = blockSize < maxPartitionSize ? juce::jmin(2 * nextBlockSize, impulseLength)
+                                                     : impulseLength;
+
+        auto stage = std::make_unique<Stage>();
+        stage->blockSize = blockSize;
+        stage->fftSize = 2 * blockSize;
+        stage->spectrumSize = stage->fftSize + 2;
+        stage->offset = offset;
+        stage->numPartitions = (end - offset + blockSize - 1) / blockSize;
+        stage->background = !stages.empty();
+        stage->fft = std::make_unique<juce::dsp::FFT>(juce::roundToInt(std::log2(stage->fftSize)));
+
+        const auto spectrum = static_cast<size_t>(stage->spectrumSize);
+        const auto block = static_cast<size_t>(blockSize);
+
+        stage->channels.resize(static_cast<size_t>(numChannels));
+        for (int ch = 0; ch < numChannels; ++ch) {
+            auto& channel = stage->channels[static_cast<size_t>(ch)];
+            channel.filter.assign(spectrum * static_cast<size_t>(stage->numPartitions), 0.0f);
+            channel.delayLine.assign(spectrum * static_cast<size_t>(stage->numPartitions), 0.0f);
+            for (auto& input : channel.input) {
+                input.assign(block, 0.0f);
+            }
+            for (auto& output : channel.output) {
+                output.assign(block, 0.0f);
+            }
+            channel.work.assign(static_cast<size_t>(2 * stage->fftSize), 0.0f);
+            channel.accumulator.assign(spectrum, 0.0f);
+
+            // Partition p holds taps [offset + p * B, offset + (p + 1) * B),
+            // zero-padded to the FFT size
+            const float* taps = impulseChannel(ch);
+            for (int p = 0; p < stage->numPartitions; ++p) {
+                const int start = offset + p * blockSize;
+                const int count = juce::jmin(blockSize, impulseLength - start);
+
+                std::fill(channel.work.begin(), channel.work.end(), 0.0f);
+                std::copy(taps + start, taps + start + count, channel.work.begin());
+                stage->fft->performRealOnlyForwardTransform(channel.work.data(), true);
+                std::copy(channel.work.begin(), channel.work.begin() + stage->spectrumSize,
+                          channel.filter.begin() + static_cast<std::ptrdiff_t>(spectrum * static_cast<size_t>(p)));
+            }
+        }
+
+        stages.push_back(std::move(stage));
+        offset = end;
+        blockSize = nextBlockSize;
+    }
+
+    reset();
+
+    if (stages.size() > 1) {
+        workers = Workers::acquire();
+        workers->add(*this);
+    }
+}
+
+void PartitionedConvolver::reset() {
+    for (auto& history : headHistory) {
+        std::fill(history.begin(), history.end(), 0.0f);
+    }
+
+    for (auto& stage : stages) {
+        // Let a running job finish before its buffers are cleared
+        while (stage->claimed.load() > stage->completed.load()) {
+            juce::Thread::yield();
+        }
+
+        for (auto& channel : stage->channels) {
+            std::fill(channel.delayLine.begin(), channel.delayLine.end(), 0.0f);
+            for (auto& input : channel.input) {
+                std::fill(input.begin(), input.end(), 0.0f);
+            }
+            for (auto& output : channel.output) {
+                std::fill(output.begin(), output.end(), 0.0f);
+            }
+        }
+
+        stage->delayLinePosition = 0;
+        stage->posted = -1;
+        stage->claimed = -1;
+        stage->completed = -1;
+    }
+
+    samplePosition = 0;
+    lateBlocks = 0;
+}
+
+void PartitionedConvolver::process(const float* const* input, float* const* output,
+                                   int channels, int numSamples) noexcept {
+    const int numUsed = juce::jmin(channels, numChannels);
+
+    // Channels without a response pass nothing
+    for (int ch = numUsed; ch < channels; ++ch) {
+        juce::FloatVectorOperations::clear(output[ch], numSamples);
+    }
+
+    if (numUsed == 0) {
+        return;
+    }
+
+    int done = 0;
+    while (done < numSamples) {
+        // Chunks never cross a head block boundary, which is also every
+        // stage's block boundary
+        const int phase = static_cast<int>(samplePosition % headSize);
+        const int numThisTime = juce::jmin(numSamples - done, headSize - phase);
+
+        // Results due in this chunk must be ready before their input slot
+        // is overwritten below
+        for (auto& stage : stages) {
+            const int64_t elapsed = samplePosition - stage->offset;
+            if (elapsed >= 0 && elapsed % stage->blockSize == 0) {
+                waitForJob(*stage, elapsed / stage->blockSize);
+            }
+        }
+
+        for (int ch = 0; ch < numUsed; ++ch) {
+            const float* in = input[ch] + done;
+            float* out = output[ch] + done;
+
+            // Take the input first; output may alias it
+            auto& history = headHistory[static_cast<size_t>(ch)];
+            float* chunk = history.data() + headSize - 1;
+            juce::FloatVectorOperations::copy(chunk, in, numThisTime);
+
+            for (auto& stage : stages) {
+                const auto block = samplePosition / stage->blockSize;
+                const int stagePhase = static_cast<int>(samplePosition % stage->blockSize);
+                auto& slot = stage->channels[static_cast<size_t>(ch)].input[block % 3];
+                juce::FloatVectorOperations::copy(slot.data() + stagePhase, chunk, numThisTime);
+            }
+
+            // Head: direct convolution, one vector multiply-add per tap
+            juce::FloatVectorOperations::clear(out, numThisTime);
+            const auto& taps = headTaps[static_cast<size_t>(ch)];
+            for (size_t k = 0; k < taps.size(); ++k) {
+                if (taps[k] != 0.0f) {
+                    juce::FloatVectorOperations::addWithMultiply(out, chunk - k, taps[k], numThisTime);
+                }
+            }
+            std::memmove(history.data(), history.data() + numThisTime, static_cast<size_t>(headSize - 1) * sizeof(float));
+
+            // Tail: each stage's current output block
+            for (auto& stage : stages) {
+                const int64_t elapsed = samplePosition - stage->offset;
+                if (elapsed >= 0) {
+                    const auto block = elapsed / stage->blockSize;
+                    const int stagePhase = static_cast<int>(elapsed % stage->blockSize);
+                    const auto& result = stage->channels[static_cast<size_t>(ch)].output[block % 2];
+                    juce::FloatVectorOperations::add(out, result.data() + stagePhase, numThisTime);
+                }
+            }
+        }
+
+        samplePosition += numThisTime;
+        done += numThisTime;
+
+        // Completed input blocks: the first stage runs here, the rest are
+        // handed to the workers
+        bool wakeWorker = false;
+        for (auto& stage : stages) {
+            if (samplePosition % stage->blockSize == 0) {
+                stage->posted.store(samplePosition / stage->blockSize - 1, std::memory_order_release);
+                if (stage->background) {
+                    wakeWorker = true;
+                } else {
+                    runNextJob(*stage);
+                }
+            }
+        }
+
+        if (wakeWorker) {
+            workers->wake();
+        }
+    }
+}
+
+bool PartitionedConvolver::runNextJob(Stage& stage) noexcept {
+    const int64_t next = stage.completed.load(std::memory_order_acquire) + 1;
+    if (next > stage.posted.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    // Whoever moves claimed to next runs the job
+    int64_t expected = next - 1;
+    if (!stage.claimed.compare_exchange_strong(expected, next, std::memory_order_acq_rel)) {
+        return false;
+    }
+
+    runJob(stage, next);
+    stage.completed.store(next, std::memory_order_release);
+    return true;
+}
+
+void PartitionedConvolver::runJob(Stage& stage, int64_t block) noexcept {
+    const auto spectrum = static_cast<size_t>(stage.spectrumSize);
+    const int numBins = stage.spectrumSize / 2;
+    const int blockSize = stage.blockSize;
+
+    for (auto& channel : stage.channels) {
+        // Overlap-save frame: previous input block, then this one
+        const auto& previous = channel.input[(block + 2) % 3];
+        const auto& current = channel.input[block % 3];
+        float* work = channel.work.data();
+
+        std::copy(previous.begin(), previous.end(), work);
+        std::copy(current.begin(), current.end(), work + blockSize);
+        std::fill(work + stage.fftSize, work + 2 * stage.fftSize, 0.0f);
+        stage.fft->performRealOnlyForwardTransform(work, true);
+
+        float* newest = channel.delayLine.data() + spectrum * static_cast<size_t>(stage.delayLinePosition);
+        std::copy(work, work + stage.spectrumSize, newest);
+
+        // Multiply-accumulate every partition against the input it lines up
+        // with in the delay line
+        std::fill(channel.accumulator.begin(), channel.accumulator.end(), 0.0f);
+        float* acc = channel.accumulator.data();
+
+        for (int p = 0; p < stage.numPartitions; ++p) {
+            const int slot = (stage.delayLinePosition - p + stage.numPartitions) % stage.numPartitions;
+            const float* x = channel.delayLine.data() + spectrum * static_cast<size_t>(slot);
+            const float* h = channel.filter.data() + spectrum * static_cast<size_t>(p);
+
+            for (int i = 0; i < numBins; ++i) {
+                const float xr = x[2 * i], xi = x[2 * i + 1];
+                const float hr = h[2 * i], hi = h[2 * i + 1];
+                acc[2 * i] += xr * hr - xi * hi;
+                acc[2 * i + 1] += xr * hi + xi * hr;
+            }
+        }
+
+        std::copy(acc, acc + stage.spectrumSize, work);
+        std::fill(work + stage.spectrumSize, work + 2 * stage.fftSize, 0.0f);
+        stage.fft->performRealOnlyInverseTransform(work);
+
+        // The second half is free of circular wrap-around
+        auto& result = channel.output[block % 2];
+        std::copy(work + blockSize, work + stage.fftSize, result.begin());
+    }
+
+    stage.delayLinePosition = (stage.delayLinePosition + 1) % stage.numPartitions;
+}
+
+void PartitionedConvolver::waitForJob(Stage& stage, int64_t block) noexcept {
+    if (stage.completed.load(std::memory_order_acquire) >= block) {
+        return;
+    }
+
+    ++lateBlocks;
+
+    // Run the job here if the worker hasn't started it, otherwise wait for it
+    while (stage.completed.load(std::memory_order_acquire) < block) {
+        if (!runNextJob(stage)) {
+            juce::Thread::yield();
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Zero-latency, non-uniformly partitioned FFT convolution for long impulse
+// responses.
+//
+// The first headSize taps are applied directly in the time domain. The rest
+// of the response is split into stages whose FFT block size grows by four
+// each time (headSize, 4x, 16x, ... up to maxPartitionSize). Each stage is
+// uniformly partitioned, with a frequency-domain delay line, and starts far
+// enough into the response to hide its own block of latency:
+//
+//   stage 0 starts at one block  - computed on the audio thread when its
+//                                  input block completes
+//   later stages start at two    - computed by a worker, with a whole block
+//   blocks                         of time before the result is due
+//
+// The workers are one small pool shared by every convolver in the process,
+// so a session full of reverbs does not start a thread per instance. If a
+// worker is ever late the audio thread runs the pending job itself, or
+// waits for it if it is already running, and counts a late block.
+//
+// loadImpulseResponse() and reset() must not run concurrently with
+// process(); swap whole convolvers to change the response while playing.
+class PartitionedConvolver {
+public:
+    // Constructor/Destructor
+    PartitionedConvolver();
+    ~PartitionedConvolver();
+
+    // Builds the partitions. Impulse channels map onto the numChannels
+    // processing channels; a mono response is used for all of them.
+    void loadImpulseResponse(const juce::AudioBuffer<float>& impulse,
+                             int numChannelsToUse,
+                             int headSizeToUse = 128,
+                             int maxPartitionSize = 8192);
+    void reset();
+
+    // Audio thread. input and output may be the same buffers.
+    void process(const float* const* input, float* const* output, int numChannels, int numSamples) noexcept;
+
+    int getLatencySamples() const { return 0; }
+    int getImpulseLength() const { return impulseLength; }
+    int getNumChannels() const { return numChannels; }
+    int getNumStages() const { return static_cast<int>(stages.size()); }
+    int getNumLateBlocks() const { return lateBlocks.load(); }
+
+private:
+    class Workers;
+
+    // One uniformly partitioned section of the response
+    struct Stage {
+        int blockSize{0};
+        int fftSize{0};        // Twice the block size
+        int spectrumSize{0};   // Floats per spectrum: fftSize / 2 + 1 complex bins
+        int offset{0};         // First tap of the response this stage covers
+        int numPartitions{0};
+        bool background{false};
+        std::unique_ptr<juce::dsp::FFT> fft;
+
+        struct Channel {
+            std::vector<float> filter;       // numPartitions spectra
+            std::vector<float> delayLine;    // numPartitions input spectra
+            std::vector<float> input[3];     // Input blocks k-1, k, and k+1 being written
+            std::vector<float> output[2];    // Results for blocks k and k+1
+            std::vector<float> work;         // FFT buffer, 2 * fftSize
+            std::vector<float> accumulator;  // Summed spectrum
+        };
+
+        std::vector<Channel> channels;
+        int delayLinePosition{0};
+
+        // Job k processes input block k. Jobs run strictly in order.
+        std::atomic<int64_t> posted{-1};
+        std::atomic<int64_t> claimed{-1};
+        std::atomic<int64_t> completed{-1};
+    };
+
+    int numChannels{0};
+    int headSize{0};
+    int impulseLength{0};
+
+    // Time-domain head
+    std::vector<std::vector<float>> headTaps;
+    std::vector<std::vector<float>> headHistory;  // headSize - 1 past samples, then the chunk
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    int64_t samplePosition{0};
+    std::atomic<int> lateBlocks{0};
+
+    std::shared_ptr<Workers> workers;  // Set while there are background stages
+
+    bool runNextJob(Stage& stage) noexcept;
+    void runJob(Stage& stage, int64_t block) noexcept;
+    void waitForJob(Stage& stage, int64_t block) noexcept;
+    void releaseWorkers();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PartitionedConvolver)
+};
@@ -11,7 +11,8 @@ Plugin::Plugin(Track& track)
 }
 
 Plugin::~Plugin() {
-    releaseResources();
+    // Subclasses release their own resources; a virtual call from here
+    // would no longer reach them
 }
 
 void Plugin::bypass(bool shouldBypass) {
@@ -40,6 +41,14 @@ void Plugin::enable(bool shouldBeEnabled) {
     }
 }
 
+void Plugin::setNonRealtime(bool isNonRealtime) {
+    if (nonRealtime != isNonRealtime) {
+        nonRealtime = isNonRealtime;
+        handleNonRealtimeChange();
+        sendChangeMessage();
+    }
+}
+
 void Plugin::bypassProcessing(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
     // Default bypass behavior - do nothing, letting audio pass through unchanged
     juce::ignoreUnused(buffer, midiMessages);
@@ -53,6 +62,10 @@ void Plugin::handleEnableChange() {
     // Default implementation - subclasses can override
 }
 
+void Plugin::handleNonRealtimeChange() {
+    // Default implementation - subclasses can override
+}
+
 //==============================================================================
 // PluginUtils Implementation
 //==============================================================================
@@ -84,6 +97,8 @@ namespace PluginUtils {
 
     void savePluginState(const Plugin& plugin, juce::ValueTree& state) {
         // Save basic properties
+        state.setProperty("identifier", plugin.getFormat().identifier, nullptr);
+        state.setProperty("type", typeToString(plugin.getFormat().type), nullptr);
         state.setProperty("name", plugin.getName(), nullptr);
         state.setProperty("bypassed", plugin.isBypassed(), nullptr);
         state.setProperty("enabled", plugin.isEnabled(), nullptr);
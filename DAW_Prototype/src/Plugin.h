@@ -40,6 +40,11 @@ public:
     bool isEnabled() const { return enabled; }
     void enable(bool shouldBeEnabled);
 
+    // Offline rendering, where plugins may trade speed for quality. Call
+    // with processing stopped.
+    bool isNonRealtime() const { return nonRealtime; }
+    void setNonRealtime(bool isNonRealtime);
+
     // GUI
     virtual bool hasEditor() const = 0;
     virtual juce::AudioProcessorEditor* createEditor() = 0;
@@ -68,6 +73,14 @@ public:
     virtual void releaseResources() = 0;
     virtual void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) = 0;
 
+    // Sidechain input. The mixer points it at another node's output for
+    // the duration of processBlock(), without copying; it is empty the
+    // rest of the time. Audio thread.
+    virtual bool acceptsSidechain() const { return false; }
+    void setSidechainInput(const juce::dsp::AudioBlock<const float>& block) noexcept { sidechainInput = block; }
+    void clearSidechainInput() noexcept { sidechainInput = {}; }
+    const juce::dsp::AudioBlock<const float>& getSidechainInput() const noexcept { return sidechainInput; }
+
     // Latency handling
     virtual int getLatencySamples() const = 0;
     virtual double getTailLengthSeconds() const = 0;
@@ -82,11 +95,14 @@ protected:
     Track& track;
     bool bypassed{false};
     bool enabled{true};
+    bool nonRealtime{false};
+    juce::dsp::AudioBlock<const float> sidechainInput;
     
     // Internal helpers
     virtual void bypassProcessing(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages);
     virtual void handleBypassChange();
     virtual void handleEnableChange();
+    virtual void handleNonRealtimeChange();
 
 private:
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Plugin)
@@ -0,0 +1,183 @@
+#include "PluginLoader.h"
+#include "PluginManager.h"
+#include "Track.h"
+#include "Configuration.h"
+#include "Logger.h"
+
+//==============================================================================
+// PluginLoader::LoadJob Implementation
+//==============================================================================
+
+class PluginLoader::LoadJob : public juce::ThreadPoolJob {
+public:
+    LoadJob(PluginLoader& owner, Track& track, const juce::ValueTree& pluginsState)
+        : juce::ThreadPoolJob("Plugin chain: " + track.getName())
+        , owner(owner)
+        , track(track)
+        , pluginsState(pluginsState.createCopy())
+        , sampleRate(track.getSampleRate())
+        , blockSize(track.getBlockSize())
+        , remaining(pluginsState.getNumChildren()) {
+    }
+
+    ~LoadJob() override {
+        // Cancelled before finishing: count the rest as done so progress
+        // still reaches the end
+        if (remaining > 0) {
+            owner.numFinished += remaining;
+            owner.triggerAsyncUpdate();
+        }
+    }
+
+    Track& getTrack() const { return track; }
+
+    JobStatus runJob() override {
+        Result result;
+        result.track = &track;
+
+        for (auto pluginState : pluginsState) {
+            if (shouldExit()) {
+                return jobHasFinished;
+            }
+
+            const juce::String pluginID = pluginState.getProperty("identifier");
+            if (auto plugin = PluginManager::getInstance().createPlugin(track, pluginID)) {
+                plugin->prepareToPlay(sampleRate, blockSize);
+                
+                if (canRestoreOffMessageThread(*plugin)) {
+                    PluginUtils::loadPluginState(*plugin, pluginState);
+                    result.pendingStates.emplace_back();
+                } else {
+                    result.pendingStates.push_back(pluginState);
+                }
+                result.plugins.push_back(std::move(plugin));
+            } else {
+                LOG_WARNING("Missing plugin %s on track %s", pluginID.toRawUTF8(), track.getName().toRawUTF8());
+            }
+
+            --remaining;
+            owner.pluginFinished();
+        }
+
+        owner.addResult(std::move(result));
+        return jobHasFinished;
+    }
+
+private:
+    PluginLoader& owner;
+    Track& track;
+    juce::ValueTree pluginsState;  // Private copy; never shared with the message thread
+    double sampleRate;
+    int blockSize;
+    int remaining;
+};
+
+//==============================================================================
+// PluginLoader Implementation
+//==============================================================================
+
+PluginLoader::PluginLoader() {
+    const int numThreads = juce::jlimit(1, 32, Configuration::getInstance().getPerformanceSettings().pluginThreadPool);
+    pool = std::make_unique<juce::ThreadPool>(numThreads);
+}
+
+PluginLoader::~PluginLoader() {
+    pool->removeAllJobs(true, 10000);
+    cancelPendingUpdate();
+}
+
+PluginLoader& PluginLoader::getInstance() {
+    static PluginLoader instance;
+    return instance;
+}
+
+void PluginLoader::loadChain(Track& track, const juce::ValueTree& pluginsState) {
+    if (pluginsState.getNumChildren() == 0) {
+        return;
+    }
+
+    numQueued += pluginsState.getNumChildren();
+    pool->addJob(new LoadJob(*this, track, pluginsState), true);
+    sendChangeMessage();
+}
+
+void PluginLoader::cancel(Track& track) {
+    struct TrackJobs : juce::ThreadPool::JobSelector {
+        explicit TrackJobs(Track& t) : track(t) {}
+
+        bool isJobSuitable(juce::ThreadPoolJob* job) override {
+            auto* loadJob = dynamic_cast<LoadJob*>(job);
+            return loadJob != nullptr && &loadJob->getTrack() == &track;
+        }
+
+        Track& track;
+    };
+
+    TrackJobs selector(track);
+    pool->removeAllJobs(true, 10000, &selector);
+
+    // Chains that finished but were never delivered die with the track
+    std::vector<std::unique_ptr<Plugin>> discarded;
+    {
+        const juce::ScopedLock sl(resultLock);
+        for (auto it = results.begin(); it != results.end();) {
+            if (it->track == &track) {
+                for (auto& plugin : it->plugins) {
+                    discarded.push_back(std::move(plugin));
+                }
+                it = results.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+bool PluginLoader::canRestoreOffMessageThread(const Plugin& plugin) {
+    return plugin.getFormat().type == Plugin::Type::Internal;
+}
+
+float PluginLoader::getProgress() const {
+    const int queued = numQueued.load();
+    return queued > 0 ? static_cast<float>(numFinished.load()) / static_cast<float>(queued) : 1.0f;
+}
+
+void PluginLoader::addResult(Result result) {
+    {
+        const juce::ScopedLock sl(resultLock);
+        results.push_back(std::move(result));
+    }
+    triggerAsyncUpdate();
+}
+
+void PluginLoader::pluginFinished() {
+    ++numFinished;
+    triggerAsyncUpdate();
+}
+
+void PluginLoader::handleAsyncUpdate() {
+    std::vector<Result> ready;
+    {
+        const juce::ScopedLock sl(resultLock);
+        ready.swap(results);
+    }
+
+    // Each finished chain goes live straight away, once the state the jobs
+    // could not restore has been
+    for (auto& result : ready) {
+        for (size_t i = 0; i < result.plugins.size(); ++i) {
+            if (result.pendingStates[i].isValid()) {
+                PluginUtils::loadPluginState(*result.plugins[i], result.pendingStates[i]);
+            }
+        }
+        result.track->addLoadedPlugins(std::move(result.plugins));
+    }
+
+    if (!isLoading() && numQueued.load() > 0) {
+        LOG_INFO("Finished loading %d plugins", numQueued.load());
+        numQueued = 0;
+        numFinished = 0;
+    }
+
+    sendChangeMessage();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class Plugin;
+class Track;
+
+// Instantiates plugins and restores their state on a background thread pool.
+//
+// Loading a session queues one job per track. A job creates and prepares
+// that track's whole chain off the message thread, then hands it back; the
+// chain is swapped into the live track on the message thread. Tracks
+// therefore come to life one by one while the rest keep loading, and the
+// UI never stalls on a slow plugin.
+//
+// Internal plugins restore their state in the job too. VST3 and AudioUnit
+// controllers often require the message thread, so theirs is restored
+// there, just before the chain goes live.
+class PluginLoader : public juce::ChangeBroadcaster,
+                     private juce::AsyncUpdater {
+public:
+    // Constructor/Destructor
+    PluginLoader();
+    ~PluginLoader() override;
+
+    // Singleton access
+    static PluginLoader& getInstance();
+
+    // Message thread. Queues the "plugin" children of pluginsState for the
+    // track; they are added in order once all of them have loaded.
+    void loadChain(Track& track, const juce::ValueTree& pluginsState);
+
+    // Message thread. Drops queued and finished work for the track, waiting
+    // for a running job. Call before the track is destroyed.
+    void cancel(Track& track);
+
+    // Progress, counted in plugins (any thread)
+    bool isLoading() const { return numFinished.load() < numQueued.load(); }
+    int getNumQueued() const { return numQueued.load(); }
+    int getNumFinished() const { return numFinished.load(); }
+    float getProgress() const;
+
+private:
+    class LoadJob;
+
+    // A loaded chain waiting for the message thread
+    struct Result {
+        Track* track{nullptr};
+        std::vector<std::unique_ptr<Plugin>> plugins;
+        std::vector<juce::ValueTree> pendingStates;  // Per plugin; invalid once restored
+    };
+
+    static bool canRestoreOffMessageThread(const Plugin& plugin);
+
+    std::unique_ptr<juce::ThreadPool> pool;
+
+    juce::CriticalSection resultLock;
+    std::vector<Result> results;
+
+    std::atomic<int> numQueued{0};
+    std::atomic<int> numFinished{0};
+
+    void addResult(Result result);
+    void pluginFinished();
+    void handleAsyncUpdate() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginLoader)
+};
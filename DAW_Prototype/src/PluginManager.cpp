@@ -1,4 +1,6 @@
 #include "PluginManager.h"
+#include "HostedPlugin.h"
+#include "AudioEngine.h"
 #include "Logger.h"
 #include "Configuration.h"
 
@@ -130,6 +132,11 @@ bool PluginManager::isPluginBlacklisted(const juce::String& identifier) const {
 }
 
 std::unique_ptr<Plugin> PluginManager::createPlugin(Track& track, const juce::String& identifier) {
+    // Built-in effects need no scan
+    if (internalPlugins.getPluginNames().contains(identifier)) {
+        return internalPlugins.createPlugin(track, identifier);
+    }
+    
     if (!isPluginAvailable(identifier) || isPluginBlacklisted(identifier)) {
         return nullptr;
     }
@@ -137,39 +144,29 @@ std::unique_ptr<Plugin> PluginManager::createPlugin(Track& track, const juce::St
     const auto& cache = pluginCache.at(identifier);
     
     try {
-        juce::AudioPluginFormat* format = nullptr;
-        
-        switch (cache.info.type) {
-            case Plugin::Type::VST3:
-                format = formatManager->getFormat(0);  // VST3 format
-                break;
-                
-            case Plugin::Type::AudioUnit:
-                #if JUCE_PLUGINHOST_AU && JUCE_MAC
-                format = formatManager->getFormat(1);  // AU format
-                #endif
-                break;
-                
-            default:
-                break;
+        auto description = findPluginDescription(cache.file.getFullPathName());
+        if (description == nullptr) {
+            LOG_ERROR("No plugin description for %s", cache.info.name.toRawUTF8());
+            return nullptr;
         }
         
-        if (format != nullptr) {
-            juce::String error;
-            std::unique_ptr<juce::AudioPluginInstance> instance(
-                format->createInstanceFromDescription(
-                    knownPluginList->getTypeForFile(cache.file.getFullPathName()),
-                    44100.0, 512, error));
-                    
-            if (instance != nullptr) {
-                // TODO: Create wrapper plugin class
-                LOG_INFO("Created plugin instance: %s", cache.info.name);
-                return nullptr;  // Replace with actual plugin instance
-            }
-            
-            LOG_ERROR("Failed to create plugin instance: %s (%s)",
-                     cache.info.name, error);
+        // Instantiate at the session's rate and block size, so plugins that
+        // size themselves on construction start out right. The owner
+        // prepares the plugin again once its channel layout is known.
+        const auto& settings = AudioEngine::getInstance().getSettings();
+        juce::String error;
+        auto instance = formatManager->createPluginInstance(*description,
+                                                            settings.sampleRate,
+                                                            settings.bufferSize,
+                                                            error);
+        
+        if (instance != nullptr) {
+            LOG_INFO("Created plugin instance: %s", cache.info.name.toRawUTF8());
+            return std::make_unique<HostedPlugin>(track, std::move(instance), cache.info.type);
         }
+        
+        LOG_ERROR("Failed to create plugin instance: %s (%s)",
+                 cache.info.name.toRawUTF8(), error.toRawUTF8());
     }
     catch (const std::exception& e) {
         LOG_ERROR("Exception creating plugin instance: %s (%s)",
@@ -179,6 +176,29 @@ std::unique_ptr<Plugin> PluginManager::createPlugin(Track& track, const juce::St
     return nullptr;
 }
 
+std::unique_ptr<juce::PluginDescription> PluginManager::findPluginDescription(const juce::String& path) {
+    const juce::ScopedLock sl(descriptionLock);
+    
+    if (auto description = knownPluginList->getTypeForFile(path)) {
+        return description;
+    }
+    
+    // Not in the known list yet (older cache): ask the formats directly
+    juce::OwnedArray<juce::PluginDescription> types;
+    for (auto* format : formatManager->getFormats()) {
+        if (format->fileMightContainThisPluginType(path)) {
+            format->findAllTypesForFile(types, path);
+        }
+    }
+    
+    if (types.isEmpty()) {
+        return nullptr;
+    }
+    
+    knownPluginList->addType(*types[0]);
+    return std::make_unique<juce::PluginDescription>(*types[0]);
+}
+
 void PluginManager::releasePlugin(Plugin* plugin) {
     if (plugin != nullptr) {
         cleanupPlugin(plugin);
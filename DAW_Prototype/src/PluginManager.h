@@ -1,6 +1,7 @@
 #pragma once
 #include <JuceHeader.h>
 #include "Plugin.h"
+#include "InternalPlugins.h"
 
 class PluginManager : public juce::ChangeBroadcaster {
 public:
@@ -56,7 +57,7 @@ public:
     bool isPluginValid(const juce::String& identifier) const;
     bool isPluginBlacklisted(const juce::String& identifier) const;
 
-    // Plugin creation
+    // Plugin creation. Safe to call from PluginLoader's threads.
     std::unique_ptr<Plugin> createPlugin(Track& track, const juce::String& identifier);
     void releasePlugin(Plugin* plugin);
 
@@ -79,6 +80,8 @@ private:
     // Plugin formats
     std::unique_ptr<juce::AudioPluginFormatManager> formatManager;
     std::unique_ptr<juce::KnownPluginList> knownPluginList;
+    InternalPluginFactory internalPlugins;
+    juce::CriticalSection descriptionLock;  // Description lookups from loader threads
     
     // Plugin paths
     juce::StringArray pluginPaths;
@@ -109,6 +112,7 @@ private:
     bool validatePluginCache(const juce::String& identifier) const;
     void clearPluginCache();
     
+    std::unique_ptr<juce::PluginDescription> findPluginDescription(const juce::String& path);
     ScanResult scanPlugin(const juce::String& path);
     void handlePluginScanResult(const ScanResult& result);
     void updateScanProgress(float progress);
@@ -2,6 +2,7 @@
 #include "Logger.h"
 
 Project::Project() {
+    mixer.setProject(this);
     createNew();
 }
 
@@ -17,12 +18,19 @@ void Project::createNew() {
     metadata.created = juce::Time::getCurrentTime();
     metadata.modified = metadata.created;
     
+    // Reset tempo map to the project tempo
+    tempoMap = TempoMap(settings.tempo, settings.timeSignature.numerator,
+                        settings.timeSignature.denominator);
+    tempoMapChanged();
+    
     // Create master track
     masterTrack = std::make_unique<Track>(Track::Type::Master);
     masterTrack->setName("Master");
     
     // Clear all collections
-    tracks.clear();
+    while (!tracks.isEmpty()) {
+        retireTrack(tracks.size() - 1);
+    }
     buses.clear();
     audioFiles.clear();
     midiFiles.clear();
@@ -74,12 +82,15 @@ bool Project::save(const juce::File& file) {
         settingsObj->setProperty("sampleRate", settings.sampleRate);
         settingsObj->setProperty("bitDepth", settings.bitDepth);
         json->setProperty("settings", settingsObj);
+        json->setProperty("tempoMap", tempoMap.toVar());
         
         // Add transport state
         auto transportObj = new juce::DynamicObject();
         transportObj->setProperty("loopEnabled", transportState.loopEnabled);
         transportObj->setProperty("loopStart", transportState.loopStart);
         transportObj->setProperty("loopEnd", transportState.loopEnd);
+        transportObj->setProperty("punchIn", transportState.punchIn);
+        transportObj->setProperty("punchOut", transportState.punchOut);
         transportObj->setProperty("timeRulerOffset", transportState.timeRulerOffset);
         transportObj->setProperty("snapToGrid", transportState.snapToGrid);
         transportObj->setProperty("gridSize", transportState.gridSize);
@@ -172,13 +183,22 @@ bool Project::load(const juce::File& file) {
                     settings.length = settingsObj->getProperty("length");
                     settings.sampleRate = settingsObj->getProperty("sampleRate");
                     settings.bitDepth = settingsObj->getProperty("bitDepth");
+                    
+                    tempoMap = TempoMap(settings.tempo, settings.timeSignature.numerator,
+                                        settings.timeSignature.denominator);
                 }
                 
+                // Load tempo map (older projects only have the settings tempo)
+                tempoMap.fromVar(json.getProperty("tempoMap", {}));
+                tempoMapChanged();
+                
                 // Load transport state
                 if (auto* transportObj = json.getProperty("transport", {}).getDynamicObject()) {
                     transportState.loopEnabled = transportObj->getProperty("loopEnabled");
                     transportState.loopStart = transportObj->getProperty("loopStart");
                     transportState.loopEnd = transportObj->getProperty("loopEnd");
+                    transportState.punchIn = transportObj->getProperty("punchIn", 0.0);
+                    transportState.punchOut = transportObj->getProperty("punchOut", 4.0);
                     transportState.timeRulerOffset = transportObj->getProperty("timeRulerOffset");
                     transportState.snapToGrid = transportObj->getProperty("snapToGrid");
                     transportState.gridSize = transportObj->getProperty("gridSize");
@@ -250,11 +270,43 @@ void Project::setMetadata(const Metadata& newMetadata) {
 }
 
 void Project::setSettings(const Settings& newSettings) {
+    const bool tempoChanged = newSettings.tempo != settings.tempo ||
+        newSettings.timeSignature.numerator != settings.timeSignature.numerator ||
+        newSettings.timeSignature.denominator != settings.timeSignature.denominator;
+    
     settings = newSettings;
+    
+    if (tempoChanged) {
+        const auto& start = tempoMap.getTempoPoints().front();
+        tempoMap.addTempoPoint(0.0, settings.tempo, start.ramp);
+        tempoMap.setTimeSignature(0, settings.timeSignature.numerator,
+                                  settings.timeSignature.denominator);
+        tempoMapChanged();
+    }
+    
+    markAsUnsaved();
+    notifyProjectChanged();
+}
+
+void Project::setTempoMap(const TempoMap& newTempoMap) {
+    tempoMap = newTempoMap;
+    
+    // Keep the single-tempo settings in step with the start of the map
+    settings.tempo = tempoMap.getTempoPoints().front().bpm;
+    settings.timeSignature.numerator = tempoMap.getTimeSignatures().front().numerator;
+    settings.timeSignature.denominator = tempoMap.getTimeSignatures().front().denominator;
+    
+    tempoMapChanged();
     markAsUnsaved();
     notifyProjectChanged();
 }
 
+void Project::tempoMapChanged() {
+    // The audio thread gets an immutable copy through the render model
+    tempoMapSnapshot = std::make_shared<const TempoMap>(tempoMap);
+    mixer.publishRenderModel();
+}
+
 void Project::setTransportState(const TransportState& newState) {
     transportState = newState;
     markAsUnsaved();
@@ -263,26 +315,50 @@ void Project::setTransportState(const TransportState& newState) {
 
 Track* Project::addTrack(Track::Type type) {
     auto track = new Track(type);
+    track->setMixer(&mixer);
     tracks.add(track);
+    track->addChangeListener(this);
+    mixer.addChannel();
     markAsUnsaved();
     notifyProjectChanged();
     return track;
 }
 
 void Project::removeTrack(Track* track) {
-    if (tracks.removeObject(track)) {
+    const int index = tracks.indexOf(track);
+    if (index >= 0) {
+        retireTrack(index);
         markAsUnsaved();
         notifyProjectChanged();
     }
 }
 
 void Project::moveTrack(int fromIndex, int toIndex) {
-    if (tracks.move(fromIndex, toIndex)) {
+    if (fromIndex >= 0 && fromIndex < tracks.size() &&
+        toIndex >= 0 && toIndex < tracks.size() && fromIndex != toIndex) {
+        tracks.move(fromIndex, toIndex);
+        mixer.moveChannel(fromIndex, toIndex);
         markAsUnsaved();
         notifyProjectChanged();
     }
 }
 
+void Project::changeListenerCallback(juce::ChangeBroadcaster* source) {
+    if (tracks.contains(static_cast<Track*>(source))) {
+        mixer.publishRenderModel();
+    }
+}
+
+void Project::retireTrack(int index) {
+    std::unique_ptr<Track> track(tracks.removeAndReturn(index));
+    track->removeChangeListener(this);
+    
+    // Removing the channel publishes a render model without the track, so
+    // it can be deleted as soon as the audio thread has finished the block
+    mixer.removeChannel(index);
+    mixer.retireTrack(std::move(track));
+}
+
 Track* Project::getTrackByID(const juce::String& id) const {
     for (auto* track : tracks) {
         if (track->getID() == id) {
@@ -2,8 +2,10 @@
 #include <JuceHeader.h>
 #include "Track.h"
 #include "Mixer.h"
+#include "TempoMap.h"
 
-class Project : public juce::ChangeBroadcaster {
+class Project : public juce::ChangeBroadcaster,
+                private juce::ChangeListener {
 public:
     // Project metadata
     struct Metadata {
@@ -35,6 +37,8 @@ public:
         bool loopEnabled{false};
         double loopStart{0.0};
         double loopEnd{4.0};
+        double punchIn{0.0};   // Enabled by RecordingSettings
+        double punchOut{4.0};
         juce::Array<std::pair<double, juce::String>> markers;
         double timeRulerOffset{0.0};
         bool snapToGrid{true};
@@ -57,6 +61,12 @@ public:
     const Settings& getSettings() const { return settings; }
     void setSettings(const Settings& newSettings);
     
+    // Tempo and time signature over time. Settings::tempo and
+    // timeSignature mirror the map's starting values.
+    const TempoMap& getTempoMap() const { return tempoMap; }
+    void setTempoMap(const TempoMap& newTempoMap);
+    std::shared_ptr<const TempoMap> getTempoMapSnapshot() const { return tempoMapSnapshot; }
+    
     const TransportState& getTransportState() const { return transportState; }
     void setTransportState(const TransportState& newState);
     
@@ -70,6 +80,10 @@ public:
     const juce::OwnedArray<Track>& getTracks() const { return tracks; }
     Track* getTrackByID(const juce::String& id) const;
     Track* getMasterTrack() const { return masterTrack.get(); }
+    
+    // Mixer (one channel per track, kept in step by the track methods)
+    Mixer& getMixer() { return mixer; }
+    const Mixer& getMixer() const { return mixer; }
 
     // Bus management
     Track* addBus(const juce::String& name);
@@ -108,10 +122,16 @@ private:
     Metadata metadata;
     Settings settings;
     TransportState transportState;
+    TempoMap tempoMap;
+    std::shared_ptr<const TempoMap> tempoMapSnapshot;
     
     juce::File projectFile;
     bool unsavedChanges{false};
     
+    // Declared before the tracks so it outlives them; removed tracks are
+    // handed to it and deleted once the audio thread has let go of them
+    Mixer mixer;
+    
     std::unique_ptr<Track> masterTrack;
     juce::OwnedArray<Track> tracks;
     juce::OwnedArray<Track> buses;
@@ -131,9 +151,15 @@ private:
     int maxHistorySize{100};
     
     void markAsUnsaved() { unsavedChanges = true; }
+    void retireTrack(int index);
+    void tempoMapChanged();
     void addToHistory(const juce::String& description);
     void updateModifiedTime();
     void notifyProjectChanged();
     
+    // Track changes (monitoring, input routing) reach the audio thread
+    // through a new render model
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Project)
 };
\ No newline at end of file
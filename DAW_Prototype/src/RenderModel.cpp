@@ -0,0 +1,174 @@
+#include "RenderModel.h"
+
+//==============================================================================
+// RenderModel Implementation
+//==============================================================================
+
+bool RenderModel::Buffers::matches(int numChannels, int numBuses, int maxBlockSize,
+                                   int numDelayLines, int maxDelay) const {
+    return static_cast<int>(channelBuffers.size()) == numChannels &&
+           static_cast<int>(busBuffers.size()) == numBuses &&
+           blockSize == maxBlockSize &&
+           static_cast<int>(delayLines.size()) == numDelayLines &&
+           maxDelay + blockSize <= delayCapacity;
+}
+
+void RenderModel::Buffers::setNumSamples(int numSamples) noexcept {
+    // Shrinking and regrowing within the allocation never reallocates
+    auto resize = [numSamples](juce::AudioBuffer<float>& buffer) {
+        buffer.setSize(buffer.getNumChannels(), numSamples, false, false, true);
+    };
+
+    for (auto& buffer : channelBuffers) {
+        resize(buffer);
+    }
+
+    for (auto& buffer : busBuffers) {
+        resize(buffer);
+    }
+
+    resize(masterBuffer);
+
+    for (auto& delayLine : delayLines) {
+        resize(delayLine.output);
+    }
+}
+
+void RenderModel::DelayLine::prepare(int numChannels, int capacity, int blockSize) {
+    ring.setSize(numChannels, capacity);
+    ring.clear();
+    output.setSize(numChannels, blockSize);
+    output.clear();
+    writePosition = 0;
+    silentSamples = capacity;
+}
+
+void RenderModel::DelayLine::process(const juce::AudioBuffer<float>& input, int numSamples, int delay) noexcept {
+    const int capacity = ring.getNumSamples();
+    const int numChannels = juce::jmin(ring.getNumChannels(), input.getNumChannels());
+    numSamples = juce::jmin(numSamples, output.getNumSamples(), input.getNumSamples());
+
+    // Write the block, then read it back delay samples behind, both in at
+    // most two pieces around the end of the ring
+    const int firstWrite = juce::jmin(numSamples, capacity - writePosition);
+    int readPosition = writePosition - delay;
+    if (readPosition < 0) {
+        readPosition += capacity;
+    }
+    const int firstRead = juce::jmin(numSamples, capacity - readPosition);
+
+    // Silence written into a ring holding only silence changes nothing,
+    // and nothing is read once the last signal is further back than the
+    // delay
+    const bool inputSilent = input.hasBeenCleared();
+    const bool skipWrite = inputSilent && silentSamples >= capacity;
+    silentSamples = inputSilent ? juce::jmin(silentSamples + numSamples, capacity) : 0;
+    const bool outputSilent = silentSamples >= delay + numSamples;
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        if (!skipWrite) {
+            ring.copyFrom(channel, writePosition, input, channel, 0, firstWrite);
+            ring.copyFrom(channel, 0, input, channel, firstWrite, numSamples - firstWrite);
+        }
+
+        if (!outputSilent) {
+            output.copyFrom(channel, 0, ring, channel, readPosition, firstRead);
+            output.copyFrom(channel, firstRead, ring, channel, 0, numSamples - firstRead);
+        }
+    }
+
+    if (outputSilent) {
+        output.clear();
+    }
+
+    writePosition = (writePosition + numSamples) % capacity;
+}
+
+//==============================================================================
+// RenderModelExchange::ScopedRead Implementation
+//==============================================================================
+
+RenderModelExchange::ScopedRead::ScopedRead(RenderModelExchange& owner) noexcept
+    : exchange(owner) {
+    if (exchange.readDepth++ == 0) {
+        // Enter the block before loading, so a concurrent retire sees an odd epoch
+        exchange.audioEpoch.fetch_add(1, std::memory_order_seq_cst);
+        exchange.activeModel = exchange.current.load(std::memory_order_seq_cst);
+    }
+
+    model = exchange.activeModel;
+}
+
+RenderModelExchange::ScopedRead::~ScopedRead() noexcept {
+    if (--exchange.readDepth == 0) {
+        exchange.activeModel = nullptr;
+        exchange.audioEpoch.fetch_add(1, std::memory_order_release);
+    }
+}
+
+//==============================================================================
+// RenderModelExchange Implementation
+//==============================================================================
+
+RenderModelExchange::RenderModelExchange()
+    : juce::Thread("Render Model Reclaimer") {
+    startThread();
+}
+
+RenderModelExchange::~RenderModelExchange() {
+    stopThread(2000);
+
+    // The audio thread must be detached by now
+    delete current.exchange(nullptr);
+    reclaim(true);
+}
+
+void RenderModelExchange::publish(std::unique_ptr<RenderModel> model) {
+    std::unique_ptr<RenderModel> previous(current.exchange(model.release(), std::memory_order_seq_cst));
+    retire(std::move(previous));
+}
+
+int RenderModelExchange::getNumPendingRetirements() const {
+    const juce::ScopedLock sl(retireLock);
+    return static_cast<int>(retired.size());
+}
+
+void RenderModelExchange::retireObject(std::shared_ptr<const void> object) {
+    // Read after the pointer swap: if the audio thread is inside a block now
+    // it may still hold the old model, otherwise it will load the new one
+    const auto epoch = audioEpoch.load(std::memory_order_seq_cst);
+
+    const juce::ScopedLock sl(retireLock);
+    retired.push_back({ std::move(object), epoch });
+}
+
+void RenderModelExchange::reclaim(bool force) {
+    const auto epoch = audioEpoch.load(std::memory_order_acquire);
+    std::vector<std::shared_ptr<const void>> toFree;
+
+    {
+        const juce::ScopedLock sl(retireLock);
+
+        // Safe once the audio thread was idle at retirement, or has since
+        // left the block it was in
+        auto it = std::partition(retired.begin(), retired.end(),
+            [epoch, force](const Retired& r) {
+                return !(force || (r.epoch & 1) == 0 || r.epoch != epoch);
+            });
+
+        for (auto i = it; i != retired.end(); ++i) {
+            toFree.push_back(std::move(i->object));
+        }
+        retired.erase(it, retired.end());
+    }
+
+    // Destructors run outside the lock
+    toFree.clear();
+}
+
+void RenderModelExchange::run() {
+    while (!threadShouldExit()) {
+        reclaim(false);
+        wait(50);
+    }
+}
@@ -0,0 +1,203 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "MeterBus.h"
+#include "LoudnessMeter.h"
+#include "TempoMap.h"
+#include "DiskRecorder.h"
+
+class Plugin;
+class Track;
+
+// Immutable snapshot of everything the audio thread renders.
+//
+// Built on the message thread from the Mixer and Project state and never
+// modified after it has been published. The audio thread only follows raw
+// pointers out of it; anything they point at is retired through the
+// RenderModelExchange, so it outlives every model that references it.
+struct RenderModel {
+    // A node of the routing graph
+    struct Node {
+        enum class Type {
+            Channel,
+            Bus,
+            Master
+        };
+
+        Type type{Type::Master};
+        int index{0};
+
+        bool operator==(const Node& other) const { return type == other.type && index == other.index; }
+        bool operator!=(const Node& other) const { return !(*this == other); }
+    };
+
+    // Where an edge leaves its node's strip
+    enum class Tap {
+        PreFader,   // After the plugins
+        PostFader,  // After volume
+        PostPan     // After volume and pan
+    };
+    static constexpr int numTaps = 3;
+
+    // Gain an edge applied to its last block. Shared by consecutive models,
+    // so a level change ramps over one block instead of stepping. Audio
+    // thread only.
+    struct GainRamp {
+        float gain{0.0f};
+    };
+
+    // Edge into a bus or the master, delayed so it lines up with the other
+    // inputs summed there
+    struct Output {
+        int bus{-1};  // -1 = master
+        Tap tap{Tap::PostPan};
+        float gain{1.0f};  // Target; zero when muted
+        std::shared_ptr<GainRamp> ramp;
+        int delay{0};
+        int delayLine{-1};  // Slot in Buffers::delayLines when delayed
+    };
+
+    // Edge from a node's output into a plugin's sidechain, delayed to line
+    // up with the audio reaching that plugin
+    struct Sidechain {
+        Node source;
+        Plugin* plugin{nullptr};
+        int delay{0};
+        int delayLine{-1};
+    };
+
+    struct Channel {
+        float volume{1.0f};
+        float pan{0.0f};
+        bool mute{false};
+        bool bypass{false};
+        bool active{true};  // Renders at all: mute, solo and routing resolved
+        int monitorInput{-1};  // Zero-based device input, -1 when not monitoring
+        int latency{0};  // At the output, including everything upstream
+        int tailSamples{0};  // Track and strip chain latency plus tail; -1 if it may ring forever
+        std::vector<Output> outputs;  // Direct out, bus sources and sends, grouped by tap
+        std::array<int, numTaps + 1> tapOffsets{};  // Tap t is outputs[tapOffsets[t], tapOffsets[t + 1])
+        std::vector<Sidechain> sidechains;  // Into this node's plugins
+        std::vector<Plugin*> plugins;
+        std::shared_ptr<MeterBus::Slot> meter;
+        std::shared_ptr<LoudnessAnalyser::Source> loudness;
+    };
+
+    struct Bus {
+        Channel channel;
+    };
+
+    // Fixed delay compensating one edge of the graph. The ring holds the
+    // input history; output receives the delayed block, flagged cleared
+    // once the last signal has passed through.
+    struct DelayLine {
+        juce::AudioBuffer<float> ring;
+        juce::AudioBuffer<float> output;
+        int writePosition{0};
+        int silentSamples{0};  // Trailing silence written, up to the capacity
+
+        void prepare(int numChannels, int capacity, int blockSize);
+        void process(const juce::AudioBuffer<float>& input, int numSamples, int delay) noexcept;
+    };
+
+    // Scratch buffers written only by the audio thread. Consecutive models
+    // with the same topology share them, so a fader move does not allocate.
+    // Allocated for blockSize samples; each block resizes them in place to
+    // the samples actually rendered.
+    struct Buffers {
+        std::vector<juce::AudioBuffer<float>> channelBuffers;
+        std::vector<juce::AudioBuffer<float>> busBuffers;
+        juce::AudioBuffer<float> masterBuffer;
+        std::vector<DelayLine> delayLines;
+        int delayCapacity{0};
+        int blockSize{0};
+        std::vector<int> silentSamples;  // Per node, channels, buses then master: how long its input has been silent
+
+        bool matches(int numChannels, int numBuses, int maxBlockSize,
+                     int numDelayLines, int maxDelay) const;
+        void setNumSamples(int numSamples) noexcept;  // Up to blockSize
+    };
+
+    std::vector<Track*> tracks;
+    std::vector<Channel> channels;
+    std::vector<Bus> buses;
+    Channel master;
+    std::vector<Node> order;  // Channels and buses, sources before destinations
+    int outputLatency{0};  // Master output relative to the timeline
+    std::shared_ptr<Buffers> buffers;
+    std::shared_ptr<const TempoMap> tempoMap;
+    std::shared_ptr<DiskRecorder::Session> recording;  // Armed inputs, if recording
+    int monitoringLatencyLimit{-1};  // Low-latency monitoring threshold, -1 = off
+};
+
+// Publishes RenderModels to the audio thread and reclaims them safely.
+//
+// The audio thread brackets every block with a ScopedRead, which bumps an
+// epoch counter on entry and exit (odd = inside a block). A replaced model,
+// or any other object handed to retire(), is freed on a background thread
+// once the epoch shows the audio thread cannot still be using it. Neither
+// side ever blocks the audio thread.
+//
+// ScopedReads nest: an inner read returns the model the outermost one
+// loaded, so everything rendered in one callback sees the same snapshot.
+class RenderModelExchange : private juce::Thread {
+public:
+    // Audio thread access for the duration of one block
+    class ScopedRead {
+    public:
+        explicit ScopedRead(RenderModelExchange& exchange) noexcept;
+        ~ScopedRead() noexcept;
+
+        const RenderModel* get() const noexcept { return model; }
+        const RenderModel* operator->() const noexcept { return model; }
+
+    private:
+        RenderModelExchange& exchange;
+        const RenderModel* model;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRead)
+    };
+
+    // Constructor/Destructor
+    RenderModelExchange();
+    ~RenderModelExchange() override;
+
+    // Message thread
+    void publish(std::unique_ptr<RenderModel> model);
+    const RenderModel* getLatest() const noexcept { return current.load(std::memory_order_acquire); }
+
+    // Defers destruction of anything a published model may reference
+    template <typename ObjectType>
+    void retire(std::unique_ptr<ObjectType> object) {
+        if (object != nullptr) {
+            retireObject(std::shared_ptr<const void>(object.release(), std::default_delete<ObjectType>()));
+        }
+    }
+
+    int getNumPendingRetirements() const;
+
+private:
+    struct Retired {
+        std::shared_ptr<const void> object;
+        uint64_t epoch;
+    };
+
+    std::atomic<RenderModel*> current{nullptr};
+    std::atomic<uint64_t> audioEpoch{0};
+
+    // Audio thread only
+    int readDepth{0};
+    const RenderModel* activeModel{nullptr};
+
+    juce::CriticalSection retireLock;
+    std::vector<Retired> retired;
+
+    void retireObject(std::shared_ptr<const void> object);
+    void reclaim(bool force);
+    void run() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RenderModelExchange)
+};
@@ -0,0 +1,342 @@
+#include "TempoMap.h"
+
+namespace {
+    constexpr double minBpm = 1.0;
+    constexpr double maxBpm = 999.0;
+}
+
+//==============================================================================
+// TempoMap::Segment Implementation
+//==============================================================================
+
+// With tempo linear in beats, bpm(b) = b0 + k(b - B0) and dt/db = 60 / bpm(b),
+// which integrates to a logarithm and inverts to an exponential.
+
+double TempoMap::Segment::secondsAt(double beat) const {
+    const double beats = beat - startBeat;
+    if (slope == 0.0 || beats < 0.0) {
+        return startSeconds + beats * 60.0 / startBpm;
+    }
+    return startSeconds + (60.0 / slope) * std::log((startBpm + slope * beats) / startBpm);
+}
+
+double TempoMap::Segment::beatAt(double seconds) const {
+    const double elapsed = seconds - startSeconds;
+    if (slope == 0.0 || elapsed < 0.0) {
+        return startBeat + elapsed * startBpm / 60.0;
+    }
+    return startBeat + (startBpm / slope) * std::expm1(slope * elapsed / 60.0);
+}
+
+double TempoMap::Segment::bpmAt(double beat) const {
+    return startBpm + slope * std::max(0.0, beat - startBeat);
+}
+
+//==============================================================================
+// TempoMap::Cursor Implementation
+//==============================================================================
+
+void TempoMap::Cursor::setMap(const TempoMap* map) {
+    if (map != tempoMap) {
+        tempoMap = map;
+        segment = 0;
+    }
+}
+
+double TempoMap::Cursor::samplesToBeat(int64_t samples, double sampleRate) {
+    const double seconds = static_cast<double>(samples) / sampleRate;
+    seekSeconds(seconds);
+    return tempoMap->segments[segment].beatAt(seconds);
+}
+
+int64_t TempoMap::Cursor::beatToSamples(double beat, double sampleRate) {
+    seekBeat(beat);
+    return static_cast<int64_t>(std::llround(tempoMap->segments[segment].secondsAt(beat) * sampleRate));
+}
+
+double TempoMap::Cursor::getTempoAtBeat(double beat) {
+    seekBeat(beat);
+    return tempoMap->segments[segment].bpmAt(beat);
+}
+
+void TempoMap::Cursor::seekBeat(double beat) {
+    const auto& segments = tempoMap->segments;
+    if (segment >= segments.size()) {
+        segment = 0;
+    }
+
+    // Usually still in the same segment or just past its end
+    if (beat >= segments[segment].startBeat) {
+        if (segment + 1 >= segments.size() || beat < segments[segment + 1].startBeat) {
+            return;
+        }
+        if (segment + 2 >= segments.size() || beat < segments[segment + 2].startBeat) {
+            ++segment;
+            return;
+        }
+    }
+
+    segment = tempoMap->findSegmentForBeat(beat);
+}
+
+void TempoMap::Cursor::seekSeconds(double seconds) {
+    const auto& segments = tempoMap->segments;
+    if (segment >= segments.size()) {
+        segment = 0;
+    }
+
+    if (seconds >= segments[segment].startSeconds) {
+        if (segment + 1 >= segments.size() || seconds < segments[segment + 1].startSeconds) {
+            return;
+        }
+        if (segment + 2 >= segments.size() || seconds < segments[segment + 2].startSeconds) {
+            ++segment;
+            return;
+        }
+    }
+
+    segment = tempoMap->findSegmentForSeconds(seconds);
+}
+
+//==============================================================================
+// TempoMap Implementation
+//==============================================================================
+
+TempoMap::TempoMap(double bpm, int numerator, int denominator) {
+    tempoPoints.push_back({ 0.0, juce::jlimit(minBpm, maxBpm, bpm), false });
+    timeSignatures.push_back({ 0, juce::jmax(1, numerator), juce::jmax(1, denominator), 0.0 });
+    rebuild();
+}
+
+void TempoMap::setTempo(double bpm) {
+    tempoPoints.clear();
+    tempoPoints.push_back({ 0.0, juce::jlimit(minBpm, maxBpm, bpm), false });
+    rebuild();
+}
+
+void TempoMap::addTempoPoint(double beat, double bpm, bool ramp) {
+    const TempoPoint point{ juce::jmax(0.0, beat), juce::jlimit(minBpm, maxBpm, bpm), ramp };
+
+    auto it = std::lower_bound(tempoPoints.begin(), tempoPoints.end(), point.beat,
+        [](const TempoPoint& p, double b) { return p.beat < b; });
+
+    if (it != tempoPoints.end() && it->beat == point.beat) {
+        *it = point;
+    } else {
+        tempoPoints.insert(it, point);
+    }
+
+    rebuild();
+}
+
+void TempoMap::removeTempoPoint(int index) {
+    // The point at beat 0 defines the starting tempo and always stays
+    if (index > 0 && index < static_cast<int>(tempoPoints.size())) {
+        tempoPoints.erase(tempoPoints.begin() + index);
+        rebuild();
+    }
+}
+
+void TempoMap::setTimeSignature(int bar, int numerator, int denominator) {
+    const TimeSignaturePoint point{ juce::jmax(0, bar), juce::jmax(1, numerator),
+                                    juce::jmax(1, denominator), 0.0 };
+
+    auto it = std::lower_bound(timeSignatures.begin(), timeSignatures.end(), point.bar,
+        [](const TimeSignaturePoint& p, int b) { return p.bar < b; });
+
+    if (it != timeSignatures.end() && it->bar == point.bar) {
+        *it = point;
+    } else {
+        timeSignatures.insert(it, point);
+    }
+
+    rebuild();
+}
+
+void TempoMap::removeTimeSignature(int index) {
+    if (index > 0 && index < static_cast<int>(timeSignatures.size())) {
+        timeSignatures.erase(timeSignatures.begin() + index);
+        rebuild();
+    }
+}
+
+double TempoMap::beatToSeconds(double beat) const {
+    return segments[findSegmentForBeat(beat)].secondsAt(beat);
+}
+
+double TempoMap::secondsToBeat(double seconds) const {
+    return segments[findSegmentForSeconds(seconds)].beatAt(seconds);
+}
+
+int64_t TempoMap::beatToSamples(double beat, double sampleRate) const {
+    return static_cast<int64_t>(std::llround(beatToSeconds(beat) * sampleRate));
+}
+
+double TempoMap::samplesToBeat(int64_t samples, double sampleRate) const {
+    return secondsToBeat(static_cast<double>(samples) / sampleRate);
+}
+
+double TempoMap::getTempoAtBeat(double beat) const {
+    return segments[findSegmentForBeat(beat)].bpmAt(beat);
+}
+
+double TempoMap::getTempoAtTime(double seconds) const {
+    return getTempoAtBeat(secondsToBeat(seconds));
+}
+
+const TempoMap::TimeSignaturePoint& TempoMap::getTimeSignatureAtBeat(double beat) const {
+    auto it = std::upper_bound(timeSignatures.begin(), timeSignatures.end(), beat,
+        [](double b, const TimeSignaturePoint& p) { return b < p.beat; });
+    return it == timeSignatures.begin() ? timeSignatures.front() : *(it - 1);
+}
+
+TempoMap::BarBeat TempoMap::beatToBarBeat(double beat) const {
+    const auto& signature = getTimeSignatureAtBeat(beat);
+    const double beatLength = 4.0 / signature.denominator;
+    const double barLength = beatsPerBar(signature);
+
+    const double sinceSignature = juce::jmax(0.0, beat - signature.beat);
+    const double barsSince = std::floor(sinceSignature / barLength);
+    const double inBar = (sinceSignature - barsSince * barLength) / beatLength;
+
+    BarBeat result;
+    result.bar = signature.bar + static_cast<int>(barsSince) + 1;
+    result.beat = static_cast<int>(std::floor(inBar)) + 1;
+    result.fraction = inBar - std::floor(inBar);
+    return result;
+}
+
+double TempoMap::barToBeat(int bar) const {
+    auto it = std::upper_bound(timeSignatures.begin(), timeSignatures.end(), bar,
+        [](int b, const TimeSignaturePoint& p) { return b < p.bar; });
+    const auto& signature = it == timeSignatures.begin() ? timeSignatures.front() : *(it - 1);
+    return signature.beat + (bar - signature.bar) * beatsPerBar(signature);
+}
+
+double TempoMap::snapBeat(double beat, double gridBeats) const {
+    if (gridBeats <= 0.0) {
+        return beat;
+    }
+
+    // Snap relative to the bar so odd meters keep the grid on the downbeat
+    const auto& signature = getTimeSignatureAtBeat(beat);
+    return signature.beat + std::round((beat - signature.beat) / gridBeats) * gridBeats;
+}
+
+double TempoMap::snapTime(double seconds, double gridBeats) const {
+    return beatToSeconds(snapBeat(secondsToBeat(seconds), gridBeats));
+}
+
+juce::var TempoMap::toVar() const {
+    juce::Array<juce::var> tempos;
+    for (const auto& point : tempoPoints) {
+        auto obj = new juce::DynamicObject();
+        obj->setProperty("beat", point.beat);
+        obj->setProperty("bpm", point.bpm);
+        obj->setProperty("ramp", point.ramp);
+        tempos.add(juce::var(obj));
+    }
+
+    juce::Array<juce::var> signatures;
+    for (const auto& signature : timeSignatures) {
+        auto obj = new juce::DynamicObject();
+        obj->setProperty("bar", signature.bar);
+        obj->setProperty("numerator", signature.numerator);
+        obj->setProperty("denominator", signature.denominator);
+        signatures.add(juce::var(obj));
+    }
+
+    auto result = new juce::DynamicObject();
+    result->setProperty("tempos", tempos);
+    result->setProperty("timeSignatures", signatures);
+    return juce::var(result);
+}
+
+void TempoMap::fromVar(const juce::var& data) {
+    if (auto* tempos = data.getProperty("tempos", {}).getArray()) {
+        const double initialBpm = tempoPoints.front().bpm;
+        tempoPoints.clear();
+        tempoPoints.push_back({ 0.0, initialBpm, false });
+
+        for (const auto& point : *tempos) {
+            const TempoPoint loaded{ point.getProperty("beat", 0.0),
+                                     juce::jlimit(minBpm, maxBpm, static_cast<double>(point.getProperty("bpm", initialBpm))),
+                                     point.getProperty("ramp", false) };
+            if (loaded.beat <= 0.0) {
+                tempoPoints.front() = { 0.0, loaded.bpm, loaded.ramp };
+            } else {
+                tempoPoints.push_back(loaded);
+            }
+        }
+
+        std::stable_sort(tempoPoints.begin(), tempoPoints.end(),
+                         [](const TempoPoint& a, const TempoPoint& b) { return a.beat < b.beat; });
+    }
+
+    if (auto* signatures = data.getProperty("timeSignatures", {}).getArray()) {
+        const auto initial = timeSignatures.front();
+        timeSignatures.clear();
+        timeSignatures.push_back(initial);
+
+        for (const auto& signature : *signatures) {
+            const TimeSignaturePoint loaded{ juce::jmax(0, static_cast<int>(signature.getProperty("bar", 0))),
+                                             juce::jmax(1, static_cast<int>(signature.getProperty("numerator", 4))),
+                                             juce::jmax(1, static_cast<int>(signature.getProperty("denominator", 4))),
+                                             0.0 };
+            if (loaded.bar == 0) {
+                timeSignatures.front() = loaded;
+            } else {
+                timeSignatures.push_back(loaded);
+            }
+        }
+
+        std::stable_sort(timeSignatures.begin(), timeSignatures.end(),
+                         [](const TimeSignaturePoint& a, const TimeSignaturePoint& b) { return a.bar < b.bar; });
+    }
+
+    rebuild();
+}
+
+void TempoMap::rebuild() {
+    // Tempo segments: each point starts one, ramps end at the next point
+    segments.clear();
+    segments.reserve(tempoPoints.size());
+
+    double seconds = 0.0;
+    for (size_t i = 0; i < tempoPoints.size(); ++i) {
+        const auto& point = tempoPoints[i];
+
+        Segment segment{ point.beat, seconds, point.bpm, 0.0 };
+        if (i + 1 < tempoPoints.size()) {
+            const auto& next = tempoPoints[i + 1];
+            if (point.ramp && next.beat > point.beat) {
+                segment.slope = (next.bpm - point.bpm) / (next.beat - point.beat);
+            }
+            seconds = segment.secondsAt(next.beat);
+        }
+
+        segments.push_back(segment);
+    }
+
+    // Time signatures: derive each change's beat from the bars before it
+    for (size_t i = 1; i < timeSignatures.size(); ++i) {
+        const auto& previous = timeSignatures[i - 1];
+        timeSignatures[i].beat = previous.beat + (timeSignatures[i].bar - previous.bar) * beatsPerBar(previous);
+    }
+}
+
+size_t TempoMap::findSegmentForBeat(double beat) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), beat,
+        [](double b, const Segment& s) { return b < s.startBeat; });
+    return it == segments.begin() ? 0 : static_cast<size_t>(it - segments.begin() - 1);
+}
+
+size_t TempoMap::findSegmentForSeconds(double seconds) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), seconds,
+        [](double t, const Segment& s) { return t < s.startSeconds; });
+    return it == segments.begin() ? 0 : static_cast<size_t>(it - segments.begin() - 1);
+}
+
+double TempoMap::beatsPerBar(const TimeSignaturePoint& signature) {
+    return signature.numerator * 4.0 / signature.denominator;
+}
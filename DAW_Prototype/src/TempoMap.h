@@ -0,0 +1,120 @@
+#pragma once
+#include <JuceHeader.h>
+#include <vector>
+
+// Tempo and time-signature map.
+//
+// Musical time is measured in beats (quarter notes, i.e. PPQ position).
+// Tempo points may hold their tempo or ramp linearly (in beats) to the
+// next point. Edits rebuild a segment table with the start time of every
+// point, so beat <-> time conversion is a binary search plus a closed-form
+// evaluation. A Cursor remembers its segment and makes monotonic lookups
+// during playback O(1).
+//
+// Not thread-safe: edit on the message thread and hand the audio thread an
+// immutable copy (see RenderModel).
+class TempoMap {
+public:
+    struct TempoPoint {
+        double beat{0.0};
+        double bpm{120.0};
+        bool ramp{false};  // Ramp linearly to the next point's tempo
+    };
+
+    struct TimeSignaturePoint {
+        int bar{0};  // Zero-based
+        int numerator{4};
+        int denominator{4};
+        double beat{0.0};  // Derived from the bars before it
+    };
+
+    struct BarBeat {
+        int bar{1};  // One-based, as displayed
+        int beat{1};
+        double fraction{0.0};  // Position within the beat, 0..1
+    };
+
+    // Audio thread lookups that remember the last segment
+    class Cursor {
+    public:
+        Cursor() = default;
+        explicit Cursor(const TempoMap& map) : tempoMap(&map) {}
+
+        // Points the cursor at a (possibly new) map; cheap if unchanged
+        void setMap(const TempoMap* map);
+        bool isValid() const { return tempoMap != nullptr; }
+
+        double samplesToBeat(int64_t samples, double sampleRate);
+        int64_t beatToSamples(double beat, double sampleRate);
+        double getTempoAtBeat(double beat);
+
+    private:
+        const TempoMap* tempoMap{nullptr};
+        size_t segment{0};
+
+        void seekBeat(double beat);
+        void seekSeconds(double seconds);
+    };
+
+    // Constructor/Destructor
+    explicit TempoMap(double bpm = 120.0, int numerator = 4, int denominator = 4);
+    ~TempoMap() = default;
+
+    TempoMap(const TempoMap&) = default;
+    TempoMap& operator=(const TempoMap&) = default;
+
+    // Tempo editing
+    void setTempo(double bpm);  // Replaces the map with a constant tempo
+    void addTempoPoint(double beat, double bpm, bool ramp = false);
+    void removeTempoPoint(int index);
+    const std::vector<TempoPoint>& getTempoPoints() const { return tempoPoints; }
+
+    // Time signature editing
+    void setTimeSignature(int bar, int numerator, int denominator);
+    void removeTimeSignature(int index);
+    const std::vector<TimeSignaturePoint>& getTimeSignatures() const { return timeSignatures; }
+
+    // Conversion, O(log segments)
+    double beatToSeconds(double beat) const;
+    double secondsToBeat(double seconds) const;
+    int64_t beatToSamples(double beat, double sampleRate) const;
+    double samplesToBeat(int64_t samples, double sampleRate) const;
+    double getTempoAtBeat(double beat) const;
+    double getTempoAtTime(double seconds) const;
+
+    // Bars and beats
+    const TimeSignaturePoint& getTimeSignatureAtBeat(double beat) const;
+    BarBeat beatToBarBeat(double beat) const;
+    double barToBeat(int bar) const;
+
+    // Grid snapping; grid size is in beats
+    double snapBeat(double beat, double gridBeats) const;
+    double snapTime(double seconds, double gridBeats) const;
+
+    // Persistence
+    juce::var toVar() const;
+    void fromVar(const juce::var& data);
+
+private:
+    struct Segment {
+        double startBeat;
+        double startSeconds;
+        double startBpm;
+        double slope;  // bpm per beat, 0 for constant tempo
+
+        double secondsAt(double beat) const;
+        double beatAt(double seconds) const;
+        double bpmAt(double beat) const;
+    };
+
+    std::vector<TempoPoint> tempoPoints;
+    std::vector<TimeSignaturePoint> timeSignatures;
+    std::vector<Segment> segments;
+
+    void rebuild();
+    size_t findSegmentForBeat(double beat) const;
+    size_t findSegmentForSeconds(double seconds) const;
+    static double beatsPerBar(const TimeSignaturePoint& signature);
+
+    JUCE_LEAK_DETECTOR(TempoMap)
+};
@@ -1,4 +1,7 @@
 #include "Track.h"
+#include "PluginManager.h"
+#include "PluginLoader.h"
+#include "Mixer.h"
 #include "Logger.h"
 
 Track::Track(Type trackType)
@@ -9,6 +12,8 @@ Track::Track(Type trackType)
 }
 
 Track::~Track() {
+    PluginLoader::getInstance().cancel(*this);
+    delete pluginSnapshot.exchange(nullptr);
     LOG_INFO("Destroyed track: %s (%s)", name.toRawUTF8(), id.toRawUTF8());
 }
 
@@ -103,15 +108,26 @@ void Track::setOutputChannel(int channel) {
 }
 
 void Track::addPlugin(const juce::String& pluginID) {
-    auto plugin = std::make_unique<Plugin>(pluginID);
+    auto plugin = PluginManager::getInstance().createPlugin(*this, pluginID);
+    if (plugin == nullptr) {
+        LOG_ERROR("Could not create plugin %s on track %s", pluginID.toRawUTF8(), name.toRawUTF8());
+        return;
+    }
+    
+    // Ready to process before the audio thread can see it
+    plugin->prepareToPlay(sampleRate, blockSize);
     plugins.add(plugin.release());
+    publishPluginChain();
     notifyTrackChanged();
     LOG_INFO("Added plugin %s to track %s", pluginID.toRawUTF8(), name.toRawUTF8());
 }
 
 void Track::removePlugin(int index) {
     if (isPositiveAndBelow(index, plugins.size())) {
-        plugins.remove(index);
+        std::vector<std::unique_ptr<Plugin>> removed;
+        removed.emplace_back(plugins.removeAndReturn(index));
+        publishPluginChain();
+        retirePluginData(nullptr, std::move(removed));
         notifyTrackChanged();
         LOG_INFO("Removed plugin at index %d from track %s", index, name.toRawUTF8());
     }
@@ -121,6 +137,7 @@ void Track::movePlugin(int fromIndex, int toIndex) {
     if (isPositiveAndBelow(fromIndex, plugins.size()) &&
         isPositiveAndBelow(toIndex, plugins.size())) {
         plugins.move(fromIndex, toIndex);
+        publishPluginChain();
         notifyTrackChanged();
     }
 }
@@ -140,14 +157,31 @@ int Track::getNumPlugins() const {
     return plugins.size();
 }
 
+void Track::addLoadedPlugins(std::vector<std::unique_ptr<Plugin>> loaded) {
+    pendingPluginsState = juce::ValueTree();
+    
+    for (size_t i = 0; i < loaded.size(); ++i) {
+        // No-op unless the device changed while the chain was loading
+        loaded[i]->prepareToPlay(sampleRate, blockSize);
+        plugins.insert(static_cast<int>(i), loaded[i].release());
+    }
+    
+    publishPluginChain();
+    notifyTrackChanged();
+    LOG_INFO("Loaded %d plugins on track %s", static_cast<int>(loaded.size()), name.toRawUTF8());
+}
+
 void Track::addClip(std::unique_ptr<Clip> clip) {
-    clips.add(clip.release());
+    auto* added = clips.add(clip.release());
+    clipIndex.insert(added->getStartTime(), added->getStartTime() + added->getLength(), added);
     notifyTrackChanged();
     LOG_INFO("Added clip to track %s", name.toRawUTF8());
 }
 
 void Track::removeClip(Clip* clip) {
-    if (clips.removeObject(clip)) {
+    if (clips.contains(clip)) {
+        clipIndex.remove(clip);
+        clips.removeObject(clip);
         notifyTrackChanged();
         LOG_INFO("Removed clip from track %s", name.toRawUTF8());
     }
@@ -156,17 +190,55 @@ void Track::removeClip(Clip* clip) {
 void Track::moveClip(Clip* clip, double newStartTime) {
     if (clip != nullptr) {
         clip->setStartTime(newStartTime);
+        clipIndex.update(clip, newStartTime, newStartTime + clip->getLength());
         notifyTrackChanged();
     }
 }
 
-Clip* Track::getClipAt(double time) const {
+void Track::setActiveTake(const juce::String& takeGroup, int takeIndex) {
+    if (takeGroup.isEmpty()) {
+        return;
+    }
+    
+    // Takes share one file and only differ in metadata, so nothing reloads
     for (auto* clip : clips) {
-        if (clip->containsTime(time)) {
-            return clip;
+        if (clip->getTakeGroup() == takeGroup) {
+            clip->setMuted(clip->getTakeIndex() != takeIndex);
+        }
+    }
+    
+    notifyTrackChanged();
+}
+
+Clip* Track::getClipAt(double time) const {
+    Clip* clip = nullptr;
+    clipIndex.findAt(time, clip);
+    return clip;
+}
+
+std::vector<Clip*> Track::getClipsInRange(double startTime, double endTime) const {
+    return clipIndex.query(startTime, endTime);
+}
+
+void Track::publishPluginChain() {
+    auto snapshot = std::make_unique<const PluginChain>(plugins.begin(), plugins.end());
+    std::unique_ptr<const PluginChain> previous(
+        pluginSnapshot.exchange(snapshot.release(), std::memory_order_acq_rel));
+    
+    if (previous != nullptr) {
+        retirePluginData(std::move(previous), {});
+    }
+}
+
+void Track::retirePluginData(std::unique_ptr<const PluginChain> chain,
+                             std::vector<std::unique_ptr<Plugin>> removed) {
+    // Call once the published chain no longer holds the removed plugins
+    if (mixer != nullptr) {
+        mixer->getRenderModels().retire(std::move(chain));
+        if (!removed.empty()) {
+            mixer->retireTrackPlugins(std::move(removed));
         }
     }
-    return nullptr;
 }
 
 void Track::addAutomation(const juce::String& paramID) {
@@ -254,7 +326,8 @@ void Track::prepareToPlay(double newSampleRate, int maximumExpectedSamplesPerBlo
 }
 
 void Track::processBlock(juce::AudioBuffer<float>& buffer,
-                        juce::MidiBuffer& midiMessages) {
+                        juce::MidiBuffer& midiMessages,
+                        int maxPluginLatency) {
     if (parameters.mute || (frozen && type != Type::Master)) {
         buffer.clear();
         midiMessages.clear();
@@ -275,13 +348,31 @@ void Track::processBlock(juce::AudioBuffer<float>& buffer,
     }
     
     // Process through plugins
-    for (auto* plugin : plugins) {
-        if (!plugin->isBypassed()) {
+    const auto* chain = getPluginChainSnapshot();
+    if (chain == nullptr) {
+        return;
+    }
+    
+    for (auto* plugin : *chain) {
+        if (!plugin->isBypassed() &&
+            (maxPluginLatency < 0 || plugin->getLatencySamples() <= maxPluginLatency)) {
             plugin->processBlock(buffer, midiMessages);
         }
     }
 }
 
+int Track::getPluginLatencySamples(int maxPluginLatency) const {
+    int latency = 0;
+    for (auto* plugin : plugins) {
+        const int pluginLatency = plugin->getLatencySamples();
+        if (!plugin->isBypassed() &&
+            (maxPluginLatency < 0 || pluginLatency <= maxPluginLatency)) {
+            latency += pluginLatency;
+        }
+    }
+    return latency;
+}
+
 void Track::releaseResources() {
     for (auto* plugin : plugins) {
         plugin->releaseResources();
@@ -329,11 +420,14 @@ void Track::saveState(juce::ValueTree& state) const {
     paramsState.setProperty("outputBus", parameters.output.bus, nullptr);
     paramsState.setProperty("outputChannel", parameters.output.channel, nullptr);
     
-    // Save plugins
+    // Save plugins, including any still loading (they come first)
     auto pluginsState = state.getOrCreateChildWithName("plugins", nullptr);
+    for (auto pendingState : pendingPluginsState) {
+        pluginsState.addChild(pendingState.createCopy(), -1, nullptr);
+    }
     for (auto* plugin : plugins) {
         auto pluginState = juce::ValueTree("plugin");
-        plugin->saveState(pluginState);
+        PluginUtils::savePluginState(*plugin, pluginState);
         pluginsState.addChild(pluginState, -1, nullptr);
     }
     
@@ -379,27 +473,37 @@ void Track::restoreState(const juce::ValueTree& state) {
         parameters.output.channel = paramsState.getProperty("outputChannel", 1);
     }
     
-    // Restore plugins
-    plugins.clear();
-    if (auto pluginsState = state.getChildWithName("plugins")) {
-        for (auto pluginState : pluginsState) {
-            if (auto plugin = std::make_unique<Plugin>("")) {
-                plugin->restoreState(pluginState);
-                plugins.add(plugin.release());
-            }
-        }
+    // Restore plugins. The old chain is retired once an empty one is
+    // published; the new one is created and restored in the background and
+    // swapped in once it is ready.
+    PluginLoader::getInstance().cancel(*this);
+    std::vector<std::unique_ptr<Plugin>> removedPlugins;
+    while (!plugins.isEmpty()) {
+        removedPlugins.emplace_back(plugins.removeAndReturn(plugins.size() - 1));
+    }
+    publishPluginChain();
+    retirePluginData(nullptr, std::move(removedPlugins));
+    
+    pendingPluginsState = juce::ValueTree();
+    auto pluginsState = state.getChildWithName("plugins");
+    if (pluginsState.isValid() && pluginsState.getNumChildren() > 0) {
+        pendingPluginsState = pluginsState.createCopy();
+        PluginLoader::getInstance().loadChain(*this, pendingPluginsState);
     }
     
     // Restore clips
     clips.clear();
+    clipIndex.clear();
     if (auto clipsState = state.getChildWithName("clips")) {
         for (auto clipState : clipsState) {
             if (auto clip = std::make_unique<Clip>()) {
                 clip->restoreState(clipState);
+                clipIndex.add(clip->getStartTime(), clip->getStartTime() + clip->getLength(), clip.get());
                 clips.add(clip.release());
             }
         }
     }
+    clipIndex.build();
     
     // Restore automation
     automation.clear();
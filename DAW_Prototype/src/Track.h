@@ -1,10 +1,17 @@
 #pragma once
 #include <JuceHeader.h>
+#include <atomic>
 #include "Plugin.h"
 #include "Clip.h"
+#include "IntervalIndex.h"
+
+class Mixer;
 
 class Track : public juce::ChangeBroadcaster {
 public:
+    using ClipIndex = IntervalIndex<Clip*>;
+    using PluginChain = std::vector<Plugin*>;
+
     enum class Type {
         Audio,
         MIDI,
@@ -65,13 +72,29 @@ public:
     Plugin* getPlugin(int index) const;
     int getNumPlugins() const;
     const juce::OwnedArray<Plugin>& getPlugins() const { return plugins; }
+    
+    // Chain loaded in the background (see PluginLoader); goes in front of
+    // any plugin added while it was loading
+    void addLoadedPlugins(std::vector<std::unique_ptr<Plugin>> loaded);
+    bool isLoadingPlugins() const { return pendingPluginsState.isValid(); }
 
     // Clip management
     void addClip(std::unique_ptr<Clip> clip);
     void removeClip(Clip* clip);
     void moveClip(Clip* clip, double newStartTime);
     Clip* getClipAt(double time) const;
+    std::vector<Clip*> getClipsInRange(double startTime, double endTime) const;
     const juce::OwnedArray<Clip>& getClips() const { return clips; }
+    
+    // Take lanes: unmutes one take of a group and mutes the others
+    void setActiveTake(const juce::String& takeGroup, int takeIndex);
+    
+    // Plugin chain for the audio thread. Never blocks; read it inside a
+    // RenderModelExchange::ScopedRead of the track's mixer, which keeps the
+    // pointer and the plugins it references alive.
+    const PluginChain* getPluginChainSnapshot() const noexcept {
+        return pluginSnapshot.load(std::memory_order_acquire);
+    }
 
     // Automation
     void addAutomation(const juce::String& paramID);
@@ -80,10 +103,22 @@ public:
     void setAutomationValue(const juce::String& paramID, double time, float value);
     float getAutomationValue(const juce::String& paramID, double time) const;
 
-    // Processing
+    // The mixer rendering this track. Removed plugins and superseded chain
+    // snapshots are retired through it; without one nothing renders the
+    // track and they are deleted at once.
+    void setMixer(Mixer* newMixer) { mixer = newMixer; }
+
+    // Processing. processBlock() takes any buffer length up to the
+    // prepared maximum.
     void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock);
+    double getSampleRate() const { return sampleRate; }
+    int getBlockSize() const { return blockSize; }  // Maximum, not every block's length
+    // Plugins reporting more than maxPluginLatency samples are skipped
+    // (low-latency monitoring); -1 runs the whole chain
     void processBlock(juce::AudioBuffer<float>& buffer,
-                     juce::MidiBuffer& midiMessages);
+                     juce::MidiBuffer& midiMessages,
+                     int maxPluginLatency = -1);
+    int getPluginLatencySamples(int maxPluginLatency = -1) const;
     void releaseResources();
 
     // State management
@@ -105,6 +140,16 @@ private:
     juce::OwnedArray<Plugin> plugins;
     juce::OwnedArray<Clip> clips;
     
+    // Plugin chain: edited on the message thread, published as snapshots
+    std::atomic<const PluginChain*> pluginSnapshot{nullptr};
+    juce::ValueTree pendingPluginsState;  // Saved state of a chain still loading
+    
+    // Clip index, for message-thread queries. Nothing on the audio thread
+    // reads clips yet, so it is not published.
+    ClipIndex clipIndex;
+    
+    Mixer* mixer{nullptr};
+    
     struct AutomationData {
         juce::Array<double> times;
         juce::Array<float> values;
@@ -122,6 +167,9 @@ private:
     void generateID();
     void updateAutomation(double time);
     void notifyTrackChanged();
+    void publishPluginChain();
+    void retirePluginData(std::unique_ptr<const PluginChain> chain,
+                          std::vector<std::unique_ptr<Plugin>> removed);
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Track)
 };
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "Clip.h"
 #include "Logger.h"
 #include "CustomLookAndFeel.h"
+#include "WaveformCache.h"
 
 //==============================================================================
 // TrackHeader Implementation
@@ -154,6 +155,92 @@ void TrackEditorComponent::TrackHeader::handleHeightChange() {
     auto params = track.getParameters();
     params.height = static_cast<int>(heightSlider.getValue());
     track.setParameters(params);
+    owner.updateLayout();
+}
+
+//==============================================================================
+// ClipComponent Implementation
+//==============================================================================
+
+TrackEditorComponent::ClipComponent::ClipComponent(Clip& clip)
+    : clip(clip) {
+    setInterceptsMouseClicks(false, false);
+    clip.addChangeListener(this);
+    
+    if (clip.getType() == Clip::Type::Audio) {
+        WaveformCache::getInstance().addChangeListener(this);
+    }
+}
+
+TrackEditorComponent::ClipComponent::~ClipComponent() {
+    WaveformCache::getInstance().removeChangeListener(this);
+    clip.removeChangeListener(this);
+}
+
+void TrackEditorComponent::ClipComponent::paint(juce::Graphics& g) {
+    auto& lf = dynamic_cast<CustomLookAndFeel&>(getLookAndFeel());
+    auto bounds = getLocalBounds();
+    
+    // Draw background
+    g.setColour(selected ? lf.getSelectedClipBackground() : lf.getClipBackground());
+    g.fillRect(bounds);
+    
+    // Draw name bar
+    auto nameArea = bounds.removeFromTop(14);
+    g.setColour(clip.getColor());
+    g.fillRect(nameArea);
+    g.setColour(clip.getColor().contrasting());
+    g.setFont(juce::Font(11.0f));
+    g.drawText(clip.getName(), nameArea.reduced(3, 0), juce::Justification::centredLeft, true);
+    
+    // Draw waveform
+    if (clip.getType() == Clip::Type::Audio) {
+        paintWaveform(g, bounds);
+    }
+    
+    // Draw border
+    g.setColour(selected ? lf.getSelectedClipBorder() : lf.getClipBorder());
+    g.drawRect(getLocalBounds());
+}
+
+void TrackEditorComponent::ClipComponent::changeListenerCallback(juce::ChangeBroadcaster* source) {
+    repaint();
+}
+
+void TrackEditorComponent::ClipComponent::setSelected(bool shouldBeSelected) {
+    if (selected != shouldBeSelected) {
+        selected = shouldBeSelected;
+        repaint();
+    }
+}
+
+void TrackEditorComponent::ClipComponent::paintWaveform(juce::Graphics& g, juce::Rectangle<int> area) {
+    auto state = WaveformCache::State::Building;
+    auto peaks = WaveformCache::getInstance().getPeaks(clip.getAudioFile(), &state);
+    
+    if (peaks == nullptr) {
+        g.setColour(clip.getColor().withAlpha(0.6f));
+        g.setFont(juce::Font(11.0f));
+        g.drawText(state == WaveformCache::State::Failed ? "Overview unavailable" : "Building overview...",
+                   area, juce::Justification::centred, true);
+        return;
+    }
+    
+    if (clip.getLength() <= 0.0 || getWidth() <= 0 || peaks->getNumChannels() == 0) {
+        return;
+    }
+    
+    // Resolution follows the zoom level, so only the matching pyramid level
+    // and the columns inside the clip region are read
+    const double samplesPerPixel = clip.getLength() * peaks->getSampleRate() / getWidth();
+    const double startSample = clip.getOffset() * peaks->getSampleRate();
+    const int laneHeight = area.getHeight() / peaks->getNumChannels();
+    
+    for (int channel = 0; channel < peaks->getNumChannels(); ++channel) {
+        const auto lane = area.removeFromTop(laneHeight);
+        WaveformCacheUtils::drawChannel(g, *peaks, channel, lane, startSample, samplesPerPixel,
+                                        clip.getColor(), clip.getColor().brighter(0.4f));
+    }
 }
 
 //==============================================================================
@@ -178,12 +265,40 @@ void TrackEditorComponent::TrackContent::paint(juce::Graphics& g) {
     // Draw background
     g.fillAll(lf.getTrackContentBackground());
     
-    // Draw grid
+    // Draw grid, only inside the repaint region and never denser than
+    // one line every few pixels
     g.setColour(lf.getTrackContentGrid());
-    const double gridInterval = 1.0;  // 1 second
-    for (double t = timeStart; t <= timeEnd; t += gridInterval) {
-        const int x = static_cast<int>(timeToX(t));
-        g.drawVerticalLine(x, 0.0f, static_cast<float>(getHeight()));
+    const auto area = g.getClipBounds();
+    const double firstTime = juce::jmax(timeStart, xToTime(area.getX()));
+    const double lastTime = juce::jmin(timeEnd, xToTime(area.getRight()));
+    
+    if (auto* project = owner.getProject()) {
+        // Musical grid: lines on beats from the tempo map, so they follow
+        // tempo changes and ramps
+        const auto& tempoMap = project->getTempoMap();
+        const double pixelsPerBeat = pixelsPerSecond * 60.0 / tempoMap.getTempoAtTime(firstTime);
+        double gridBeats = project->getTransportState().gridSize > 0.0 ?
+            project->getTransportState().gridSize : 1.0;
+        while (gridBeats * pixelsPerBeat < 8.0) {
+            gridBeats *= 2.0;
+        }
+        
+        for (double beat = std::ceil(tempoMap.secondsToBeat(firstTime) / gridBeats) * gridBeats;; beat += gridBeats) {
+            const double t = tempoMap.beatToSeconds(beat);
+            if (t > lastTime) {
+                break;
+            }
+            g.drawVerticalLine(static_cast<int>(timeToX(t)), 0.0f, static_cast<float>(getHeight()));
+        }
+    } else {
+        double gridInterval = 1.0;  // 1 second
+        while (gridInterval * pixelsPerSecond < 8.0) {
+            gridInterval *= 2.0;
+        }
+        
+        for (double t = std::ceil(firstTime / gridInterval) * gridInterval; t <= lastTime; t += gridInterval) {
+            g.drawVerticalLine(static_cast<int>(timeToX(t)), 0.0f, static_cast<float>(getHeight()));
+        }
     }
 }
 
@@ -197,19 +312,35 @@ void TrackEditorComponent::TrackContent::mouseDown(const juce::MouseEvent& e) {
         if (draggedClipIndex >= 0) {
             dragging = true;
             dragStartTime = xToTime(e.x);
+            dragClipStartTime = track.getClips()[draggedClipIndex]->getStartTime();
             selectClip(draggedClipIndex, !e.mods.isShiftDown());
         } else {
-            owner.selectTrack(&track, !e.mods.isShiftDown());
+            owner.selectTrack(owner.getTrackIndexAt(getY()), !e.mods.isShiftDown());
         }
     }
 }
 
 void TrackEditorComponent::TrackContent::mouseDrag(const juce::MouseEvent& e) {
     if (dragging && draggedClipIndex >= 0) {
-        const double dragTime = xToTime(e.x);
-        const double timeDelta = dragTime - dragStartTime;
+        auto* clip = track.getClips()[draggedClipIndex];
+        if (clip == nullptr) {
+            return;
+        }
         
-        // TODO: Update clip position
+        const double timeDelta = xToTime(e.x) - dragStartTime;
+        double newStartTime = juce::jmax(0.0, dragClipStartTime + timeDelta);
+        
+        // Snap to the musical grid in beats, wherever the tempo map puts them
+        if (auto* project = owner.getProject()) {
+            const auto& transportState = project->getTransportState();
+            if (transportState.snapToGrid && !e.mods.isAltDown()) {
+                newStartTime = juce::jmax(0.0, project->getTempoMap().snapTime(newStartTime, transportState.gridSize));
+            }
+        }
+        
+        if (newStartTime != clip->getStartTime()) {
+            track.moveClip(clip, newStartTime);
+        }
         updateClipPositions();
     }
 }
@@ -253,17 +384,81 @@ void TrackEditorComponent::TrackContent::updateFromTrack() {
 }
 
 void TrackEditorComponent::TrackContent::setTimeRange(double start, double end) {
+    const double newPixelsPerSecond = getWidth() / (end - start);
+    if (start == timeStart && end == timeEnd && newPixelsPerSecond == pixelsPerSecond) {
+        return;
+    }
+    
     timeStart = start;
     timeEnd = end;
-    pixelsPerSecond = getWidth() / (timeEnd - timeStart);
+    pixelsPerSecond = newPixelsPerSecond;
     updateClipPositions();
     repaint();
 }
 
+void TrackEditorComponent::TrackContent::setVisibleTimeRange(double start, double end) {
+    if (start == visibleStart && end == visibleEnd) {
+        return;
+    }
+    
+    visibleStart = start;
+    visibleEnd = end;
+    updateVisibleClips();
+}
+
 void TrackEditorComponent::TrackContent::createClipViews() {
     clipViews.clear();
+    clipIndex.clear();
+    
+    const auto& clips = track.getClips();
+    for (int i = 0; i < clips.size(); ++i) {
+        clipIndex.add(clips[i]->getStartTime(), clips[i]->getStartTime() + clips[i]->getLength(), i);
+    }
+    clipIndex.build();
     
-    // TODO: Create clip views based on track type
+    // Drop selections of clips that no longer exist
+    selectedClips.erase(selectedClips.lower_bound(clips.size()), selectedClips.end());
+    
+    updateVisibleClips();
+}
+
+void TrackEditorComponent::TrackContent::updateVisibleClips() {
+    auto visible = clipIndex.query(visibleStart, visibleEnd);
+    std::sort(visible.begin(), visible.end());
+    
+    // Release views that scrolled out
+    clipViews.erase(std::remove_if(clipViews.begin(), clipViews.end(),
+        [&visible](const ClipView& view) {
+            return !std::binary_search(visible.begin(), visible.end(), view.clipIndex);
+        }), clipViews.end());
+    
+    std::vector<int> existing;
+    existing.reserve(clipViews.size());
+    for (const auto& view : clipViews) {
+        existing.push_back(view.clipIndex);
+    }
+    std::sort(existing.begin(), existing.end());
+    
+    // Create views that scrolled in
+    const auto& clips = track.getClips();
+    for (int index : visible) {
+        if (std::binary_search(existing.begin(), existing.end(), index)) {
+            continue;
+        }
+        
+        auto* clip = clips[index];
+        ClipView view;
+        view.component = std::make_unique<ClipComponent>(*clip);
+        view.component->setSelected(selectedClips.count(index) > 0);
+        view.clipIndex = index;
+        view.startTime = clip->getStartTime();
+        view.endTime = clip->getStartTime() + clip->getLength();
+        
+        addAndMakeVisible(view.component.get());
+        clipViews.push_back(std::move(view));
+    }
+    
+    updateClipPositions();
 }
 
 void TrackEditorComponent::TrackContent::updateClipPositions() {
@@ -283,23 +478,25 @@ double TrackEditorComponent::TrackContent::xToTime(int x) const {
 }
 
 int TrackEditorComponent::TrackContent::findClipAt(juce::Point<int> position) const {
-    for (int i = static_cast<int>(clipViews.size()) - 1; i >= 0; --i) {
-        if (clipViews[i].component->getBounds().contains(position)) {
-            return i;
-        }
+    int index = -1;
+    if (position.y >= 0 && position.y < getHeight() &&
+        clipIndex.findAt(xToTime(position.x), index)) {
+        return index;
     }
     return -1;
 }
 
 void TrackEditorComponent::TrackContent::selectClip(int index, bool deselectOthers) {
     if (deselectOthers) {
-        for (auto& clipView : clipViews) {
-            clipView.selected = false;
-        }
+        selectedClips.clear();
+    }
+    
+    if (index >= 0 && index < track.getClips().size()) {
+        selectedClips.insert(index);
     }
     
-    if (index >= 0 && index < clipViews.size()) {
-        clipViews[index].selected = true;
+    for (auto& clipView : clipViews) {
+        clipView.component->setSelected(selectedClips.count(clipView.clipIndex) > 0);
     }
     
     repaint();
@@ -323,6 +520,7 @@ TrackEditorComponent::TrackEditorComponent() {
     // Synchronize vertical scrolling
     headerViewport.getVerticalScrollBar().addListener(this);
     contentViewport.getVerticalScrollBar().addListener(this);
+    contentViewport.getHorizontalScrollBar().addListener(this);
 }
 
 TrackEditorComponent::~TrackEditorComponent() {
@@ -404,13 +602,11 @@ void TrackEditorComponent::moveTrack(int fromIndex, int toIndex) {
 
 void TrackEditorComponent::selectTrack(int index, bool deselectOthers) {
     if (deselectOthers) {
-        for (auto& trackView : trackViews) {
-            trackView.selected = false;
-        }
+        std::fill(trackSelection.begin(), trackSelection.end(), false);
     }
     
-    if (index >= 0 && index < trackViews.size()) {
-        trackViews[index].selected = true;
+    if (index >= 0 && index < trackSelection.size()) {
+        trackSelection[index] = true;
     }
     
     repaint();
@@ -421,10 +617,8 @@ void TrackEditorComponent::selectClip(Track* track, int clipIndex, bool deselect
 }
 
 void TrackEditorComponent::clearSelection() {
-    for (auto& trackView : trackViews) {
-        trackView.selected = false;
-        // TODO: Clear clip selection
-    }
+    std::fill(trackSelection.begin(), trackSelection.end(), false);
+    // TODO: Clear clip selection
     repaint();
 }
 
@@ -455,28 +649,21 @@ void TrackEditorComponent::hideAutomation() {
 void TrackEditorComponent::updateTrackViews() {
     if (currentProject == nullptr) {
         trackViews.clear();
+        trackSelection.clear();
         updateLayout();
         return;
     }
 
     const auto& tracks = currentProject->getTracks();
     
-    // Add/remove track views
-    while (trackViews.size() < tracks.size()) {
-        TrackView view;
-        view.header = std::make_unique<TrackHeader>(*this, *tracks[trackViews.size()]);
-        view.content = std::make_unique<TrackContent>(*this, *tracks[trackViews.size()]);
-        view.selected = false;
-        
-        headerContainer.addAndMakeVisible(view.header.get());
-        contentContainer.addAndMakeVisible(view.content.get());
-        
-        trackViews.push_back(std::move(view));
-    }
+    // Drop views whose track was removed or moved; they are recreated on
+    // demand by updateVisibleTracks()
+    trackViews.erase(std::remove_if(trackViews.begin(), trackViews.end(),
+        [&tracks](const TrackView& view) {
+            return view.trackIndex >= tracks.size() || tracks[view.trackIndex] != view.track;
+        }), trackViews.end());
     
-    while (trackViews.size() > tracks.size()) {
-        trackViews.pop_back();
-    }
+    trackSelection.resize(tracks.size(), false);
     
     updateLayout();
 }
@@ -485,19 +672,111 @@ void TrackEditorComponent::updateTimeRange() {
     for (auto& trackView : trackViews) {
         trackView.content->setTimeRange(timeStart, timeEnd);
     }
+    
+    updateVisibleTracks();
 }
 
 void TrackEditorComponent::updateLayout() {
+    const int numTracks = currentProject != nullptr ? currentProject->getTracks().size() : 0;
+    
+    // Track offsets are cheap to recompute; components are not
+    trackOffsets.resize(static_cast<size_t>(numTracks + 1));
     int y = 0;
     
-    for (auto& trackView : trackViews) {
-        const int height = trackView.header->getHeight();
-        trackView.header->setBounds(0, y, headerWidth, height);
-        trackView.content->setBounds(0, y, contentContainer.getWidth(), height);
-        y += height;
+    for (int i = 0; i < numTracks; ++i) {
+        trackOffsets[static_cast<size_t>(i)] = y;
+        y += getTrackHeight(i);
     }
+    trackOffsets[static_cast<size_t>(numTracks)] = y;
     
     headerContainer.setSize(headerWidth, y);
     contentContainer.setSize(
         static_cast<int>((timeEnd - timeStart) * pixelsPerSecond), y);
-}
\ No newline at end of file
+    
+    updateVisibleTracks();
+}
+
+void TrackEditorComponent::updateVisibleTracks() {
+    const int numTracks = static_cast<int>(trackOffsets.size()) - 1;
+    
+    if (currentProject == nullptr || numTracks <= 0) {
+        trackViews.clear();
+        return;
+    }
+    
+    const auto& tracks = currentProject->getTracks();
+    const auto viewArea = contentViewport.getViewArea();
+    const int first = getTrackIndexAt(viewArea.getY() - overscanPixels);
+    const int last = getTrackIndexAt(viewArea.getBottom() + overscanPixels);
+    
+    // Release views that scrolled out
+    trackViews.erase(std::remove_if(trackViews.begin(), trackViews.end(),
+        [first, last](const TrackView& view) {
+            return view.trackIndex < first || view.trackIndex > last;
+        }), trackViews.end());
+    
+    const double visibleStart = timeStart + (viewArea.getX() - overscanPixels) / pixelsPerSecond;
+    const double visibleEnd = timeStart + (viewArea.getRight() + overscanPixels) / pixelsPerSecond;
+    
+    for (int i = first; i <= last; ++i) {
+        auto it = std::find_if(trackViews.begin(), trackViews.end(),
+            [i](const TrackView& view) { return view.trackIndex == i; });
+        
+        if (it == trackViews.end()) {
+            TrackView view;
+            view.track = tracks[i];
+            view.trackIndex = i;
+            view.header = std::make_unique<TrackHeader>(*this, *tracks[i]);
+            view.content = std::make_unique<TrackContent>(*this, *tracks[i]);
+            
+            headerContainer.addAndMakeVisible(view.header.get());
+            contentContainer.addAndMakeVisible(view.content.get());
+            
+            trackViews.push_back(std::move(view));
+            it = std::prev(trackViews.end());
+        }
+        
+        const int y = getTrackY(i);
+        const int height = getTrackHeight(i);
+        it->header->setBounds(0, y, headerWidth, height);
+        it->content->setBounds(0, y, contentContainer.getWidth(), height);
+        it->content->setTimeRange(timeStart, timeEnd);
+        it->content->setVisibleTimeRange(visibleStart, visibleEnd);
+    }
+}
+
+int TrackEditorComponent::getTrackY(int index) const {
+    return juce::isPositiveAndBelow(index, static_cast<int>(trackOffsets.size()))
+        ? trackOffsets[static_cast<size_t>(index)] : 0;
+}
+
+int TrackEditorComponent::getTrackHeight(int index) const {
+    if (currentProject == nullptr || !juce::isPositiveAndBelow(index, currentProject->getTracks().size())) {
+        return minTrackHeight;
+    }
+    
+    return juce::jmax(minTrackHeight, currentProject->getTracks()[index]->getParameters().height);
+}
+
+int TrackEditorComponent::getTrackIndexAt(int y) const {
+    if (trackOffsets.size() < 2) {
+        return -1;
+    }
+    
+    // Binary search over the track tops
+    const auto it = std::upper_bound(trackOffsets.begin(), trackOffsets.end() - 1, y);
+    return juce::jlimit(0, static_cast<int>(trackOffsets.size()) - 2,
+                        static_cast<int>(it - trackOffsets.begin()) - 1);
+}
+
+void TrackEditorComponent::scrollBarMoved(juce::ScrollBar* scrollBar, double newRangeStart) {
+    // Keep headers and content vertically in sync
+    if (scrollBar == &contentViewport.getVerticalScrollBar()) {
+        headerViewport.setViewPosition(0, contentViewport.getViewPositionY());
+    } else if (scrollBar == &headerViewport.getVerticalScrollBar()) {
+        contentViewport.setViewPosition(contentViewport.getViewPositionX(),
+                                        headerViewport.getViewPositionY());
+    }
+    
+    updateVisibleTracks();
+}
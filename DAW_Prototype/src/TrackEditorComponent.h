@@ -1,12 +1,15 @@
 #pragma once
 #include <JuceHeader.h>
+#include <set>
 #include "Track.h"
+#include "IntervalIndex.h"
 
 class Project;
 class Clip;
 
 class TrackEditorComponent : public juce::Component,
-                           public juce::ChangeListener {
+                           public juce::ChangeListener,
+                           private juce::ScrollBar::Listener {
 public:
     // Track header component
     class TrackHeader : public juce::Component,
@@ -43,6 +46,28 @@ public:
         JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackHeader)
     };
 
+    // Clip component. Mouse handling is left to the owning TrackContent.
+    class ClipComponent : public juce::Component,
+                         public juce::ChangeListener {
+    public:
+        explicit ClipComponent(Clip& clip);
+        ~ClipComponent() override;
+        
+        void paint(juce::Graphics& g) override;
+        void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+        
+        Clip& getClip() const { return clip; }
+        void setSelected(bool shouldBeSelected);
+        
+    private:
+        Clip& clip;
+        bool selected{false};
+        
+        void paintWaveform(juce::Graphics& g, juce::Rectangle<int> area);
+        
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ClipComponent)
+    };
+
     // Track content component
     class TrackContent : public juce::Component,
                         public juce::ChangeListener,
@@ -68,6 +93,9 @@ public:
         void updateFromTrack();
         void setTimeRange(double start, double end);
         
+        // Only clips overlapping this range get a component
+        void setVisibleTimeRange(double start, double end);
+        
     private:
         TrackEditorComponent& owner;
         Track& track;
@@ -76,19 +104,27 @@ public:
         double timeEnd{60.0};
         double pixelsPerSecond{100.0};
         
+        double visibleStart{0.0};
+        double visibleEnd{60.0};
+        
         bool dragging{false};
         double dragStartTime{0.0};
+        double dragClipStartTime{0.0};
         int draggedClipIndex{-1};
         
+        // Views exist only for visible clips; indices refer to track.getClips()
         struct ClipView {
-            std::unique_ptr<juce::Component> component;
+            std::unique_ptr<ClipComponent> component;
+            int clipIndex;
             double startTime;
             double endTime;
-            bool selected;
         };
         std::vector<ClipView> clipViews;
+        IntervalIndex<int> clipIndex;
+        std::set<int> selectedClips;
         
         void createClipViews();
+        void updateVisibleClips();
         void updateClipPositions();
         double timeToX(double time) const;
         double xToTime(int x) const;
@@ -109,6 +145,11 @@ public:
     
     // ChangeListener interface
     void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    
+    // Track layout
+    int getTrackY(int index) const;
+    int getTrackHeight(int index) const;
+    int getTrackIndexAt(int y) const;
 
     // Project handling
     void setProject(Project* project);
@@ -143,12 +184,16 @@ public:
 private:
     Project* currentProject{nullptr};
     
+    // Views exist only for tracks inside the viewport (plus overscan)
     struct TrackView {
+        Track* track{nullptr};
+        int trackIndex{-1};
         std::unique_ptr<TrackHeader> header;
         std::unique_ptr<TrackContent> content;
-        bool selected;
     };
     std::vector<TrackView> trackViews;
+    std::vector<int> trackOffsets;      // Top of each track, plus total height
+    std::vector<bool> trackSelection;
     
     juce::Viewport headerViewport;
     juce::Viewport contentViewport;
@@ -164,9 +209,14 @@ private:
     void updateTrackViews();
     void updateTimeRange();
     void updateLayout();
+    void updateVisibleTracks();
+    
+    // ScrollBar::Listener interface
+    void scrollBarMoved(juce::ScrollBar* scrollBar, double newRangeStart) override;
     
     static constexpr int headerWidth = 200;
     static constexpr int minTrackHeight = 60;
+    static constexpr int overscanPixels = 200;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TrackEditorComponent)
 };
\ No newline at end of file
@@ -0,0 +1,372 @@
+#include "Transport.h"
+#include "Logger.h"
+
+//==============================================================================
+// Transport Implementation
+//==============================================================================
+
+Transport::Transport() {
+    publishState();
+}
+
+bool Transport::play() {
+    Command command;
+    command.type = CommandType::Play;
+    return pushCommand(command);
+}
+
+bool Transport::playWithCountIn(int64_t countInSamples) {
+    Command command;
+    command.type = CommandType::PlayWithCountIn;
+    command.first = std::max<int64_t>(0, countInSamples);
+    return pushCommand(command);
+}
+
+bool Transport::stop() {
+    Command command;
+    command.type = CommandType::Stop;
+    return pushCommand(command);
+}
+
+bool Transport::setRecording(bool shouldRecord) {
+    Command command;
+    command.type = CommandType::SetRecording;
+    command.flag = shouldRecord;
+    return pushCommand(command);
+}
+
+bool Transport::locate(int64_t samplePosition) {
+    Command command;
+    command.type = CommandType::Locate;
+    command.first = std::max<int64_t>(0, samplePosition);
+    return pushCommand(command);
+}
+
+bool Transport::setLoopRange(int64_t startSample, int64_t endSample) {
+    Command command;
+    command.type = CommandType::SetLoopRange;
+    command.first = std::max<int64_t>(0, std::min(startSample, endSample));
+    command.second = std::max<int64_t>(0, std::max(startSample, endSample));
+    return pushCommand(command);
+}
+
+bool Transport::setLooping(bool shouldLoop) {
+    Command command;
+    command.type = CommandType::SetLooping;
+    command.flag = shouldLoop;
+    return pushCommand(command);
+}
+
+bool Transport::setPunchRange(int64_t punchInSample, int64_t punchOutSample) {
+    Command command;
+    command.type = CommandType::SetPunchRange;
+    command.first = std::max<int64_t>(0, punchInSample);
+    command.second = std::max<int64_t>(0, punchOutSample);
+    return pushCommand(command);
+}
+
+bool Transport::setPunchEnabled(bool punchIn, bool punchOut) {
+    Command command;
+    command.type = CommandType::SetPunchEnabled;
+    command.flag = punchIn;
+    command.secondFlag = punchOut;
+    return pushCommand(command);
+}
+
+bool Transport::setAutoStop(int64_t samplePosition) {
+    Command command;
+    command.type = CommandType::SetAutoStop;
+    command.first = samplePosition;
+    return pushCommand(command);
+}
+
+bool Transport::setTempo(double bpm, int64_t atSample) {
+    if (bpm <= 0.0) {
+        return false;
+    }
+
+    Command command;
+    command.type = CommandType::SetTempo;
+    command.value = bpm;
+    command.first = atSample;
+    return pushCommand(command);
+}
+
+bool Transport::setTimeSignature(int numerator, int denominator) {
+    if (numerator <= 0 || denominator <= 0) {
+        return false;
+    }
+
+    Command command;
+    command.type = CommandType::SetTimeSignature;
+    command.first = numerator;
+    command.second = denominator;
+    return pushCommand(command);
+}
+
+double Transport::getPositionInSeconds() const {
+    return static_cast<double>(getPosition()) / getSampleRate();
+}
+
+void Transport::prepare(double newSampleRate) {
+    const double oldSampleRate = sampleRate.load();
+    if (newSampleRate <= 0.0 || newSampleRate == oldSampleRate) {
+        return;
+    }
+
+    const double ratio = newSampleRate / oldSampleRate;
+    auto rescale = [ratio](int64_t samples) {
+        return static_cast<int64_t>(std::llround(static_cast<double>(samples) * ratio));
+    };
+
+    state.position = rescale(state.position);
+    state.loopStart = rescale(state.loopStart);
+    state.loopEnd = rescale(state.loopEnd);
+    state.punchIn = rescale(state.punchIn);
+    state.punchOut = rescale(state.punchOut);
+    if (state.autoStopAt >= 0) {
+        state.autoStopAt = rescale(state.autoStopAt);
+    }
+    if (state.pendingTempoAt >= 0) {
+        state.pendingTempoAt = rescale(state.pendingTempoAt);
+    }
+
+    sampleRate = newSampleRate;
+    publishState();
+}
+
+bool Transport::pushCommand(const Command& command) {
+    const juce::ScopedLock sl(writerLock);
+
+    int start1, size1, start2, size2;
+    commandFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1) {
+        LOG_WARNING("Transport command queue full, command dropped");
+        return false;
+    }
+
+    commands[static_cast<size_t>(size1 > 0 ? start1 : start2)] = command;
+    commandFifo.finishedWrite(1);
+    return true;
+}
+
+void Transport::chase(int64_t samplePosition, bool shouldPlay) {
+    state.position = samplePosition;
+    state.countInRemaining = 0;
+    state.loopWrapped = false;
+    state.playing = shouldPlay;
+    if (!shouldPlay) {
+        state.recording = false;
+    }
+}
+
+void Transport::applyPendingCommands() {
+    int start1, size1, start2, size2;
+    commandFifo.prepareToRead(commandFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1; ++i) {
+        applyCommand(commands[static_cast<size_t>(start1 + i)]);
+    }
+    for (int i = 0; i < size2; ++i) {
+        applyCommand(commands[static_cast<size_t>(start2 + i)]);
+    }
+
+    commandFifo.finishedRead(size1 + size2);
+
+    // A scheduled tempo change the timeline has already passed
+    if (state.pendingTempoAt >= 0 && state.pendingTempoAt <= state.position) {
+        state.bpm = state.pendingBpm;
+        state.pendingTempoAt = -1;
+    }
+}
+
+void Transport::applyCommand(const Command& command) {
+    switch (command.type) {
+        case CommandType::Play:
+            state.playing = true;
+            state.countInRemaining = 0;
+            break;
+
+        case CommandType::PlayWithCountIn:
+            if (!state.playing) {
+                state.countInRemaining = command.first;
+                state.playing = command.first == 0;
+            }
+            break;
+
+        case CommandType::Stop:
+            state.playing = false;
+            state.recording = false;
+            state.countInRemaining = 0;
+            break;
+
+        case CommandType::SetRecording:
+            state.recording = command.flag;
+            break;
+
+        case CommandType::Locate:
+            state.position = command.first;
+            break;
+
+        case CommandType::SetLoopRange:
+            state.loopStart = command.first;
+            state.loopEnd = command.second;
+            break;
+
+        case CommandType::SetLooping:
+            state.looping = command.flag;
+            break;
+
+        case CommandType::SetPunchRange:
+            state.punchIn = command.first;
+            state.punchOut = command.second;
+            break;
+
+        case CommandType::SetPunchEnabled:
+            state.punchInEnabled = command.flag;
+            state.punchOutEnabled = command.secondFlag;
+            break;
+
+        case CommandType::SetAutoStop:
+            state.autoStopAt = command.first;
+            break;
+
+        case CommandType::SetTempo:
+            if (command.first < 0) {
+                state.bpm = command.value;
+                state.pendingTempoAt = -1;
+            } else {
+                state.pendingBpm = command.value;
+                state.pendingTempoAt = command.first;
+            }
+            break;
+
+        case CommandType::SetTimeSignature:
+            state.numerator = static_cast<int>(command.first);
+            state.denominator = static_cast<int>(command.second);
+            break;
+    }
+}
+
+Transport::Segment Transport::nextSegment(int startSample, int samplesRemaining) {
+    Segment segment;
+    segment.startSample = startSample;
+    segment.numSamples = samplesRemaining;
+    segment.position = state.position;
+    segment.bpm = state.bpm;
+    segment.playing = state.playing;
+    segment.recording = state.playing && isRecordingAt(state.position);
+    segment.loopWrapped = state.loopWrapped;
+    state.loopWrapped = false;
+
+    // Count-in runs on its own timeline leading up to the start position
+    if (state.countInRemaining > 0) {
+        segment.countingIn = true;
+        segment.position = state.position - state.countInRemaining;
+        segment.numSamples = static_cast<int>(std::min<int64_t>(samplesRemaining, state.countInRemaining));
+        return segment;
+    }
+
+    if (!state.playing) {
+        return segment;
+    }
+
+    // End the segment at the first boundary strictly inside it
+    int64_t end = state.position + samplesRemaining;
+    auto limit = [&end, this](int64_t boundary) {
+        if (boundary > state.position && boundary < end) {
+            end = boundary;
+        }
+    };
+
+    if (state.looping && state.loopEnd > state.loopStart) {
+        limit(state.loopEnd);
+    }
+
+    if (state.recording) {
+        if (state.punchInEnabled) {
+            limit(state.punchIn);
+        }
+        if (state.punchOutEnabled) {
+            limit(state.punchOut);
+        }
+    }
+
+    if (state.autoStopAt >= 0) {
+        limit(state.autoStopAt);
+    }
+
+    if (state.pendingTempoAt >= 0) {
+        limit(state.pendingTempoAt);
+    }
+
+    segment.numSamples = static_cast<int>(end - state.position);
+    return segment;
+}
+
+void Transport::advance(const Segment& segment) {
+    if (segment.countingIn) {
+        state.countInRemaining -= segment.numSamples;
+        state.playing = state.countInRemaining <= 0;
+        return;
+    }
+
+    if (!state.playing) {
+        return;
+    }
+
+    state.position += segment.numSamples;
+
+    if (state.pendingTempoAt >= 0 && state.position >= state.pendingTempoAt) {
+        state.bpm = state.pendingBpm;
+        state.pendingTempoAt = -1;
+    }
+
+    if (state.autoStopAt >= 0 && segment.position < state.autoStopAt &&
+        state.position >= state.autoStopAt) {
+        state.playing = false;
+        state.recording = false;
+        state.autoStopAt = -1;
+        ++state.autoStops;
+        return;
+    }
+
+    // Only wrap when playback reached the loop end from inside the loop,
+    // so locating past it plays on
+    if (state.looping && state.loopEnd > state.loopStart &&
+        segment.position < state.loopEnd && state.position >= state.loopEnd) {
+        state.position = state.loopStart + (state.position - state.loopEnd);
+        state.loopWrapped = true;
+    }
+}
+
+void Transport::publishState() {
+    published.playing.store(state.playing, std::memory_order_relaxed);
+    published.recording.store(state.recording, std::memory_order_relaxed);
+    published.countingIn.store(state.countInRemaining > 0, std::memory_order_relaxed);
+    published.looping.store(state.looping, std::memory_order_relaxed);
+    published.position.store(state.position, std::memory_order_relaxed);
+    published.loopStart.store(state.loopStart, std::memory_order_relaxed);
+    published.loopEnd.store(state.loopEnd, std::memory_order_relaxed);
+    published.bpm.store(state.bpm, std::memory_order_relaxed);
+    published.numerator.store(state.numerator, std::memory_order_relaxed);
+    published.denominator.store(state.denominator, std::memory_order_relaxed);
+    published.autoStops.store(state.autoStops, std::memory_order_relaxed);
+}
+
+bool Transport::isRecordingAt(int64_t position) const {
+    if (!state.recording) {
+        return false;
+    }
+
+    if (state.punchInEnabled && position < state.punchIn) {
+        return false;
+    }
+
+    if (state.punchOutEnabled && position >= state.punchOut) {
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,171 @@
+#pragma once
+#include <JuceHeader.h>
+#include <array>
+#include <atomic>
+
+// Sample-accurate transport.
+//
+// The timeline position is an int64 sample count owned by the audio thread,
+// so long loops never drift the way an accumulated double in seconds does.
+// Other threads never touch the audio-thread state. They push commands into a
+// lock-free FIFO that is drained at the start of each block, and read back
+// atomics published at the end of it.
+//
+// processBlock() splits each device block into segments at loop end, punch
+// in/out, auto-stop and scheduled tempo changes. A loop wrap therefore
+// happens on the exact sample, however large the device buffer is.
+class Transport {
+public:
+    // A run of samples inside one device block with constant transport state
+    struct Segment {
+        int startSample{0};      // Offset into the device block
+        int numSamples{0};
+        int64_t position{0};     // Timeline sample at startSample
+        double bpm{120.0};
+        bool playing{false};
+        bool recording{false};   // Record enabled and inside the punch range
+        bool loopWrapped{false}; // First segment after a jump back to the loop start
+        bool countingIn{false};  // Count-in before playback; position is negative
+                                 // relative to where playback will start
+    };
+
+    // Constructor/Destructor
+    Transport();
+    ~Transport() = default;
+
+    // Commands (any non-audio thread). Return false if the queue is full.
+    bool play();
+    bool playWithCountIn(int64_t countInSamples);  // Plays after countInSamples
+    bool stop();
+    bool setRecording(bool shouldRecord);
+    bool locate(int64_t samplePosition);
+    bool setLoopRange(int64_t startSample, int64_t endSample);
+    bool setLooping(bool shouldLoop);
+    bool setPunchRange(int64_t punchInSample, int64_t punchOutSample);
+    bool setPunchEnabled(bool punchIn, bool punchOut);
+    bool setAutoStop(int64_t samplePosition);  // Stops there (post-roll); -1 = never
+    bool setTempo(double bpm, int64_t atSample = -1);  // -1 = start of the next block
+    bool setTimeSignature(int numerator, int denominator);
+
+    // Published state (any thread, updated once per block)
+    bool isPlaying() const { return published.playing.load(std::memory_order_relaxed); }
+    bool isRecording() const { return published.recording.load(std::memory_order_relaxed); }
+    bool isCountingIn() const { return published.countingIn.load(std::memory_order_relaxed); }
+    bool isLooping() const { return published.looping.load(std::memory_order_relaxed); }
+    int64_t getPosition() const { return published.position.load(std::memory_order_relaxed); }
+    double getPositionInSeconds() const;
+    double getBpm() const { return published.bpm.load(std::memory_order_relaxed); }
+    int64_t getLoopStart() const { return published.loopStart.load(std::memory_order_relaxed); }
+    int64_t getLoopEnd() const { return published.loopEnd.load(std::memory_order_relaxed); }
+    int getTimeSignatureNumerator() const { return published.numerator.load(std::memory_order_relaxed); }
+    int getTimeSignatureDenominator() const { return published.denominator.load(std::memory_order_relaxed); }
+    int getNumAutoStops() const { return published.autoStops.load(std::memory_order_relaxed); }
+    double getSampleRate() const { return sampleRate.load(std::memory_order_relaxed); }
+
+    // Call while the audio callback is stopped. Rescales sample positions
+    // if the rate changes, so the timeline stays put in seconds.
+    void prepare(double newSampleRate);
+
+    // Audio thread, before processBlock(): moves the playhead without going
+    // through the command queue, for chasing an external sync source
+    void chase(int64_t samplePosition, bool shouldPlay);
+
+    // Audio thread: applies queued commands, then calls
+    // renderSegment(const Segment&) for consecutive segments covering the block
+    template <typename Callback>
+    void processBlock(int numSamples, Callback&& renderSegment) {
+        applyPendingCommands();
+
+        for (int offset = 0; offset < numSamples;) {
+            const auto segment = nextSegment(offset, numSamples - offset);
+            renderSegment(segment);
+            advance(segment);
+            offset += segment.numSamples;
+        }
+
+        publishState();
+    }
+
+private:
+    enum class CommandType {
+        Play,
+        PlayWithCountIn,
+        Stop,
+        SetRecording,
+        Locate,
+        SetLoopRange,
+        SetLooping,
+        SetPunchRange,
+        SetPunchEnabled,
+        SetAutoStop,
+        SetTempo,
+        SetTimeSignature
+    };
+
+    struct Command {
+        CommandType type{CommandType::Stop};
+        int64_t first{0};
+        int64_t second{0};
+        double value{0.0};
+        bool flag{false};
+        bool secondFlag{false};
+    };
+
+    // Audio thread state
+    struct State {
+        bool playing{false};
+        bool recording{false};
+        bool looping{false};
+        bool punchInEnabled{false};
+        bool punchOutEnabled{false};
+        bool loopWrapped{false};
+        int64_t position{0};
+        int64_t countInRemaining{0};
+        int64_t loopStart{0};
+        int64_t loopEnd{0};
+        int64_t punchIn{0};
+        int64_t punchOut{0};
+        int64_t autoStopAt{-1};
+        int autoStops{0};
+        double bpm{120.0};
+        double pendingBpm{120.0};
+        int64_t pendingTempoAt{-1};
+        int numerator{4};
+        int denominator{4};
+    };
+
+    struct PublishedState {
+        std::atomic<bool> playing{false};
+        std::atomic<bool> recording{false};
+        std::atomic<bool> countingIn{false};
+        std::atomic<bool> looping{false};
+        std::atomic<int64_t> position{0};
+        std::atomic<int64_t> loopStart{0};
+        std::atomic<int64_t> loopEnd{0};
+        std::atomic<double> bpm{120.0};
+        std::atomic<int> numerator{4};
+        std::atomic<int> denominator{4};
+        std::atomic<int> autoStops{0};  // Counts stops made by setAutoStop()
+    };
+
+    static constexpr int commandQueueSize = 256;
+
+    juce::AbstractFifo commandFifo{commandQueueSize};
+    std::array<Command, commandQueueSize> commands;
+    juce::CriticalSection writerLock;  // Serialises producers only
+
+    State state;
+    PublishedState published;
+    std::atomic<double> sampleRate{44100.0};
+
+    bool pushCommand(const Command& command);
+    void applyPendingCommands();
+    void applyCommand(const Command& command);
+    Segment nextSegment(int startSample, int samplesRemaining);
+    void advance(const Segment& segment);
+    void publishState();
+
+    bool isRecordingAt(int64_t position) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Transport)
+};
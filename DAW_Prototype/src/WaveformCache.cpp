@@ -0,0 +1,436 @@
+#include "WaveformCache.h"
+#include "Configuration.h"
+#include "Logger.h"
+
+namespace {
+    constexpr char peakFileMagic[8] = { 'D', 'A', 'W', 'P', 'E', 'A', 'K', 'S' };
+
+    int16_t quantise(float value) {
+        return static_cast<int16_t>(juce::jlimit(-32767, 32767, juce::roundToInt(value * 32767.0f)));
+    }
+
+    float dequantise(int16_t value) {
+        return value / 32767.0f;
+    }
+}
+
+//==============================================================================
+// WaveformPeaks Implementation
+//==============================================================================
+
+WaveformPeaks::~WaveformPeaks() {
+}
+
+std::unique_ptr<WaveformPeaks> WaveformPeaks::load(const juce::File& peakFile,
+                                                   const juce::File& sourceFile) {
+    if (!peakFile.existsAsFile()) {
+        return nullptr;
+    }
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(peakFile, juce::MemoryMappedFile::readOnly);
+    if (mapped->getData() == nullptr || mapped->getSize() < sizeof(FileHeader)) {
+        return nullptr;
+    }
+
+    FileHeader header;
+    std::memcpy(&header, mapped->getData(), sizeof(FileHeader));
+
+    // Reject foreign, outdated or stale files
+    if (std::memcmp(header.magic, peakFileMagic, sizeof(peakFileMagic)) != 0 ||
+        header.version != fileVersion ||
+        header.sourceSize != sourceFile.getSize() ||
+        header.sourceModified != sourceFile.getLastModificationTime().toMilliseconds() ||
+        header.numChannels == 0) {
+        return nullptr;
+    }
+
+    const size_t tableSize = sizeof(LevelInfo) * header.numLevels;
+    if (mapped->getSize() < sizeof(FileHeader) + tableSize) {
+        return nullptr;
+    }
+
+    std::unique_ptr<WaveformPeaks> result(new WaveformPeaks());
+    result->levels.resize(header.numLevels);
+    std::memcpy(result->levels.data(),
+                static_cast<const char*>(mapped->getData()) + sizeof(FileHeader),
+                tableSize);
+
+    for (const auto& level : result->levels) {
+        const auto end = static_cast<size_t>(level.dataOffset) +
+                         static_cast<size_t>(level.numPeaks) * header.numChannels * sizeof(Peak);
+        if (level.samplesPerPeak <= 0 || end > mapped->getSize()) {
+            return nullptr;
+        }
+    }
+
+    result->numChannels = static_cast<int>(header.numChannels);
+    result->sampleRate = header.sampleRate;
+    result->lengthInSamples = header.lengthInSamples;
+    result->mappedFile = std::move(mapped);
+    return result;
+}
+
+bool WaveformPeaks::build(const juce::File& sourceFile,
+                          const juce::File& peakFile,
+                          const std::function<bool()>& shouldAbort) {
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(sourceFile));
+    if (reader == nullptr) {
+        LOG_ERROR("Cannot read %s for waveform overview", sourceFile.getFullPathName().toRawUTF8());
+        return false;
+    }
+
+    const int channels = static_cast<int>(reader->numChannels);
+    const juce::int64 length = reader->lengthInSamples;
+
+    // Level 0 straight from the source
+    std::vector<std::vector<Peak>> data(1);
+    data[0].reserve(static_cast<size_t>((length / baseSamplesPerPeak + 1) * channels));
+
+    const int peaksPerRead = 1024;
+    juce::AudioBuffer<float> buffer(channels, baseSamplesPerPeak * peaksPerRead);
+
+    for (juce::int64 position = 0; position < length; position += buffer.getNumSamples()) {
+        if (shouldAbort != nullptr && shouldAbort()) {
+            return false;
+        }
+
+        const int numSamples = static_cast<int>(
+            juce::jmin(static_cast<juce::int64>(buffer.getNumSamples()), length - position));
+        reader->read(&buffer, 0, numSamples, position, true, true);
+
+        for (int start = 0; start < numSamples; start += baseSamplesPerPeak) {
+            const int count = juce::jmin(baseSamplesPerPeak, numSamples - start);
+
+            for (int ch = 0; ch < channels; ++ch) {
+                const auto range = juce::FloatVectorOperations::findMinAndMax(
+                    buffer.getReadPointer(ch, start), count);
+                const float rms = buffer.getRMSLevel(ch, start, count);
+                data[0].push_back({ quantise(range.getStart()), quantise(range.getEnd()), quantise(rms) });
+            }
+        }
+    }
+
+    // Coarser levels reduce the previous one
+    while (data.back().size() / channels > 1) {
+        const auto& source = data.back();
+        const size_t sourcePeaks = source.size() / channels;
+        std::vector<Peak> reduced;
+        reduced.reserve((sourcePeaks / levelFactor + 1) * channels);
+
+        for (size_t first = 0; first < sourcePeaks; first += levelFactor) {
+            const size_t last = std::min(first + levelFactor, sourcePeaks);
+
+            for (int ch = 0; ch < channels; ++ch) {
+                Peak peak{ 32767, -32767, 0 };
+                double sumSquares = 0.0;
+
+                for (size_t i = first; i < last; ++i) {
+                    const auto& p = source[i * channels + ch];
+                    peak.min = std::min(peak.min, p.min);
+                    peak.max = std::max(peak.max, p.max);
+                    sumSquares += static_cast<double>(p.rms) * p.rms;
+                }
+
+                peak.rms = static_cast<int16_t>(std::sqrt(sumSquares / (last - first)));
+                reduced.push_back(peak);
+            }
+        }
+
+        data.push_back(std::move(reduced));
+    }
+
+    // Write to a temporary file and swap it in, so readers never map a
+    // half-written pyramid
+    auto header = createHeader(sourceFile, *reader, static_cast<uint32_t>(data.size()));
+
+    std::vector<LevelInfo> table;
+    int64_t offset = sizeof(FileHeader) + sizeof(LevelInfo) * data.size();
+    juce::int64 samplesPerPeak = baseSamplesPerPeak;
+
+    for (const auto& level : data) {
+        table.push_back({ samplesPerPeak, static_cast<int64_t>(level.size() / channels), offset });
+        offset += static_cast<int64_t>(level.size() * sizeof(Peak));
+        samplesPerPeak *= levelFactor;
+    }
+
+    if (!peakFile.getParentDirectory().createDirectory()) {
+        return false;
+    }
+
+    juce::TemporaryFile temp(peakFile);
+    {
+        juce::FileOutputStream out(temp.getFile());
+        if (out.failedToOpen()) {
+            return false;
+        }
+
+        out.write(&header, sizeof(header));
+        out.write(table.data(), sizeof(LevelInfo) * table.size());
+        for (const auto& level : data) {
+            out.write(level.data(), level.size() * sizeof(Peak));
+        }
+        out.flush();
+
+        if (out.getStatus().failed()) {
+            return false;
+        }
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+juce::int64 WaveformPeaks::getSamplesPerPeak(int level) const {
+    return juce::isPositiveAndBelow(level, getNumLevels()) ? levels[static_cast<size_t>(level)].samplesPerPeak
+                                                           : baseSamplesPerPeak;
+}
+
+int WaveformPeaks::getLevelForResolution(double samplesPerPixel) const {
+    int level = 0;
+
+    while (level + 1 < getNumLevels() &&
+           levels[static_cast<size_t>(level + 1)].samplesPerPeak <= samplesPerPixel) {
+        ++level;
+    }
+
+    return level;
+}
+
+WaveformPeaks::Range WaveformPeaks::getRange(int channel, int level,
+                                             juce::int64 startSample,
+                                             juce::int64 endSample) const {
+    Range range;
+
+    if (!juce::isPositiveAndBelow(channel, numChannels) ||
+        !juce::isPositiveAndBelow(level, getNumLevels())) {
+        return range;
+    }
+
+    const auto& info = levels[static_cast<size_t>(level)];
+    const juce::int64 first = juce::jmax(static_cast<juce::int64>(0), startSample / info.samplesPerPeak);
+    const juce::int64 last = juce::jmin(static_cast<juce::int64>(info.numPeaks),
+                                        (endSample + info.samplesPerPeak - 1) / info.samplesPerPeak);
+
+    if (first >= last) {
+        return range;
+    }
+
+    const Peak* data = getLevelData(level);
+    int16_t minValue = 32767;
+    int16_t maxValue = -32767;
+    double sumSquares = 0.0;
+
+    for (juce::int64 i = first; i < last; ++i) {
+        const auto& peak = data[i * numChannels + channel];
+        minValue = std::min(minValue, peak.min);
+        maxValue = std::max(maxValue, peak.max);
+        sumSquares += static_cast<double>(peak.rms) * peak.rms;
+    }
+
+    range.min = dequantise(minValue);
+    range.max = dequantise(maxValue);
+    range.rms = static_cast<float>(std::sqrt(sumSquares / (last - first)) / 32767.0);
+    return range;
+}
+
+const WaveformPeaks::Peak* WaveformPeaks::getLevelData(int level) const {
+    return reinterpret_cast<const Peak*>(static_cast<const char*>(mappedFile->getData()) +
+                                         levels[static_cast<size_t>(level)].dataOffset);
+}
+
+WaveformPeaks::FileHeader WaveformPeaks::createHeader(const juce::File& sourceFile,
+                                                      const juce::AudioFormatReader& reader,
+                                                      uint32_t numLevels) {
+    FileHeader header{};
+    std::memcpy(header.magic, peakFileMagic, sizeof(peakFileMagic));
+    header.version = fileVersion;
+    header.numChannels = reader.numChannels;
+    header.sampleRate = reader.sampleRate;
+    header.lengthInSamples = reader.lengthInSamples;
+    header.sourceSize = sourceFile.getSize();
+    header.sourceModified = sourceFile.getLastModificationTime().toMilliseconds();
+    header.numLevels = numLevels;
+    return header;
+}
+
+//==============================================================================
+// WaveformCache::BuildJob Implementation
+//==============================================================================
+
+class WaveformCache::BuildJob : public juce::ThreadPoolJob {
+public:
+    BuildJob(WaveformCache& owner, const juce::File& source, const juce::File& target)
+        : juce::ThreadPoolJob("Waveform overview: " + source.getFileName())
+        , owner(owner)
+        , sourceFile(source)
+        , peakFile(target) {
+    }
+
+    JobStatus runJob() override {
+        const bool success = WaveformPeaks::build(sourceFile, peakFile, [this] { return shouldExit(); });
+        owner.buildFinished(sourceFile, peakFile, success);
+        return jobHasFinished;
+    }
+
+private:
+    WaveformCache& owner;
+    juce::File sourceFile;
+    juce::File peakFile;
+};
+
+//==============================================================================
+// WaveformCache Implementation
+//==============================================================================
+
+WaveformCache::WaveformCache() {
+}
+
+WaveformCache::~WaveformCache() {
+    buildPool.removeAllJobs(true, 5000);
+}
+
+WaveformCache& WaveformCache::getInstance() {
+    static WaveformCache instance;
+    return instance;
+}
+
+std::shared_ptr<const WaveformPeaks> WaveformCache::getPeaks(const juce::File& sourceFile, State* state) {
+    auto setState = [state](State newState) {
+        if (state != nullptr) {
+            *state = newState;
+        }
+    };
+
+    if (!sourceFile.existsAsFile()) {
+        setState(State::Failed);
+        return nullptr;
+    }
+
+    const auto key = sourceFile.getFullPathName();
+    const auto modified = sourceFile.getLastModificationTime();
+
+    const juce::ScopedLock sl(lock);
+
+    // Cached results, failures included, hold until the source changes
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        if (it->second.sourceModified == modified) {
+            setState(it->second.peaks != nullptr ? State::Ready : State::Failed);
+            return it->second.peaks;
+        }
+        entries.erase(it);
+    }
+
+    setState(State::Building);
+    if (pendingBuilds.count(key) > 0) {
+        return nullptr;
+    }
+
+    // Existing peak file next to the source or in the cache
+    const auto peakFile = getPeakFileFor(sourceFile);
+    if (auto loaded = WaveformPeaks::load(peakFile, sourceFile)) {
+        std::shared_ptr<const WaveformPeaks> shared(std::move(loaded));
+        entries[key] = { shared, modified };
+        setState(State::Ready);
+        return shared;
+    }
+
+    pendingBuilds[key] = modified;
+    buildPool.addJob(new BuildJob(*this, sourceFile, peakFile), true);
+    return nullptr;
+}
+
+void WaveformCache::clear() {
+    const juce::ScopedLock sl(lock);
+    entries.clear();
+}
+
+juce::File WaveformCache::getPeakFileFor(const juce::File& sourceFile) const {
+    const auto sibling = sourceFile.getSiblingFile(sourceFile.getFileName() + ".peaks");
+
+    if (sibling.existsAsFile() || sourceFile.getParentDirectory().hasWriteAccess()) {
+        return sibling;
+    }
+
+    return WaveformCacheUtils::getCacheDirectory()
+        .getChildFile(juce::String::toHexString(sourceFile.getFullPathName().hashCode64()) + ".peaks");
+}
+
+void WaveformCache::buildFinished(const juce::File& sourceFile, const juce::File& peakFile, bool success) {
+    const auto key = sourceFile.getFullPathName();
+
+    // A file that cannot be mapped after all counts as a failure too
+    std::shared_ptr<const WaveformPeaks> built;
+    if (success) {
+        built = WaveformPeaks::load(peakFile, sourceFile);
+    }
+
+    {
+        const juce::ScopedLock sl(lock);
+        auto pending = pendingBuilds.find(key);
+        if (pending == pendingBuilds.end()) {
+            return;
+        }
+
+        // Stamped with the source as it was when the build was queued, so
+        // a failure is not retried on every repaint but a changed file is
+        // rebuilt
+        entries[key] = { built, pending->second };
+        pendingBuilds.erase(pending);
+    }
+
+    if (built != nullptr) {
+        LOG_INFO("Built waveform overview for %s", sourceFile.getFileName().toRawUTF8());
+    } else {
+        LOG_WARNING("Failed to build waveform overview for %s", sourceFile.getFileName().toRawUTF8());
+    }
+    sendChangeMessage();
+}
+
+//==============================================================================
+// WaveformCacheUtils Implementation
+//==============================================================================
+
+namespace WaveformCacheUtils {
+    void drawChannel(juce::Graphics& g,
+                     const WaveformPeaks& peaks,
+                     int channel,
+                     juce::Rectangle<int> area,
+                     double startSample,
+                     double samplesPerPixel,
+                     juce::Colour peakColour,
+                     juce::Colour rmsColour) {
+        const auto visible = g.getClipBounds().getIntersection(area);
+        if (visible.isEmpty() || samplesPerPixel <= 0.0) {
+            return;
+        }
+
+        const int level = peaks.getLevelForResolution(samplesPerPixel);
+        const float centre = static_cast<float>(area.getCentreY());
+        const float halfHeight = area.getHeight() * 0.5f;
+
+        for (int x = visible.getX(); x < visible.getRight(); ++x) {
+            const double columnStart = startSample + (x - area.getX()) * samplesPerPixel;
+            const auto range = peaks.getRange(channel, level,
+                                              static_cast<juce::int64>(columnStart),
+                                              static_cast<juce::int64>(columnStart + samplesPerPixel));
+
+            if (range.max < range.min) {
+                continue;
+            }
+
+            const float top = centre - range.max * halfHeight;
+            g.setColour(peakColour);
+            g.drawVerticalLine(x, top, juce::jmax(top + 1.0f, centre - range.min * halfHeight));
+
+            g.setColour(rmsColour);
+            g.drawVerticalLine(x, centre - range.rms * halfHeight, centre + range.rms * halfHeight);
+        }
+    }
+
+    juce::File getCacheDirectory() {
+        return Configuration::getInstance().getConfigDirectory().getChildFile("PeakCache");
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include <JuceHeader.h>
+#include <functional>
+#include <map>
+#include <memory>
+
+// Multi-resolution min/max/RMS overview of one audio file.
+//
+// Level 0 holds one peak per baseSamplesPerPeak source samples and every
+// further level reduces the previous one by levelFactor. The pyramid lives in
+// a .peaks file that is memory-mapped, so a view only pages in the level and
+// range it actually draws.
+class WaveformPeaks {
+public:
+    // One quantised peak (full scale = 32767)
+    struct Peak {
+        int16_t min{0};
+        int16_t max{0};
+        int16_t rms{0};
+    };
+
+    // Aggregated range in linear gain
+    struct Range {
+        float min{0.0f};
+        float max{0.0f};
+        float rms{0.0f};
+    };
+
+    static constexpr int baseSamplesPerPeak = 256;
+    static constexpr int levelFactor = 4;
+
+    // Constructor/Destructor
+    ~WaveformPeaks();
+
+    // Maps an existing peak file. Returns nullptr if it is missing, corrupt
+    // or older than the source file.
+    static std::unique_ptr<WaveformPeaks> load(const juce::File& peakFile,
+                                               const juce::File& sourceFile);
+
+    // Analyses the source and writes a peak file. Returns false on failure
+    // or when shouldAbort() turns true.
+    static bool build(const juce::File& sourceFile,
+                      const juce::File& peakFile,
+                      const std::function<bool()>& shouldAbort = nullptr);
+
+    // Properties
+    int getNumChannels() const { return numChannels; }
+    double getSampleRate() const { return sampleRate; }
+    juce::int64 getLengthInSamples() const { return lengthInSamples; }
+    int getNumLevels() const { return static_cast<int>(levels.size()); }
+    juce::int64 getSamplesPerPeak(int level) const;
+
+    // Coarsest level that still has at least one peak per pixel
+    int getLevelForResolution(double samplesPerPixel) const;
+
+    // Aggregates the peaks covering [startSample, endSample) on a level
+    Range getRange(int channel, int level,
+                   juce::int64 startSample, juce::int64 endSample) const;
+
+private:
+    // On-disk layout (native endianness, the file is a local cache):
+    // FileHeader, LevelInfo[numLevels], then per level
+    // Peak[numPeaks * numChannels] interleaved by channel.
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t numChannels;
+        double sampleRate;
+        int64_t lengthInSamples;
+        int64_t sourceSize;
+        int64_t sourceModified;
+        uint32_t numLevels;
+        uint32_t reserved;
+    };
+
+    struct LevelInfo {
+        int64_t samplesPerPeak;
+        int64_t numPeaks;
+        int64_t dataOffset;
+    };
+
+    static constexpr uint32_t fileVersion = 1;
+
+    WaveformPeaks() = default;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    std::vector<LevelInfo> levels;
+    int numChannels{0};
+    double sampleRate{44100.0};
+    juce::int64 lengthInSamples{0};
+
+    const Peak* getLevelData(int level) const;
+
+    static FileHeader createHeader(const juce::File& sourceFile,
+                                   const juce::AudioFormatReader& reader,
+                                   uint32_t numLevels);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformPeaks)
+};
+
+// Owns the peak pyramids of every audio file shown in the editor.
+//
+// Missing or stale peak files are built on a background pool; listeners get
+// a change message whenever a new overview becomes available or a build
+// fails. Entries, failures included, are kept until the source changes.
+class WaveformCache : public juce::ChangeBroadcaster {
+public:
+    enum class State {
+        Building,
+        Ready,
+        Failed  // Retried once the source file changes
+    };
+
+    // Constructor/Destructor
+    WaveformCache();
+    ~WaveformCache() override;
+
+    // Singleton access
+    static WaveformCache& getInstance();
+
+    // Returns the overview if it is ready, otherwise queues a build and
+    // returns nullptr; state says which. Safe to call from paint().
+    std::shared_ptr<const WaveformPeaks> getPeaks(const juce::File& sourceFile,
+                                                  State* state = nullptr);
+
+    // Drops the in-memory mappings (peak files are kept)
+    void clear();
+
+    // Where the peak file for a source lives: next to the source if that
+    // directory is writable, otherwise in the application cache directory
+    juce::File getPeakFileFor(const juce::File& sourceFile) const;
+
+private:
+    class BuildJob;
+
+    juce::ThreadPool buildPool{1};
+    // An overview, or nullptr after a failed build, for the source as it
+    // was at sourceModified
+    struct Entry {
+        std::shared_ptr<const WaveformPeaks> peaks;
+        juce::Time sourceModified;
+    };
+
+    juce::CriticalSection lock;
+    std::map<juce::String, Entry> entries;
+    std::map<juce::String, juce::Time> pendingBuilds;  // Source modification time when queued
+
+    void buildFinished(const juce::File& sourceFile, const juce::File& peakFile, bool success);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(WaveformCache)
+};
+
+// Waveform drawing utilities
+namespace WaveformCacheUtils {
+    // Draws one channel lane of a clip overview, touching only the columns
+    // inside the graphics clip region
+    void drawChannel(juce::Graphics& g,
+                     const WaveformPeaks& peaks,
+                     int channel,
+                     juce::Rectangle<int> area,
+                     double startSample,
+                     double samplesPerPixel,
+                     juce::Colour peakColour,
+                     juce::Colour rmsColour);
+
+    juce::File getCacheDirectory();
+}